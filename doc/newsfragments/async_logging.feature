@@ -0,0 +1 @@
+Log messages are now written by a background thread in batches and the log file is kept open between messages, so logging no longer slows down input handling.
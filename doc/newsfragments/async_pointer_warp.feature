@@ -0,0 +1 @@
+The X11 server tracks the mouse on other screens from the pointer grab's motion events and warps the pointer back to the center without waiting for the X server.
@@ -0,0 +1 @@
+X11 clients send the keystrokes for a key, and all the input from messages that arrive together, to the X server with one flush instead of one flush per event.
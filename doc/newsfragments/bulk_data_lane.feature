@@ -0,0 +1 @@
+Mouse and keyboard events no longer wait behind clipboard or file transfers: bulk data is only handed to the connection as it drains.
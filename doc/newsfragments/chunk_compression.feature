@@ -0,0 +1 @@
+Clipboard and file transfer data is now compressed on the wire when both ends support protocol 1.8, except for data that is already compressed such as PNG or JPEG images.
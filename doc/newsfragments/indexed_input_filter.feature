@@ -0,0 +1 @@
+The server finds the input filter rule for a hot key or mouse button through an index instead of trying every rule, and passes other input through without copying it.
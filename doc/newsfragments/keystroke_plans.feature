@@ -0,0 +1 @@
+Clients remember the keystrokes for each key and modifier state, so typing no longer searches the keyboard map for every key press.
@@ -0,0 +1 @@
+Clipboard data is now sent to clients only when something is pasted there: on screen switch the server announces the available formats and the client fetches each one on demand (protocol 1.7).
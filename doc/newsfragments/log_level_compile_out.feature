@@ -0,0 +1 @@
+Debug log messages can be compiled out with the INPUTLEAP_LOG_MAX_LEVEL CMake option, and enabled messages are formatted on the log's writer thread.
@@ -0,0 +1 @@
+Setting the `mouseMoveInterval` option (in microseconds, off by default) merges mouse motion sent to a client faster than that interval, or while its connection is backed up, into a single move, which is always sent before the next button, key or wheel event.
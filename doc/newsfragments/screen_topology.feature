@@ -0,0 +1 @@
+The server now finds the screen to switch to through a precomputed index of the screen links, without searching by screen name.
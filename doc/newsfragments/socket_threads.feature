@@ -0,0 +1 @@
+Added `--socket-threads <n>` server option to service client connections on several threads, so traffic to one client no longer waits behind a large transfer to another.
\ No newline at end of file
@@ -0,0 +1 @@
+Dragged files are now streamed to and from disk instead of being held in memory, so large files transfer without memory growth.
@@ -0,0 +1 @@
+Event queue timers are kept in a heap ordered by absolute deadline, so waiting for events no longer costs more with every timer and deleting a timer no longer searches for it. Repeating timers no longer drift.
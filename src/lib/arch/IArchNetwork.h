@@ -54,6 +54,20 @@ An opaque type representing a network address.
 */
 typedef ArchNetAddressImpl* ArchNetAddress;
 
+/*!
+\class ArchPollerImpl
+\brief Internal poller data.
+An architecture dependent type holding the necessary data for a poller.
+*/
+class ArchPollerImpl;
+
+/*!
+\var ArchPoller
+\brief Opaque poller type.
+An opaque type representing a persistent set of sockets to wait on.
+*/
+typedef ArchPollerImpl* ArchPoller;
+
 /** This interface defines the networking operations required by InputLeap.
     Each architecture must implement this interface.
 */
@@ -103,6 +117,16 @@ public:
         unsigned short m_revents;
     };
 
+    //! A ready socket reported by \c waitPoller()
+    class PollerEvent {
+    public:
+        //! The data passed to \c setPollerSocket() for the socket
+        void* m_data;
+
+        //! The result events
+        unsigned short m_revents;
+    };
+
     //! @name manipulators
     //@{
 
@@ -198,6 +222,54 @@ public:
     */
     virtual void unblockPollSocket(ArchThread thread) = 0;
 
+    //! Create a poller
+    /*!
+    Returns a new poller, a persistent set of sockets that can be waited
+    on with \c waitPoller().  Unlike \c pollSocket() the cost of waiting
+    does not depend on the number of sockets in the set.  Returns nullptr
+    if the platform has no such facility, in which case callers must use
+    \c pollSocket() instead.
+    */
+    virtual ArchPoller newPoller() = 0;
+
+    //! Destroy a poller
+    /*!
+    Destroys a poller returned by \c newPoller().  The sockets in the
+    set are not affected.
+    */
+    virtual void closePoller(ArchPoller poller) = 0;
+
+    //! Add or modify a socket in a poller
+    /*!
+    Adds socket \c s to \c poller or, if it's already in the set,
+    replaces its events and data.  \c events can be any combination of
+    \c kPOLLIN and \c kPOLLOUT;  errors are always reported.  \c data
+    is returned in the \c m_data member of the events for \c s.
+    */
+    virtual void setPollerSocket(ArchPoller poller, ArchSocket s,
+                            unsigned short events, void* data) = 0;
+
+    //! Remove a socket from a poller
+    /*!
+    Removes socket \c s from \c poller.  This must be called before
+    the socket is closed.  Subsequent calls to \c waitPoller() will not
+    report \c s.
+    */
+    virtual void removePollerSocket(ArchPoller poller, ArchSocket s) = 0;
+
+    //! Wait for sockets in a poller
+    /*!
+    Waits up to \c timeout seconds (or indefinitely if \c timeout < 0)
+    for some socket in \c poller to become ready, then fills in up to
+    \c num entries of \c events and returns the number of entries
+    filled in.  Like \c pollSocket() this returns 0 when the thread is
+    unblocked with \c unblockPollSocket().
+
+    (Cancellation point)
+    */
+    virtual int waitPoller(ArchPoller poller, PollerEvent events[],
+                            int num, double timeout) = 0;
+
     //! Read data from socket
     /*!
     Read up to \c len bytes from socket \c s in \c buf and return the
@@ -238,6 +310,15 @@ public:
     */
     virtual bool setReuseAddrOnSocket(ArchSocket, bool reuse) = 0;
 
+    //! Limit unsent data queued by the system on socket
+    /*!
+    Keeps the system from accepting more data for the socket while more
+    than \c bytes of what it already accepted hasn't been sent yet, so
+    that data written later isn't stuck behind a long backlog.  Returns
+    false if the system doesn't support this.
+    */
+    virtual bool setUnsentLimitOnSocket(ArchSocket, int bytes) = 0;
+
     //! Return local host's name
     virtual std::string getHostName() = 0;
 
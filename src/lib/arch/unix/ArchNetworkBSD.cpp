@@ -38,6 +38,9 @@
 #include <string.h>
 
 #include <poll.h>
+#if defined(__linux__)
+#    include <sys/epoll.h>
+#endif
 
 namespace inputleap {
 
@@ -359,6 +362,205 @@ ArchNetworkBSD::unblockPollSocket(ArchThread thread)
     }
 }
 
+#if defined(__linux__)
+
+ArchPoller
+ArchNetworkBSD::newPoller()
+{
+    int fd = epoll_create1(EPOLL_CLOEXEC);
+    if (fd == -1) {
+        throwError(errno);
+    }
+
+    ArchPollerImpl* poller = new ArchPollerImpl;
+    poller->m_fd        = fd;
+    poller->m_unblockFd = -1;
+    return poller;
+}
+
+void
+ArchNetworkBSD::closePoller(ArchPoller poller)
+{
+    assert(poller != nullptr);
+
+    close(poller->m_fd);
+    delete poller;
+}
+
+void
+ArchNetworkBSD::setPollerSocket(ArchPoller poller, ArchSocket s,
+                                unsigned short events, void* data)
+{
+    assert(poller != nullptr);
+    assert(s != nullptr);
+
+    struct epoll_event ev;
+    ev.events   = 0;
+    ev.data.ptr = data;
+    if ((events & kPOLLIN) != 0) {
+        // a half closed socket is readable until the end of the stream
+        // is read.  it's only asked for with reads so a socket with
+        // reads paused isn't reported over and over.
+        ev.events |= EPOLLIN | EPOLLRDHUP;
+    }
+    if ((events & kPOLLOUT) != 0) {
+        ev.events |= EPOLLOUT;
+    }
+
+    // try modifying first since that's the common case
+    if (epoll_ctl(poller->m_fd, EPOLL_CTL_MOD, s->m_fd, &ev) == -1) {
+        if (errno != ENOENT ||
+            epoll_ctl(poller->m_fd, EPOLL_CTL_ADD, s->m_fd, &ev) == -1) {
+            throwError(errno);
+        }
+    }
+}
+
+void
+ArchNetworkBSD::removePollerSocket(ArchPoller poller, ArchSocket s)
+{
+    assert(poller != nullptr);
+    assert(s != nullptr);
+
+    if (epoll_ctl(poller->m_fd, EPOLL_CTL_DEL, s->m_fd, nullptr) == -1) {
+        if (errno != ENOENT && errno != EBADF) {
+            throwError(errno);
+        }
+    }
+}
+
+int
+ArchNetworkBSD::waitPoller(ArchPoller poller, PollerEvent events[], int num, double timeout)
+{
+    assert(poller != nullptr);
+    assert(events != nullptr && num > 0);
+
+    // make sure the unblock pipe of the waiting thread is in the set.
+    // it's the only entry with no data.
+    const int* unblockPipe = getUnblockPipe();
+    if (unblockPipe != nullptr && poller->m_unblockFd != unblockPipe[0]) {
+        if (poller->m_unblockFd != -1) {
+            epoll_ctl(poller->m_fd, EPOLL_CTL_DEL, poller->m_unblockFd, nullptr);
+        }
+        struct epoll_event ev;
+        ev.events   = EPOLLIN;
+        ev.data.ptr = nullptr;
+        if (epoll_ctl(poller->m_fd, EPOLL_CTL_ADD, unblockPipe[0], &ev) == -1) {
+            throwError(errno);
+        }
+        poller->m_unblockFd = unblockPipe[0];
+    }
+
+    // prepare timeout
+    int t = (timeout < 0.0) ? -1 : static_cast<int>(1000.0 * timeout);
+
+    // do the wait
+    const int maxEvents = 64;
+    struct epoll_event ev[maxEvents];
+    int n = epoll_wait(poller->m_fd, ev, (num < maxEvents) ? num : maxEvents, t);
+
+    // handle results
+    if (n == -1) {
+        if (errno == EINTR) {
+            // interrupted system call
+            ARCH->testCancelThread();
+            return 0;
+        }
+        throwError(errno);
+    }
+
+    // translate back
+    int j = 0;
+    for (int i = 0; i < n; ++i) {
+        if (ev[i].data.ptr == nullptr) {
+            // the unblock event was signalled.  flush the pipe.
+            char dummy[100];
+            int ignore;
+
+            do {
+                ignore = read(poller->m_unblockFd, dummy, sizeof(dummy));
+            } while (errno != EAGAIN);
+            (void) ignore;
+            continue;
+        }
+
+        events[j].m_data    = ev[i].data.ptr;
+        events[j].m_revents = 0;
+        if ((ev[i].events & (EPOLLIN | EPOLLRDHUP)) != 0) {
+            events[j].m_revents |= kPOLLIN;
+        }
+        if ((ev[i].events & EPOLLOUT) != 0) {
+            events[j].m_revents |= kPOLLOUT;
+        }
+        if ((ev[i].events & EPOLLERR) != 0) {
+            events[j].m_revents |= kPOLLERR;
+        }
+        if ((ev[i].events & EPOLLHUP) != 0) {
+            // a hung up socket is always reported.  let any data left be
+            // read first, after that (or with reads paused) it's an error
+            // so the socket gets closed instead of being reported forever.
+            if ((ev[i].events & EPOLLIN) != 0) {
+                events[j].m_revents |= kPOLLIN;
+            }
+            else {
+                events[j].m_revents |= kPOLLERR;
+            }
+        }
+        ++j;
+    }
+
+    return j;
+}
+
+#else // !defined(__linux__)
+
+ArchPoller
+ArchNetworkBSD::newPoller()
+{
+    // no persistent readiness set on this platform.  callers fall back
+    // to pollSocket().
+    return nullptr;
+}
+
+void
+ArchNetworkBSD::closePoller(ArchPoller poller)
+{
+    (void) poller;
+    assert(false && "pollers are not supported");
+}
+
+void
+ArchNetworkBSD::setPollerSocket(ArchPoller poller, ArchSocket s,
+                                unsigned short events, void* data)
+{
+    (void) poller;
+    (void) s;
+    (void) events;
+    (void) data;
+    assert(false && "pollers are not supported");
+}
+
+void
+ArchNetworkBSD::removePollerSocket(ArchPoller poller, ArchSocket s)
+{
+    (void) poller;
+    (void) s;
+    assert(false && "pollers are not supported");
+}
+
+int
+ArchNetworkBSD::waitPoller(ArchPoller poller, PollerEvent events[], int num, double timeout)
+{
+    (void) poller;
+    (void) events;
+    (void) num;
+    (void) timeout;
+    assert(false && "pollers are not supported");
+    return 0;
+}
+
+#endif
+
 size_t
 ArchNetworkBSD::readSocket(ArchSocket s, void* buf, size_t len)
 {
@@ -473,6 +675,22 @@ ArchNetworkBSD::setReuseAddrOnSocket(ArchSocket s, bool reuse)
     return (oflag != 0);
 }
 
+bool
+ArchNetworkBSD::setUnsentLimitOnSocket(ArchSocket s, int bytes)
+{
+    assert(s != nullptr);
+
+#if defined(TCP_NOTSENT_LOWAT)
+    // best effort:  the socket works the same without it
+    socklen_t size = static_cast<socklen_t>(sizeof(bytes));
+    return setsockopt(s->m_fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT,
+                      reinterpret_cast<optval_t*>(&bytes), size) == 0;
+#else
+    (void) bytes;
+    return false;
+#endif
+}
+
 std::string
 ArchNetworkBSD::getHostName()
 {
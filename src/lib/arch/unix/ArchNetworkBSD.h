@@ -44,6 +44,12 @@ public:
     int m_refCount;
 };
 
+class ArchPollerImpl {
+public:
+    int m_fd;
+    int m_unblockFd;
+};
+
 class ArchNetAddressImpl {
 public:
     ArchNetAddressImpl() : m_len(sizeof(m_addr)) { }
@@ -73,11 +79,18 @@ public:
     bool connectSocket(ArchSocket s, ArchNetAddress name) override;
     int pollSocket(PollEntry[], int num, double timeout) override;
     void unblockPollSocket(ArchThread thread) override;
+    ArchPoller newPoller() override;
+    void closePoller(ArchPoller poller) override;
+    void setPollerSocket(ArchPoller poller, ArchSocket s,
+                         unsigned short events, void* data) override;
+    void removePollerSocket(ArchPoller poller, ArchSocket s) override;
+    int waitPoller(ArchPoller poller, PollerEvent events[], int num, double timeout) override;
     size_t readSocket(ArchSocket s, void* buf, size_t len) override;
     size_t writeSocket(ArchSocket s, const void* buf, size_t len) override;
     void throwErrorOnSocket(ArchSocket) override;
     bool setNoDelayOnSocket(ArchSocket, bool noDelay) override;
     bool setReuseAddrOnSocket(ArchSocket, bool reuse) override;
+    bool setUnsentLimitOnSocket(ArchSocket, int bytes) override;
     std::string getHostName() override;
     ArchNetAddress newAnyAddr(EAddressFamily) override;
     ArchNetAddress copyAddr(ArchNetAddress) override;
@@ -546,6 +546,52 @@ ArchNetworkWinsock::unblockPollSocket(ArchThread thread)
     }
 }
 
+ArchPoller
+ArchNetworkWinsock::newPoller()
+{
+    // winsock has no persistent readiness set that we can use here.
+    // callers fall back to pollSocket().
+    return nullptr;
+}
+
+void
+ArchNetworkWinsock::closePoller(ArchPoller poller)
+{
+    (void) poller;
+    assert(false && "pollers are not supported");
+}
+
+void
+ArchNetworkWinsock::setPollerSocket(ArchPoller poller, ArchSocket s,
+                            unsigned short events, void* data)
+{
+    (void) poller;
+    (void) s;
+    (void) events;
+    (void) data;
+    assert(false && "pollers are not supported");
+}
+
+void
+ArchNetworkWinsock::removePollerSocket(ArchPoller poller, ArchSocket s)
+{
+    (void) poller;
+    (void) s;
+    assert(false && "pollers are not supported");
+}
+
+int
+ArchNetworkWinsock::waitPoller(ArchPoller poller, PollerEvent events[],
+                            int num, double timeout)
+{
+    (void) poller;
+    (void) events;
+    (void) num;
+    (void) timeout;
+    assert(false && "pollers are not supported");
+    return 0;
+}
+
 size_t
 ArchNetworkWinsock::readSocket(ArchSocket s, void* buf, size_t len)
 {
@@ -660,6 +706,16 @@ ArchNetworkWinsock::setReuseAddrOnSocket(ArchSocket s, bool reuse)
     return (oflag != 0);
 }
 
+bool
+ArchNetworkWinsock::setUnsentLimitOnSocket(ArchSocket s, int bytes)
+{
+    assert(s != nullptr);
+    (void) bytes;
+
+    // winsock has no equivalent of TCP_NOTSENT_LOWAT
+    return false;
+}
+
 std::string
 ArchNetworkWinsock::getHostName()
 {
@@ -80,12 +80,20 @@ public:
     virtual bool connectSocket(ArchSocket s, ArchNetAddress name);
     virtual int pollSocket(PollEntry[], int num, double timeout);
     virtual void unblockPollSocket(ArchThread thread);
+    virtual ArchPoller newPoller();
+    virtual void closePoller(ArchPoller poller);
+    virtual void setPollerSocket(ArchPoller poller, ArchSocket s,
+                            unsigned short events, void* data);
+    virtual void removePollerSocket(ArchPoller poller, ArchSocket s);
+    virtual int waitPoller(ArchPoller poller, PollerEvent events[],
+                            int num, double timeout);
     virtual size_t readSocket(ArchSocket s, void* buf, size_t len);
     virtual size_t writeSocket(ArchSocket s,
                             const void* buf, size_t len);
     virtual void throwErrorOnSocket(ArchSocket);
     virtual bool setNoDelayOnSocket(ArchSocket, bool noDelay);
     virtual bool setReuseAddrOnSocket(ArchSocket, bool reuse);
+    virtual bool setUnsentLimitOnSocket(ArchSocket, int bytes);
     virtual std::string getHostName();
     virtual ArchNetAddress newAnyAddr(EAddressFamily);
     virtual ArchNetAddress copyAddr(ArchNetAddress);
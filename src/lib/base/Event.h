@@ -96,6 +96,13 @@ public:
         data_ = other.data_->clone();
     }
 
+    /// Returns an event for another target that shares the data of this event. The returned
+    /// event must not outlive this one and its data must not be released.
+    Event retargeted(const EventTarget* target) const
+    {
+        return Event(type_, target, data_, flags_);
+    }
+
     //! Release event data
     /*!
     Deletes event data for the given event (using free()).
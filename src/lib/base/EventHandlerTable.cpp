@@ -0,0 +1,309 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/EventHandlerTable.h"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <utility>
+
+namespace inputleap {
+
+namespace {
+
+std::atomic<std::uint64_t> s_next_table_id(1);
+
+} // namespace
+
+//
+// EventHandlerTable::Reader
+//
+
+EventHandlerTable::Reader::Reader(const EventHandlerTable& table) :
+    table_(table),
+    slot_(table.reader_slot())
+{
+    if (slot_->depth++ == 0) {
+        // the slot must be visible before we look anything up so a
+        // writer that retires what we find afterwards keeps it alive
+        slot_->epoch.store(table_.epoch_.load(std::memory_order_relaxed),
+                           std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+}
+
+EventHandlerTable::Reader::~Reader()
+{
+    if (--slot_->depth == 0) {
+        slot_->epoch.store(0, std::memory_order_release);
+        if (table_.has_retired_.load(std::memory_order_relaxed)) {
+            table_.end_read();
+        }
+    }
+}
+
+const EventHandlerTable::EventHandler*
+EventHandlerTable::Reader::find(EventType type, const EventTarget* target) const
+{
+    const Index* index = table_.index_.load(std::memory_order_acquire);
+    const TargetHandlers* handlers = index->find(target);
+    if (handlers == nullptr) {
+        return nullptr;
+    }
+
+    const auto& handler = handlers->handlers[static_cast<std::size_t>(type)];
+    if (handler) {
+        return handler.get();
+    }
+    return handlers->handlers[static_cast<std::size_t>(EventType::UNKNOWN)].get();
+}
+
+//
+// EventHandlerTable::Index
+//
+
+EventHandlerTable::Index::Index(std::size_t capacity) :
+    slots(new Slot[capacity]),
+    mask(capacity - 1)
+{
+}
+
+const EventHandlerTable::TargetHandlers*
+EventHandlerTable::Index::find(const EventTarget* target) const
+{
+    for (std::size_t i = hash(target) & mask; ; i = (i + 1) & mask) {
+        const EventTarget* key = slots[i].target.load(std::memory_order_acquire);
+        if (key == target) {
+            return slots[i].handlers.load(std::memory_order_acquire);
+        }
+        if (key == nullptr) {
+            return nullptr;
+        }
+    }
+}
+
+EventHandlerTable::Slot* EventHandlerTable::Index::slot(const EventTarget* target)
+{
+    // only writers change slots so relaxed loads see the latest
+    for (std::size_t i = hash(target) & mask; ; i = (i + 1) & mask) {
+        const EventTarget* key = slots[i].target.load(std::memory_order_relaxed);
+        if (key == target || key == nullptr) {
+            return &slots[i];
+        }
+    }
+}
+
+//
+// EventHandlerTable
+//
+
+EventHandlerTable::EventHandlerTable() :
+    owned_index_(new Index(16)),
+    index_(owned_index_.get()),
+    epoch_(1),
+    has_retired_(false),
+    id_(s_next_table_id.fetch_add(1))
+{
+}
+
+EventHandlerTable::~EventHandlerTable() = default;
+
+void EventHandlerTable::set(EventType type, const EventTarget* target,
+                            const EventHandler& handler)
+{
+    // destroying handlers can run arbitrary code that may want to
+    // change handlers, so freed handlers are destroyed after unlocking
+    RetiredList freed;
+    std::lock_guard<std::mutex> lock(write_mutex_);
+
+    std::unique_ptr<TargetHandlers> handlers(new TargetHandlers);
+    auto i = current_.find(target);
+    if (i != current_.end()) {
+        *handlers = *i->second;
+    }
+
+    auto& entry = handlers->handlers[static_cast<std::size_t>(type)];
+    if (!entry) {
+        ++handlers->count;
+    }
+    entry = std::make_shared<const EventHandler>(handler);
+
+    replace(target, std::move(handlers), freed);
+}
+
+bool EventHandlerTable::remove(EventType type, const EventTarget* target)
+{
+    RetiredList freed;
+    std::lock_guard<std::mutex> lock(write_mutex_);
+
+    auto i = current_.find(target);
+    if (i == current_.end()) {
+        return true;
+    }
+    const TargetHandlers& old = *i->second;
+    if (!old.handlers[static_cast<std::size_t>(type)]) {
+        return false;
+    }
+
+    if (old.count == 1) {
+        replace(target, nullptr, freed);
+        return true;
+    }
+
+    std::unique_ptr<TargetHandlers> handlers(new TargetHandlers(old));
+    handlers->handlers[static_cast<std::size_t>(type)].reset();
+    --handlers->count;
+    replace(target, std::move(handlers), freed);
+    return false;
+}
+
+void EventHandlerTable::remove_all(const EventTarget* target)
+{
+    RetiredList freed;
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    if (current_.count(target) != 0) {
+        replace(target, nullptr, freed);
+    }
+}
+
+std::vector<const EventTarget*> EventHandlerTable::targets() const
+{
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    std::vector<const EventTarget*> result;
+    result.reserve(current_.size());
+    for (const auto& entry : current_) {
+        result.push_back(entry.first);
+    }
+    return result;
+}
+
+std::size_t EventHandlerTable::hash(const EventTarget* target)
+{
+    // fibonacci hashing.  the low bits of a pointer are mostly zero.
+    auto value = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(target));
+    return static_cast<std::size_t>((value * 0x9e3779b97f4a7c15ull) >> 32);
+}
+
+EventHandlerTable::ReaderSlot* EventHandlerTable::reader_slot() const
+{
+    // the slot of the table this thread read last
+    static thread_local std::uint64_t cached_id = 0;
+    static thread_local ReaderSlot* cached_slot = nullptr;
+    if (cached_id == id_) {
+        return cached_slot;
+    }
+
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    ReaderSlot*& slot = reader_slot_by_thread_[std::this_thread::get_id()];
+    if (slot == nullptr) {
+        reader_slots_.push_back(std::unique_ptr<ReaderSlot>(new ReaderSlot));
+        slot = reader_slots_.back().get();
+    }
+    cached_id = id_;
+    cached_slot = slot;
+    return slot;
+}
+
+void EventHandlerTable::replace(const EventTarget* target,
+                                std::unique_ptr<const TargetHandlers> handlers,
+                                RetiredList& freed)
+{
+    std::unique_ptr<const Index> old_index;
+
+    Slot* slot = owned_index_->slot(target);
+    if (slot->target.load(std::memory_order_relaxed) == nullptr) {
+        // a new target.  keep the load factor, counting the slots of
+        // targets without handlers, at or below one half, rebuilding
+        // at no more than a quarter so rebuilds stay rare.
+        if ((owned_index_->used + 1) * 2 > owned_index_->mask + 1) {
+            std::size_t capacity = 16;
+            while (capacity < 4 * (current_.size() + 1)) {
+                capacity *= 2;
+            }
+            std::unique_ptr<Index> index(new Index(capacity));
+            for (const auto& entry : current_) {
+                Slot* copy = index->slot(entry.first);
+                copy->target.store(entry.first, std::memory_order_relaxed);
+                copy->handlers.store(entry.second.get(), std::memory_order_relaxed);
+                ++index->used;
+            }
+            index_.store(index.get(), std::memory_order_release);
+            old_index = std::move(owned_index_);
+            owned_index_ = std::move(index);
+            slot = owned_index_->slot(target);
+        }
+        slot->handlers.store(handlers.get(), std::memory_order_relaxed);
+        slot->target.store(target, std::memory_order_release);
+        ++owned_index_->used;
+    } else {
+        slot->handlers.store(handlers.get(), std::memory_order_release);
+    }
+
+    // the old handlers for the target are no longer reachable by new
+    // readers.  free them once the readers that may have found them
+    // are gone.
+    std::unique_ptr<const TargetHandlers> old_handlers;
+    auto i = current_.find(target);
+    if (i != current_.end()) {
+        old_handlers = std::move(i->second);
+        if (handlers) {
+            i->second = std::move(handlers);
+        } else {
+            current_.erase(i);
+        }
+    } else if (handlers) {
+        current_.emplace(target, std::move(handlers));
+    }
+
+    if (old_handlers || old_index) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::uint64_t epoch = epoch_.fetch_add(1, std::memory_order_relaxed);
+        retired_.push_back(Retired{epoch, std::move(old_index), std::move(old_handlers)});
+    }
+    collect(freed);
+}
+
+void EventHandlerTable::collect(RetiredList& freed) const
+{
+    // the oldest epoch a reader is still in
+    std::uint64_t oldest = std::numeric_limits<std::uint64_t>::max();
+    for (const auto& slot : reader_slots_) {
+        std::uint64_t epoch = slot->epoch.load(std::memory_order_acquire);
+        if (epoch != 0 && epoch < oldest) {
+            oldest = epoch;
+        }
+    }
+
+    // retired_ is in epoch order
+    auto end = retired_.begin();
+    while (end != retired_.end() && end->epoch < oldest) {
+        ++end;
+    }
+    std::move(retired_.begin(), end, std::back_inserter(freed));
+    retired_.erase(retired_.begin(), end);
+    has_retired_.store(!retired_.empty(), std::memory_order_relaxed);
+}
+
+void EventHandlerTable::end_read() const
+{
+    RetiredList freed;
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    collect(freed);
+}
+
+} // namespace inputleap
@@ -0,0 +1,187 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/EventTypes.h"
+#include "base/IEventQueue.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace inputleap {
+
+//! Event handler lookup table
+/*!
+Maps (target, event type) pairs to handlers for an event queue.  Targets
+are found in an open addressing hash whose slots point at an immutable
+array of handlers indexed by event type.  Changing a handler builds a
+new array for its target only and swaps it into the target's slot, so
+lookups never lock and never touch a reference count.
+
+Lookups go through a Reader.  Each thread announces the epoch it started
+reading in, in a slot of its own, and replaced handler arrays and hashes
+are kept until every reader that may have seen them is gone, so a
+handler may remove itself or any other handler while it runs.
+*/
+class EventHandlerTable {
+    struct ReaderSlot;
+
+public:
+    using EventHandler = IEventQueue::EventHandler;
+
+    //! Lookup scope
+    /*!
+    Keeps whatever it finds alive for the lifetime of the reader.
+    Readers may be nested and may be created on any thread but must be
+    destroyed on the thread that created them.
+    */
+    class Reader {
+    public:
+        explicit Reader(const EventHandlerTable& table);
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+        ~Reader();
+
+        //! Find a handler
+        /*!
+        Returns the handler for \p type on \p target, or the target's
+        handler for EventType::UNKNOWN if there is none.  Returns nullptr
+        if neither exists.  The handler stays valid while the reader is
+        alive.
+        */
+        const EventHandler* find(EventType type, const EventTarget* target) const;
+
+    private:
+        const EventHandlerTable& table_;
+        ReaderSlot* slot_;
+    };
+
+    EventHandlerTable();
+    EventHandlerTable(const EventHandlerTable&) = delete;
+    EventHandlerTable& operator=(const EventHandlerTable&) = delete;
+    ~EventHandlerTable();
+
+    //! @name manipulators
+    //@{
+
+    //! Set a handler
+    /*!
+    Sets the handler for \p type on \p target, replacing any existing
+    one.
+    */
+    void set(EventType type, const EventTarget* target, const EventHandler& handler);
+
+    //! Remove a handler
+    /*!
+    Removes the handler for \p type on \p target.  Returns true if the
+    target has no handlers left.
+    */
+    bool remove(EventType type, const EventTarget* target);
+
+    //! Remove all handlers for a target
+    void remove_all(const EventTarget* target);
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Get the targets that have at least one handler
+    std::vector<const EventTarget*> targets() const;
+
+    //@}
+
+private:
+    static const std::size_t kTypeCount = static_cast<std::size_t>(EventType::EVENT_COUNT);
+
+    struct TargetHandlers {
+        std::array<std::shared_ptr<const EventHandler>, kTypeCount> handlers;
+        std::size_t count = 0;
+    };
+
+    // a target's slot keeps its target once set, with null handlers
+    // once the target has none left, so probing never has to skip
+    // removed targets.  such slots are dropped when the hash is rebuilt.
+    struct Slot {
+        std::atomic<const EventTarget*> target{nullptr};
+        std::atomic<const TargetHandlers*> handlers{nullptr};
+    };
+
+    struct Index {
+        explicit Index(std::size_t capacity);
+
+        std::unique_ptr<Slot[]> slots;
+        std::size_t mask;
+        std::size_t used = 0;
+
+        const TargetHandlers* find(const EventTarget* target) const;
+        Slot* slot(const EventTarget* target);
+    };
+
+    // the epoch a thread started reading in, zero while it isn't.  only
+    // its own thread writes it.  aligned so threads don't share lines.
+    struct alignas(64) ReaderSlot {
+        std::atomic<std::uint64_t> epoch{0};
+        std::size_t depth = 0;
+    };
+
+    // an index or handler array that readers may still be using
+    struct Retired {
+        std::uint64_t epoch;
+        std::unique_ptr<const Index> index;
+        std::unique_ptr<const TargetHandlers> handlers;
+    };
+    using RetiredList = std::vector<Retired>;
+
+    static std::size_t hash(const EventTarget* target);
+
+    ReaderSlot* reader_slot() const;
+    void replace(const EventTarget* target, std::unique_ptr<const TargetHandlers> handlers,
+                 RetiredList& freed);
+    void collect(RetiredList& freed) const;
+    void end_read() const;
+
+private:
+    // writers hold write_mutex_.  current_ owns the handlers published
+    // in index_.
+    mutable std::mutex write_mutex_;
+    std::unordered_map<const EventTarget*, std::unique_ptr<const TargetHandlers>> current_;
+    std::unique_ptr<Index> owned_index_;
+    std::atomic<const Index*> index_;
+
+    // bumped whenever something is retired.  an item retired in epoch e
+    // is freed once no reader slot holds an epoch of e or less.
+    std::atomic<std::uint64_t> epoch_;
+    mutable RetiredList retired_;
+    mutable std::atomic<bool> has_retired_;
+
+    // one slot per thread that has read the table.  id_ tells tables
+    // apart in each thread's cached slot.
+    const std::uint64_t id_;
+    mutable std::vector<std::unique_ptr<ReaderSlot>> reader_slots_;
+    mutable std::map<std::thread::id, ReaderSlot*> reader_slot_by_thread_;
+};
+
+} // namespace inputleap
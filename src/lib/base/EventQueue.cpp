@@ -23,9 +23,12 @@
 #include "base/SimpleEventQueueBuffer.h"
 #include "base/Stopwatch.h"
 #include "base/EventTypes.h"
+#include "base/Time.h"
 #include "base/Log.h"
 #include "base/XBase.h"
 
+#include <algorithm>
+
 namespace inputleap {
 
 // interrupt handler.  this just adds a quit event to the queue.
@@ -49,8 +52,8 @@ EventQueue::~EventQueue()
     ARCH->setSignalHandler(Arch::kINTERRUPT, nullptr, nullptr);
     ARCH->setSignalHandler(Arch::kTERMINATE, nullptr, nullptr);
 
-    for (const auto& handlers : m_handlers) {
-        handlers.first->event_queue_ = nullptr;
+    for (const auto* target : m_handlers.targets()) {
+        target->event_queue_ = nullptr;
     }
 }
 
@@ -82,23 +85,18 @@ EventQueue::loop()
 
 void EventQueue::set_buffer(std::unique_ptr<IEventQueueBuffer> buffer)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::unique_lock<std::shared_mutex> lock(buffer_mutex_);
 
     LOG_DEBUG("adopting new buffer");
 
-    if (m_events.size() != 0) {
-        // this can come as a nasty surprise to programmers expecting
-        // their events to be raised, only to have them deleted.
-        LOG_DEBUG("discarding %zd event(s)", m_events.size());
-    }
-
     // discard old buffer and old events
     buffer_.reset();
-    for (auto i = m_events.begin(); i != m_events.end(); ++i) {
-        Event::deleteData(i->second);
+    std::size_t discarded = m_events.clear();
+    if (discarded != 0) {
+        // this can come as a nasty surprise to programmers expecting
+        // their events to be raised, only to have them deleted.
+        LOG_DEBUG("discarding %zd event(s)", discarded);
     }
-    m_events.clear();
-    m_oldEventIDs.clear();
 
     // use new buffer
     buffer_ = std::move(buffer);
@@ -154,11 +152,8 @@ retry:
         return true;
 
     case IEventQueueBuffer::kUser:
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            event = removeEvent(dataID);
-            return true;
-        }
+        event = m_events.remove(dataID);
+        return true;
 
     default:
         assert(0 && "invalid event type");
@@ -169,17 +164,10 @@ retry:
 bool
 EventQueue::dispatchEvent(const Event& event)
 {
-    auto* target = event.getTarget();
-
-    auto type_handler = get_handler(event.getType(), target);
-    if (type_handler) {
-        (*type_handler)(event);
-        return true;
-    }
-
-    auto any_handler = get_handler(EventType::UNKNOWN, target);
-    if (any_handler) {
-        (*any_handler)(event);
+    EventHandlerTable::Reader handlers(m_handlers);
+    const EventHandler* handler = handlers.find(event.getType(), event.getTarget());
+    if (handler != nullptr) {
+        (*handler)(event);
         return true;
     }
     return false;
@@ -211,20 +199,30 @@ void EventQueue::add_event(Event&& event)
 
 void EventQueue::add_event_to_buffer(Event&& event)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_lock<std::shared_mutex> lock(buffer_mutex_);
 
     // store the event's data locally
-    std::uint32_t eventID = save_event(std::move(event));
+    std::uint32_t eventID = m_events.insert(std::move(event));
 
     // add it
     if (!buffer_->addEvent(eventID)) {
         // failed to send event
-        auto removed_event = removeEvent(eventID);
+        auto removed_event = m_events.remove(eventID);
         Event::deleteData(removed_event);
     }
 }
 
 EventQueueTimer* EventQueue::newTimer(double duration, const EventTarget* target)
+{
+    return add_timer(duration, target, false);
+}
+
+EventQueueTimer* EventQueue::newOneShotTimer(double duration, const EventTarget* target)
+{
+    return add_timer(duration, target, true);
+}
+
+EventQueueTimer* EventQueue::add_timer(double duration, const EventTarget* target, bool one_shot)
 {
     assert(duration > 0.0);
 
@@ -232,32 +230,30 @@ EventQueueTimer* EventQueue::newTimer(double duration, const EventTarget* target
     if (target == nullptr) {
         target = timer;
     }
+    timer->target_ = target;
+    double deadline = current_time_seconds() + duration;
     std::lock_guard<std::mutex> lock(mutex_);
-    m_timers.insert(timer);
-    // initial duration is requested duration plus whatever's on
-    // the clock currently because the latter will be subtracted
-    // the next time we check for timers.
-    m_timerQueue.push(Timer(timer, duration,
-                            duration + m_time.getTime(), target, false));
+    push_timer(Timer{timer, target, deadline, duration, one_shot});
     return timer;
 }
 
-EventQueueTimer* EventQueue::newOneShotTimer(double duration, const EventTarget* target)
+void EventQueue::restartTimer(EventQueueTimer* timer, double duration)
 {
     assert(duration > 0.0);
 
-    EventQueueTimer* timer = new EventQueueTimer;
-    if (target == nullptr) {
-        target = timer;
-    }
+    double deadline = current_time_seconds() + duration;
     std::lock_guard<std::mutex> lock(mutex_);
-    m_timers.insert(timer);
-    // initial duration is requested duration plus whatever's on
-    // the clock currently because the latter will be subtracted
-    // the next time we check for timers.
-    m_timerQueue.push(Timer(timer, duration,
-                            duration + m_time.getTime(), target, true));
-    return timer;
+    if (timer->queue_index_ == EventQueueTimer::kNotQueued) {
+        // only one-shot timers leave the heap when they expire
+        push_timer(Timer{timer, timer->target_, deadline, duration, true});
+        return;
+    }
+
+    assert(timers_[timer->queue_index_].timer == timer);
+    timers_[timer->queue_index_].deadline = deadline;
+    timers_[timer->queue_index_].period = duration;
+    sift_timer_down(timer->queue_index_);
+    sift_timer_up(timer->queue_index_);
 }
 
 void
@@ -265,15 +261,10 @@ EventQueue::deleteTimer(EventQueueTimer* timer)
 {
     {
         std::lock_guard<std::mutex> lock(mutex_);
-        for (auto index = m_timerQueue.begin(); index != m_timerQueue.end(); ++index) {
-            if (index->getTimer() == timer) {
-                m_timerQueue.erase(index);
-                break;
-            }
-        }
-        auto index = m_timers.find(timer);
-        if (index != m_timers.end()) {
-            m_timers.erase(index);
+        if (timer->queue_index_ != EventQueueTimer::kNotQueued) {
+            assert(timer->queue_index_ < timers_.size());
+            assert(timers_[timer->queue_index_].timer == timer);
+            remove_timer(timer->queue_index_);
         }
     }
     delete timer;
@@ -288,7 +279,7 @@ void EventQueue::add_handler(EventType type, const EventTarget* target, const Ev
         throw std::invalid_argument("EventTarget added to wrong EventQueue");
     }
 
-    m_handlers[target][type] = std::make_shared<EventHandler>(handler);
+    m_handlers.set(type, target, handler);
 }
 
 void EventQueue::remove_handler(EventType type, const EventTarget* target)
@@ -298,17 +289,8 @@ void EventQueue::remove_handler(EventType type, const EventTarget* target)
     }
 
     std::lock_guard<std::mutex> lock(mutex_);
-    auto index = m_handlers.find(target);
-    if (index != m_handlers.end()) {
-        TypeHandlerTable& typeHandlers = index->second;
-        auto index2 = typeHandlers.find(type);
-        if (index2 != typeHandlers.end()) {
-            typeHandlers.erase(index2);
-        }
-        if (typeHandlers.empty()) {
-            m_handlers.erase(index);
-            target->event_queue_ = nullptr;
-        }
+    if (m_handlers.remove(type, target)) {
+        target->event_queue_ = nullptr;
     }
 }
 
@@ -323,102 +305,42 @@ void EventQueue::remove_handlers(const EventTarget* target)
         throw std::invalid_argument("EventTarget sent to wrong EventQueue");
     }
 
-    auto index = m_handlers.find(target);
-    if (index != m_handlers.end()) {
-        m_handlers.erase(index);
-    }
+    m_handlers.remove_all(target);
     target->event_queue_ = nullptr;
 }
 
-std::shared_ptr<EventQueue::EventHandler>
-    EventQueue::get_handler(EventType type, const EventTarget* target) const
-{
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto index = m_handlers.find(target);
-    if (index != m_handlers.end()) {
-        const TypeHandlerTable& typeHandlers = index->second;
-        auto index2 = typeHandlers.find(type);
-        if (index2 != typeHandlers.end()) {
-            return index2->second;
-        }
-    }
-    return nullptr;
-}
-
-std::uint32_t EventQueue::save_event(Event&& event)
-{
-    // choose id
-    std::uint32_t id;
-    if (!m_oldEventIDs.empty()) {
-        // reuse an id
-        id = m_oldEventIDs.back();
-        m_oldEventIDs.pop_back();
-    }
-    else {
-        // make a new id
-        id = static_cast<std::uint32_t>(m_events.size());
-    }
-
-    // save data
-    m_events[id] = std::move(event);
-    return id;
-}
-
-Event EventQueue::removeEvent(std::uint32_t eventID)
-{
-    // look up id
-    auto index = m_events.find(eventID);
-    if (index == m_events.end()) {
-        return Event();
-    }
-
-    // get data
-    Event event = std::move(index->second);
-    m_events.erase(index);
-
-    // save old id for reuse
-    m_oldEventIDs.push_back(eventID);
-
-    return event;
-}
-
 bool
 EventQueue::hasTimerExpired(Event& event)
 {
-    // return true if there's a timer in the timer priority queue that
-    // has expired.  if returning true then fill in event appropriately
-    // and reset and reinsert the timer.
-    if (m_timerQueue.empty()) {
+    // return true if the earliest timer is due.  if returning true then
+    // fill in event appropriately and move the timer to its next
+    // deadline or, if it's a one-shot, out of the heap.
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (timers_.empty()) {
         return false;
     }
 
-    // get time elapsed since last check
-    const double time = m_time.getTime();
-    m_time.reset();
-
-    // countdown elapsed time
-    for (auto index = m_timerQueue.begin(); index != m_timerQueue.end(); ++index) {
-        (*index) -= time;
-    }
-
-    // done if no timers are expired
-    if (m_timerQueue.top() > 0.0) {
+    const double now = current_time_seconds();
+    Timer& timer = timers_.front();
+    if (timer.deadline > now) {
         return false;
     }
 
-    // remove timer from queue
-    Timer timer = m_timerQueue.top();
-    m_timerQueue.pop();
-
-    // prepare event and reset the timer's clock
-    timer.fillEvent(m_timerEvent);
-    event = Event(EventType::TIMER, timer.get_target(),
+    // prepare event
+    m_timerEvent.m_timer = timer.timer;
+    m_timerEvent.m_count = 1;
+    event = Event(EventType::TIMER, timer.target,
                   create_event_data<TimerEvent*>(&m_timerEvent));
-    timer.reset();
 
-    // reinsert timer into queue if it's not a one-shot
-    if (!timer.isOneShot()) {
-        m_timerQueue.push(timer);
+    if (timer.one_shot) {
+        remove_timer(0);
+    }
+    else {
+        // count the periods that have passed, including any that were
+        // missed because the queue was busy
+        m_timerEvent.m_count += static_cast<std::uint32_t>((now - timer.deadline) / timer.period);
+        timer.deadline += m_timerEvent.m_count * timer.period;
+        sift_timer_down(0);
     }
 
     return true;
@@ -427,97 +349,91 @@ EventQueue::hasTimerExpired(Event& event)
 double
 EventQueue::getNextTimerTimeout() const
 {
-    // return -1 if no timers, 0 if the top timer has expired, otherwise
-    // the time until the top timer in the timer priority queue will
-    // expire.
-    if (m_timerQueue.empty()) {
+    // return -1 if no timers, 0 if the earliest timer is due, otherwise
+    // the time until it is.
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (timers_.empty()) {
         return -1.0;
     }
-    if (m_timerQueue.top() <= 0.0) {
-        return 0.0;
-    }
-    return m_timerQueue.top();
+    return std::max(0.0, timers_.front().deadline - current_time_seconds());
 }
 
-const EventTarget* EventQueue::getSystemTarget()
+void EventQueue::push_timer(const Timer& timer)
 {
-    return &system_target_;
+    timer.timer->queue_index_ = timers_.size();
+    timers_.push_back(timer);
+    sift_timer_up(timers_.size() - 1);
 }
 
-void
-EventQueue::waitForReady() const
+void EventQueue::remove_timer(std::size_t index)
 {
-    std::unique_lock<std::mutex> lock(ready_mutex_);
-
-    if (!ready_cv_.wait_for(lock, std::chrono::seconds{10}, [this](){ return is_ready_; })) {
-        throw std::runtime_error("event queue is not ready within 5 sec");
+    EventQueueTimer* removed = timers_[index].timer;
+    std::size_t last = timers_.size() - 1;
+    if (index != last) {
+        swap_timers(index, last);
     }
-}
-
-//
-// EventQueue::Timer
-//
-
-EventQueue::Timer::Timer(EventQueueTimer* timer, double timeout,
-                         double initialTime, const EventTarget* target, bool oneShot) :
-    m_timer(timer),
-    m_timeout(timeout),
-    target_(target),
-    m_oneShot(oneShot),
-    m_time(initialTime)
-{
-    assert(m_timeout > 0.0);
-}
+    timers_.pop_back();
+    removed->queue_index_ = EventQueueTimer::kNotQueued;
 
-EventQueue::Timer::~Timer()
-{
-    // do nothing
+    // the timer moved into the hole may belong above or below it
+    if (index < timers_.size()) {
+        sift_timer_down(index);
+        sift_timer_up(index);
+    }
 }
 
-void
-EventQueue::Timer::reset()
+void EventQueue::sift_timer_up(std::size_t index)
 {
-    m_time = m_timeout;
+    while (index > 0) {
+        std::size_t parent = (index - 1) / 2;
+        if (timers_[parent].deadline <= timers_[index].deadline) {
+            break;
+        }
+        swap_timers(index, parent);
+        index = parent;
+    }
 }
 
-EventQueue::Timer&
-EventQueue::Timer::operator-=(double dt)
+void EventQueue::sift_timer_down(std::size_t index)
 {
-    m_time -= dt;
-    return *this;
+    for (;;) {
+        std::size_t earliest = index;
+        std::size_t left = 2 * index + 1;
+        std::size_t right = left + 1;
+        if (left < timers_.size() && timers_[left].deadline < timers_[earliest].deadline) {
+            earliest = left;
+        }
+        if (right < timers_.size() && timers_[right].deadline < timers_[earliest].deadline) {
+            earliest = right;
+        }
+        if (earliest == index) {
+            break;
+        }
+        swap_timers(index, earliest);
+        index = earliest;
+    }
 }
 
-EventQueue::Timer::operator double() const
+void EventQueue::swap_timers(std::size_t a, std::size_t b)
 {
-    return m_time;
+    std::swap(timers_[a], timers_[b]);
+    timers_[a].timer->queue_index_ = a;
+    timers_[b].timer->queue_index_ = b;
 }
 
-bool
-EventQueue::Timer::isOneShot() const
-{
-    return m_oneShot;
-}
-
-EventQueueTimer*
-EventQueue::Timer::getTimer() const
+const EventTarget* EventQueue::getSystemTarget()
 {
-    return m_timer;
+    return &system_target_;
 }
 
 void
-EventQueue::Timer::fillEvent(TimerEvent& event) const
+EventQueue::waitForReady() const
 {
-    event.m_timer = m_timer;
-    event.m_count = 0;
-    if (m_time <= 0.0) {
-        event.m_count = static_cast<std::uint32_t>((m_timeout - m_time) / m_timeout);
-    }
-}
+    std::unique_lock<std::mutex> lock(ready_mutex_);
 
-bool
-EventQueue::Timer::operator<(const Timer& t) const
-{
-    return m_time < t.m_time;
+    if (!ready_cv_.wait_for(lock, std::chrono::seconds{10}, [this](){ return is_ready_; })) {
+        throw std::runtime_error("event queue is not ready within 5 sec");
+    }
 }
 
 } // namespace inputleap
@@ -22,15 +22,16 @@
 #include "EventTarget.h"
 #include "base/IEventQueue.h"
 #include "base/Event.h"
-#include "base/PriorityQueue.h"
-#include "base/Stopwatch.h"
+#include "base/EventHandlerTable.h"
+#include "base/EventRing.h"
 
 #include <condition_variable>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <queue>
-#include <set>
+#include <shared_mutex>
+#include <vector>
 
 namespace inputleap {
 
@@ -52,6 +53,7 @@ public:
     void add_event(Event&& event) override;
     EventQueueTimer* newTimer(double duration, const EventTarget* target) override;
     EventQueueTimer* newOneShotTimer(double duration, const EventTarget* target) override;
+    void restartTimer(EventQueueTimer*, double duration) override;
     void deleteTimer(EventQueueTimer*) override;
     void add_handler(EventType type, const EventTarget* target,
                      const EventHandler& handler) override;
@@ -61,70 +63,51 @@ public:
     void waitForReady() const override;
 
 private:
-    std::uint32_t save_event(Event&& event);
-    Event removeEvent(std::uint32_t eventID);
+    // a timer, due at an absolute time on the current_time_seconds()
+    // clock.  repeating timers move their deadline on by whole periods
+    // so they don't drift.
+    struct Timer {
+        EventQueueTimer* timer;
+        const EventTarget* target;
+        double deadline;
+        double period;
+        bool one_shot;
+    };
+
     bool hasTimerExpired(Event& event);
     double getNextTimerTimeout() const;
     void add_event_to_buffer(Event&& event);
 
-private:
-    class Timer {
-    public:
-        Timer(EventQueueTimer*, double timeout, double initialTime,
-              const EventTarget* target, bool oneShot);
-        ~Timer();
-
-        void reset();
-
-        Timer& operator-=(double);
-        operator double() const;
-
-        bool isOneShot() const;
-        EventQueueTimer* getTimer() const;
-        const EventTarget* get_target() const { return target_; }
-        void fillEvent(TimerEvent&) const;
-
-        bool operator<(const Timer&) const;
-
-    private:
-        EventQueueTimer* m_timer;
-        double m_timeout;
-        const EventTarget* target_;
-        bool m_oneShot;
-        double m_time;
-    };
+    EventQueueTimer* add_timer(double duration, const EventTarget* target, bool one_shot);
 
-    typedef std::set<EventQueueTimer*> Timers;
-    typedef PriorityQueue<Timer> TimerQueue;
-    typedef std::map<std::uint32_t, Event> EventTable;
-    typedef std::vector<std::uint32_t> EventIDList;
-    using TypeHandlerTable = std::map<EventType, std::shared_ptr<EventHandler>>;
-    using HandlerTable = std::map<const EventTarget*, TypeHandlerTable>;
+    // timer heap maintenance.  each timer's queue_index_ follows its
+    // entry around the heap.
+    void push_timer(const Timer& timer);
+    void remove_timer(std::size_t index);
+    void sift_timer_up(std::size_t index);
+    void sift_timer_down(std::size_t index);
+    void swap_timers(std::size_t a, std::size_t b);
 
+private:
     EventTarget system_target_;
     mutable std::mutex mutex_;
 
-    // buffer of events
+    // buffer of events.  producers hold buffer_mutex_ shared while
+    // adding events, set_buffer() holds it exclusively.
+    std::shared_mutex buffer_mutex_;
     std::unique_ptr<IEventQueueBuffer> buffer_;
 
     // saved events
-    EventTable m_events;
-    EventIDList m_oldEventIDs;
+    EventRing m_events;
 
-    // timers
-    Stopwatch m_time;
-    Timers m_timers;
-    TimerQueue m_timerQueue;
+    // timers, a binary heap with the earliest deadline first
+    std::vector<Timer> timers_;
     TimerEvent m_timerEvent;
 
     // event handlers
-    HandlerTable m_handlers;
+    EventHandlerTable m_handlers;
 
 private:
-    // returns nullptr if handler is not found
-
-    std::shared_ptr<EventHandler> get_handler(EventType type, const EventTarget* target) const;
-
     mutable std::mutex          ready_mutex_;
     mutable std::condition_variable ready_cv_;
     bool                        is_ready_ = false;
@@ -18,12 +18,28 @@
 #pragma once
 
 #include "EventTarget.h"
+#include <cstddef>
 
 namespace inputleap {
 
+class EventQueue;
+
 class EventQueueTimer : public EventTarget {
 public:
     virtual ~EventQueueTimer() = default;
+
+private:
+    friend class EventQueue;
+
+    static constexpr std::size_t kNotQueued = static_cast<std::size_t>(-1);
+
+    // position in the timer heap of the EventQueue that created the timer, so deleting it
+    // doesn't have to search the heap
+    std::size_t queue_index_ = kNotQueued;
+
+    // the target of the timer's events, so an expired one-shot timer
+    // can be queued again
+    const EventTarget* target_ = nullptr;
 };
 
 } // namespace inputleap
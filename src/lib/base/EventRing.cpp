@@ -0,0 +1,155 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/EventRing.h"
+
+#include <utility>
+
+namespace inputleap {
+
+EventRing::EventRing() :
+    slots_(new Slot[kCapacity]),
+    tail_(0),
+    head_(0)
+{
+    for (std::uint32_t i = 0; i < kCapacity; ++i) {
+        slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+EventRing::~EventRing()
+{
+    clear();
+}
+
+std::uint32_t EventRing::insert(Event&& event)
+{
+    std::uint64_t pos = tail_.load(std::memory_order_relaxed);
+    for (;;) {
+        Slot& slot = slots_[pos & kMask];
+        std::uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<std::int64_t>(sequence - pos);
+        if (diff == 0) {
+            // slot is free for this position, try to claim it
+            if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                slot.event = std::move(event);
+                slot.sequence.store(pos + 1, std::memory_order_release);
+                return static_cast<std::uint32_t>(pos & kMask);
+            }
+        } else if (diff < 0) {
+            // slot still holds an event from the previous lap
+            return insert_overflow(std::move(event));
+        } else {
+            // another producer claimed this position
+            pos = tail_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+Event EventRing::remove(std::uint32_t id)
+{
+    if (id >= kCapacity) {
+        return remove_overflow(id);
+    }
+
+    Slot& slot = slots_[id];
+    std::uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+    if ((sequence & kMask) != ((id + 1) & kMask)) {
+        return Event();
+    }
+
+    Event event = std::exchange(slot.event, Event());
+
+    // free the slot for the next lap
+    slot.sequence.store(sequence - 1 + kCapacity, std::memory_order_release);
+    advance_head();
+    return event;
+}
+
+std::size_t EventRing::clear()
+{
+    // only positions from head_ up to tail_ can hold events, and no
+    // more than a lap of them
+    std::size_t count = 0;
+    std::uint64_t tail = tail_.load(std::memory_order_acquire);
+    std::uint64_t head = head_.load(std::memory_order_relaxed);
+    if (tail - head > kCapacity) {
+        head = tail - kCapacity;
+    }
+    for (; head != tail; ++head) {
+        Event event = remove(static_cast<std::uint32_t>(head & kMask));
+        if (event.getType() != EventType::UNKNOWN) {
+            Event::deleteData(event);
+            ++count;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(overflow_mutex_);
+    for (const auto& event : overflow_) {
+        if (event.getType() != EventType::UNKNOWN) {
+            Event::deleteData(event);
+            ++count;
+        }
+    }
+    overflow_.clear();
+    overflow_free_ids_.clear();
+    return count;
+}
+
+void EventRing::advance_head()
+{
+    // a position is done once its slot is free for, or in use by, a
+    // later lap.  sequences only grow so this never skips an event.
+    std::uint64_t start = head_.load(std::memory_order_relaxed);
+    std::uint64_t tail = tail_.load(std::memory_order_acquire);
+    std::uint64_t head = start;
+    while (head != tail &&
+           slots_[head & kMask].sequence.load(std::memory_order_acquire) >= head + kCapacity) {
+        ++head;
+    }
+    if (head != start) {
+        head_.store(head, std::memory_order_relaxed);
+    }
+}
+
+std::uint32_t EventRing::insert_overflow(Event&& event)
+{
+    std::lock_guard<std::mutex> lock(overflow_mutex_);
+    std::uint32_t index;
+    if (!overflow_free_ids_.empty()) {
+        index = overflow_free_ids_.back();
+        overflow_free_ids_.pop_back();
+        overflow_[index] = std::move(event);
+    } else {
+        index = static_cast<std::uint32_t>(overflow_.size());
+        overflow_.push_back(std::move(event));
+    }
+    return kCapacity + index;
+}
+
+Event EventRing::remove_overflow(std::uint32_t id)
+{
+    std::lock_guard<std::mutex> lock(overflow_mutex_);
+    std::uint32_t index = id - kCapacity;
+    if (index >= overflow_.size() || overflow_[index].getType() == EventType::UNKNOWN) {
+        return Event();
+    }
+    overflow_free_ids_.push_back(index);
+    return std::exchange(overflow_[index], Event());
+}
+
+} // namespace inputleap
@@ -0,0 +1,114 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/Event.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace inputleap {
+
+//! Multi-producer single-consumer event storage
+/*!
+Stores events on behalf of an event queue and identifies each with a
+small integer id that can be passed through an IEventQueueBuffer.  Any
+thread may insert() events.  Events are written into a bounded ring of
+slots without locking;  slots are claimed in ring order but may be
+removed in any order, so the store does not depend on the order in
+which a buffer hands back ids.  When the slot at the head of the ring
+is still in use the event spills into a mutex protected overflow list
+instead of blocking the producer, which may be the consumer itself, so
+the ring only needs to cover the usual backlog.
+*/
+class EventRing {
+public:
+    //! Number of slots in the ring, a power of two
+    static const std::uint32_t kCapacity = 1024;
+
+    EventRing();
+    EventRing(const EventRing&) = delete;
+    EventRing& operator=(const EventRing&) = delete;
+    ~EventRing();
+
+    //! @name manipulators
+    //@{
+
+    //! Store an event
+    /*!
+    Takes ownership of \p event and returns its id.  Thread safe.
+    */
+    std::uint32_t insert(Event&& event);
+
+    //! Take an event
+    /*!
+    Returns the event stored under \p id and frees the id.  Returns an
+    empty event if there is no such event.  Only one thread may remove
+    a given id:  the consumer for ids it received from a buffer, or the
+    producer that inserted it if the id was never handed out.
+    */
+    Event remove(std::uint32_t id);
+
+    //! Discard all events
+    /*!
+    Deletes the data of all stored events and returns how many there
+    were.  No insert() or remove() may run concurrently.
+    */
+    std::size_t clear();
+
+    //@}
+
+private:
+    struct Slot {
+        // equals the ring position the slot is free for, or that
+        // position plus one while it holds an event
+        std::atomic<std::uint64_t> sequence;
+        Event event;
+    };
+
+    static const std::uint32_t kMask = kCapacity - 1;
+    static_assert((kCapacity & kMask) == 0, "capacity must be a power of two");
+
+    // moves head_ past the positions whose events have been removed
+    void advance_head();
+
+    std::uint32_t insert_overflow(Event&& event);
+    Event remove_overflow(std::uint32_t id);
+
+private:
+    std::unique_ptr<Slot[]> slots_;
+
+    // next ring position to claim.  kept on its own cache line since
+    // every producer writes it.
+    alignas(64) std::atomic<std::uint64_t> tail_;
+
+    // no position before head_ holds an event.  it may lag behind when
+    // events are removed out of order or by several threads at once.
+    alignas(64) std::atomic<std::uint64_t> head_;
+
+    // events that did not fit in the ring.  their ids start at kCapacity.
+    alignas(64) std::mutex overflow_mutex_;
+    std::vector<Event> overflow_;
+    std::vector<std::uint32_t> overflow_free_ids_;
+};
+
+} // namespace inputleap
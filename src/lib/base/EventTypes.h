@@ -271,8 +271,10 @@ enum class EventType : std::uint32_t {
     */
     CLIPBOARD_CHANGED,
 
-    /// This event is sent whenever a clipboard chunk is transferred.
-    CLIPBOARD_SENDING,
+    /** This event is sent whenever an application asks for clipboard data that was promised
+        but hasn't been supplied yet.  The data is an instance of a ClipboardFormatInfo.
+    */
+    CLIPBOARD_FORMAT_REQUESTED,
 
     /// This event is sent whenever a file chunk is transferred.
     FILE_CHUNK_SENDING,
@@ -123,6 +123,16 @@ public:
     */
     virtual EventQueueTimer* newOneShotTimer(double duration, const EventTarget* target) = 0;
 
+    //! Restart a timer
+    /*!
+    Makes \p timer expire \p duration seconds from now, whether it's
+    still pending or a one-shot timer that has already expired.  A
+    recurring timer then repeats every \p duration seconds.  This is
+    cheaper than deleting the timer and creating a new one, and the
+    timer's handler stays in place.
+    */
+    virtual void restartTimer(EventQueueTimer*, double duration) = 0;
+
     //! Destroy a timer
     /*!
     Destroys a previously created timer.  The timer is removed from the
@@ -68,6 +68,13 @@ public:
     */
     virtual bool write(ELevel level, const char* message) = 0;
 
+    //! Flush written messages
+    /*!
+    Called after a message or a batch of messages was written, so an
+    outputter can buffer messages until then.  The default does nothing.
+    */
+    virtual void flush() { }
+
     //@}
 };
 
@@ -19,12 +19,17 @@
 #include "arch/Arch.h"
 #include "arch/XArch.h"
 #include "base/Log.h"
+#include "base/LogFormat.h"
+#include "base/LogRing.h"
 #include "base/log_outputters.h"
 #include "common/Version.h"
+#include "mt/Thread.h"
 
+#include <chrono>
 #include <cstdio>
 #include <cstring>
 #include <iostream>
+#include <thread>
 #include <ctime>
 #include <vector>
 
@@ -55,30 +60,96 @@ static const int        g_defaultMaxPriority = kDEBUG;
 static const int        g_defaultMaxPriority = kINFO;
 #endif
 
+// how long the writer thread collects messages before writing them
+static const std::chrono::milliseconds g_writerBatchDelay(5);
+
+// identifies the log a thread's ring belongs to
+static std::atomic<std::uint64_t> g_nextLogId(1);
+
+// true on the writer thread, which must never wait for itself
+static thread_local bool g_isWriterThread = false;
+
+// longest line written, including the prefix and the location
+static const size_t g_maxLine = LogRing::kMaxMessage + 256;
+
+// formats the timestamp prefix, which only changes once a second
+static const char* formatTime(std::time_t t)
+{
+    thread_local std::time_t cachedTime = -1;
+    thread_local char cachedText[32];
+
+    if (t != cachedTime) {
+        struct tm tm;
+#if SYSAPI_WIN32
+        localtime_s(&tm, &t);
+#else
+        localtime_r(&t, &tm);
+#endif
+        std::snprintf(cachedText, sizeof(cachedText), "%04i-%02i-%02iT%02i:%02i:%02i",
+                      tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+                      tm.tm_hour, tm.tm_min, tm.tm_sec);
+        cachedTime = t;
+    }
+    return cachedText;
+}
+
+// formats a record into a line for the outputters
+static const char* formatRecord(const LogRing::Record& record, char* line, size_t size)
+{
+    // do not prefix time and file for kPRINT (CLOG_PRINT)
+    if (record.m_level == kPRINT) {
+        if (record.m_format == nullptr) {
+            return record.m_message;
+        }
+        formatLogArgs(record.m_format, record.m_message, line, size);
+        return line;
+    }
+
+    const char* message = record.m_message;
+    char deferred[LogRing::kMaxMessage];
+    if (record.m_format != nullptr) {
+        formatLogArgs(record.m_format, record.m_message, deferred, sizeof(deferred));
+        message = deferred;
+    }
+
+#ifndef NDEBUG
+    std::snprintf(line, size, "[%s] %s: %s\n\t%s,%d", formatTime(record.m_time),
+                  g_priority[record.m_level], message, record.m_file, record.m_line);
+#else
+    std::snprintf(line, size, "[%s] %s: %s", formatTime(record.m_time),
+                  g_priority[record.m_level], message);
+#endif
+    return line;
+}
+
 //
 // Log
 //
 
 Log* Log::s_log = nullptr;
 
-Log::Log()
+Log::Log() :
+    m_maxPriority(g_defaultMaxPriority),
+    m_id(g_nextLogId++)
 {
     assert(s_log == nullptr);
 
     // other initialization
-    m_maxPriority = g_defaultMaxPriority;
     insert(new ConsoleLogOutputter);
 
     s_log = this;
 }
 
-Log::Log(Log* src)
+Log::Log(Log* src) :
+    m_maxPriority(g_defaultMaxPriority)
 {
     s_log = src;
 }
 
 Log::~Log()
 {
+    setAsync(false);
+
     // clean up
     for (auto index= m_outputters.begin(); index != m_outputters.end(); ++index) {
         delete *index;
@@ -118,48 +189,75 @@ Log::print(ELevel priority, const char* file, int line, const char* fmt, ...)
         return;
     }
 
-    std::vector<char> buffer(2048);
-    int offset = 0;
-    size_t remaining = buffer.size();
-    int n;
+    // errors and prints are written right away.  everything else is
+    // buffered for the writer thread, if there is one.
+    thread_local LogRing::Record scratch;
+    LogRing* ring = nullptr;
+    LogRing::Record* record = &scratch;
+    if (priority > kERROR && m_async.load(std::memory_order_acquire)) {
+        ring = getThreadRing();
+        while ((record = ring->reserve()) == nullptr) {
+            if (!m_async.load(std::memory_order_acquire)) {
+                ring = nullptr;
+                record = &scratch;
+                break;
+            }
 
-    // print the prefix to the buffer
-    // do not prefix time and file for kPRINT (CLOG_PRINT)
-    if (priority != kPRINT) {
-        struct tm *tm;
-        time_t t;
-        time(&t);
-        tm = localtime(&t);
-
-        offset = std::snprintf(buffer.data(), remaining, "[%04i-%02i-%02iT%02i:%02i:%02i] %s: ",
-                               tm->tm_year + 1900, tm->tm_mon+1, tm->tm_mday, tm->tm_hour, tm->tm_min, tm->tm_sec,
-                               g_priority[priority]);
-        if (offset == -1) {
-            output(kERROR, "Failed to print to log");
-            return;
+            // the writer is behind;  make sure it isn't sleeping or
+            // waiting for a batch to collect, then wait for it
+            if (!m_ringFull.exchange(true)) {
+                std::lock_guard<std::mutex> lock(m_writerMutex);
+                m_writerIdle = false;
+                m_wakeWriter.notify_one();
+            }
+            std::this_thread::yield();
         }
-
-        remaining -= offset;
     }
 
-    // now print our actual message
+    record->m_level = priority;
+    record->m_time = std::time(nullptr);
+    record->m_file = file;
+    record->m_line = line;
+
+    // buffered messages are formatted by the writer thread from a copy
+    // of the arguments.  the format is a literal, see LOG().
     va_list args;
     va_start(args, fmt);
-    n = std::vsnprintf(buffer.data() + offset, remaining, fmt, args);
+    if (ring != nullptr && captureLogArgs(fmt, args, record->m_message, sizeof(record->m_message))) {
+        record->m_format = fmt;
+    }
+    else {
+        record->m_format = nullptr;
+        int n = std::vsnprintf(record->m_message, sizeof(record->m_message), fmt, args);
+        if (n < 0) {
+            std::snprintf(record->m_message, sizeof(record->m_message),
+                          "Failed to print to log (invalid arguments)");
+            record->m_level = kERROR;
+        }
+    }
     va_end(args);
-    if (n == -1) {
-        output(kERROR, "Failed to print to log (invalid arguments)");
+
+    if (ring != nullptr) {
+        ring->commit();
+
+        // wake the writer if it's asleep.  the fence pairs with the one
+        // in writerLoop() so either this sees the writer idle or the
+        // writer sees the message.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_writerIdle.load(std::memory_order_relaxed) && m_writerIdle.exchange(false)) {
+            std::lock_guard<std::mutex> lock(m_writerMutex);
+            m_wakeWriter.notify_one();
+        }
         return;
     }
 
-    remaining -= n;
-    offset += n;
-
-#ifndef NDEBUG
-    n = std::snprintf(buffer.data() + offset, remaining - offset, "\n\t%s,%d", file, line);
-#endif
+    // keep the order of messages buffered before this one
+    if (m_async.load(std::memory_order_acquire)) {
+        flush();
+    }
 
-    output(priority, buffer.data());
+    thread_local char buffer[g_maxLine];
+    output(record->m_level, formatRecord(*record, buffer, sizeof(buffer)));
 }
 
 void
@@ -224,15 +322,60 @@ Log::setFilter(const char* maxPriority)
 void
 Log::setFilter(int maxPriority)
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_maxPriority = maxPriority;
+    m_maxPriority.store(maxPriority, std::memory_order_relaxed);
 }
 
-int
-Log::getFilter() const
+void
+Log::setAsync(bool async)
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    return m_maxPriority;
+    if (async == (m_writer != nullptr)) {
+        return;
+    }
+
+    if (async) {
+        {
+            std::lock_guard<std::mutex> lock(m_writerMutex);
+            m_stopWriter = false;
+            m_writerRunning = true;
+        }
+        m_writer = std::make_unique<Thread>([this]() { writerLoop(); });
+        m_async.store(true, std::memory_order_release);
+    }
+    else {
+        m_async.store(false, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(m_writerMutex);
+            m_stopWriter = true;
+            m_wakeWriter.notify_one();
+        }
+        m_writer->wait();
+        m_writer.reset();
+        {
+            std::lock_guard<std::mutex> lock(m_writerMutex);
+            m_writerRunning = false;
+        }
+
+        // write whatever was buffered while the writer was stopping
+        while (writeRings()) {
+        }
+        flushOutputters();
+    }
+}
+
+void
+Log::flush()
+{
+    if (g_isWriterThread) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(m_writerMutex);
+    if (!m_writerRunning) {
+        return;
+    }
+    std::uint64_t ticket = ++m_flushRequested;
+    m_writerIdle = false;
+    m_wakeWriter.notify_one();
+    m_flushed.wait(lock, [this, ticket]() { return m_flushDone >= ticket || m_stopWriter; });
 }
 
 void
@@ -259,6 +402,134 @@ Log::output(ELevel priority, const char* msg)
             break;
         }
     }
+
+    if (!m_async.load(std::memory_order_relaxed) || priority <= kERROR) {
+        for (auto outputter : m_alwaysOutputters) {
+            outputter->flush();
+        }
+        for (auto outputter : m_outputters) {
+            outputter->flush();
+        }
+    }
+}
+
+void
+Log::flushOutputters()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto outputter : m_alwaysOutputters) {
+        outputter->flush();
+    }
+    for (auto outputter : m_outputters) {
+        outputter->flush();
+    }
+}
+
+LogRing*
+Log::getThreadRing()
+{
+    struct ThreadRing {
+        std::uint64_t m_owner = 0;
+        std::shared_ptr<LogRing> m_ring;
+    };
+    thread_local ThreadRing local;
+
+    if (local.m_owner != m_id) {
+        local.m_ring = std::make_shared<LogRing>();
+        local.m_owner = m_id;
+        std::lock_guard<std::mutex> lock(m_ringMutex);
+        m_rings.push_back(local.m_ring);
+    }
+    return local.m_ring.get();
+}
+
+bool
+Log::writeRings()
+{
+    std::vector<std::shared_ptr<LogRing>> rings;
+    {
+        // forget the rings of threads that are gone once they're empty
+        std::lock_guard<std::mutex> lock(m_ringMutex);
+        for (auto i = m_rings.begin(); i != m_rings.end(); ) {
+            if (i->use_count() == 1 && (*i)->empty()) {
+                i = m_rings.erase(i);
+            }
+            else {
+                ++i;
+            }
+        }
+        rings = m_rings;
+    }
+
+    bool wrote = false;
+    char line[g_maxLine];
+    for (const auto& ring : rings) {
+        const LogRing::Record* record;
+        while ((record = ring->front()) != nullptr) {
+            output(record->m_level, formatRecord(*record, line, sizeof(line)));
+            ring->pop();
+            wrote = true;
+        }
+    }
+    return wrote;
+}
+
+void
+Log::writerLoop()
+{
+    g_isWriterThread = true;
+
+    std::unique_lock<std::mutex> lock(m_writerMutex);
+    while (true) {
+        std::uint64_t flushTicket = m_flushRequested;
+        bool stop = m_stopWriter;
+        m_ringFull = false;
+        lock.unlock();
+
+        // write until every ring is empty, then flush the outputters
+        // once for the whole batch
+        bool wrote = false;
+        while (writeRings()) {
+            wrote = true;
+        }
+        if (wrote) {
+            flushOutputters();
+        }
+
+        lock.lock();
+        m_flushDone = flushTicket;
+        m_flushed.notify_all();
+        if (stop) {
+            break;
+        }
+
+        if (wrote) {
+            // let more messages collect before writing again
+            m_wakeWriter.wait_for(lock, g_writerBatchDelay, [this, flushTicket]() {
+                return m_stopWriter || m_ringFull || m_flushRequested != flushTicket;
+            });
+        }
+        else {
+            // sleep until a thread buffers a message.  check the rings
+            // again after saying so, a message may have been buffered
+            // while the writer was busy.
+            m_writerIdle = true;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            bool empty = true;
+            {
+                std::lock_guard<std::mutex> ringLock(m_ringMutex);
+                for (const auto& ring : m_rings) {
+                    empty = empty && ring->empty();
+                }
+            }
+            if (empty) {
+                m_wakeWriter.wait(lock, [this, flushTicket]() {
+                    return !m_writerIdle || m_stopWriter || m_flushRequested != flushTicket;
+                });
+            }
+            m_writerIdle = false;
+        }
+    }
 }
 
 } // namespace inputleap
@@ -24,14 +24,20 @@
 #include "common/common.h"
 
 #include <stdarg.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
 #include <list>
+#include <memory>
 #include <mutex>
+#include <vector>
 
 #define CLOG (Log::getInstance())
 #define BYE "\nTry `%s --help' for more information."
 
 namespace inputleap {
 
+class LogRing;
 class Thread;
 
 //! Logging facility
@@ -40,6 +46,8 @@ The logging class;  all console output should go through this class.
 It supports multithread safe operation, several message priority levels,
 filtering by priority, and output redirection.  The macros LOG_DEBUG(),
 LOG_INFO() etc. provide convenient access.
+
+Messages can be written by a background thread, see setAsync().
 */
 class Log {
 public:
@@ -96,6 +104,26 @@ public:
     //! Set the minimum priority filter (by ordinal).
     void setFilter(int);
 
+    //! Write messages on a background thread
+    /*!
+    If \c async is true, print() only formats a message into a buffer
+    owned by the calling thread and a writer thread passes the buffered
+    messages to the outputters in batches.  Errors, fatal errors and
+    \c kPRINT messages are still written before print() returns, after
+    everything buffered before them.  Disabling it writes the buffered
+    messages and stops the writer thread.
+
+    Threads don't survive a fork(), so enable this after daemonizing.
+    */
+    void setAsync(bool async);
+
+    //! Write buffered messages
+    /*!
+    Waits until the writer thread has written every message buffered
+    so far.  Does nothing unless setAsync() enabled the writer.
+    */
+    void flush();
+
     //@}
     //! @name accessors
     //@{
@@ -112,7 +140,7 @@ public:
                const char* format, ...);
 
     //! Get the minimum priority level.
-    int getFilter() const;
+    int getFilter() const { return m_maxPriority.load(std::memory_order_relaxed); }
 
     //! Get the filter name of the current filter level.
     const char* getFilterName() const;
@@ -130,6 +158,10 @@ public:
 
 private:
     void output(ELevel priority, const char* msg);
+    void flushOutputters();
+    LogRing* getThreadRing();
+    bool writeRings();
+    void writerLoop();
 
 private:
     typedef std::list<ILogOutputter*> OutputterList;
@@ -139,7 +171,23 @@ private:
     mutable std::mutex m_mutex;
     OutputterList m_outputters;
     OutputterList m_alwaysOutputters;
-    int m_maxPriority;
+    std::atomic<int> m_maxPriority;
+
+    // asynchronous writing
+    std::uint64_t m_id = 0;
+    std::atomic<bool> m_async{false};
+    std::mutex m_ringMutex;
+    std::vector<std::shared_ptr<LogRing>> m_rings;
+    std::unique_ptr<Thread> m_writer;
+    std::mutex m_writerMutex;
+    std::condition_variable m_wakeWriter;
+    std::condition_variable m_flushed;
+    std::atomic<bool> m_writerIdle{false};
+    std::atomic<bool> m_ringFull{false};
+    bool m_writerRunning = false;
+    bool m_stopWriter = false;
+    std::uint64_t m_flushRequested = 0;
+    std::uint64_t m_flushDone = 0;
 };
 
 /*!
@@ -156,15 +204,34 @@ not be filtered and is never prefixed by the filename and line number.
 If \c NOLOGGING is defined during the build then this macro expands to
 nothing.  If \c NDEBUG is defined during the build then it expands to a
 call to Log::print.  Otherwise it expands to a call to Log::printt,
-which includes the filename and line number.
+which includes the filename and line number.  Either way the priority
+is checked first, so the arguments of a filtered message are never
+evaluated.
+
+Priorities above \c INPUTLEAP_LOG_MAX_LEVEL (set from the CMake option
+of the same name) are compiled out, whatever the filter is at runtime.
+The format must be a string literal:  the writer thread formats buffered
+messages after print() returns.
 */
 
+#if !defined(INPUTLEAP_LOG_MAX_LEVEL)
+#define INPUTLEAP_LOG_MAX_LEVEL kDEBUG5
+#endif
+
 #if defined(NOLOGGING)
 #define LOG(...) do { } while(0)
 #elif defined(NDEBUG)
-#define LOG(pri_, ...) CLOG->print(pri_, nullptr, 0, __VA_ARGS__)
+#define LOG(pri_, ...) do { \
+        if ((pri_) <= INPUTLEAP_LOG_MAX_LEVEL && (pri_) <= CLOG->getFilter()) { \
+            CLOG->print(pri_, nullptr, 0, "" __VA_ARGS__); \
+        } \
+    } while (0)
 #else
-#define LOG(pri_, ...) CLOG->print(pri_, __FILE__, __LINE__, __VA_ARGS__)
+#define LOG(pri_, ...) do { \
+        if ((pri_) <= INPUTLEAP_LOG_MAX_LEVEL && (pri_) <= CLOG->getFilter()) { \
+            CLOG->print(pri_, __FILE__, __LINE__, "" __VA_ARGS__); \
+        } \
+    } while (0)
 #endif
 
 // the CLOG_* defines %z and an octal number (060=0, 071=9),
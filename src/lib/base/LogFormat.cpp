@@ -0,0 +1,482 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/LogFormat.h"
+
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace inputleap {
+
+namespace {
+
+// one conversion of a printf style format
+struct Conversion {
+    const char* m_flags;
+    std::size_t m_numFlags;
+    bool m_widthArg;
+    const char* m_width;
+    std::size_t m_widthSize;
+    bool m_hasPrecision;
+    bool m_precisionArg;
+    const char* m_precision;
+    std::size_t m_precisionSize;
+    char m_length[3];
+    char m_type;
+};
+
+// parses the conversion after a '%', returns the end of it
+const char* parseConversion(const char* p, Conversion& conversion)
+{
+    conversion.m_flags = p;
+    while (*p != '\0' && std::strchr("-+ #0", *p) != nullptr) {
+        ++p;
+    }
+    conversion.m_numFlags = p - conversion.m_flags;
+
+    conversion.m_widthArg = (*p == '*');
+    conversion.m_width = p;
+    if (conversion.m_widthArg) {
+        ++p;
+    }
+    while (*p >= '0' && *p <= '9') {
+        ++p;
+    }
+    conversion.m_widthSize = p - conversion.m_width;
+
+    conversion.m_hasPrecision = (*p == '.');
+    conversion.m_precisionArg = false;
+    conversion.m_precision = p;
+    if (conversion.m_hasPrecision) {
+        ++p;
+        conversion.m_precisionArg = (*p == '*');
+        if (conversion.m_precisionArg) {
+            ++p;
+        }
+        while (*p >= '0' && *p <= '9') {
+            ++p;
+        }
+    }
+    conversion.m_precisionSize = p - conversion.m_precision;
+
+    std::size_t length = 0;
+    while (length < 2 && *p != '\0' && std::strchr("hlzjtL", *p) != nullptr) {
+        conversion.m_length[length++] = *p++;
+    }
+    conversion.m_length[length] = '\0';
+
+    conversion.m_type = *p;
+    return *p == '\0' ? p : p + 1;
+}
+
+bool isLength(const Conversion& conversion, const char* length)
+{
+    return std::strcmp(conversion.m_length, length) == 0;
+}
+
+class ArgWriter {
+public:
+    ArgWriter(char* buffer, std::size_t size) : m_next(buffer), m_end(buffer + size) { }
+
+    template <typename T>
+    bool put(T value)
+    {
+        return putBytes(&value, sizeof(value));
+    }
+
+    bool putBytes(const void* data, std::size_t size)
+    {
+        if (size > static_cast<std::size_t>(m_end - m_next)) {
+            return false;
+        }
+        std::memcpy(m_next, data, size);
+        m_next += size;
+        return true;
+    }
+
+private:
+    char* m_next;
+    char* m_end;
+};
+
+class ArgReader {
+public:
+    explicit ArgReader(const char* args) : m_next(args) { }
+
+    template <typename T>
+    T get()
+    {
+        T value;
+        std::memcpy(&value, m_next, sizeof(value));
+        m_next += sizeof(value);
+        return value;
+    }
+
+    const char* getString()
+    {
+        const char* s = m_next;
+        m_next += std::strlen(s) + 1;
+        return s;
+    }
+
+private:
+    const char* m_next;
+};
+
+bool captureSigned(const Conversion& conversion, va_list& args, ArgWriter& writer)
+{
+    long long value;
+    if (isLength(conversion, "hh")) {
+        value = static_cast<signed char>(va_arg(args, int));
+    }
+    else if (isLength(conversion, "h")) {
+        value = static_cast<short>(va_arg(args, int));
+    }
+    else if (isLength(conversion, "")) {
+        value = va_arg(args, int);
+    }
+    else if (isLength(conversion, "l")) {
+        value = va_arg(args, long);
+    }
+    else if (isLength(conversion, "ll")) {
+        value = va_arg(args, long long);
+    }
+    else if (isLength(conversion, "z") || isLength(conversion, "t")) {
+        value = va_arg(args, std::ptrdiff_t);
+    }
+    else if (isLength(conversion, "j")) {
+        value = va_arg(args, std::intmax_t);
+    }
+    else {
+        return false;
+    }
+    return writer.put(value);
+}
+
+bool captureUnsigned(const Conversion& conversion, va_list& args, ArgWriter& writer)
+{
+    unsigned long long value;
+    if (isLength(conversion, "hh")) {
+        value = static_cast<unsigned char>(va_arg(args, unsigned int));
+    }
+    else if (isLength(conversion, "h")) {
+        value = static_cast<unsigned short>(va_arg(args, unsigned int));
+    }
+    else if (isLength(conversion, "")) {
+        value = va_arg(args, unsigned int);
+    }
+    else if (isLength(conversion, "l")) {
+        value = va_arg(args, unsigned long);
+    }
+    else if (isLength(conversion, "ll")) {
+        value = va_arg(args, unsigned long long);
+    }
+    else if (isLength(conversion, "z") || isLength(conversion, "t")) {
+        value = va_arg(args, std::size_t);
+    }
+    else if (isLength(conversion, "j")) {
+        value = va_arg(args, std::uintmax_t);
+    }
+    else {
+        return false;
+    }
+    return writer.put(value);
+}
+
+// appends the result of snprintf to out, keeping track of the space left
+class Output {
+public:
+    Output(char* out, std::size_t size) : m_next(out), m_left(size) { }
+
+    void append(const char* data, std::size_t size)
+    {
+        if (m_left <= 1) {
+            return;
+        }
+        size = size < m_left - 1 ? size : m_left - 1;
+        std::memcpy(m_next, data, size);
+        m_next += size;
+        m_left -= size;
+        *m_next = '\0';
+    }
+
+    template <typename T>
+    void appendFormatted(const char* spec, T value)
+    {
+        if (m_left <= 1) {
+            return;
+        }
+        int n = std::snprintf(m_next, m_left, spec, value);
+        if (n < 0) {
+            *m_next = '\0';
+            return;
+        }
+        std::size_t written = static_cast<std::size_t>(n) < m_left - 1 ? n : m_left - 1;
+        m_next += written;
+        m_left -= written;
+    }
+
+private:
+    char* m_next;
+    std::size_t m_left;
+};
+
+// writes a conversion without flags, width or precision.  returns
+// false if it needs snprintf.
+bool appendPlain(char type, ArgReader& reader, Output& output)
+{
+    char digits[24];
+    std::to_chars_result result;
+    switch (type) {
+    case 'd':
+    case 'i':
+        result = std::to_chars(digits, digits + sizeof(digits), reader.get<long long>());
+        break;
+
+    case 'u':
+        result = std::to_chars(digits, digits + sizeof(digits), reader.get<unsigned long long>());
+        break;
+
+    case 'x':
+        result = std::to_chars(digits, digits + sizeof(digits),
+                               reader.get<unsigned long long>(), 16);
+        break;
+
+    case 's': {
+        const char* s = reader.getString();
+        output.append(s, std::strlen(s));
+        return true;
+    }
+
+    default:
+        return false;
+    }
+    output.append(digits, result.ptr - digits);
+    return true;
+}
+
+// captureLogArgs() on a va_list that may be consumed
+bool captureArgs(const char* format, va_list& args, char* buffer, std::size_t size)
+{
+    ArgWriter writer(buffer, size);
+    const char* p = format;
+    while ((p = std::strchr(p, '%')) != nullptr) {
+        if (p[1] == '%') {
+            p += 2;
+            continue;
+        }
+
+        Conversion conversion;
+        p = parseConversion(p + 1, conversion);
+
+        if (conversion.m_widthArg && !writer.put(va_arg(args, int))) {
+            return false;
+        }
+        int precision = -1;
+        if (conversion.m_precisionArg) {
+            precision = va_arg(args, int);
+            if (!writer.put(precision)) {
+                return false;
+            }
+        }
+        else if (conversion.m_hasPrecision) {
+            precision = std::atoi(conversion.m_precision + 1);
+        }
+
+        bool stored;
+        switch (conversion.m_type) {
+        case 'd':
+        case 'i':
+            stored = captureSigned(conversion, args, writer);
+            break;
+
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            stored = captureUnsigned(conversion, args, writer);
+            break;
+
+        case 'c':
+            stored = isLength(conversion, "") && writer.put(va_arg(args, int));
+            break;
+
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            stored = (isLength(conversion, "") || isLength(conversion, "l")) &&
+                     writer.put(va_arg(args, double));
+            break;
+
+        case 's': {
+            if (!isLength(conversion, "")) {
+                return false;
+            }
+            const char* s = va_arg(args, const char*);
+            if (s == nullptr) {
+                s = "(null)";
+            }
+            std::size_t length = 0;
+            if (precision < 0) {
+                length = std::strlen(s);
+            }
+            else {
+                while (length < static_cast<std::size_t>(precision) && s[length] != '\0') {
+                    ++length;
+                }
+            }
+            stored = writer.putBytes(s, length) && writer.put('\0');
+            break;
+        }
+
+        case 'p':
+            stored = writer.put(va_arg(args, void*));
+            break;
+
+        default:
+            return false;
+        }
+        if (!stored) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool captureLogArgs(const char* format, va_list args, char* buffer, std::size_t size)
+{
+    va_list copy;
+    va_copy(copy, args);
+    bool captured = captureArgs(format, copy, buffer, size);
+    va_end(copy);
+    return captured;
+}
+
+void formatLogArgs(const char* format, const char* args, char* out, std::size_t size)
+{
+    if (size == 0) {
+        return;
+    }
+    *out = '\0';
+
+    Output output(out, size);
+    ArgReader reader(args);
+    const char* p = format;
+    while (*p != '\0') {
+        const char* percent = std::strchr(p, '%');
+        if (percent == nullptr) {
+            output.append(p, std::strlen(p));
+            break;
+        }
+        output.append(p, percent - p);
+        if (percent[1] == '%') {
+            output.append("%", 1);
+            p = percent + 2;
+            continue;
+        }
+
+        Conversion conversion;
+        p = parseConversion(percent + 1, conversion);
+
+        // most conversions have no flags, width or precision and are
+        // written without going through snprintf
+        if (conversion.m_numFlags == 0 && conversion.m_widthSize == 0 &&
+                conversion.m_precisionSize == 0 && appendPlain(conversion.m_type, reader, output)) {
+            continue;
+        }
+
+        // rebuild the conversion with the captured width and precision
+        // and the type the value was stored as
+        char spec[64];
+        int n;
+        if (!conversion.m_widthArg && !conversion.m_precisionArg) {
+            // flags, width and precision are next to each other
+            n = std::snprintf(spec, sizeof(spec), "%%%.*s", static_cast<int>(conversion.m_numFlags +
+                              conversion.m_widthSize + conversion.m_precisionSize), conversion.m_flags);
+        }
+        else {
+            n = std::snprintf(spec, sizeof(spec), "%%%.*s", static_cast<int>(conversion.m_numFlags),
+                              conversion.m_flags);
+            if (conversion.m_widthArg) {
+                n += std::snprintf(spec + n, sizeof(spec) - n, "%d", reader.get<int>());
+            }
+            else {
+                n += std::snprintf(spec + n, sizeof(spec) - n, "%.*s",
+                                   static_cast<int>(conversion.m_widthSize), conversion.m_width);
+            }
+            if (conversion.m_precisionArg) {
+                n += std::snprintf(spec + n, sizeof(spec) - n, ".%d", reader.get<int>());
+            }
+            else {
+                n += std::snprintf(spec + n, sizeof(spec) - n, "%.*s",
+                                   static_cast<int>(conversion.m_precisionSize),
+                                   conversion.m_precision);
+            }
+        }
+        if (n < 0 || static_cast<std::size_t>(n) + 4 > sizeof(spec)) {
+            break;
+        }
+
+        switch (conversion.m_type) {
+        case 'd':
+        case 'i':
+            std::snprintf(spec + n, sizeof(spec) - n, "ll%c", conversion.m_type);
+            output.appendFormatted(spec, reader.get<long long>());
+            break;
+
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            std::snprintf(spec + n, sizeof(spec) - n, "ll%c", conversion.m_type);
+            output.appendFormatted(spec, reader.get<unsigned long long>());
+            break;
+
+        case 'c':
+            std::snprintf(spec + n, sizeof(spec) - n, "c");
+            output.appendFormatted(spec, reader.get<int>());
+            break;
+
+        case 's':
+            std::snprintf(spec + n, sizeof(spec) - n, "s");
+            output.appendFormatted(spec, reader.getString());
+            break;
+
+        case 'p':
+            std::snprintf(spec + n, sizeof(spec) - n, "p");
+            output.appendFormatted(spec, reader.get<void*>());
+            break;
+
+        default:
+            std::snprintf(spec + n, sizeof(spec) - n, "%c", conversion.m_type);
+            output.appendFormatted(spec, reader.get<double>());
+            break;
+        }
+    }
+}
+
+} // namespace inputleap
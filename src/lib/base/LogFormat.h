@@ -0,0 +1,43 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdarg>
+#include <cstddef>
+
+namespace inputleap {
+
+//! Copy the arguments of a printf style format
+/*!
+Stores the arguments \p args of \p format in \p buffer so the message
+can be formatted later by formatLogArgs().  Integers, characters and
+pointers are stored by value and strings are copied, honouring any
+precision.  \p args is left unchanged.  Returns false if the
+arguments don't fit in \p size bytes or \p format uses a conversion
+that isn't supported (\c %%n and \c long \c double).
+*/
+bool captureLogArgs(const char* format, va_list args, char* buffer, std::size_t size);
+
+//! Format a message from captured arguments
+/*!
+Writes \p format with the arguments stored by captureLogArgs() into
+\p out, truncating it to \p size bytes including the terminating nul.
+*/
+void formatLogArgs(const char* format, const char* args, char* out, std::size_t size);
+
+} // namespace inputleap
@@ -0,0 +1,62 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/LogRing.h"
+
+namespace inputleap {
+
+LogRing::LogRing() :
+    m_records(new Record[kCapacity]),
+    m_head(0),
+    m_tail(0)
+{
+}
+
+LogRing::Record* LogRing::reserve()
+{
+    std::size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail - m_head.load(std::memory_order_acquire) == kCapacity) {
+        return nullptr;
+    }
+    return &m_records[tail % kCapacity];
+}
+
+void LogRing::commit()
+{
+    m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+const LogRing::Record* LogRing::front() const
+{
+    std::size_t head = m_head.load(std::memory_order_relaxed);
+    if (head == m_tail.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    return &m_records[head % kCapacity];
+}
+
+void LogRing::pop()
+{
+    m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+bool LogRing::empty() const
+{
+    return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+}
+
+} // namespace inputleap
@@ -0,0 +1,100 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/ELevel.h"
+
+#include <atomic>
+#include <cstddef>
+#include <ctime>
+#include <memory>
+
+namespace inputleap {
+
+//! Log records of one thread
+/*!
+A fixed size ring of log records filled by one thread and emptied by
+the log's writer thread.  Neither side takes a lock:  the filling
+thread only moves the tail and the writer only moves the head.
+*/
+class LogRing {
+public:
+    //! Longest message kept, including the terminating nul
+    static const std::size_t kMaxMessage = 2048;
+
+    //! Number of records a ring holds
+    static const std::size_t kCapacity = 64;
+
+    struct Record {
+        ELevel m_level;
+        std::time_t m_time;
+        const char* m_file;
+        int m_line;
+
+        //! Format of the message, or nullptr if it's already formatted
+        /*!
+        If set, \c m_message holds the arguments stored for it by
+        captureLogArgs() instead of the text.
+        */
+        const char* m_format;
+        char m_message[kMaxMessage];
+    };
+
+    LogRing();
+    LogRing(const LogRing&) = delete;
+    LogRing& operator=(const LogRing&) = delete;
+
+    //! @name manipulators
+    //@{
+
+    //! Get the next free record
+    /*!
+    Returns nullptr if the ring is full.  Only the filling thread may
+    call this.  The record is handed to the writer by commit().
+    */
+    Record* reserve();
+
+    //! Hand the record returned by reserve() to the writer
+    void commit();
+
+    //! Get the oldest record
+    /*!
+    Returns nullptr if the ring is empty.  Only the writer may call
+    this.  The record stays valid until pop().
+    */
+    const Record* front() const;
+
+    //! Release the record returned by front()
+    void pop();
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Check if there are no records to write
+    bool empty() const;
+
+    //@}
+
+private:
+    std::unique_ptr<Record[]> m_records;
+    std::atomic<std::size_t> m_head;
+    std::atomic<std::size_t> m_tail;
+};
+
+} // namespace inputleap
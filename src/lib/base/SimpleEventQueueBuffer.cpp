@@ -23,9 +23,16 @@
 
 namespace inputleap {
 
-SimpleEventQueueBuffer::SimpleEventQueueBuffer()
+SimpleEventQueueBuffer::SimpleEventQueueBuffer() :
+    ring_(new Cell[kRingSize]),
+    ring_tail_(0),
+    ring_head_(0),
+    overflowing_(false),
+    waiting_(false)
 {
-    m_queueReady     = false;
+    for (std::uint32_t i = 0; i < kRingSize; ++i) {
+        ring_[i].sequence.store(i, std::memory_order_relaxed);
+    }
 }
 
 SimpleEventQueueBuffer::~SimpleEventQueueBuffer()
@@ -36,47 +43,130 @@ void
 SimpleEventQueueBuffer::waitForEvent(double timeout)
 {
     std::unique_lock<std::mutex> lock(queue_mutex_);
+
+    // producers check waiting_ after publishing an id.  the fences make
+    // sure that either they see it set or we see their id.
+    waiting_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
     Stopwatch timer(true);
-    while (!m_queueReady) {
+    while (isEmpty()) {
         double timeLeft = timeout;
         if (timeLeft >= 0.0) {
             timeLeft -= timer.getTime();
             if (timeLeft < 0.0) {
-                return;
+                break;
             }
         }
         ARCH->wait_cond_var(queue_ready_cv_, lock, timeLeft);
     }
+    waiting_.store(false, std::memory_order_relaxed);
 }
 
 IEventQueueBuffer::Type SimpleEventQueueBuffer::getEvent(Event&, std::uint32_t& dataID)
 {
+    std::uint64_t pos = ring_head_.load(std::memory_order_relaxed);
+    Cell& cell = ring_[pos & kRingMask];
+    for (;;) {
+        if (cell.sequence.load(std::memory_order_acquire) == pos + 1) {
+            dataID = cell.dataID;
+            cell.sequence.store(pos + kRingSize, std::memory_order_release);
+            ring_head_.store(pos + 1, std::memory_order_relaxed);
+            return kUser;
+        }
+        if (ring_tail_.load(std::memory_order_acquire) == pos) {
+            break;
+        }
+
+        // a producer has claimed the cell but not filled it in yet.  we
+        // can't look at the overflow queue before that id or we could
+        // reorder that producer's events.
+        wait_for_cell(cell, pos);
+    }
+
+    if (!overflowing_.load(std::memory_order_acquire)) {
+        return kNone;
+    }
+
     std::lock_guard<std::mutex> lock(queue_mutex_);
-    if (!m_queueReady) {
+    if (overflow_.empty()) {
         return kNone;
     }
-    dataID = m_queue.back();
-    m_queue.pop_back();
-    m_queueReady = !m_queue.empty();
+    dataID = overflow_.front();
+    overflow_.pop_front();
+    if (overflow_.empty()) {
+        overflowing_.store(false, std::memory_order_release);
+    }
     return kUser;
 }
 
 bool SimpleEventQueueBuffer::addEvent(std::uint32_t dataID)
 {
-    std::lock_guard<std::mutex> lock(queue_mutex_);
-    m_queue.push_front(dataID);
-    if (!m_queueReady) {
-        m_queueReady = true;
-        queue_ready_cv_.notify_all();
+    // once ids overflow, keep using the overflow queue until it's
+    // drained so each producer's events stay in order
+    if (!overflowing_.load(std::memory_order_acquire) && push(dataID)) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiting_.load(std::memory_order_relaxed)) {
+            wake();
+        }
+        return true;
     }
+
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    overflow_.push_back(dataID);
+    overflowing_.store(true, std::memory_order_release);
+    queue_ready_cv_.notify_one();
     return true;
 }
 
 bool
 SimpleEventQueueBuffer::isEmpty() const
+{
+    return ring_tail_.load(std::memory_order_acquire) ==
+                ring_head_.load(std::memory_order_relaxed) &&
+           !overflowing_.load(std::memory_order_acquire);
+}
+
+bool SimpleEventQueueBuffer::push(std::uint32_t dataID)
+{
+    std::uint64_t pos = ring_tail_.load(std::memory_order_relaxed);
+    for (;;) {
+        Cell& cell = ring_[pos & kRingMask];
+        std::uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<std::int64_t>(sequence - pos);
+        if (diff == 0) {
+            if (ring_tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                cell.dataID = dataID;
+                cell.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            // ring is full
+            return false;
+        } else {
+            pos = ring_tail_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void SimpleEventQueueBuffer::wait_for_cell(const Cell& cell, std::uint64_t pos)
+{
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+
+    // same handshake as waitForEvent():  the producer checks waiting_
+    // after filling in the cell
+    waiting_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    queue_ready_cv_.wait(lock, [&cell, pos]() {
+        return cell.sequence.load(std::memory_order_acquire) == pos + 1;
+    });
+    waiting_.store(false, std::memory_order_relaxed);
+}
+
+void SimpleEventQueueBuffer::wake()
 {
     std::lock_guard<std::mutex> lock(queue_mutex_);
-    return !m_queueReady;
+    queue_ready_cv_.notify_one();
 }
 
 } // namespace inputleap
@@ -20,14 +20,24 @@
 
 #include "base/IEventQueueBuffer.h"
 #include "arch/IArchMultithread.h"
+#include <atomic>
 #include <condition_variable>
 #include <deque>
+#include <memory>
 
 namespace inputleap {
 
 //! In-memory event queue buffer
 /*!
 An event queue buffer provides a queue of events for an IEventQueue.
+
+Any thread may add events but only one thread may get them.  Event ids
+are queued in a bounded lock-free ring.  If the ring is full, ids go to
+a mutex protected overflow queue until the consumer has drained it, so
+events from any one thread are always delivered in the order they were
+added.  The mutex is otherwise only taken to wake a waiting consumer,
+either in waitForEvent() or in getEvent() when a producer has claimed
+the next cell in the ring but not filled it in yet.
 */
 class SimpleEventQueueBuffer : public IEventQueueBuffer {
 public:
@@ -42,12 +52,32 @@ public:
     bool isEmpty() const override;
 
 private:
-    typedef std::deque<std::uint32_t> EventDeque;
+    struct Cell {
+        // equals the ring position the cell is free for, or that
+        // position plus one once it holds an id
+        std::atomic<std::uint64_t> sequence;
+        std::uint32_t dataID;
+    };
+
+    static const std::uint32_t kRingSize = 1024;
+    static const std::uint32_t kRingMask = kRingSize - 1;
+
+    bool push(std::uint32_t dataID);
+    void wait_for_cell(const Cell& cell, std::uint64_t pos);
+    void wake();
+
+private:
+    std::unique_ptr<Cell[]> ring_;
+    alignas(64) std::atomic<std::uint64_t> ring_tail_;
+    alignas(64) std::atomic<std::uint64_t> ring_head_;
+
+    // true while overflow_ may hold ids
+    alignas(64) std::atomic<bool> overflowing_;
+    std::atomic<bool> waiting_;
 
     mutable std::mutex queue_mutex_;
     std::condition_variable queue_ready_cv_;
-    bool m_queueReady;
-    EventDeque m_queue;
+    std::deque<std::uint32_t> overflow_;
 };
 
 } // namespace inputleap
@@ -20,6 +20,7 @@
 #include "arch/Arch.h"
 #include "base/String.h"
 #include "io/filesystem.h"
+#include <cstring>
 #include <fstream>
 #include <iostream>
 
@@ -95,18 +96,18 @@ bool
 ConsoleLogOutputter::write(ELevel level, const char* msg)
 {
     if ((level >= kFATAL) && (level <= kWARNING))
-        std::cerr << msg << std::endl;
+        std::cerr << msg << '\n';
     else
-        std::cout << msg << std::endl;
+        std::cout << msg << '\n';
 
-    std::cout.flush();
     return true;
 }
 
 void
 ConsoleLogOutputter::flush()
 {
-
+    std::cout.flush();
+    std::cerr.flush();
 }
 
 
@@ -245,12 +246,14 @@ FileLogOutputter::FileLogOutputter(const char* logFile)
 
 FileLogOutputter::~FileLogOutputter()
 {
+    close();
 }
 
 void
 FileLogOutputter::setLogFilename(const char* logFile)
 {
     assert(logFile != nullptr);
+    close();
     m_fileName = logFile;
 }
 
@@ -259,34 +262,57 @@ FileLogOutputter::write(ELevel level, const char *message)
 {
     (void) level;
 
-    bool moveFile = false;
-
-    std::ofstream m_handle;
-    inputleap::open_utf8_path(m_handle, m_fileName, std::fstream::app);
-    if (m_handle.is_open() && m_handle.fail() != true) {
-        m_handle << message << std::endl;
-
-        // when file size exceeds limits, move to 'old log' filename.
-        size_t p = m_handle.tellp();
-        if (p > (kFileSizeLimit * 1024)) {
-            moveFile = true;
+    if (!m_handle.is_open()) {
+        inputleap::open_utf8_path(m_handle, m_fileName, std::fstream::app);
+        if (!m_handle.is_open()) {
+            return true;
         }
+        m_handle.seekp(0, std::ios::end);
+        std::streamoff size = m_handle.tellp();
+        m_size = size > 0 ? static_cast<std::size_t>(size) : 0;
     }
-    m_handle.close();
 
-    if (moveFile) {
-        std::string oldLogFilename = inputleap::string::sprintf("%s.1", m_fileName.c_str());
-        remove(oldLogFilename.c_str());
-        rename(m_fileName.c_str(), oldLogFilename.c_str());
+    std::size_t length = std::strlen(message);
+    m_handle.write(message, length);
+    m_handle.put('\n');
+    m_size += length + 1;
+
+    // when file size exceeds limits, move to 'old log' filename.
+    if (m_size > kFileSizeLimit * 1024) {
+        rotate();
     }
 
     return true;
 }
 
+void
+FileLogOutputter::flush()
+{
+    if (m_handle.is_open()) {
+        m_handle.flush();
+    }
+}
+
+void
+FileLogOutputter::rotate()
+{
+    m_handle.close();
+    m_size = 0;
+
+    std::string oldLogFilename = inputleap::string::sprintf("%s.1", m_fileName.c_str());
+    remove(oldLogFilename.c_str());
+    rename(m_fileName.c_str(), oldLogFilename.c_str());
+}
+
 void FileLogOutputter::open(const char *title) { (void) title; }
 
 void
-FileLogOutputter::close() {}
+FileLogOutputter::close()
+{
+    if (m_handle.is_open()) {
+        m_handle.close();
+    }
+}
 
 void FileLogOutputter::show(bool showIfEmpty) { (void) showIfEmpty; }
 
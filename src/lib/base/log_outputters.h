@@ -62,13 +62,16 @@ public:
     void close() override;
     void show(bool showIfEmpty) override;
     bool write(ELevel level, const char* message) override;
-    virtual void flush();
+    void flush() override;
 };
 
 //! Write log to file
 /*!
 This outputter writes output to the file.  The level for each
-message is ignored.
+message is ignored.  The file stays open and output is only flushed
+by flush().  Once the file grows past its size limit it is renamed
+with a \c .1 suffix, replacing the previous one, and a new file is
+started.
 */
 
 class FileLogOutputter : public ILogOutputter {
@@ -81,11 +84,16 @@ public:
     void close() override;
     void show(bool showIfEmpty) override;
     bool write(ELevel level, const char* message) override;
+    void flush() override;
 
     void setLogFilename(const char* title);
 
 private:
+    void rotate();
+
     std::string m_fileName;
+    std::ofstream m_handle;
+    std::size_t m_size = 0;
 };
 
 //! Write log to system log
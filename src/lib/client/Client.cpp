@@ -265,6 +265,27 @@ Client::setClipboard(ClipboardID id, const IClipboard* clipboard)
     m_sentClipboard[id] = false;
 }
 
+bool Client::setClipboardFormat(ClipboardID id, IClipboard::EFormat format,
+                                const std::string& data)
+{
+    return m_screen->setClipboardFormat(id, format, data);
+}
+
+void Client::withdrawClipboardFormat(ClipboardID id, IClipboard::EFormat format)
+{
+    m_screen->withdrawClipboardFormat(id, format);
+}
+
+void Client::beginFakeBatch()
+{
+    m_screen->beginFakeBatch();
+}
+
+void Client::endFakeBatch()
+{
+    m_screen->endFakeBatch();
+}
+
 void
 Client::grabClipboard(ClipboardID id)
 {
@@ -394,9 +415,8 @@ Client::sendClipboard(ClipboardID id)
         // save new time
         m_timeClipboard[id] = clipboard.getTime();
 
-        // marshall the data
-        std::string data = clipboard.marshall();
-        if (data.size() >= m_maximumClipboardSize) {
+        // check the size of the marshalled data
+        if (clipboard.marshalled_size() >= m_maximumClipboardSize) {
             LOG_NOTE("Skipping clipboard transfer because the clipboard"
                 " contents exceeds the %zi MB size limit set by the server",
                 m_maximumClipboardSize);
@@ -404,9 +424,10 @@ Client::sendClipboard(ClipboardID id)
         }
 
         // save and send data if different or not yet sent
-        if (!m_sentClipboard[id] || data != m_dataClipboard[id]) {
+        Clipboard::Digest digest = clipboard.digest();
+        if (!m_sentClipboard[id] || digest != m_digestClipboard[id]) {
             m_sentClipboard[id] = true;
-            m_dataClipboard[id] = data;
+            m_digestClipboard[id] = digest;
             m_server->onClipboardChanged(id, &clipboard);
         }
     }
@@ -481,6 +502,8 @@ Client::setupScreen()
                           [this](const auto& e){ handle_shape_changed(); });
     m_events->add_handler(EventType::CLIPBOARD_GRABBED, get_event_target(),
                           [this](const auto& e){ handle_clipboard_grabbed(e); });
+    m_events->add_handler(EventType::CLIPBOARD_FORMAT_REQUESTED, get_event_target(),
+                          [this](const auto& e){ handle_clipboard_format_requested(e); });
 }
 
 void
@@ -527,6 +550,7 @@ Client::cleanupScreen()
         }
         m_events->remove_handler(EventType::SCREEN_SHAPE_CHANGED, get_event_target());
         m_events->remove_handler(EventType::CLIPBOARD_GRABBED, get_event_target());
+        m_events->remove_handler(EventType::CLIPBOARD_FORMAT_REQUESTED, get_event_target());
         delete m_server;
         m_server = nullptr;
     }
@@ -632,6 +656,12 @@ void Client::handle_clipboard_grabbed(const Event& event)
     }
 }
 
+void Client::handle_clipboard_format_requested(const Event& event)
+{
+    const auto& info = event.get_data_as<IScreen::ClipboardFormatInfo>();
+    m_server->requestClipboardFormat(info.m_id, info.m_format);
+}
+
 void Client::handle_hello()
 {
     std::int16_t major, minor;
@@ -705,7 +735,13 @@ void
 Client::onFileReceiveCompleted()
 {
     if (isReceivedFileSizeValid()) {
-        m_writeToDropDirThread = new Thread([this](){ write_to_drop_dir_thread(); });
+        // the file now belongs to the thread;  another transfer may start
+        // while it waits for the drop
+        fs::path received = m_receivedFile.release();
+        m_writeToDropDirThread = new Thread([this, received]()
+        {
+            write_to_drop_dir_thread(received);
+        });
     }
 }
 
@@ -714,7 +750,7 @@ void Client::handle_stop_retry()
     m_args.m_restartable = false;
 }
 
-void Client::write_to_drop_dir_thread()
+void Client::write_to_drop_dir_thread(const fs::path& received)
 {
     LOG_DEBUG("starting write to drop dir thread");
 
@@ -722,8 +758,7 @@ void Client::write_to_drop_dir_thread()
         inputleap::this_thread_sleep(.1f);
     }
 
-    DropHelper::writeToDir(m_screen->getDropTarget(), m_dragFileList,
-                    m_receivedFileData);
+    DropHelper::writeToDir(m_screen->getDropTarget(), m_dragFileList, received);
 }
 
 void Client::dragInfoReceived(std::uint32_t fileNum, std::string data)
@@ -736,13 +771,17 @@ void Client::dragInfoReceived(std::uint32_t fileNum, std::string data)
 
     DragInformation::parseDragInfo(m_dragFileList, fileNum, data);
 
+    // the file follows the drag information.  write it where it will be
+    // dropped.
+    m_receivedFile.set_directory(fs::u8path(m_screen->getDropTarget()));
+
     m_screen->startDraggingFiles(m_dragFileList);
 }
 
 bool
 Client::isReceivedFileSizeValid()
 {
-    return m_expectedFileSize == m_receivedFileData.size();
+    return m_receivedFile.is_complete();
 }
 
 void
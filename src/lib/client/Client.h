@@ -24,6 +24,7 @@
 #include "inputleap/IClient.h"
 #include "inputleap/Clipboard.h"
 #include "inputleap/DragInformation.h"
+#include "inputleap/IncomingFile.h"
 #include "inputleap/INode.h"
 #include "inputleap/ClientArgs.h"
 #include "net/Fwd.h"
@@ -58,6 +59,20 @@ public:
 
     ~Client();
 
+#ifdef INPUTLEAP_TEST_ENV
+    Client() :
+        m_mock(true),
+        m_socketFactory(nullptr),
+        m_screen(nullptr),
+        m_stream(nullptr),
+        m_timer(nullptr),
+        m_server(nullptr),
+        m_events(nullptr),
+        m_sendFileThread(nullptr),
+        m_writeToDropDirThread(nullptr)
+    { }
+#endif
+
     //! @name manipulators
     //@{
 
@@ -89,6 +104,29 @@ public:
     //! Send dragging file information back to server
     void sendDragInfo(std::uint32_t fileCount, std::string& info, size_t size);
 
+    //! Supply promised clipboard data
+    /*!
+    Passes data for a format the last setClipboard() promised on to the
+    screen.  Returns false if the screen isn't waiting for it.
+    */
+    virtual bool setClipboardFormat(ClipboardID, IClipboard::EFormat, const std::string& data);
+
+    //! Withdraw promised clipboard data
+    /*!
+    Tells the screen that data the last setClipboard() promised won't
+    arrive.  Requests waiting for it fail.
+    */
+    virtual void withdrawClipboardFormat(ClipboardID, IClipboard::EFormat);
+
+    //! Begin a batch of input from the server
+    /*!
+    Input synthesized until the matching \c endFakeBatch() is sent to
+    the system together.  See Screen::beginFakeBatch().
+    */
+    virtual void beginFakeBatch();
+
+    //! End a batch of input from the server
+    virtual void endFakeBatch();
 
     //@}
     //! @name accessors
@@ -117,11 +155,8 @@ public:
     //! Return true if received file size is valid
     bool isReceivedFileSizeValid();
 
-    //! Return expected file size
-    size_t& getExpectedFileSize() { return m_expectedFileSize; }
-
-    //! Return received file data
-    std::string& getReceivedFileData() { return m_receivedFileData; }
+    //! Return the file being received
+    IncomingFile& getReceivedFile() { return m_receivedFile; }
 
     //! Return drag file list
     DragFileList getDragFileList() { return m_dragFileList; }
@@ -161,7 +196,7 @@ private:
     void sendConnectionFailedEvent(const char* msg);
     void send_file_chunk(const FileChunk& data);
     void send_file_thread(const char* filename);
-    void write_to_drop_dir_thread();
+    void write_to_drop_dir_thread(const fs::path& received);
     void setupConnecting();
     void setupConnection();
     void setupScreen();
@@ -178,6 +213,7 @@ private:
     void handle_disconnected();
     void handle_shape_changed();
     void handle_clipboard_grabbed(const Event& event);
+    void handle_clipboard_format_requested(const Event& event);
     void handle_hello();
     void handle_suspend();
     void handle_resume();
@@ -205,10 +241,9 @@ private:
     bool m_ownClipboard[kClipboardEnd];
     bool m_sentClipboard[kClipboardEnd];
     IClipboard::Time m_timeClipboard[kClipboardEnd];
-    std::string m_dataClipboard[kClipboardEnd];
+    Clipboard::Digest m_digestClipboard[kClipboardEnd];
     IEventQueue* m_events;
-    std::size_t m_expectedFileSize;
-    std::string m_receivedFileData;
+    IncomingFile m_receivedFile;
     DragFileList m_dragFileList;
     std::string m_dragFileExt;
     Thread* m_sendFileThread;
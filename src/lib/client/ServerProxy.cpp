@@ -21,7 +21,6 @@
 #include "client/Client.h"
 #include "inputleap/FileChunk.h"
 #include "inputleap/ClipboardChunk.h"
-#include "inputleap/StreamChunker.h"
 #include "inputleap/Clipboard.h"
 #include "inputleap/ProtocolUtil.h"
 #include "inputleap/option_types.h"
@@ -32,11 +31,32 @@
 #include "base/IEventQueue.h"
 #include "base/EventQueueTimer.h"
 #include "base/XBase.h"
+#include "base/finally.h"
 
+#include <algorithm>
+#include <iterator>
 #include <memory>
+#include <vector>
 
 namespace inputleap {
 
+namespace {
+
+// messages that synthesize input on the client
+bool is_input_message(const std::uint8_t* code)
+{
+    for (const char* input : { kMsgDMouseMove, kMsgDMouseRelMove, kMsgDMouseWheel,
+                               kMsgDKeyDown, kMsgDKeyUp, kMsgDKeyRepeat,
+                               kMsgDMouseDown, kMsgDMouseUp }) {
+        if (memcmp(code, input, 4) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
 ServerProxy::ServerProxy(Client* client, inputleap::IStream* stream, IEventQueue* events) :
     m_client(client),
     m_stream(stream),
@@ -60,11 +80,15 @@ ServerProxy::ServerProxy(Client* client, inputleap::IStream* stream, IEventQueue
     for (KeyModifierID id = 0; id < kKeyModifierIDLast; ++id)
         m_modifierTranslationTable[id] = id;
 
+    // the server is at least as new as we are so it takes compressed chunks
+    clipboard_stream_.set_compression(true);
+    file_stream_.set_compression(true);
+
     // handle data on stream
     m_events->add_handler(EventType::STREAM_INPUT_READY, m_stream->get_event_target(),
                           [this](const auto& e){ handle_data(); });
-    m_events->add_handler(EventType::CLIPBOARD_SENDING, this,
-                          [this](const auto& e){ handle_clipboard_sending_event(e); });
+    m_events->add_handler(EventType::STREAM_OUTPUT_FLUSHED, m_stream->get_event_target(),
+                          [this](const auto& e){ send_bulk_data(); });
 
     // send heartbeat
     setKeepAliveRate(kKeepAliveRate);
@@ -72,9 +96,10 @@ ServerProxy::ServerProxy(Client* client, inputleap::IStream* stream, IEventQueue
 
 ServerProxy::~ServerProxy()
 {
+    withdrawPromisedFormats();
     setKeepAliveRate(-1.0);
     m_events->remove_handler(EventType::STREAM_INPUT_READY, m_stream->get_event_target());
-    m_events->remove_handler(EventType::CLIPBOARD_SENDING, this);
+    m_events->remove_handler(EventType::STREAM_OUTPUT_FLUSHED, m_stream->get_event_target());
 }
 
 void
@@ -101,6 +126,21 @@ ServerProxy::setKeepAliveRate(double rate)
 }
 
 void ServerProxy::handle_data()
+{
+    // synthesize the input from consecutive input messages that arrived
+    // together in one go.  a disconnect deletes this proxy but not the
+    // client.
+    Client* client = m_client;
+    bool batching = false;
+    auto end_batch = finally([client, &batching]() {
+        if (batching) {
+            client->endFakeBatch();
+        }
+    });
+    handle_messages(batching);
+}
+
+void ServerProxy::handle_messages(bool& batching)
 {
     // handle messages until there are no more.  first read message code.
     std::uint8_t code[4];
@@ -113,6 +153,19 @@ void ServerProxy::handle_data()
             return;
         }
 
+        // send the input so far before handling anything else so it
+        // doesn't wait for clipboard or file data that follows it
+        bool input = is_input_message(code);
+        if (input && !batching) {
+            m_client->beginFakeBatch();
+            batching = true;
+        }
+        else if (!input && batching) {
+            flushCompressedMouse();
+            m_client->endFakeBatch();
+            batching = false;
+        }
+
         // parse message
         LOG_DEBUG2("msg from server: %c%c%c%c", code[0], code[1], code[2], code[3]);
         try {
@@ -135,7 +188,7 @@ void ServerProxy::handle_data()
             // handleData() functions, we should collect that to a single place
 
             LOG_ERR("protocol error from server: %s", e.what());
-            ProtocolUtil::writef(m_stream, kMsgEBad);
+            ProtocolUtil::write_message<kMsgEBad>(m_stream);
             m_client->disconnect("invalid message from server");
             return;
         }
@@ -171,7 +224,7 @@ ServerProxy::EResult ServerProxy::parseHandshakeMessage(const std::uint8_t* code
 
     else if (memcmp(code, kMsgCKeepAlive, 4) == 0) {
         // echo keep alives and reset alarm
-        ProtocolUtil::writef(m_stream, kMsgCKeepAlive);
+        ProtocolUtil::write_message<kMsgCKeepAlive>(m_stream);
         resetKeepAliveAlarm();
     }
 
@@ -255,7 +308,7 @@ ServerProxy::EResult ServerProxy::parseMessage(const std::uint8_t* code)
 
     else if (memcmp(code, kMsgCKeepAlive, 4) == 0) {
         // echo keep alives and reset alarm
-        ProtocolUtil::writef(m_stream, kMsgCKeepAlive);
+        ProtocolUtil::write_message<kMsgCKeepAlive>(m_stream);
         resetKeepAliveAlarm();
     }
 
@@ -291,6 +344,10 @@ ServerProxy::EResult ServerProxy::parseMessage(const std::uint8_t* code)
         setClipboard();
     }
 
+    else if (memcmp(code, kMsgDClipboardFormats, 4) == 0) {
+        setClipboardFormats();
+    }
+
     else if (memcmp(code, kMsgCResetOptions, 4) == 0) {
         resetOptions();
     }
@@ -328,7 +385,7 @@ ServerProxy::EResult ServerProxy::parseMessage(const std::uint8_t* code)
     // on a data packet.  we provide that packet here.  i don't
     // know why a delayed ACK should cause the server to wait since
     // TCP_NODELAY is enabled.
-    ProtocolUtil::writef(m_stream, kMsgCNoop);
+    ProtocolUtil::write_message<kMsgCNoop>(m_stream);
 
     return kOkay;
 }
@@ -354,17 +411,21 @@ bool
 ServerProxy::onGrabClipboard(ClipboardID id)
 {
     LOG_DEBUG1("sending clipboard %d changed", id);
-    ProtocolUtil::writef(m_stream, kMsgCClipboard, id, m_seqNum);
+    ProtocolUtil::write_message<kMsgCClipboard>(m_stream, id, m_seqNum);
+
+    // the server's data is no longer wanted
+    promised_clipboards_[id].active = false;
     return true;
 }
 
 void
 ServerProxy::onClipboardChanged(ClipboardID id, const IClipboard* clipboard)
 {
-    std::string data = IClipboard::marshall(clipboard);
+    auto data = std::make_shared<const std::string>(IClipboard::marshall(clipboard));
     LOG_DEBUG("sending clipboard %d seqnum=%d", id, m_seqNum);
 
-    StreamChunker::sendClipboard(data, data.size(), id, m_seqNum, m_events, this);
+    clipboard_stream_.push(id, m_seqNum, std::move(data));
+    send_bulk_data();
 }
 
 void
@@ -386,7 +447,7 @@ void
 ServerProxy::sendInfo(const ClientInfo& info)
 {
     LOG_DEBUG1("sending info shape=%d,%d %dx%d", info.m_x, info.m_y, info.m_w, info.m_h);
-    ProtocolUtil::writef(m_stream, kMsgDInfo,
+    ProtocolUtil::write_message<kMsgDInfo>(m_stream,
                                 info.m_x, info.m_y,
                                 info.m_w, info.m_h, 0,
                                 info.m_mx, info.m_my);
@@ -521,7 +582,7 @@ ServerProxy::enter()
     std::int16_t x, y;
     std::uint16_t mask;
     std::uint32_t seqNum;
-    ProtocolUtil::readf(m_stream, kMsgCEnter + 4, &x, &y, &seqNum, &mask);
+    ProtocolUtil::read_message_body<kMsgCEnter>(m_stream, &x, &y, &seqNum, &mask);
     LOG_DEBUG1("recv enter, %d,%d %d %04x", x, y, seqNum, mask);
 
     // discard old compressed mouse motion, if any
@@ -565,22 +626,155 @@ ServerProxy::setClipboard()
     else if (r == kFinish) {
         LOG_DEBUG("received clipboard %d size=%zd", id, dataCached.size());
 
-        // forward
+        // the server only sends data that was asked for
         Clipboard clipboard;
         clipboard.unmarshall(dataCached, 0);
-        m_client->setClipboard(id, &clipboard);
+        std::string().swap(dataCached);
+        supplyClipboardFormats(id, seq, clipboard);
+    }
+}
+
+void ServerProxy::requestClipboardFormat(ClipboardID id, IClipboard::EFormat format)
+{
+    PromisedClipboard& promised = promised_clipboards_[id];
+    if (!promised.active || !promised.pending[format] || promised.requested[format]) {
+        return;
+    }
+
+    LOG_DEBUG("asking for clipboard %d format %d", id, format);
+    promised.requested[format] = true;
+    ProtocolUtil::write_message<kMsgQClipboardFormat>(m_stream, id,
+                                                      static_cast<std::uint8_t>(format));
+}
+
+void ServerProxy::setClipboardFormats()
+{
+    // parse
+    ClipboardID id;
+    std::uint32_t seq;
+    std::vector<std::uint32_t> formats;
+    if (!ProtocolUtil::readf(m_stream, kMsgDClipboardFormats + 4, &id, &seq, &formats)) {
+        return;
+    }
+    LOG_DEBUG("recv clipboard %d formats size=%zd", id, formats.size());
+
+    // validate
+    if (id >= kClipboardEnd || formats.size() % 6 != 0) {
+        return;
+    }
+
+    // promise the advertised formats.  formats this side doesn't know
+    // are skipped.
+    PromisedClipboard& promised = promised_clipboards_[id];
+    promised.active = true;
+    promised.sequence = seq;
+    promised.collected = false;
+    Clipboard& clipboard = promised.clipboard;
+    clipboard.open(0);
+    clipboard.clear();
+    for (std::size_t i = 0; i < IClipboard::kNumFormats; ++i) {
+        promised.pending[i] = false;
+        promised.requested[i] = false;
+    }
+    for (std::size_t i = 0; i < formats.size(); i += 6) {
+        if (formats[i] >= IClipboard::kNumFormats) {
+            continue;
+        }
+        auto format = static_cast<IClipboard::EFormat>(formats[i]);
+        clipboard.promise(format);
+        promised.pending[format] = true;
+        promised.sizes[format] = formats[i + 1];
+        promised.digests[format] = {{
+            (static_cast<std::uint64_t>(formats[i + 2]) << 32) | formats[i + 3],
+            (static_cast<std::uint64_t>(formats[i + 4]) << 32) | formats[i + 5]
+        }};
+    }
+    clipboard.close();
+
+    // forward.  a screen that can't keep the promises asks for all the
+    // data right away.
+    m_client->setClipboard(id, &clipboard);
+    for (std::int32_t index = 0; index < IClipboard::kNumFormats; ++index) {
+        auto format = static_cast<IClipboard::EFormat>(index);
+        if (clipboard.is_demanded(format)) {
+            requestClipboardFormat(id, format);
+        }
+    }
+}
+
+void ServerProxy::supplyClipboardFormats(ClipboardID id, std::uint32_t sequence,
+                                         const Clipboard& clipboard)
+{
+    // replies to an older advertisement may still arrive after a newer
+    // one.  formats asked for again get a reply of their own.
+    PromisedClipboard& promised = promised_clipboards_[id];
+    if (!promised.active || sequence != promised.sequence) {
+        LOG_DEBUG("dropping clipboard %d data, no longer promised", id);
+        return;
+    }
+
+    clipboard.open(0);
+    for (std::int32_t index = 0; index < IClipboard::kNumFormats; ++index) {
+        auto format = static_cast<IClipboard::EFormat>(index);
+        if (!clipboard.has(format) || !promised.pending[format]) {
+            continue;
+        }
+        promised.pending[format] = false;
+
+        // the data must be what was advertised.  if it isn't then it
+        // won't be either when asked for again.
+        if (clipboard.size(format) != promised.sizes[format] ||
+                clipboard.digest(format) != promised.digests[format]) {
+            LOG_WARN("clipboard %d format %d doesn't match what was advertised", id, format);
+            m_client->withdrawClipboardFormat(id, format);
+            continue;
+        }
 
+        std::string data = clipboard.get(format);
+        if (!m_client->setClipboardFormat(id, format, data)) {
+            promised.clipboard.open(0);
+            promised.clipboard.add(format, data);
+            promised.clipboard.close();
+            promised.collected = true;
+        }
+    }
+    clipboard.close();
+
+    // screens that can't defer data get the whole clipboard once
+    // everything has arrived
+    if (promised.collected &&
+            std::none_of(std::begin(promised.pending), std::end(promised.pending),
+                         [](bool pending) { return pending; })) {
+        promised.collected = false;
+        m_client->setClipboard(id, &promised.clipboard);
         LOG_INFO("clipboard was updated");
     }
 }
 
+void ServerProxy::withdrawPromisedFormats()
+{
+    for (ClipboardID id = 0; id < kClipboardEnd; ++id) {
+        PromisedClipboard& promised = promised_clipboards_[id];
+        if (!promised.active) {
+            continue;
+        }
+        promised.active = false;
+        for (std::int32_t index = 0; index < IClipboard::kNumFormats; ++index) {
+            if (promised.pending[index]) {
+                promised.pending[index] = false;
+                m_client->withdrawClipboardFormat(id, static_cast<IClipboard::EFormat>(index));
+            }
+        }
+    }
+}
+
 void
 ServerProxy::grabClipboard()
 {
     // parse
     ClipboardID id;
     std::uint32_t seqNum;
-    ProtocolUtil::readf(m_stream, kMsgCClipboard + 4, &id, &seqNum);
+    ProtocolUtil::read_message_body<kMsgCClipboard>(m_stream, &id, &seqNum);
     LOG_DEBUG("recv grab clipboard %d", id);
 
     // validate
@@ -589,6 +783,7 @@ ServerProxy::grabClipboard()
     }
 
     // forward
+    promised_clipboards_[id].active = false;
     m_client->grabClipboard(id);
 }
 
@@ -600,7 +795,7 @@ ServerProxy::keyDown()
 
     // parse
     std::uint16_t id, mask, button;
-    ProtocolUtil::readf(m_stream, kMsgDKeyDown + 4, &id, &mask, &button);
+    ProtocolUtil::read_message_body<kMsgDKeyDown>(m_stream, &id, &mask, &button);
     LOG_DEBUG1("recv key down id=0x%08x, mask=0x%04x, button=0x%04x", id, mask, button);
 
     // translate
@@ -623,7 +818,7 @@ ServerProxy::keyRepeat()
 
     // parse
     std::uint16_t id, mask, count, button;
-    ProtocolUtil::readf(m_stream, kMsgDKeyRepeat + 4,
+    ProtocolUtil::read_message_body<kMsgDKeyRepeat>(m_stream,
                                 &id, &mask, &count, &button);
     LOG_DEBUG1("recv key repeat id=0x%08x, mask=0x%04x, count=%d, button=0x%04x", id, mask, count, button);
 
@@ -647,7 +842,7 @@ ServerProxy::keyUp()
 
     // parse
     std::uint16_t id, mask, button;
-    ProtocolUtil::readf(m_stream, kMsgDKeyUp + 4, &id, &mask, &button);
+    ProtocolUtil::read_message_body<kMsgDKeyUp>(m_stream, &id, &mask, &button);
     LOG_DEBUG1("recv key up id=0x%08x, mask=0x%04x, button=0x%04x", id, mask, button);
 
     // translate
@@ -670,7 +865,7 @@ ServerProxy::mouseDown()
 
     // parse
     std::int8_t id;
-    ProtocolUtil::readf(m_stream, kMsgDMouseDown + 4, &id);
+    ProtocolUtil::read_message_body<kMsgDMouseDown>(m_stream, &id);
     LOG_DEBUG1("recv mouse down id=%d", id);
 
     // forward
@@ -685,7 +880,7 @@ ServerProxy::mouseUp()
 
     // parse
     std::int8_t id;
-    ProtocolUtil::readf(m_stream, kMsgDMouseUp + 4, &id);
+    ProtocolUtil::read_message_body<kMsgDMouseUp>(m_stream, &id);
     LOG_DEBUG1("recv mouse up id=%d", id);
 
     // forward
@@ -698,7 +893,7 @@ ServerProxy::mouseMove()
     // parse
     bool ignore;
     std::int16_t x, y;
-    ProtocolUtil::readf(m_stream, kMsgDMouseMove + 4, &x, &y);
+    ProtocolUtil::read_message_body<kMsgDMouseMove>(m_stream, &x, &y);
 
     // note if we should ignore the move
     ignore = m_ignoreMouse;
@@ -731,7 +926,7 @@ ServerProxy::mouseRelativeMove()
     // parse
     bool ignore;
     std::int16_t dx, dy;
-    ProtocolUtil::readf(m_stream, kMsgDMouseRelMove + 4, &dx, &dy);
+    ProtocolUtil::read_message_body<kMsgDMouseRelMove>(m_stream, &dx, &dy);
 
     // note if we should ignore the move
     ignore = m_ignoreMouse;
@@ -763,7 +958,7 @@ ServerProxy::mouseWheel()
 
     // parse
     std::int16_t xDelta, yDelta;
-    ProtocolUtil::readf(m_stream, kMsgDMouseWheel + 4, &xDelta, &yDelta);
+    ProtocolUtil::read_message_body<kMsgDMouseWheel>(m_stream, &xDelta, &yDelta);
     LOG_DEBUG2("recv mouse wheel %+d,%+d", xDelta, yDelta);
 
     // forward
@@ -775,7 +970,7 @@ ServerProxy::screensaver()
 {
     // parse
     std::int8_t on;
-    ProtocolUtil::readf(m_stream, kMsgCScreenSaver + 4, &on);
+    ProtocolUtil::read_message_body<kMsgCScreenSaver>(m_stream, &on);
     LOG_DEBUG1("recv screen saver on=%d", on);
 
     // forward
@@ -864,10 +1059,7 @@ ServerProxy::infoAcknowledgment()
 void
 ServerProxy::fileChunkReceived()
 {
-    int result = FileChunk::assemble(
-                    m_stream,
-                    m_client->getReceivedFileData(),
-                    m_client->getExpectedFileSize());
+    int result = FileChunk::assemble(m_stream, m_client->getReceivedFile());
 
     if (result == kFinish) {
         m_events->add_event(EventType::FILE_RECEIVE_COMPLETED, m_client);
@@ -891,16 +1083,28 @@ ServerProxy::dragInfoReceived()
     m_client->dragInfoReceived(fileNum, content);
 }
 
-void ServerProxy::handle_clipboard_sending_event(const Event& event)
+void ServerProxy::send_bulk_data()
 {
-    const auto& chunk = event.get_data_as<ClipboardChunk>();
-    ProtocolUtil::writef(m_stream, kMsgDClipboard, chunk.id_, chunk.sequence_, chunk.mark_,
-                         &chunk.data_);
+    // called when bulk data is queued and whenever the stream drains.
+    // other messages are written right away so they only ever wait
+    // behind a window's worth of bulk data.  clipboards go first since
+    // they're usually small and about to be pasted.
+    clipboard_stream_.pump([this](const ClipboardChunk& chunk)
+    {
+        ProtocolUtil::writef(m_stream, kMsgDClipboardSlice, chunk.id_, chunk.sequence_,
+                             chunk.mark_, static_cast<std::uint32_t>(chunk.size_),
+                             reinterpret_cast<const std::uint8_t*>(chunk.bytes()));
+    }, m_stream->getOutputSize());
+    file_stream_.pump([this](const FileChunk& chunk)
+    {
+        ProtocolUtil::writef(m_stream, kMsgDFileTransfer, chunk.mark_, &chunk.data_);
+    }, m_stream->getOutputSize());
 }
 
 void ServerProxy::file_chunk_sending(const FileChunk& chunk)
 {
-    ProtocolUtil::writef(m_stream, kMsgDFileTransfer, chunk.mark_, &chunk.data_);
+    file_stream_.push(chunk);
+    send_bulk_data();
 }
 
 void ServerProxy::sendDragInfo(std::uint32_t fileCount, const char* info, size_t size)
@@ -21,6 +21,9 @@
 #include "inputleap/clipboard_types.h"
 #include "inputleap/key_types.h"
 #include "inputleap/Fwd.h"
+#include "inputleap/Clipboard.h"
+#include "inputleap/ClipboardStream.h"
+#include "inputleap/FileTransferStream.h"
 #include "base/Fwd.h"
 #include "base/Event.h"
 #include "base/EventTarget.h"
@@ -52,6 +55,13 @@ public:
     bool onGrabClipboard(ClipboardID);
     void onClipboardChanged(ClipboardID, const IClipboard*);
 
+    //! Ask the server for promised clipboard data
+    /*!
+    Asks for the data of \p format of clipboard \p id if the server
+    advertised it and it hasn't been asked for yet.
+    */
+    void requestClipboardFormat(ClipboardID id, IClipboard::EFormat format);
+
     //@}
 
     // sending file chunk to server
@@ -61,7 +71,7 @@ public:
     void sendDragInfo(std::uint32_t fileCount, const char* info, size_t size);
 
 #ifdef INPUTLEAP_TEST_ENV
-    void handleDataForTest() { handleData(Event(), nullptr); }
+    void handleDataForTest() { handle_data(); }
 #endif
 
 protected:
@@ -84,12 +94,16 @@ private:
 
     // event handlers
     void handle_data();
+    // handles the messages that are ready.  \p batching tells whether a
+    // fake input batch is open and is updated as batches begin and end.
+    void handle_messages(bool& batching);
     void handle_keep_alive_alarm();
 
     // message handlers
     void enter();
     void leave();
     void setClipboard();
+    void setClipboardFormats();
     void grabClipboard();
     void keyDown();
     void keyRepeat();
@@ -106,7 +120,12 @@ private:
     void infoAcknowledgment();
     void fileChunkReceived();
     void dragInfoReceived();
-    void handle_clipboard_sending_event(const Event&);
+    void send_bulk_data();
+    void supplyClipboardFormats(ClipboardID id, std::uint32_t sequence,
+                                const Clipboard& clipboard);
+    // withdraws every format whose data hasn't arrived.  pending
+    // requests for them fail instead of waiting for a server that's gone.
+    void withdrawPromisedFormats();
 
 private:
     typedef EResult (ServerProxy::*MessageParser)(const std::uint8_t*);
@@ -115,6 +134,23 @@ private:
     inputleap::IStream* m_stream;
 
     std::uint32_t m_seqNum;
+    ClipboardStream clipboard_stream_;
+    FileTransferStream file_stream_;
+
+    // the server's clipboards as last advertised.  the data of each
+    // format is fetched when the screen asks for it.  collected is set
+    // once data had to be kept for a screen that can't defer it.
+    struct PromisedClipboard {
+        bool active = false;
+        std::uint32_t sequence = 0;
+        Clipboard clipboard;
+        std::size_t sizes[IClipboard::kNumFormats] = {};
+        Clipboard::Digest digests[IClipboard::kNumFormats];
+        bool pending[IClipboard::kNumFormats] = {};
+        bool requested[IClipboard::kNumFormats] = {};
+        bool collected = false;
+    };
+    PromisedClipboard promised_clipboards_[kClipboardEnd];
 
     bool m_compressMouse;
     bool m_compressMouseRelative;
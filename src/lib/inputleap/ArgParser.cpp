@@ -143,6 +143,13 @@ ArgParser::parseServerArgs(ServerArgs& args, int argc, const char* const* argv)
             }
             else if (a.shift("--disable-client-cert-checking")) {
                 args.check_client_certificates = false;
+            }
+            else if (a.shift("--socket-threads", nullptr, &optarg)) {
+                int threads = atoi(optarg);
+                if (threads < 1) {
+                    throw XArgvParserError("invalid number of socket threads `%s'", optarg);
+                }
+                args.socket_threads = static_cast<std::size_t>(threads);
             } else {
                 throw XArgvParserError("unrecognized option `%s'", a.peek());
             }
@@ -0,0 +1,275 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "inputleap/ChunkCompressor.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace inputleap {
+
+namespace {
+
+// LZ4 block format parameters
+const std::size_t kMinMatch = 4;
+const std::size_t kLastLiterals = 5;
+const std::size_t kMatchFindLimit = 12;
+const std::size_t kMaxOffset = 65535;
+const unsigned kHashBits = 12;
+
+// chunks smaller than this aren't worth the effort
+const std::size_t kMinCompressSize = 64;
+
+// longest run of chunks sent uncompressed after failing to compress,
+// as a power of two
+const unsigned kMaxMisses = 5;
+
+std::uint32_t read32(const std::uint8_t* p)
+{
+    std::uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+std::uint32_t hash(std::uint32_t value)
+{
+    return (value * 2654435761u) >> (32 - kHashBits);
+}
+
+void write_length(std::string& out, std::size_t length)
+{
+    while (length >= 255) {
+        out.push_back(static_cast<char>(255));
+        length -= 255;
+    }
+    out.push_back(static_cast<char>(length));
+}
+
+void write_sequence(std::string& out, const std::uint8_t* literals, std::size_t literalLength,
+                    std::size_t offset, std::size_t matchLength)
+{
+    std::size_t matchCode = matchLength - kMinMatch;
+    out.push_back(static_cast<char>((std::min<std::size_t>(literalLength, 15) << 4) |
+                                    std::min<std::size_t>(matchCode, 15)));
+    if (literalLength >= 15) {
+        write_length(out, literalLength - 15);
+    }
+    out.append(reinterpret_cast<const char*>(literals), literalLength);
+    out.push_back(static_cast<char>(offset & 0xff));
+    out.push_back(static_cast<char>(offset >> 8));
+    if (matchCode >= 15) {
+        write_length(out, matchCode - 15);
+    }
+}
+
+void write_last_literals(std::string& out, const std::uint8_t* literals, std::size_t length)
+{
+    out.push_back(static_cast<char>(std::min<std::size_t>(length, 15) << 4));
+    if (length >= 15) {
+        write_length(out, length - 15);
+    }
+    out.append(reinterpret_cast<const char*>(literals), length);
+}
+
+// compresses src into out, giving up once out grows past limit
+bool compress_block(const std::uint8_t* src, std::size_t size, std::string& out,
+                    std::size_t limit)
+{
+    out.clear();
+    out.reserve(limit + 16);
+
+    std::size_t anchor = 0;
+    if (size > kMatchFindLimit) {
+        // positions are stored plus one so zero means empty
+        std::uint32_t table[1u << kHashBits] = {};
+        const std::size_t matchLimit = size - kLastLiterals;
+        const std::size_t findLimit = size - kMatchFindLimit;
+
+        std::size_t pos = 0;
+        while (pos < findLimit) {
+            std::uint32_t value = read32(src + pos);
+            std::uint32_t& slot = table[hash(value)];
+            std::size_t candidate = slot;
+            slot = static_cast<std::uint32_t>(pos + 1);
+
+            if (candidate == 0 || pos + 1 - candidate > kMaxOffset ||
+                    read32(src + candidate - 1) != value) {
+                // move faster through data that doesn't match
+                pos += 1 + ((pos - anchor) >> 6);
+                continue;
+            }
+            --candidate;
+
+            std::size_t length = kMinMatch;
+            while (pos + length < matchLimit && src[candidate + length] == src[pos + length]) {
+                ++length;
+            }
+
+            write_sequence(out, src + anchor, pos - anchor, pos - candidate, length);
+            if (out.size() > limit) {
+                return false;
+            }
+            pos += length;
+            anchor = pos;
+        }
+    }
+
+    write_last_literals(out, src + anchor, size - anchor);
+    return out.size() <= limit;
+}
+
+bool read_length(const std::uint8_t* src, std::size_t size, std::size_t& pos,
+                 std::size_t& length)
+{
+    std::uint8_t byte;
+    do {
+        if (pos >= size) {
+            return false;
+        }
+        byte = src[pos++];
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+bool starts_with(const char* data, std::size_t size, std::size_t offset,
+                 const char* signature, std::size_t length)
+{
+    return size >= offset + length && std::memcmp(data + offset, signature, length) == 0;
+}
+
+} // namespace
+
+void ChunkCompressor::reset(bool enabled)
+{
+    enabled_ = enabled;
+    first_ = true;
+    misses_ = 0;
+    skip_ = 0;
+}
+
+bool ChunkCompressor::compress(const char* data, std::size_t size, std::string& out)
+{
+    if (first_) {
+        first_ = false;
+        enabled_ = enabled_ && !looks_compressed(data, size);
+    }
+    if (!enabled_ || size < kMinCompressSize) {
+        return false;
+    }
+    if (skip_ > 0) {
+        --skip_;
+        return false;
+    }
+
+    // only worth it if it saves at least an eighth
+    if (compress_block(reinterpret_cast<const std::uint8_t*>(data), size, out,
+                       size - size / 8)) {
+        misses_ = 0;
+        return true;
+    }
+
+    misses_ = std::min(misses_ + 1, kMaxMisses);
+    skip_ = (std::size_t(1) << misses_) - 1;
+    return false;
+}
+
+bool ChunkCompressor::decompress(const std::string& data, std::string& out, std::size_t limit)
+{
+    const std::uint8_t* src = reinterpret_cast<const std::uint8_t*>(data.data());
+    const std::size_t size = data.size();
+    const std::size_t base = out.size();
+    std::size_t pos = 0;
+
+    while (true) {
+        if (pos >= size) {
+            return false;
+        }
+        std::uint8_t token = src[pos++];
+
+        // literals
+        std::size_t literalLength = token >> 4;
+        if (literalLength == 15 && !read_length(src, size, pos, literalLength)) {
+            return false;
+        }
+        if (literalLength > size - pos || literalLength > limit - (out.size() - base)) {
+            return false;
+        }
+        out.append(reinterpret_cast<const char*>(src + pos), literalLength);
+        pos += literalLength;
+
+        // the last sequence has no match
+        if (pos == size) {
+            return true;
+        }
+
+        // match
+        if (size - pos < 2) {
+            return false;
+        }
+        std::size_t offset = src[pos] | (src[pos + 1] << 8);
+        pos += 2;
+        std::size_t matchLength = token & 15;
+        if (matchLength == 15 && !read_length(src, size, pos, matchLength)) {
+            return false;
+        }
+        matchLength += kMinMatch;
+        std::size_t written = out.size() - base;
+        if (offset == 0 || offset > written || matchLength > limit - written) {
+            return false;
+        }
+
+        // copy byte by byte since the match may overlap itself
+        std::size_t end = out.size();
+        out.resize(end + matchLength);
+        char* dst = &out[0];
+        for (std::size_t i = 0; i < matchLength; ++i) {
+            dst[end + i] = dst[end - offset + i];
+        }
+    }
+}
+
+bool ChunkCompressor::is_compressible(IClipboard::EFormat format)
+{
+    switch (format) {
+    case IClipboard::kPNG:
+    case IClipboard::kJpeg:
+    case IClipboard::kWebp:
+        return false;
+
+    default:
+        return true;
+    }
+}
+
+bool ChunkCompressor::looks_compressed(const char* data, std::size_t size)
+{
+    return starts_with(data, size, 0, "\x89PNG", 4) ||
+           starts_with(data, size, 0, "\xff\xd8\xff", 3) ||
+           starts_with(data, size, 0, "GIF8", 4) ||
+           (starts_with(data, size, 0, "RIFF", 4) && starts_with(data, size, 8, "WEBP", 4)) ||
+           starts_with(data, size, 4, "ftyp", 4) ||
+           starts_with(data, size, 0, "PK\x03\x04", 4) ||
+           starts_with(data, size, 0, "\x1f\x8b", 2) ||
+           starts_with(data, size, 0, "\x28\xb5\x2f\xfd", 4) ||
+           starts_with(data, size, 0, "\xfd" "7zXZ", 5) ||
+           starts_with(data, size, 0, "BZh", 3) ||
+           starts_with(data, size, 0, "7z\xbc\xaf\x27\x1c", 6);
+}
+
+} // namespace inputleap
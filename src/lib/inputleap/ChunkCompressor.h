@@ -0,0 +1,93 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "inputleap/IClipboard.h"
+
+#include <cstddef>
+#include <string>
+
+namespace inputleap {
+
+//! Compression of clipboard and file transfer chunks
+/*!
+Compresses the chunks of one transfer into the LZ4 block format.  Each
+chunk is compressed on its own so the receiver can inflate it as soon
+as it arrives.
+
+Compression is skipped when it doesn't pay:  a chunk is only sent
+compressed if that saves at least an eighth of its size, and after a
+chunk that doesn't compress the next chunks are sent as they are for
+an exponentially growing stretch before trying again.  Transfers of
+data that is already compressed skip compression altogether, either
+because the caller says so or because the first chunk starts like a
+compressed file.
+*/
+class ChunkCompressor {
+public:
+    //! @name manipulators
+    //@{
+
+    //! Start a new transfer
+    /*!
+    Forgets what was learned about the previous transfer.  If \p enabled
+    is false no chunk of the new transfer is compressed.
+    */
+    void reset(bool enabled = true);
+
+    //! Compress a chunk
+    /*!
+    Returns true and sets \p out to the compressed \p data if that is
+    worth sending instead of \p data.
+    */
+    bool compress(const char* data, std::size_t size, std::string& out);
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Inflate a compressed chunk
+    /*!
+    Appends the chunk in \p data to \p out.  Returns false if the chunk
+    is corrupt or would inflate to more than \p limit bytes.
+    */
+    static bool decompress(const std::string& data, std::string& out, std::size_t limit);
+
+    //! Check if a clipboard format is worth compressing
+    /*!
+    Returns false for formats that are compressed already.
+    */
+    static bool is_compressible(IClipboard::EFormat format);
+
+    //! Check if data starts like a compressed file
+    /*!
+    Recognizes common compressed image and archive formats by their
+    signature.
+    */
+    static bool looks_compressed(const char* data, std::size_t size);
+
+    //@}
+
+private:
+    bool enabled_ = true;
+    bool first_ = true;
+    unsigned misses_ = 0;
+    std::size_t skip_ = 0;
+};
+
+} // namespace inputleap
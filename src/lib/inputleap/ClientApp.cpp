@@ -421,6 +421,9 @@ ClientApp::mainLoop()
     // on unix because threads evaporate across a fork().
     setSocketMultiplexer(std::make_unique<SocketMultiplexer>());
 
+    // likewise for the thread writing the log
+    CLOG->setAsync(true);
+
     // start client, etc
     appUtil().startNode();
 
@@ -456,6 +459,7 @@ ClientApp::mainLoop()
     stopClient();
     updateStatus();
     LOG_NOTE("stopped client");
+    CLOG->setAsync(false);
 
     if (argsBase().m_enableIpc) {
         cleanupIpcClient();
@@ -21,9 +21,65 @@
 
 namespace inputleap {
 
+namespace {
+
+const std::uint64_t kPrime1 = 0x9e3779b185ebca87ull;
+const std::uint64_t kPrime2 = 0xc2b2ae3d27d4eb4full;
+const std::uint64_t kPrime3 = 0x165667b19e3779f9ull;
+const std::uint64_t kPrime4 = 0x85ebca77c2b2ae63ull;
+
+std::uint64_t rotl(std::uint64_t v, int n)
+{
+    return (v << n) | (v >> (64 - n));
+}
+
+std::uint64_t avalanche(std::uint64_t v)
+{
+    v ^= v >> 33;
+    v *= 0xff51afd7ed558ccdull;
+    v ^= v >> 33;
+    v *= 0xc4ceb9fe1a85ec53ull;
+    v ^= v >> 33;
+    return v;
+}
+
+// loads up to 8 bytes as a little endian word
+std::uint64_t load(const unsigned char* p, std::size_t size)
+{
+    std::uint64_t w = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+        w |= static_cast<std::uint64_t>(p[i]) << (8 * i);
+    }
+    return w;
+}
+
+// two independent 64 bit lanes over 8 byte words.  words are read in a
+// fixed byte order because format digests are compared across hosts.
+Clipboard::Digest hash(const void* data, std::size_t size, std::uint64_t seed)
+{
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    std::uint64_t a = seed ^ kPrime1;
+    std::uint64_t b = seed ^ kPrime2;
+
+    for (; size >= 8; size -= 8, p += 8) {
+        std::uint64_t w = load(p, 8);
+        a = rotl(a ^ (w * kPrime2), 31) * kPrime1;
+        b = rotl(b + (w * kPrime4), 27) * kPrime3;
+    }
+
+    std::uint64_t tail = load(p, size);
+    a ^= tail * kPrime3;
+    b += tail * kPrime1;
+
+    return {{ avalanche(a ^ rotl(b, 17)), avalanche(b + rotl(a, 41)) }};
+}
+
+} // namespace
+
 Clipboard::Clipboard() :
     m_open(false),
-    m_owner(false)
+    m_owner(false),
+    m_marshalledSize(4)
 {
     open(0);
     clear();
@@ -44,7 +100,11 @@ Clipboard::clear()
     for (std::int32_t index = 0; index < kNumFormats; ++index) {
         m_data[index]  = "";
         m_added[index] = false;
+        m_promised[index] = false;
+        m_demanded[index] = false;
+        m_hashed[index] = false;
     }
+    m_marshalledSize = 4;
 
     // save time
     m_timeOwned = m_time;
@@ -61,8 +121,31 @@ Clipboard::add(EFormat format, const std::string& data)
     assert(m_open);
     assert(m_owner);
 
+    set_data(format, data);
+    m_promised[format] = false;
+}
+
+bool
+Clipboard::promise(EFormat format)
+{
+    assert(m_open);
+    assert(m_owner);
+
+    set_data(format, std::string());
+    m_promised[format] = true;
+    m_demanded[format] = false;
+    return true;
+}
+
+void Clipboard::set_data(EFormat format, const std::string& data)
+{
+    if (m_added[format]) {
+        m_marshalledSize -= 4 + 4 + m_data[format].size();
+    }
     m_data[format]  = data;
     m_added[format] = true;
+    m_hashed[format] = false;
+    m_marshalledSize += 4 + 4 + data.size();
 }
 
 bool
@@ -100,9 +183,18 @@ Clipboard::has(EFormat format) const
 std::string Clipboard::get(EFormat format) const
 {
     assert(m_open);
+    if (m_promised[format]) {
+        m_demanded[format] = true;
+    }
     return m_data[format];
 }
 
+bool Clipboard::is_promised(EFormat format) const
+{
+    assert(m_open);
+    return m_promised[format];
+}
+
 void
 Clipboard::unmarshall(const std::string& data, Time time)
 {
@@ -114,4 +206,49 @@ std::string Clipboard::marshall() const
     return IClipboard::marshall(this);
 }
 
+std::size_t Clipboard::marshalled_size() const
+{
+    return m_marshalledSize;
+}
+
+Clipboard::Digest Clipboard::digest() const
+{
+    // combine the format ids, sizes and per-format hashes
+    std::uint64_t summary[kNumFormats * 4];
+    std::size_t n = 0;
+    for (std::int32_t index = 0; index < kNumFormats; ++index) {
+        if (!m_added[index]) {
+            continue;
+        }
+        Digest format = digest(static_cast<EFormat>(index));
+        summary[n++] = static_cast<std::uint64_t>(index);
+        summary[n++] = m_data[index].size();
+        summary[n++] = format[0];
+        summary[n++] = format[1];
+    }
+    return hash(summary, n * sizeof(summary[0]), 0);
+}
+
+Clipboard::Digest Clipboard::digest(EFormat format) const
+{
+    if (!m_added[format]) {
+        return {};
+    }
+    if (!m_hashed[format]) {
+        m_hash[format] = hash(m_data[format].data(), m_data[format].size(), format);
+        m_hashed[format] = true;
+    }
+    return m_hash[format];
+}
+
+std::size_t Clipboard::size(EFormat format) const
+{
+    return m_data[format].size();
+}
+
+bool Clipboard::is_demanded(EFormat format) const
+{
+    return m_demanded[format];
+}
+
 } // namespace inputleap
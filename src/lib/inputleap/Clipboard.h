@@ -19,15 +19,32 @@
 #pragma once
 
 #include "inputleap/IClipboard.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
 
 namespace inputleap {
 
 //! Memory buffer clipboard
 /*!
-This class implements a clipboard that stores data in memory.
+This class implements a clipboard that stores data in memory.  It
+tracks the size of its marshalled form and a digest of its contents so
+callers can check for changes and enforce size limits without
+marshalling.
+
+Formats may be promised and have their data added later.  get() on a
+promised format returns the empty string and records that the data
+was asked for.
 */
 class Clipboard : public IClipboard {
 public:
+    //! Content digest
+    /*!
+    A 128 bit non-cryptographic hash of the formats and data in a
+    clipboard.  Equal contents always have equal digests.
+    */
+    using Digest = std::array<std::uint64_t, 2>;
+
     Clipboard();
     virtual ~Clipboard();
 
@@ -52,24 +69,68 @@ public:
     */
     std::string marshall() const;
 
+    //! Get marshalled size
+    /*!
+    Return the size of the buffer marshall() would return.
+    */
+    std::size_t marshalled_size() const;
+
+    //! Get content digest
+    /*!
+    Return a digest of the clipboard's formats and data.  Each format
+    is hashed the first time it's needed after it changes, so repeated
+    calls on an unchanged clipboard are cheap.
+    */
+    Digest digest() const;
+
+    //! Get format digest
+    /*!
+    Return a digest of the data in the given format, or all zeroes if
+    the clipboard doesn't have the format.  Format digests don't depend
+    on the host so they can be compared with a peer's.
+    */
+    Digest digest(EFormat) const;
+
+    //! Get format size
+    /*!
+    Return the size of the data in the given format.
+    */
+    std::size_t size(EFormat) const;
+
+    //! Check if promised data was asked for
+    /*!
+    Return true iff get() was called for the given format while it was
+    promised.
+    */
+    bool is_demanded(EFormat) const;
+
     //@}
 
     // IClipboard overrides
     bool clear() override;
     void add(EFormat, const std::string& data) override;
+    bool promise(EFormat) override;
     bool open(Time) const override;
     void close() const override;
     Time getTime() const override;
     bool has(EFormat) const override;
     std::string get(EFormat) const override;
+    bool is_promised(EFormat) const override;
 
 private:
+    void set_data(EFormat, const std::string& data);
+
     mutable bool m_open;
     mutable Time m_time;
     bool m_owner;
     Time m_timeOwned;
     bool m_added[kNumFormats];
     std::string m_data[kNumFormats];
+    bool m_promised[kNumFormats];
+    mutable bool m_demanded[kNumFormats];
+    std::size_t m_marshalledSize;
+    mutable bool m_hashed[kNumFormats];
+    mutable Digest m_hash[kNumFormats];
 };
 
 } // namespace inputleap
@@ -17,11 +17,13 @@
 
 #include "inputleap/ClipboardChunk.h"
 
+#include "inputleap/ChunkCompressor.h"
 #include "inputleap/ProtocolUtil.h"
 #include "inputleap/protocol_types.h"
 #include "io/IStream.h"
 #include "base/Log.h"
 #include "base/String.h"
+#include <algorithm>
 #include <cstring>
 
 namespace inputleap {
@@ -35,18 +37,34 @@ ClipboardChunk ClipboardChunk::start(ClipboardID id, std::uint32_t sequence,
     chunk.id_ = id;
     chunk.sequence_ = sequence;
     chunk.mark_ = kDataStart;
-    chunk.data_ = std::to_string(size);
+    chunk.buffer_ = std::make_shared<const std::string>(std::to_string(size));
+    chunk.size_ = chunk.buffer_->size();
     return chunk;
 }
 
 ClipboardChunk ClipboardChunk::data(ClipboardID id, std::uint32_t sequence,
-                                    const std::string& data)
+                                    std::shared_ptr<const std::string> buffer,
+                                    std::size_t offset, std::size_t size)
 {
     ClipboardChunk chunk;
     chunk.id_ = id;
     chunk.sequence_ = sequence;
     chunk.mark_ = kDataChunk;
-    chunk.data_ = data;
+    chunk.buffer_ = std::move(buffer);
+    chunk.offset_ = offset;
+    chunk.size_ = size;
+    return chunk;
+}
+
+ClipboardChunk ClipboardChunk::compressed(ClipboardID id, std::uint32_t sequence,
+                                          std::shared_ptr<const std::string> buffer)
+{
+    ClipboardChunk chunk;
+    chunk.id_ = id;
+    chunk.sequence_ = sequence;
+    chunk.mark_ = kDataChunkLZ4;
+    chunk.buffer_ = std::move(buffer);
+    chunk.size_ = chunk.buffer_->size();
     return chunk;
 }
 
@@ -73,12 +91,25 @@ int ClipboardChunk::assemble(inputleap::IStream* stream, std::string& dataCached
         s_expectedSize = inputleap::string::stringToSizeType(data);
         LOG_DEBUG("start receiving clipboard data");
         dataCached.clear();
+
+        // make room for the whole clipboard up front so appending the
+        // chunks rarely reallocates.  the size comes from the peer so
+        // don't trust it with more than a bounded allocation.
+        dataCached.reserve(std::min(s_expectedSize, kMaxReservedSize));
         return kStart;
     }
     else if (mark == kDataChunk) {
         dataCached.append(data);
         return kNotFinish;
     }
+    else if (mark == kDataChunkLZ4) {
+        std::size_t remaining = s_expectedSize - std::min(s_expectedSize, dataCached.size());
+        if (!ChunkCompressor::decompress(data, dataCached, remaining)) {
+            LOG_ERR("corrupted compressed clipboard chunk, size=%zd", data.size());
+            return kError;
+        }
+        return kNotFinish;
+    }
     else if (mark == kDataEnd) {
         // validate
         if (id >= kClipboardEnd) {
@@ -20,6 +20,7 @@
 #include "inputleap/clipboard_types.h"
 
 #include <cstdint>
+#include <memory>
 #include <string>
 
 #define CLIPBOARD_CHUNK_META_SIZE 7
@@ -32,7 +33,11 @@ class ClipboardChunk {
 public:
 
     static ClipboardChunk start(ClipboardID id, std::uint32_t sequence, const std::size_t& size);
-    static ClipboardChunk data(ClipboardID id, std::uint32_t sequence, const std::string& data);
+    static ClipboardChunk data(ClipboardID id, std::uint32_t sequence,
+                               std::shared_ptr<const std::string> buffer,
+                               std::size_t offset, std::size_t size);
+    static ClipboardChunk compressed(ClipboardID id, std::uint32_t sequence,
+                                     std::shared_ptr<const std::string> buffer);
     static ClipboardChunk end(ClipboardID id, std::uint32_t sequence);
 
     static int assemble(inputleap::IStream* stream, std::string& dataCached, ClipboardID& id,
@@ -40,10 +45,21 @@ public:
 
     static size_t getExpectedSize() { return s_expectedSize; }
 
+    // the most assemble() reserves up front for the size the peer
+    // announced.  larger clipboards grow as their chunks arrive.
+    static constexpr std::size_t kMaxReservedSize = 16 * 1024 * 1024;
+
+    const char* bytes() const { return buffer_ ? buffer_->data() + offset_ : ""; }
+
     std::uint8_t id_ = 0;
     std::uint32_t sequence_ = 0;
     std::uint8_t mark_ = 0;
-    std::string data_;
+
+    // the chunk's payload is [offset_, offset_ + size_) in buffer_.  data
+    // chunks share the marshalled clipboard rather than copying it.
+    std::shared_ptr<const std::string> buffer_;
+    std::size_t offset_ = 0;
+    std::size_t size_ = 0;
 
 private:
     static size_t        s_expectedSize;
@@ -0,0 +1,108 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "inputleap/ClipboardStream.h"
+#include "base/Log.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace inputleap {
+
+const std::size_t ClipboardStream::kChunkSize = 32 * 1024;
+const std::size_t ClipboardStream::kDefaultWindow = 64 * 1024;
+
+ClipboardStream::ClipboardStream(std::size_t window) :
+    window_(std::max(window, kChunkSize))
+{
+}
+
+void ClipboardStream::push(ClipboardID id, std::uint32_t sequence,
+                           std::shared_ptr<const std::string> data, bool replace,
+                           bool compressible)
+{
+    // a newer clipboard supersedes one that hasn't started sending
+    for (auto& transfer : transfers_) {
+        if (replace && transfer.id == id && !transfer.started) {
+            transfer.sequence = sequence;
+            transfer.data = std::move(data);
+            transfer.compressor.reset(compressible);
+            return;
+        }
+    }
+    transfers_.push_back(Transfer{id, sequence, std::move(data), 0, 0, false, {}});
+    transfers_.back().compressor.reset(compressible);
+}
+
+bool ClipboardStream::pump(const Writer& writer, std::size_t buffered)
+{
+    bool wrote = false;
+    std::size_t written = buffered;
+    while (!transfers_.empty() && written < window_) {
+        Transfer& transfer = transfers_.front();
+        wrote = true;
+
+        if (!transfer.started) {
+            transfer.started = true;
+            writer(ClipboardChunk::start(transfer.id, transfer.sequence,
+                                         transfer.data->size()));
+        }
+        else if (transfer.offset < transfer.data->size()) {
+            std::size_t size = std::min(kChunkSize, transfer.data->size() - transfer.offset);
+            std::string packed;
+            if (compression_ &&
+                    transfer.compressor.compress(transfer.data->data() + transfer.offset,
+                                                 size, packed)) {
+                auto buffer = std::make_shared<const std::string>(std::move(packed));
+                writer(ClipboardChunk::compressed(transfer.id, transfer.sequence, buffer));
+                transfer.sent += buffer->size();
+                written += buffer->size();
+            }
+            else {
+                writer(ClipboardChunk::data(transfer.id, transfer.sequence, transfer.data,
+                                            transfer.offset, size));
+                transfer.sent += size;
+                written += size;
+            }
+            transfer.offset += size;
+        }
+        else {
+            writer(ClipboardChunk::end(transfer.id, transfer.sequence));
+            LOG_DEBUG("sent clipboard size=%zd wire size=%zd",
+                      transfer.data->size(), transfer.sent);
+            transfers_.pop_front();
+        }
+    }
+    return wrote;
+}
+
+void ClipboardStream::clear()
+{
+    transfers_.clear();
+}
+
+void ClipboardStream::set_compression(bool enabled)
+{
+    compression_ = enabled;
+}
+
+bool ClipboardStream::empty() const
+{
+    return transfers_.empty();
+}
+
+} // namespace inputleap
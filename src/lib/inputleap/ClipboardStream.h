@@ -0,0 +1,112 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "inputleap/ChunkCompressor.h"
+#include "inputleap/ClipboardChunk.h"
+#include "inputleap/clipboard_types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace inputleap {
+
+//! Outgoing clipboard transfers
+/*!
+Splits marshalled clipboards into chunks on demand.  A connection calls
+pump() when a clipboard is queued and again each time its stream has
+drained;  each call tops the stream's unsent output up to a window's
+worth of data.  Chunks are slices of the queued buffer, so a clipboard
+is only held once no matter how large it is.
+
+Clipboards are sent one at a time in the order they were queued.  A
+queued clipboard that hasn't started yet is replaced by a newer one
+with the same id.
+
+If compression is enabled, data chunks are sent compressed whenever
+that makes them noticeably smaller.
+*/
+class ClipboardStream {
+public:
+    using Writer = std::function<void(const ClipboardChunk&)>;
+
+    //! Create a stream keeping up to \p window bytes of data unsent
+    explicit ClipboardStream(std::size_t window = kDefaultWindow);
+
+    //! @name manipulators
+    //@{
+
+    //! Queue a marshalled clipboard for sending
+    /*!
+    Unless \p replace is false, a queued clipboard with the same id that
+    hasn't started sending is replaced instead.  \p compressible should
+    be false if the data is known to be compressed already.
+    */
+    void push(ClipboardID id, std::uint32_t sequence, std::shared_ptr<const std::string> data,
+              bool replace = true, bool compressible = true);
+
+    //! Write the next chunks
+    /*!
+    Passes chunks to \p writer until \p buffered, the number of bytes
+    the stream has yet to send, plus the data written reaches the window
+    or nothing is left.  Returns true if anything was written.
+    */
+    bool pump(const Writer& writer, std::size_t buffered = 0);
+
+    //! Discard all queued clipboards
+    void clear();
+
+    //! Enable or disable compression of data chunks
+    /*!
+    Only enable compression if the receiver understands kDataChunkLZ4.
+    */
+    void set_compression(bool enabled);
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Check if there is nothing left to send
+    bool empty() const;
+
+    //@}
+
+    static const std::size_t kChunkSize;
+    static const std::size_t kDefaultWindow;
+
+private:
+    struct Transfer {
+        ClipboardID id;
+        std::uint32_t sequence;
+        std::shared_ptr<const std::string> data;
+        std::size_t offset;
+        std::size_t sent;
+        bool started;
+        ChunkCompressor compressor;
+    };
+
+    std::deque<Transfer> transfers_;
+    std::size_t window_;
+    bool compression_ = false;
+};
+
+} // namespace inputleap
@@ -20,17 +20,17 @@
 #include "base/Log.h"
 #include "io/filesystem.h"
 
-#include <fstream>
+#include <system_error>
 
 namespace inputleap {
 
 void
-DropHelper::writeToDir(const std::string& destination, DragFileList& fileList, std::string& data)
+DropHelper::writeToDir(const std::string& destination, DragFileList& fileList,
+                       const fs::path& received)
 {
     LOG_DEBUG("dropping file, files=%zi target=%s", fileList.size(), destination.c_str());
 
     if (!destination.empty() && fileList.size() > 0) {
-        std::fstream file;
         std::string dropTarget = destination;
 #ifdef SYSAPI_WIN32
         dropTarget.append("\\");
@@ -38,13 +38,24 @@ DropHelper::writeToDir(const std::string& destination, DragFileList& fileList, s
         dropTarget.append("/");
 #endif
         dropTarget.append(fileList.at(0).getFilename());
-        open_utf8_path(file, dropTarget, std::ios::out | std::ios::binary);
-        if (!file.is_open()) {
-            LOG_ERR("drop file failed: can not open %s", dropTarget.c_str());
-        }
+        fs::path target = fs::u8path(dropTarget);
 
-        file.write(data.c_str(), data.size());
-        file.close();
+        // the transfer is written to the drop directory when it's known
+        // up front, so a rename is all it takes.  otherwise the file may
+        // be on another file system and has to be copied.
+        std::error_code error;
+        fs::rename(received, target, error);
+        if (error) {
+            error.clear();
+            fs::copy_file(received, target, fs::copy_options::overwrite_existing, error);
+            std::error_code ignored;
+            fs::remove(received, ignored);
+        }
+        if (error) {
+            LOG_ERR("drop file failed: can not write %s: %s", dropTarget.c_str(),
+                    error.message().c_str());
+            return;
+        }
 
         LOG_INFO("dropped file \"%s\" in \"%s\"", fileList.at(0).getFilename().c_str(), destination.c_str());
 
@@ -52,6 +63,8 @@ DropHelper::writeToDir(const std::string& destination, DragFileList& fileList, s
     }
     else {
         LOG_ERR("drop file failed: drop target is empty");
+        std::error_code ignored;
+        fs::remove(received, ignored);
     }
 }
 
@@ -18,14 +18,21 @@
 #pragma once
 
 #include "inputleap/DragInformation.h"
+#include "io/filesystem.h"
 #include <string>
 
 namespace inputleap {
 
 class DropHelper {
 public:
+    //! Move a received file into the drop target
+    /*!
+    \p received is the finished temporary file of the transfer.  It is
+    moved, or copied if it's on another file system, to \p destination
+    under the name of the first dragged file, and removed either way.
+    */
     static void writeToDir(const std::string& destination,
-                           DragFileList& fileList, std::string& data);
+                           DragFileList& fileList, const fs::path& received);
 };
 
 } // namespace inputleap
@@ -17,6 +17,8 @@
 
 #include "inputleap/FileChunk.h"
 
+#include "inputleap/ChunkCompressor.h"
+#include "inputleap/IncomingFile.h"
 #include "inputleap/ProtocolUtil.h"
 #include "inputleap/protocol_types.h"
 #include "io/IStream.h"
@@ -24,6 +26,8 @@
 #include "base/String.h"
 #include "base/Log.h"
 
+#include <utility>
+
 namespace inputleap {
 
 static const std::uint16_t kIntervalThreshold = 1;
@@ -44,6 +48,14 @@ FileChunk FileChunk::data(std::uint8_t* data, size_t dataSize)
     return chunk;
 }
 
+FileChunk FileChunk::data(std::string data)
+{
+    FileChunk chunk;
+    chunk.mark_ = kDataChunk;
+    chunk.data_ = std::move(data);
+    return chunk;
+}
+
 FileChunk FileChunk::end()
 {
     FileChunk chunk;
@@ -51,11 +63,12 @@ FileChunk FileChunk::end()
     return chunk;
 }
 
-int FileChunk::assemble(inputleap::IStream* stream, std::string& dataReceived, size_t& expectedSize)
+int FileChunk::assemble(inputleap::IStream* stream, IncomingFile& file)
 {
     // parse
     std::uint8_t mark = 0;
     std::string content;
+    static std::string inflated;
     static size_t receivedDataSize;
     static double elapsedTime;
     static Stopwatch stopwatch;
@@ -66,8 +79,9 @@ int FileChunk::assemble(inputleap::IStream* stream, std::string& dataReceived, s
 
     switch (mark) {
     case kDataStart:
-        dataReceived.clear();
-        expectedSize = inputleap::string::stringToSizeType(content);
+        if (!file.start(inputleap::string::stringToSizeType(content))) {
+            return kError;
+        }
         receivedDataSize = 0;
         elapsedTime = 0;
         stopwatch.reset();
@@ -79,7 +93,22 @@ int FileChunk::assemble(inputleap::IStream* stream, std::string& dataReceived, s
         return kStart;
 
     case kDataChunk:
-        dataReceived.append(content);
+    case kDataChunkLZ4:
+        if (mark == kDataChunkLZ4) {
+            inflated.clear();
+            if (!ChunkCompressor::decompress(content, inflated, file.size() - file.received())) {
+                LOG_ERR("corrupted compressed file chunk, size=%zd", content.size());
+                file.discard();
+                return kError;
+            }
+            content.swap(inflated);
+        }
+        if (!file.write(content.data(), content.size())) {
+            LOG_ERR("corrupted file data, expected size=%zd received size=%zd",
+                    file.size(), file.received() + content.size());
+            file.discard();
+            return kError;
+        }
         if (CLOG->getFilter() >= kDEBUG2) {
                 LOG_DEBUG2("recv file chunk size=%zi", content.size());
                 double interval = stopwatch.getTime();
@@ -97,17 +126,19 @@ int FileChunk::assemble(inputleap::IStream* stream, std::string& dataReceived, s
         return kNotFinish;
 
     case kDataEnd:
-        if (expectedSize != dataReceived.size()) {
-            LOG_ERR("corrupted clipboard data, expected size=%zd actual size=%zd", expectedSize, dataReceived.size());
+        if (!file.finish()) {
+            LOG_ERR("corrupted file data, expected size=%zd actual size=%zd",
+                    file.size(), file.received());
+            file.discard();
             return kError;
         }
 
         if (CLOG->getFilter() >= kDEBUG2) {
             LOG_DEBUG2("file transfer finished");
             elapsedTime += stopwatch.getTime();
-            double averageSpeed = expectedSize / elapsedTime / 1000;
+            double averageSpeed = file.size() / elapsedTime / 1000;
             LOG_DEBUG2("file transfer finished: total time consumed=%f s", elapsedTime);
-            LOG_DEBUG2("file transfer finished: total data received=%zi kb", expectedSize / 1000);
+            LOG_DEBUG2("file transfer finished: total data received=%zi kb", file.size() / 1000);
             LOG_DEBUG2("file transfer finished: total average speed=%f kb/s", averageSpeed);
         }
         return kFinish;
@@ -18,23 +18,34 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
 
 #define FILE_CHUNK_META_SIZE 2
 
 namespace inputleap {
 
+class IncomingFile;
 class IStream;
 
 class FileChunk {
 public:
     static FileChunk start(std::size_t size);
     static FileChunk data(std::uint8_t* data, size_t dataSize);
+    static FileChunk data(std::string data);
     static FileChunk end();
-    static int assemble(inputleap::IStream* stream, std::string& dataCached, size_t& expectedSize);
+    static int assemble(inputleap::IStream* stream, IncomingFile& file);
 
     std::uint8_t mark_ = 0;
     std::string data_;
+
+    //! Keeps the sender's read-ahead window taken until the chunk is sent
+    std::shared_ptr<void> credit_;
+
+    //! Takes data_ back once the chunk has been written, so the sender
+    //! can read the next chunk into it
+    std::function<void(std::string&&)> recycle_;
 };
 
 } // namespace inputleap
@@ -0,0 +1,85 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "inputleap/FileTransferStream.h"
+
+#include "inputleap/protocol_types.h"
+
+#include <string>
+#include <utility>
+
+namespace inputleap {
+
+const std::size_t FileTransferStream::kDefaultWindow = 64 * 1024;
+
+FileTransferStream::FileTransferStream(std::size_t window) :
+    window_(window)
+{
+}
+
+void FileTransferStream::push(FileChunk chunk)
+{
+    chunks_.push_back(std::move(chunk));
+}
+
+bool FileTransferStream::pump(const Writer& writer, std::size_t buffered)
+{
+    bool wrote = false;
+    std::size_t written = buffered;
+    std::string packed;
+    while (!chunks_.empty() && written < window_) {
+        FileChunk& chunk = chunks_.front();
+        bool compressed = false;
+        if (chunk.mark_ == kDataStart) {
+            compressor_.reset(compression_);
+        }
+        else if (compression_ && chunk.mark_ == kDataChunk &&
+                 compressor_.compress(chunk.data_.data(), chunk.data_.size(), packed)) {
+            chunk.mark_ = kDataChunkLZ4;
+            chunk.data_.swap(packed);
+            compressed = true;
+        }
+        writer(chunk);
+        written += chunk.data_.size();
+        if (compressed) {
+            chunk.data_.swap(packed);
+        }
+        if (chunk.recycle_) {
+            chunk.recycle_(std::move(chunk.data_));
+        }
+        chunks_.pop_front();
+        wrote = true;
+    }
+    return wrote;
+}
+
+void FileTransferStream::clear()
+{
+    chunks_.clear();
+}
+
+void FileTransferStream::set_compression(bool enabled)
+{
+    compression_ = enabled;
+}
+
+bool FileTransferStream::empty() const
+{
+    return chunks_.empty();
+}
+
+} // namespace inputleap
@@ -0,0 +1,87 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "inputleap/ChunkCompressor.h"
+#include "inputleap/FileChunk.h"
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+
+namespace inputleap {
+
+//! Outgoing file transfers
+/*!
+Holds file chunks until the connection has room for them.  Like
+ClipboardStream, a connection calls pump() when a chunk is queued and
+again each time its stream has drained, so other messages never wait
+behind more than a window's worth of file data.
+
+If compression is enabled, data chunks are sent compressed whenever
+that makes them noticeably smaller.
+*/
+class FileTransferStream {
+public:
+    using Writer = std::function<void(const FileChunk&)>;
+
+    //! Create a stream keeping up to \p window bytes of data unsent
+    explicit FileTransferStream(std::size_t window = kDefaultWindow);
+
+    //! @name manipulators
+    //@{
+
+    //! Queue a chunk for sending
+    void push(FileChunk chunk);
+
+    //! Write the next chunks
+    /*!
+    Passes chunks to \p writer until \p buffered, the number of bytes
+    the stream has yet to send, plus the data written reaches the window
+    or nothing is left.  Returns true if anything was written.
+    */
+    bool pump(const Writer& writer, std::size_t buffered = 0);
+
+    //! Discard all queued chunks
+    void clear();
+
+    //! Enable or disable compression of data chunks
+    /*!
+    Only enable compression if the receiver understands kDataChunkLZ4.
+    */
+    void set_compression(bool enabled);
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Check if there is nothing left to send
+    bool empty() const;
+
+    //@}
+
+    static const std::size_t kDefaultWindow;
+
+private:
+    std::deque<FileChunk> chunks_;
+    std::size_t window_;
+    ChunkCompressor compressor_;
+    bool compression_ = false;
+};
+
+} // namespace inputleap
@@ -131,8 +131,18 @@ IClipboard::copy(IClipboard* dst, const IClipboard* src, Time time)
                 for (std::int32_t format = 0;
                                 format != IClipboard::kNumFormats; ++format) {
                     IClipboard::EFormat eFormat = static_cast<IClipboard::EFormat>(format);
-                    if (src->has(eFormat)) {
-                        dst->add(eFormat, src->get(eFormat));
+                    if (!src->has(eFormat)) {
+                        continue;
+                    }
+                    if (src->is_promised(eFormat) && dst->promise(eFormat)) {
+                        continue;
+                    }
+
+                    // getting promised data asks the source for it but
+                    // there's nothing to add until it has arrived
+                    std::string data = src->get(eFormat);
+                    if (!src->is_promised(eFormat)) {
+                        dst->add(eFormat, data);
                     }
                 }
                 success = true;
@@ -88,6 +88,15 @@ public:
     */
     virtual void add(EFormat, const std::string& data) = 0;
 
+    //! Promise data
+    /*!
+    Add the given format to the clipboard without its data, which will
+    be supplied later.  May only be called after a successful empty().
+    Returns false if the clipboard can't defer data, in which case the
+    data must be added with add() instead.
+    */
+    virtual bool promise(EFormat) { return false; }
+
     //@}
     //! @name accessors
     //@{
@@ -134,6 +143,15 @@ public:
     */
     virtual std::string get(EFormat) const = 0;
 
+    //! Check for promised data
+    /*!
+    Return true iff the clipboard has the given format but its data
+    was promised and hasn't been supplied yet.  get() returns the empty
+    string for such a format.  Must be called between a successful
+    open() and close().
+    */
+    virtual bool is_promised(EFormat) const { return false; }
+
     //! Marshall clipboard data
     /*!
     Merge \p clipboard's data into a single buffer that can be later
@@ -154,7 +172,9 @@ public:
     clipboards can be of any concrete clipboard type (and
     they don't have to be the same type).  This also sets
     the destination clipboard's timestamp to source clipboard's
-    timestamp.  Returns true iff the copy succeeded.
+    timestamp.  Promised formats stay promised if the destination
+    can keep the promise and are skipped otherwise.  Returns true
+    iff the copy succeeded.
     */
     static bool copy(IClipboard* dst, const IClipboard* src);
 
@@ -141,6 +141,21 @@ public:
      */
     virtual bool fakeMediaKey(KeyID id) = 0;
 
+    //! Begin a batch of fake events
+    /*!
+    Events synthesized until the matching \c endFakeBatch() may be queued
+    and sent to the system together instead of one at a time.  Batches
+    may be nested.
+    */
+    virtual void beginFakeBatch() = 0;
+
+    //! End a batch of fake events
+    /*!
+    Ends a batch started by \c beginFakeBatch().  The queued events are
+    sent when the outermost batch ends.
+    */
+    virtual void endFakeBatch() = 0;
+
     //@}
     //! @name accessors
     //@{
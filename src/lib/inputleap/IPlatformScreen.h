@@ -84,6 +84,24 @@ public:
     */
     virtual bool setClipboard(ClipboardID id, const IClipboard*) = 0;
 
+    //! Supply promised clipboard data
+    /*!
+    Supply \c data for \c format of the clipboard indicated by \c id
+    after the last setClipboard() promised it.  Returns false if the
+    system clipboard isn't waiting for that format, e.g. because the
+    platform can't defer clipboard data.
+    */
+    virtual bool setClipboardFormat(ClipboardID id, IClipboard::EFormat format,
+                                    const std::string& data) = 0;
+
+    //! Withdraw promised clipboard data
+    /*!
+    Tell the system clipboard indicated by \c id that the data for
+    \c format the last setClipboard() promised won't arrive.  Requests
+    waiting for it fail and the format is no longer offered.
+    */
+    virtual void withdrawClipboardFormat(ClipboardID id, IClipboard::EFormat format) = 0;
+
     //! Check clipboard owner
     /*!
     Check ownership of all clipboards and post grab events for any that
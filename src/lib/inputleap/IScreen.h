@@ -19,6 +19,7 @@
 #pragma once
 
 #include "inputleap/clipboard_types.h"
+#include "inputleap/IClipboard.h"
 #include "inputleap/Fwd.h"
 #include "base/Event.h"
 #include "base/EventTypes.h"
@@ -39,6 +40,12 @@ public:
         std::uint32_t m_sequenceNumber;
     };
 
+    struct ClipboardFormatInfo {
+    public:
+        ClipboardID m_id;
+        IClipboard::EFormat m_format;
+    };
+
     //! @name accessors
     //@{
 
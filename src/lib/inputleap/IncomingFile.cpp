@@ -0,0 +1,165 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "inputleap/IncomingFile.h"
+
+#include "base/Log.h"
+
+#include <cerrno>
+#include <random>
+#include <string>
+#include <system_error>
+
+#if SYSAPI_UNIX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace inputleap {
+
+namespace {
+
+// creates a file that only the user can access.  fails if anything,
+// including a symbolic link, is in the way.
+std::FILE* create_private_file(const fs::path& path)
+{
+#if SYSAPI_UNIX
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        return nullptr;
+    }
+    std::FILE* file = fdopen(fd, "wb");
+    if (file == nullptr) {
+        ::close(fd);
+    }
+    return file;
+#else
+    return fopen_utf8_path(path, "wbx");
+#endif
+}
+
+} // namespace
+
+IncomingFile::~IncomingFile()
+{
+    discard();
+}
+
+void IncomingFile::set_directory(const fs::path& directory)
+{
+    directory_ = directory;
+}
+
+bool IncomingFile::start(std::size_t size)
+{
+    discard();
+
+    std::error_code error;
+    fs::path dir = directory_.empty() ? fs::temp_directory_path(error) : directory_;
+    if (error) {
+        LOG_ERR("failed to find a directory for the transfer: %s", error.message().c_str());
+        return false;
+    }
+
+    // names that are taken are skipped, never opened
+    std::random_device random;
+    for (int attempt = 0; attempt < 16 && file_ == nullptr; ++attempt) {
+        path_ = dir / (".inputleap-drop-" + std::to_string(random()) + ".part");
+        file_ = create_private_file(path_);
+        if (file_ == nullptr && errno != EEXIST) {
+            break;
+        }
+    }
+    if (file_ == nullptr) {
+        LOG_ERR("failed to create %s", path_.u8string().c_str());
+        path_.clear();
+        return false;
+    }
+    size_ = size;
+
+#if defined(__linux__)
+    // reserve the space in the drop directory now so the disk doesn't
+    // fill up halfway and the file isn't fragmented.  not in the temporary
+    // directory, which may be in memory.  best effort:  not every file
+    // system can.
+    if (!directory_.empty() && size > 0 &&
+            posix_fallocate(fileno(file_), 0, static_cast<off_t>(size)) != 0) {
+        LOG_DEBUG1("could not preallocate %zu bytes for %s", size, path_.u8string().c_str());
+    }
+#endif
+    return true;
+}
+
+bool IncomingFile::write(const char* data, std::size_t size)
+{
+    if (file_ == nullptr || size > size_ - received_) {
+        return false;
+    }
+    if (std::fwrite(data, 1, size, file_) != size) {
+        LOG_ERR("failed to write %s", path_.u8string().c_str());
+        return false;
+    }
+    received_ += size;
+    return true;
+}
+
+bool IncomingFile::finish()
+{
+    if (file_ == nullptr) {
+        return false;
+    }
+    bool closed = std::fclose(file_) == 0;
+    file_ = nullptr;
+    finished_ = closed && received_ == size_;
+    return finished_;
+}
+
+fs::path IncomingFile::release()
+{
+    if (!is_complete()) {
+        return fs::path();
+    }
+    fs::path path = std::move(path_);
+    path_.clear();
+    size_ = 0;
+    received_ = 0;
+    finished_ = false;
+    return path;
+}
+
+void IncomingFile::discard()
+{
+    if (file_ != nullptr) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+    if (!path_.empty()) {
+        std::error_code error;
+        fs::remove(path_, error);
+        path_.clear();
+    }
+    size_ = 0;
+    received_ = 0;
+    finished_ = false;
+}
+
+bool IncomingFile::is_complete() const
+{
+    return finished_;
+}
+
+} // namespace inputleap
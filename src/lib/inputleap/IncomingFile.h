@@ -0,0 +1,110 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "io/filesystem.h"
+
+#include <cstddef>
+#include <cstdio>
+
+namespace inputleap {
+
+//! Incoming file transfer
+/*!
+Writes a file transfer to a temporary file as its chunks arrive, so a
+large file is never held in memory.  The file is created in the drop
+directory, if one is set, so it can be renamed into place when the drop
+completes.  It is always a new file only the user can access.  Where the
+platform supports it, a file in the drop directory is allocated at its
+full size up front.  A finished file is handed over with release(); a
+file that is not released is removed.
+*/
+class IncomingFile {
+public:
+    IncomingFile() = default;
+    IncomingFile(const IncomingFile&) = delete;
+    IncomingFile& operator=(const IncomingFile&) = delete;
+    ~IncomingFile();
+
+    //! @name manipulators
+    //@{
+
+    //! Set the drop directory
+    /*!
+    Transfers started from now on are written to \p directory.  If it's
+    empty they go to the system's temporary directory.
+    */
+    void set_directory(const fs::path& directory);
+
+    //! Start a transfer
+    /*!
+    Discards any previous transfer and creates a temporary file for
+    \p size bytes.  Returns false if the file can't be created.
+    */
+    bool start(std::size_t size);
+
+    //! Append data
+    /*!
+    Returns false if the data doesn't fit the size given to start() or
+    can't be written.
+    */
+    bool write(const char* data, std::size_t size);
+
+    //! Finish the transfer
+    /*!
+    Closes the temporary file.  Returns false if less than the expected
+    size was received or the file couldn't be written.
+    */
+    bool finish();
+
+    //! Take the finished file
+    /*!
+    Returns the path of the temporary file, which the caller is now
+    responsible for, and forgets about it.  Returns an empty path if
+    the transfer isn't finished.
+    */
+    fs::path release();
+
+    //! Discard the transfer
+    void discard();
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Check if the whole file was received
+    bool is_complete() const;
+
+    //! Get the expected size of the file
+    std::size_t size() const { return size_; }
+
+    //! Get the number of bytes received so far
+    std::size_t received() const { return received_; }
+
+    //@}
+
+private:
+    fs::path directory_;
+    fs::path path_;
+    std::FILE* file_ = nullptr;
+    std::size_t size_ = 0;
+    std::size_t received_ = 0;
+    bool finished_ = false;
+};
+
+} // namespace inputleap
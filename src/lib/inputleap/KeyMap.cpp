@@ -20,18 +20,33 @@
 #include "inputleap/key_types.h"
 #include "base/Log.h"
 
+#include <algorithm>
 #include <assert.h>
 #include <cctype>
 #include <cstdlib>
 
 namespace inputleap {
 
+namespace {
+
+// plans kept before they're all dropped.  a keyboard has far fewer
+// keys but each one can be mapped from many modifier states.
+const std::size_t kMaxKeystrokePlans = 4096;
+
+std::size_t hashCombine(std::size_t seed, std::size_t value)
+{
+    return seed ^ (value + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
+} // namespace
+
 KeyMap::NameToKeyMap* KeyMap::s_nameToKeyMap = nullptr;
 KeyMap::NameToModifierMap* KeyMap::s_nameToModifierMap = nullptr;
 KeyMap::KeyToNameMap* KeyMap::s_keyToNameMap = nullptr;
 KeyMap::ModifierToNameMap* KeyMap::s_modifierToNameMap = nullptr;
 
 KeyMap::KeyMap() :
+    m_keyIDIndexValid(false),
     m_numGroups(0),
     m_composeAcrossGroups(false)
 {
@@ -54,6 +69,8 @@ KeyMap::~KeyMap()
 void
 KeyMap::swap(KeyMap& x)
 {
+    invalidate();
+    x.invalidate();
     m_keyIDMap.swap(x.m_keyIDMap);
     m_modifierKeys.swap(x.m_modifierKeys);
     m_halfDuplex.swap(x.m_halfDuplex);
@@ -73,6 +90,7 @@ KeyMap::addKeyEntry(const KeyItem& item)
     if (item.m_id == kKeyNone) {
         return;
     }
+    invalidate();
 
     // resize number of groups for key
     std::int32_t numGroups = item.m_group + 1;
@@ -141,6 +159,7 @@ bool KeyMap::addKeyCombinationEntry(KeyID id, std::int32_t group, const KeyID* k
     if (id == kKeyNone) {
         return false;
     }
+    invalidate();
 
     std::int32_t numGroups = group + 1;
     if (getNumGroups() > numGroups) {
@@ -197,30 +216,35 @@ bool KeyMap::addKeyCombinationEntry(KeyID id, std::int32_t group, const KeyID* k
 void
 KeyMap::allowGroupSwitchDuringCompose()
 {
+    invalidate();
     m_composeAcrossGroups = true;
 }
 
 void
 KeyMap::addHalfDuplexButton(KeyButton button)
 {
+    invalidate();
     m_halfDuplex.insert(button);
 }
 
 void
 KeyMap::clearHalfDuplexModifiers()
 {
+    invalidate();
     m_halfDuplexMods.clear();
 }
 
 void
 KeyMap::addHalfDuplexModifier(KeyID key)
 {
+    invalidate();
     m_halfDuplexMods.insert(key);
 }
 
 void
 KeyMap::finish()
 {
+    invalidate();
     m_numGroups = findNumGroups();
 
     // make sure every key has the same number of groups
@@ -235,6 +259,8 @@ KeyMap::finish()
 void
 KeyMap::foreachKey(ForeachKeyCallback cb, void* userData)
 {
+    // the callback may change the items
+    invalidate();
     for (auto i = m_keyIDMap.begin(); i != m_keyIDMap.end(); ++i) {
         KeyGroupTable& groupTable = i->second;
         for (size_t group = 0; group < groupTable.size(); ++group) {
@@ -257,6 +283,84 @@ const KeyMap::KeyItem* KeyMap::mapKey(Keystrokes& keys, KeyID id, std::int32_t g
 {
     LOG_DEBUG1("mapKey %04x (%d) with mask %04x, start state: %04x", id, id, desiredMask, currentState);
 
+    // group changes and modifier changes are rare and cheap
+    switch (id) {
+    case kKeyNextGroup:
+    case kKeyPrevGroup:
+    case kKeySetModifiers:
+    case kKeyClearModifiers:
+        return mapKeyUncached(keys, id, group, activeModifiers, currentState,
+                              desiredMask, isAutoRepeat);
+    }
+
+    if (!m_keyIDIndexValid) {
+        m_keyIDIndex.clear();
+        m_keyIDIndex.reserve(m_keyIDMap.size());
+        for (auto i = m_keyIDMap.begin(); i != m_keyIDMap.end(); ++i) {
+            m_keyIDIndex.emplace_back(i->first, &i->second);
+        }
+        m_keyIDIndexValid = true;
+    }
+
+    // look for a plan made in the same state
+    std::size_t hash = hashCombine(id, static_cast<std::size_t>(group));
+    hash = hashCombine(hash, currentState);
+    hash = hashCombine(hash, desiredMask);
+    hash = hashCombine(hash, isAutoRepeat ? 1 : 0);
+    for (auto i = activeModifiers.begin(); i != activeModifiers.end(); ++i) {
+        hash = hashCombine(hash, i->first);
+        hash = hashCombine(hash, i->second.m_button);
+    }
+    auto range = m_plans.equal_range(hash);
+    for (auto i = range.first; i != range.second; ++i) {
+        const KeystrokePlan& plan = i->second;
+        if (plan.m_id == id && plan.m_group == group && plan.m_state == currentState &&
+                plan.m_desiredMask == desiredMask && plan.m_isAutoRepeat == isAutoRepeat &&
+                plan.m_modifiers == activeModifiers) {
+            keys.insert(keys.end(), plan.m_keys.begin(), plan.m_keys.end());
+            if (activeModifiers != plan.m_newModifiers) {
+                activeModifiers = plan.m_newModifiers;
+            }
+            currentState = plan.m_newState;
+            LOG_DEBUG1("mapped to %03x, new state %04x", plan.m_item->m_button, currentState);
+            return plan.m_item;
+        }
+    }
+
+    // make a plan
+    KeystrokePlan plan;
+    plan.m_id           = id;
+    plan.m_group        = group;
+    plan.m_state        = currentState;
+    plan.m_desiredMask  = desiredMask;
+    plan.m_isAutoRepeat = isAutoRepeat;
+    plan.m_modifiers    = activeModifiers;
+    std::size_t start   = keys.size();
+    const KeyItem* item = mapKeyUncached(keys, id, group, activeModifiers, currentState,
+                                         desiredMask, isAutoRepeat);
+    if (item == nullptr) {
+        return nullptr;
+    }
+    LOG_DEBUG1("mapped to %03x, new state %04x", item->m_button, currentState);
+
+    // remember it
+    if (m_plans.size() >= kMaxKeystrokePlans) {
+        m_plans.clear();
+    }
+    plan.m_keys.assign(keys.begin() + start, keys.end());
+    plan.m_newModifiers = activeModifiers;
+    plan.m_newState     = currentState;
+    plan.m_item         = item;
+    m_plans.emplace(hash, std::move(plan));
+    return item;
+}
+
+const KeyMap::KeyItem* KeyMap::mapKeyUncached(Keystrokes& keys, KeyID id, std::int32_t group,
+                                              ModifierToKeys& activeModifiers,
+                                              KeyModifierMask& currentState,
+                                              KeyModifierMask desiredMask,
+                                              bool isAutoRepeat) const
+{
     // handle group change
     if (id == kKeyNextGroup) {
         keys.push_back(Keystroke(1, false, false));
@@ -316,9 +420,6 @@ const KeyMap::KeyItem* KeyMap::mapKey(Keystrokes& keys, KeyID id, std::int32_t g
         break;
     }
 
-    if (item != nullptr) {
-        LOG_DEBUG1("mapped to %03x, new state %04x", item->m_button, currentState);
-    }
     return item;
 }
 
@@ -338,12 +439,12 @@ const KeyMap::KeyItemList* KeyMap::findCompatibleKey(KeyID id, std::int32_t grou
 {
     assert(group >= 0 && group < getNumGroups());
 
-    auto i = m_keyIDMap.find(id);
-    if (i == m_keyIDMap.end()) {
+    const KeyGroupTable* keyGroupTable = findKeyGroupTable(id);
+    if (keyGroupTable == nullptr) {
         return nullptr;
     }
 
-    const KeyEntryList& entries = i->second[group];
+    const KeyEntryList& entries = (*keyGroupTable)[group];
     for (size_t j = 0; j < entries.size(); ++j) {
         if ((entries[j].back().m_sensitive & sensitive) == 0 ||
             (entries[j].back().m_required & sensitive) ==
@@ -445,6 +546,33 @@ KeyMap::initModifierKey(KeyItem& item)
     }
 }
 
+void
+KeyMap::invalidate()
+{
+    m_plans.clear();
+    m_keyIDIndex.clear();
+    m_keyIDIndexValid = false;
+}
+
+const KeyMap::KeyGroupTable* KeyMap::findKeyGroupTable(KeyID id) const
+{
+    // the index is rebuilt by mapKey() so the map is searched while
+    // it's being filled
+    if (!m_keyIDIndexValid) {
+        auto i = m_keyIDMap.find(id);
+        return (i == m_keyIDMap.end()) ? nullptr : &i->second;
+    }
+
+    auto i = std::lower_bound(m_keyIDIndex.begin(), m_keyIDIndex.end(), id,
+                              [](const std::pair<KeyID, const KeyGroupTable*>& entry, KeyID key) {
+                                  return entry.first < key;
+                              });
+    if (i == m_keyIDIndex.end() || i->first != id) {
+        return nullptr;
+    }
+    return i->second;
+}
+
 std::int32_t KeyMap::findNumGroups() const
 {
     size_t max = 0;
@@ -498,13 +626,13 @@ const KeyMap::KeyItem* KeyMap::mapCommandKey(Keystrokes& keys, KeyID id, std::in
     static const KeyModifierMask s_overrideModifiers = 0xffffu;
 
     // find KeySym in table
-    auto it = m_keyIDMap.find(id);
-    if (it == m_keyIDMap.end()) {
+    const KeyGroupTable* keyGroupTablePtr = findKeyGroupTable(id);
+    if (keyGroupTablePtr == nullptr) {
         // unknown key
         LOG_DEBUG1("key %04x is not on keyboard", id);
         return nullptr;
     }
-    const KeyGroupTable& keyGroupTable = it->second;
+    const KeyGroupTable& keyGroupTable = *keyGroupTablePtr;
 
     // find the first key that generates this KeyID
     const KeyItem* keyItem = nullptr;
@@ -587,13 +715,13 @@ const KeyMap::KeyItem* KeyMap::mapCharacterKey(Keystrokes& keys, KeyID id, std::
                                                KeyModifierMask desiredMask, bool isAutoRepeat) const
 {
     // find KeySym in table
-    auto i = m_keyIDMap.find(id);
-    if (i == m_keyIDMap.end()) {
+    const KeyGroupTable* keyGroupTablePtr = findKeyGroupTable(id);
+    if (keyGroupTablePtr == nullptr) {
         // unknown key
         LOG_DEBUG1("key %04x is not on keyboard", id);
         return nullptr;
     }
-    const KeyGroupTable& keyGroupTable = i->second;
+    const KeyGroupTable& keyGroupTable = *keyGroupTablePtr;
 
     // find best key in any group, starting with the active group
     std::int32_t keyIndex  = -1;
@@ -27,6 +27,8 @@
 
 #include <map>
 #include <set>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace inputleap {
@@ -216,6 +218,10 @@ public:
     \p desiredMask into the keystrokes necessary to synthesize that key
     event in \p keys.  It returns the \c KeyItem of the key being
     pressed/repeated, or nullptr if the key cannot be mapped.
+
+    The keystrokes for a key only depend on the arguments and the map,
+    so they're remembered and reused when the same key is mapped from
+    the same state again.  Changing the map forgets them.
     */
     virtual const KeyItem* mapKey(Keystrokes& keys, KeyID id, std::int32_t group,
                                   ModifierToKeys& activeModifiers, KeyModifierMask& currentState,
@@ -337,6 +343,8 @@ private:
     FRIEND_TEST(KeyMapTests,
                 findBestKey_onlyOneRequiredDown_matchTwoRequiredChangesItem);
     FRIEND_TEST(KeyMapTests, findBestKey_noRequiredDown_cannotMatch);
+    FRIEND_TEST(KeyMapTests, mapKey_typingTrace_sameAsUncached);
+    FRIEND_TEST(KeyMapTests, DISABLED_benchmark_mapKeyTypingTrace);
 #endif
 
 private:
@@ -356,6 +364,19 @@ private:
     // computes the number of groups
     std::int32_t findNumGroups() const;
 
+    // forgets the keystroke plans and the key ID index.  called whenever
+    // the map changes.
+    void invalidate();
+
+    // finds the groups for \p id or returns nullptr
+    const std::vector<KeyEntryList>* findKeyGroupTable(KeyID id) const;
+
+    // does the work of mapKey() without remembering the result
+    const KeyItem* mapKeyUncached(Keystrokes& keys, KeyID id, std::int32_t group,
+                                  ModifierToKeys& activeModifiers,
+                                  KeyModifierMask& currentState,
+                                  KeyModifierMask desiredMask, bool isAutoRepeat) const;
+
     // computes the map of modifiers to the keys that generate the modifiers
     void setModifierKeys();
 
@@ -470,8 +491,32 @@ private:
     typedef std::map<KeyID, std::string> KeyToNameMap;
     typedef std::map<KeyModifierMask, std::string> ModifierToNameMap;
 
+    // The result of mapping a key from a given state
+    struct KeystrokePlan {
+        KeyID m_id;
+        std::int32_t m_group;
+        KeyModifierMask m_state;
+        KeyModifierMask m_desiredMask;
+        bool m_isAutoRepeat;
+        ModifierToKeys m_modifiers;
+
+        Keystrokes m_keys;
+        ModifierToKeys m_newModifiers;
+        KeyModifierMask m_newState;
+        const KeyItem* m_item;
+    };
+
+    // Keystroke plans by hash of the state they were made in
+    typedef std::unordered_multimap<std::size_t, KeystrokePlan> KeystrokePlanCache;
+
+    // Sorted KeyIDs and their entries in m_keyIDMap
+    typedef std::vector<std::pair<KeyID, const KeyGroupTable*>> KeyIDIndex;
+
     // KeyID info
     KeyIDMap m_keyIDMap;
+    mutable KeyIDIndex m_keyIDIndex;
+    mutable bool m_keyIDIndexValid;
+    mutable KeystrokePlanCache m_plans;
     std::int32_t m_numGroups;
     ModifierToKeyTable m_modifierKeys;
 
@@ -19,6 +19,7 @@
 #include "inputleap/KeyState.h"
 #include "base/Log.h"
 
+#include <assert.h>
 #include <cstring>
 #include <algorithm>
 #include <iterator>
@@ -389,6 +390,7 @@ KeyState::KeyState(IEventQueue* events) :
     m_keyMapPtr(new inputleap::KeyMap()),
     m_keyMap(*m_keyMapPtr),
     m_mask(0),
+    m_fakeBatchDepth(0),
     m_events(events)
 {
     init();
@@ -398,6 +400,7 @@ KeyState::KeyState(IEventQueue* events, inputleap::KeyMap& keyMap) :
     m_keyMapPtr(nullptr),
     m_keyMap(keyMap),
     m_mask(0),
+    m_fakeBatchDepth(0),
     m_events(events)
 {
     init();
@@ -722,6 +725,24 @@ KeyState::fakeMediaKey(KeyID id)
     return false;
 }
 
+void KeyState::beginFakeBatch()
+{
+    ++m_fakeBatchDepth;
+}
+
+void KeyState::endFakeBatch()
+{
+    assert(m_fakeBatchDepth > 0);
+    if (--m_fakeBatchDepth == 0) {
+        flushFakeEvents();
+    }
+}
+
+void KeyState::flushFakeEvents()
+{
+    // do nothing
+}
+
 bool
 KeyState::isKeyDown(KeyButton button) const
 {
@@ -837,8 +858,9 @@ void KeyState::fakeKeys(const Keystrokes& keys, std::uint32_t count)
         return;
     }
 
-    // generate key events
+    // generate key events.  they're sent together when the batch ends.
     LOG_DEBUG1("keystrokes:");
+    beginFakeBatch();
     for (auto k = keys.begin(); k != keys.end(); ) {
         if (k->m_type == Keystroke::kButton && k->m_data.m_button.m_repeat) {
             // repeat from here up to but not including the next key
@@ -864,6 +886,7 @@ void KeyState::fakeKeys(const Keystrokes& keys, std::uint32_t count)
             ++k;
         }
     }
+    endFakeBatch();
 }
 
 void
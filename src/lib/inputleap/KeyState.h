@@ -72,6 +72,8 @@ public:
     bool fakeKeyUp(KeyButton button) override;
     void fakeAllKeysUp() override;
     bool fakeMediaKey(KeyID id) override;
+    void beginFakeBatch() override;
+    void endFakeBatch() override;
 
     bool isKeyDown(KeyButton) const override;
     KeyModifierMask getActiveModifiers() const override;
@@ -96,6 +98,14 @@ protected:
     */
     virtual void fakeKey(const Keystroke& keystroke) = 0;
 
+    //! Send queued fake events
+    /*!
+    Sends the events queued by \c fakeKey() and other fake input to the
+    system.  Called when the outermost batch of fake events ends.  The
+    default does nothing.
+    */
+    virtual void flushFakeEvents();
+
     //! Get the active modifiers
     /*!
     Returns the modifiers that are currently active according to our
@@ -221,6 +231,9 @@ private:
     // otherwise it's the local KeyButton synthesized for the server key.
     KeyButton m_serverKeys[kNumButtons];
 
+    // number of batches of fake events begun and not yet ended
+    std::uint32_t m_fakeBatchDepth;
+
     IEventQueue* m_events;
 };
 
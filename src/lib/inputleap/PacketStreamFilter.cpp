@@ -86,15 +86,22 @@ std::uint32_t PacketStreamFilter::read(void* buffer, std::uint32_t n)
 
 void PacketStreamFilter::write(const void* buffer, std::uint32_t count)
 {
-    // write the length of the payload
-    std::uint8_t length[4];
-    length[0] = static_cast<std::uint8_t>((count >> 24) & 0xff);
-    length[1] = static_cast<std::uint8_t>((count >> 16) & 0xff);
-    length[2] = static_cast<std::uint8_t>((count >> 8) & 0xff);
-    length[3] = static_cast<std::uint8_t>(count& 0xff);
-    getStream()->write(length, sizeof(length));
-
-    // write the payload
+    // length of the payload
+    std::uint8_t packet[256];
+    packet[0] = static_cast<std::uint8_t>((count >> 24) & 0xff);
+    packet[1] = static_cast<std::uint8_t>((count >> 16) & 0xff);
+    packet[2] = static_cast<std::uint8_t>((count >> 8) & 0xff);
+    packet[3] = static_cast<std::uint8_t>(count& 0xff);
+
+    // small packets go to the stream in one write so the length and the
+    // payload aren't sent separately
+    if (count <= sizeof(packet) - 4) {
+        memcpy(packet + 4, buffer, count);
+        getStream()->write(packet, count + 4);
+        return;
+    }
+
+    getStream()->write(packet, 4);
     getStream()->write(buffer, count);
 }
 
@@ -153,11 +160,11 @@ PacketStreamFilter::readMore()
     // note if we have whole packet
     bool wasReady = isReadyNoLock();
 
-    // read more data
-    char buffer[4096];
-    std::uint32_t n = getStream()->read(buffer, sizeof(buffer));
+    // read more data straight into the buffer
+    const std::uint32_t kReadSize = 4096;
+    std::uint32_t n = getStream()->read(m_buffer.reserve(kReadSize), kReadSize);
     while (n > 0) {
-        m_buffer.write(buffer, n);
+        m_buffer.commit(n);
 
         // if we don't yet have the next packet size then get it, if possible.
         // Note that we can't wait for whole pending data to arrive because it may be huge in
@@ -166,7 +173,7 @@ PacketStreamFilter::readMore()
             break;
         }
 
-        n = getStream()->read(buffer, sizeof(buffer));
+        n = getStream()->read(m_buffer.reserve(kReadSize), kReadSize);
     }
 
     // note if we now have a whole packet
@@ -83,6 +83,16 @@ PlatformScreen::fakeCtrlAltDel()
     return getKeyState()->fakeCtrlAltDel();
 }
 
+void PlatformScreen::beginFakeBatch()
+{
+    getKeyState()->beginFakeBatch();
+}
+
+void PlatformScreen::endFakeBatch()
+{
+    getKeyState()->endFakeBatch();
+}
+
 bool
 PlatformScreen::isKeyDown(KeyButton button) const
 {
@@ -46,6 +46,8 @@ public:
     bool fakeKeyUp(KeyButton button) override;
     void fakeAllKeysUp() override;
     bool fakeCtrlAltDel() override;
+    void beginFakeBatch() override;
+    void endFakeBatch() override;
     bool isKeyDown(KeyButton) const override;
     KeyModifierMask getActiveModifiers() const override;
     KeyModifierMask pollActiveModifiers() const override;
@@ -69,6 +71,10 @@ public:
 
     bool fakeMediaKey(KeyID id) override;
 
+    bool setClipboardFormat(ClipboardID, IClipboard::EFormat, const std::string&) override
+        { return false; }
+    void withdrawClipboardFormat(ClipboardID, IClipboard::EFormat) override { }
+
 protected:
     //! Update mouse buttons
     /*!
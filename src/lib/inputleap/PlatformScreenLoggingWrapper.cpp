@@ -61,6 +61,22 @@ bool PlatformScreenLoggingWrapper::setClipboard(ClipboardID id, const IClipboard
     return result;
 }
 
+bool PlatformScreenLoggingWrapper::setClipboardFormat(ClipboardID id, IClipboard::EFormat format,
+                                                      const std::string& data)
+{
+    bool result = screen_->setClipboardFormat(id, format, data);
+    LOG_DEBUG1("PlatformScreen::setClipboardFormat() id=%d format=%d size=%zd => %d",
+         id, format, data.size(), result);
+    return result;
+}
+
+void PlatformScreenLoggingWrapper::withdrawClipboardFormat(ClipboardID id,
+                                                           IClipboard::EFormat format)
+{
+    LOG_DEBUG1("PlatformScreen::withdrawClipboardFormat() id=%d format=%d", id, format);
+    screen_->withdrawClipboardFormat(id, format);
+}
+
 void PlatformScreenLoggingWrapper::checkClipboards()
 {
     LOG_DEBUG1("PlatformScreen::checkClipboards()");
@@ -333,6 +349,18 @@ bool PlatformScreenLoggingWrapper::fakeMediaKey(KeyID id)
     return result;
 }
 
+void PlatformScreenLoggingWrapper::beginFakeBatch()
+{
+    LOG_DEBUG1("PlatformScreen::beginFakeBatch()");
+    screen_->beginFakeBatch();
+}
+
+void PlatformScreenLoggingWrapper::endFakeBatch()
+{
+    LOG_DEBUG1("PlatformScreen::endFakeBatch()");
+    screen_->endFakeBatch();
+}
+
 bool PlatformScreenLoggingWrapper::isKeyDown(KeyButton key) const
 {
     auto result = screen_->isKeyDown(key);
@@ -33,6 +33,9 @@ public:
     bool canLeave() override;
     void leave() override;
     bool setClipboard(ClipboardID id, const IClipboard* clipboard) override;
+    bool setClipboardFormat(ClipboardID id, IClipboard::EFormat format,
+                            const std::string& data) override;
+    void withdrawClipboardFormat(ClipboardID id, IClipboard::EFormat format) override;
     void checkClipboards() override;
     void openScreensaver(bool notify) override;
     void closeScreensaver() override;
@@ -89,6 +92,8 @@ public:
     void fakeAllKeysUp() override;
     bool fakeCtrlAltDel() override;
     bool fakeMediaKey(KeyID id) override;
+    void beginFakeBatch() override;
+    void endFakeBatch() override;
     bool isKeyDown(KeyButton) const override;
 
     KeyModifierMask getActiveModifiers() const override;
@@ -0,0 +1,214 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+namespace inputleap {
+
+namespace detail {
+
+struct FixedFormatLayout {
+    bool fixed = true;
+    std::size_t size = 0;
+    std::size_t args = 0;
+};
+
+template<std::size_t Size, std::size_t Args>
+struct FixedFormatFields {
+    // message bytes with the regular characters filled in and the
+    // integer fields zeroed
+    std::array<std::uint8_t, Size> bytes{};
+    std::array<bool, Size> literal{};
+    std::array<std::size_t, Args> offset{};
+    std::array<std::size_t, Args> width{};
+};
+
+constexpr FixedFormatLayout scan_fixed_format(const char* fmt)
+{
+    FixedFormatLayout layout;
+    while (*fmt != '\0') {
+        if (*fmt != '%') {
+            ++layout.size;
+            ++fmt;
+            continue;
+        }
+        ++fmt;
+        std::size_t len = 0;
+        while (*fmt >= '0' && *fmt <= '9') {
+            len = 10 * len + static_cast<std::size_t>(*fmt - '0');
+            ++fmt;
+        }
+        if (*fmt == '%' && len == 0) {
+            ++layout.size;
+        } else if (*fmt == 'i' && (len == 1 || len == 2 || len == 4)) {
+            layout.size += len;
+            ++layout.args;
+        } else {
+            layout.fixed = false;
+            return layout;
+        }
+        ++fmt;
+    }
+    return layout;
+}
+
+template<std::size_t Size, std::size_t Args>
+constexpr FixedFormatFields<Size, Args> layout_fixed_format(const char* fmt)
+{
+    FixedFormatFields<Size, Args> fields;
+    std::size_t pos = 0;
+    std::size_t arg = 0;
+    while (*fmt != '\0') {
+        if (*fmt != '%') {
+            fields.bytes[pos] = static_cast<std::uint8_t>(*fmt++);
+            fields.literal[pos++] = true;
+            continue;
+        }
+        ++fmt;
+        std::size_t len = 0;
+        while (*fmt >= '0' && *fmt <= '9') {
+            len = 10 * len + static_cast<std::size_t>(*fmt - '0');
+            ++fmt;
+        }
+        if (*fmt == '%') {
+            fields.bytes[pos] = '%';
+            fields.literal[pos++] = true;
+        } else {
+            fields.offset[arg] = pos;
+            fields.width[arg++] = len;
+            pos += len;
+        }
+        ++fmt;
+    }
+    return fields;
+}
+
+} // namespace detail
+
+//! Compile time layout of a fixed size protocol format
+/*!
+Parses a ProtocolUtil::writef() format string at compile time, starting
+at offset \c Begin.  Only regular characters and the \%1i, \%2i, \%4i and
+\%\% specifiers are allowed;  formats with variable length fields (\%s,
+\%S, \%I) fail to compile.  \c Format must be a constexpr character array
+with linkage, such as the kMsg* codes in protocol_types.h.
+*/
+template<const char* Format, std::size_t Begin = 0>
+class ProtocolFixedFormat {
+    static constexpr detail::FixedFormatLayout kLayout =
+            detail::scan_fixed_format(Format + Begin);
+    static_assert(kLayout.fixed, "format has variable length fields, use writef()/readf()");
+
+public:
+    //! Number of bytes the format encodes to
+    static constexpr std::size_t kSize = kLayout.size;
+
+    //! Number of integer arguments the format takes
+    static constexpr std::size_t kArgs = kLayout.args;
+
+private:
+    static constexpr detail::FixedFormatFields<kSize, kArgs> kFields =
+            detail::layout_fixed_format<kSize, kArgs>(Format + Begin);
+
+public:
+    //! Encode arguments
+    /*!
+    Writes kSize bytes to \p dst.  Integer arguments are truncated to the
+    width of their field and stored in NBO, as writef() does.
+    */
+    template<class... Args>
+    static void encode(std::uint8_t* dst, Args... args)
+    {
+        static_assert(sizeof...(Args) == kArgs, "argument count does not match format");
+        encode_fields(dst, std::index_sequence_for<Args...>{}, args...);
+    }
+
+    //! Decode arguments
+    /*!
+    Reads kSize bytes from \p src into the integers pointed to by \p args.
+    Each destination must be at least as wide as its field;  signed
+    destinations are sign extended.  Returns false if the regular
+    characters of the format do not match.
+    */
+    template<class... Args>
+    static bool decode(const std::uint8_t* src, Args*... args)
+    {
+        static_assert(sizeof...(Args) == kArgs, "argument count does not match format");
+        for (std::size_t i = 0; i < kSize; ++i) {
+            if (kFields.literal[i] && src[i] != kFields.bytes[i]) {
+                return false;
+            }
+        }
+        decode_fields(src, std::index_sequence_for<Args...>{}, args...);
+        return true;
+    }
+
+private:
+    template<std::size_t... I, class... Args>
+    static void encode_fields(std::uint8_t* dst, std::index_sequence<I...>, Args... args)
+    {
+        std::memcpy(dst, kFields.bytes.data(), kSize);
+        (put<kFields.width[I]>(dst + kFields.offset[I], static_cast<std::uint32_t>(args)), ...);
+    }
+
+    template<std::size_t... I, class... Args>
+    static void decode_fields(const std::uint8_t* src, std::index_sequence<I...>, Args*... args)
+    {
+        (get<kFields.width[I]>(src + kFields.offset[I], args), ...);
+    }
+
+    template<std::size_t Width>
+    static void put(std::uint8_t* dst, std::uint32_t v)
+    {
+        if constexpr (Width == 4) {
+            *dst++ = static_cast<std::uint8_t>((v >> 24) & 0xff);
+            *dst++ = static_cast<std::uint8_t>((v >> 16) & 0xff);
+        }
+        if constexpr (Width >= 2) {
+            *dst++ = static_cast<std::uint8_t>((v >> 8) & 0xff);
+        }
+        *dst = static_cast<std::uint8_t>(v & 0xff);
+    }
+
+    template<std::size_t Width, class T>
+    static void get(const std::uint8_t* src, T* dst)
+    {
+        static_assert(std::is_integral<T>::value, "argument must point to an integer");
+        static_assert(sizeof(T) >= Width, "argument is narrower than its field");
+
+        using Unsigned = std::conditional_t<Width == 1, std::uint8_t,
+                         std::conditional_t<Width == 2, std::uint16_t, std::uint32_t>>;
+        std::uint32_t v = 0;
+        for (std::size_t i = 0; i < Width; ++i) {
+            v = (v << 8) | src[i];
+        }
+        if constexpr (std::is_signed<T>::value) {
+            *dst = static_cast<T>(static_cast<std::make_signed_t<Unsigned>>(v));
+        } else {
+            *dst = static_cast<T>(v);
+        }
+    }
+};
+
+} // namespace inputleap
@@ -24,6 +24,7 @@
 
 #include <cctype>
 #include <cstring>
+#include <memory>
 #include <vector>
 
 namespace inputleap {
@@ -76,21 +77,19 @@ void ProtocolUtil::vwritef(inputleap::IStream* stream, const char* fmt, std::uin
         return;
     }
 
-    // fill buffer
-    std::uint8_t* buffer = new std::uint8_t[size];
+    // fill buffer.  most messages are small enough for the stack.
+    std::uint8_t fixed_buffer[256];
+    std::unique_ptr<std::uint8_t[]> heap_buffer;
+    std::uint8_t* buffer = fixed_buffer;
+    if (size > sizeof(fixed_buffer)) {
+        heap_buffer.reset(new std::uint8_t[size]);
+        buffer = heap_buffer.get();
+    }
     writef_void(buffer, fmt, args);
 
-    try {
-        // write buffer
-        stream->write(buffer, size);
-        LOG_DEBUG5("wrote %d bytes", size);
-
-        delete[] buffer;
-    }
-    catch (XBase&) {
-        delete[] buffer;
-        throw;
-    }
+    // write buffer
+    stream->write(buffer, size);
+    LOG_DEBUG5("wrote %d bytes", size);
 }
 
 void
@@ -18,6 +18,8 @@
 
 #pragma once
 
+#include "inputleap/ProtocolFixedFormat.h"
+#include "io/IStream.h"
 #include "io/XIO.h"
 #include "base/EventTypes.h"
 
@@ -25,8 +27,6 @@
 
 namespace inputleap {
 
-class IStream;
-
 /**
 This class provides various functions for implementing the inputleap protocol.
 */
@@ -70,6 +70,47 @@ public:
     */
     static bool readf(inputleap::IStream*, const char* fmt, ...);
 
+    //! Write a fixed size message
+    /*!
+    Typed counterpart of writef() for formats made only of regular
+    characters and \%1i, \%2i, \%4i and \%\% specifiers, which covers
+    all input and control messages.  The layout is computed at compile
+    time, the message is encoded into a stack buffer and handed to the
+    stream with a single write.  \c Format must be a constexpr character
+    array such as the kMsg* codes.  Produces the same bytes as writef().
+    */
+    template<const char* Format, class... Args>
+    static void write_message(inputleap::IStream* stream, Args... args)
+    {
+        using Layout = ProtocolFixedFormat<Format>;
+        std::uint8_t buffer[Layout::kSize];
+        Layout::encode(buffer, args...);
+        stream->write(buffer, Layout::kSize);
+    }
+
+    //! Read a fixed size message body
+    /*!
+    Typed counterpart of readf(stream, Format + 4, ...) for a message whose
+    4 byte code has already been read.  The whole body is read from the
+    stream at once and decoded from that contiguous span.  Arguments point
+    to integers at least as wide as their field;  signed integers are sign
+    extended.  Returns false if the stream ends or the data does not match
+    the format.
+    */
+    template<const char* Format, class... Args>
+    static bool read_message_body(inputleap::IStream* stream, Args*... args)
+    {
+        using Layout = ProtocolFixedFormat<Format, 4>;
+        std::uint8_t buffer[Layout::kSize + 1];
+        try {
+            read(stream, buffer, Layout::kSize);
+        }
+        catch (XIO&) {
+            return false;
+        }
+        return Layout::decode(buffer, args...);
+    }
+
 private:
     static void vwritef(inputleap::IStream*, const char* fmt, std::uint32_t size, va_list);
     static void vreadf(inputleap::IStream*, const char* fmt, va_list);
@@ -161,6 +161,17 @@ Screen::setClipboard(ClipboardID id, const IClipboard* clipboard)
     m_screen->setClipboard(id, clipboard);
 }
 
+bool Screen::setClipboardFormat(ClipboardID id, IClipboard::EFormat format,
+                                const std::string& data)
+{
+    return m_screen->setClipboardFormat(id, format, data);
+}
+
+void Screen::withdrawClipboardFormat(ClipboardID id, IClipboard::EFormat format)
+{
+    m_screen->withdrawClipboardFormat(id, format);
+}
+
 void
 Screen::grabClipboard(ClipboardID id)
 {
@@ -178,6 +189,16 @@ Screen::screensaver(bool activate)
     }
 }
 
+void Screen::beginFakeBatch()
+{
+    m_screen->beginFakeBatch();
+}
+
+void Screen::endFakeBatch()
+{
+    m_screen->endFakeBatch();
+}
+
 void
 Screen::keyDown(KeyID id, KeyModifierMask mask, KeyButton button)
 {
@@ -99,6 +99,20 @@ public:
     */
     void setClipboard(ClipboardID, const IClipboard*);
 
+    //! Supply promised clipboard data
+    /*!
+    Supplies data for a format that the last setClipboard() promised.
+    Returns false if the system clipboard isn't waiting for it.
+    */
+    bool setClipboardFormat(ClipboardID, IClipboard::EFormat, const std::string& data);
+
+    //! Withdraw promised clipboard data
+    /*!
+    Tells the system clipboard that data the last setClipboard()
+    promised won't arrive.
+    */
+    void withdrawClipboardFormat(ClipboardID, IClipboard::EFormat);
+
     //! Grab clipboard
     /*!
     Grabs (i.e. take ownership of) the system clipboard.
@@ -112,6 +126,20 @@ public:
     */
     void screensaver(bool activate);
 
+    //! Begin a batch of synthesized input
+    /*!
+    Input synthesized until the matching \c endFakeBatch() may be sent
+    to the system together instead of event by event.  Batches may be
+    nested.
+    */
+    void beginFakeBatch();
+
+    //! End a batch of synthesized input
+    /*!
+    Ends a batch started by \c beginFakeBatch().
+    */
+    void endFakeBatch();
+
     //! Notify of key press
     /*!
     Synthesize key events to generate a press of key \c id.  If possible
@@ -146,6 +146,7 @@ ServerApp::help()
            << HELP_COMMON_INFO_1
            << "      --disable-client-cert-checking disable client SSL certificate \n"
               "                                     checking (deprecated)\n"
+           << "      --socket-threads <n> service client connections on <n> threads.\n"
 #ifdef WINAPI_XWINDOWS
            << "      --use-x11            use the X11 backend\n"
            << "      --display <display>  connect to the X server at <display>\n"
@@ -709,7 +710,10 @@ ServerApp::mainLoop()
 {
     // create socket multiplexer.  this must happen after daemonization
     // on unix because threads evaporate across a fork().
-    setSocketMultiplexer(std::make_unique<SocketMultiplexer>());
+    setSocketMultiplexer(std::make_unique<SocketMultiplexer>(args().socket_threads));
+
+    // likewise for the thread writing the log
+    CLOG->setAsync(true);
 
     // if configuration has no screens then add this system
     // as the default
@@ -786,6 +790,7 @@ ServerApp::mainLoop()
     cleanupServer();
     updateStatus();
     LOG_NOTE("stopped server");
+    CLOG->setAsync(false);
 
     if (argsBase().m_enableIpc) {
         cleanupIpcClient();
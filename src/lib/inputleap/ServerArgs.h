@@ -19,6 +19,8 @@
 
 #include "inputleap/ArgsBase.h"
 
+#include <cstddef>
+
 namespace inputleap {
 
 class Config;
@@ -32,6 +34,7 @@ public:
     Config* m_config;
     std::string m_screenChangeScript;
     bool check_client_certificates = true;
+    std::size_t socket_threads = 1;
 };
 
 } // namespace inputleap
@@ -18,7 +18,6 @@
 #include "inputleap/StreamChunker.h"
 
 #include "inputleap/FileChunk.h"
-#include "inputleap/ClipboardChunk.h"
 #include "inputleap/protocol_types.h"
 #include "base/EventTypes.h"
 #include "base/Event.h"
@@ -26,128 +25,157 @@
 #include "base/EventTypes.h"
 #include "base/Log.h"
 #include "base/String.h"
+#include "io/filesystem.h"
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include <fstream>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 namespace inputleap {
 
 static const size_t g_chunkSize = 32 * 1024; //32kb
 
+// how much of the file may be read ahead of the connection.  each chunk
+// holds its share of the window until it has been written out, so a
+// large file never sits in memory as a whole.
+static const size_t g_readAhead = 1024 * 1024; //1mb
+
 bool StreamChunker::s_isChunkingFile = false;
-bool StreamChunker::s_interruptFile = false;
+std::atomic<bool> StreamChunker::s_interruptFile(false);
+
+namespace {
+
+class ReadAheadWindow {
+public:
+    explicit ReadAheadWindow(size_t size) : m_available(size) { }
+
+    // waits until size bytes of the window are free.  returns false if
+    // the transfer was interrupted meanwhile.
+    bool acquire(size_t size, const std::atomic<bool>& interrupted)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (m_available < size) {
+            if (interrupted) {
+                return false;
+            }
+            m_released.wait_for(lock, std::chrono::milliseconds(100));
+        }
+        m_available -= size;
+        return true;
+    }
+
+    void release(size_t size)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_available += size;
+        m_released.notify_one();
+    }
+
+    // returns a buffer of a chunk that was already sent, if any.  there
+    // are never more buffers than fit in the window.
+    std::string take_buffer()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_buffers.empty()) {
+            return std::string();
+        }
+        std::string buffer = std::move(m_buffers.back());
+        m_buffers.pop_back();
+        return buffer;
+    }
+
+    void give_back(std::string&& buffer)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_buffers.push_back(std::move(buffer));
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_released;
+    size_t m_available;
+    std::vector<std::string> m_buffers;
+};
+
+} // namespace
 
 void StreamChunker::sendFile(const char* filename, IEventQueue* events,
                              const EventTarget* event_target)
 {
     s_isChunkingFile = true;
 
-    std::fstream file(filename, std::ios::in | std::ios::binary);
+    std::ifstream file;
+    open_utf8_path(file, filename, std::ios::in | std::ios::binary | std::ios::ate);
 
     if (!file.is_open()) {
         throw std::runtime_error("failed to open file");
     }
 
     // check file size
-    file.seekg (0, std::ios::end);
     size_t size = static_cast<size_t>(file.tellg());
+    file.seekg(0, std::ios::beg);
 
     // send first message (file size)
-    auto size_message = FileChunk::start(size);
-
     events->add_event(EventType::FILE_CHUNK_SENDING, event_target,
-                      create_event_data<FileChunk>(size_message));
+                      create_event_data<FileChunk>(FileChunk::start(size)));
 
-    // send chunk messages with a fixed chunk size
+    // send chunk messages with a fixed chunk size, reading straight into
+    // each chunk and never further ahead than the window.  buffers of sent
+    // chunks are handed back and reused for the next ones.
+    auto window = std::make_shared<ReadAheadWindow>(g_readAhead);
     size_t sentLength = 0;
-    size_t chunkSize = g_chunkSize;
-    file.seekg (0, std::ios::beg);
+    bool interrupted = false;
 
-    while (true) {
-        if (s_interruptFile) {
-            s_interruptFile = false;
-            LOG_DEBUG("file transmission interrupted");
+    while (sentLength < size) {
+        size_t chunkSize = std::min(g_chunkSize, size - sentLength);
+        if (s_interruptFile || !window->acquire(chunkSize, s_interruptFile)) {
+            interrupted = true;
             break;
         }
 
         events->add_event(EventType::FILE_KEEPALIVE, event_target);
 
-        // make sure we don't read too much from the mock data.
-        if (sentLength + chunkSize > size) {
-            chunkSize = size - sentLength;
+        std::string data = window->take_buffer();
+        data.resize(chunkSize);
+        if (!file.read(&data[0], chunkSize)) {
+            window->release(chunkSize);
+            s_isChunkingFile = false;
+            throw std::runtime_error("failed to read file");
         }
 
-        char* chunkData = new char[chunkSize];
-        file.read(chunkData, chunkSize);
-        std::uint8_t* data = reinterpret_cast<std::uint8_t*>(chunkData);
-        FileChunk fileChunk = FileChunk::data(data, chunkSize);
-        delete[] chunkData;
-
+        FileChunk chunk = FileChunk::data(std::move(data));
+        chunk.credit_ = std::shared_ptr<void>(nullptr, [window, chunkSize](void*)
+        {
+            window->release(chunkSize);
+        });
+        chunk.recycle_ = [window](std::string&& buffer)
+        {
+            window->give_back(std::move(buffer));
+        };
         events->add_event(EventType::FILE_CHUNK_SENDING, event_target,
-                          create_event_data<FileChunk>(fileChunk));
+                          create_event_data<FileChunk>(std::move(chunk)));
 
         sentLength += chunkSize;
-        file.seekg (sentLength, std::ios::beg);
+    }
 
-        if (sentLength == size) {
-            break;
-        }
+    if (interrupted) {
+        s_interruptFile = false;
+        LOG_DEBUG("file transmission interrupted");
     }
 
     // send last message
-    FileChunk end = FileChunk::end();
-
     events->add_event(EventType::FILE_CHUNK_SENDING, event_target,
-                      create_event_data<FileChunk>(end));
-
-    file.close();
+                      create_event_data<FileChunk>(FileChunk::end()));
 
     s_isChunkingFile = false;
 }
 
-void StreamChunker::sendClipboard(std::string& data, std::size_t size, ClipboardID id,
-                                  std::uint32_t sequence, IEventQueue* events,
-                                  const EventTarget* event_target)
-{
-    // send first message (data size)
-    ClipboardChunk size_message = ClipboardChunk::start(id, sequence, size);
-
-    events->add_event(EventType::CLIPBOARD_SENDING, event_target,
-                      create_event_data<ClipboardChunk>(size_message));
-
-    // send clipboard chunk with a fixed size
-    size_t sentLength = 0;
-    size_t chunkSize = g_chunkSize;
-
-    while (true) {
-        events->add_event(EventType::FILE_KEEPALIVE, event_target);
-
-        // make sure we don't read too much from the mock data.
-        if (sentLength + chunkSize > size) {
-            chunkSize = size - sentLength;
-        }
-
-        std::string chunk(data.substr(sentLength, chunkSize).c_str(), chunkSize);
-        ClipboardChunk data_chunk = ClipboardChunk::data(id, sequence, chunk);
-
-        events->add_event(EventType::CLIPBOARD_SENDING, event_target,
-                          create_event_data<ClipboardChunk>(data_chunk));
-
-        sentLength += chunkSize;
-        if (sentLength == size) {
-            break;
-        }
-    }
-
-    // send last message
-    ClipboardChunk end = ClipboardChunk::end(id, sequence);
-
-    events->add_event(EventType::CLIPBOARD_SENDING, event_target,
-                      create_event_data<ClipboardChunk>(end));
-
-    LOG_DEBUG("sent clipboard size=%zd", sentLength);
-}
-
 void
 StreamChunker::interruptFile()
 {
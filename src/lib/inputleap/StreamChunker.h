@@ -20,6 +20,7 @@
 #include "inputleap/clipboard_types.h"
 #include "base/Fwd.h"
 
+#include <atomic>
 #include <string>
 
 namespace inputleap {
@@ -27,14 +28,11 @@ namespace inputleap {
 class StreamChunker {
 public:
     static void sendFile(const char* filename, IEventQueue* events, const EventTarget* event_target);
-    static void sendClipboard(std::string& data, std::size_t size, ClipboardID id,
-                              std::uint32_t sequence, IEventQueue* events,
-                              const EventTarget* event_target);
     static void interruptFile();
 
 private:
     static bool            s_isChunkingFile;
-    static bool            s_interruptFile;
+    static std::atomic<bool> s_interruptFile;
 };
 
 } // namespace inputleap
@@ -33,9 +33,11 @@ namespace inputleap {
 // 1.4:  adds crypto support
 // 1.5:  adds file transfer and removes home brew crypto
 // 1.6:  adds clipboard streaming
+// 1.7:  adds on demand clipboard formats
+// 1.8:  adds compressed clipboard and file chunks
 // NOTE: with new version, InputLeap minor version should increment
 static const std::int16_t kProtocolMajorVersion = 1;
-static const std::int16_t kProtocolMinorVersion = 6;
+static const std::int16_t kProtocolMinorVersion = 8;
 
 // default contact port number
 static const std::uint16_t kDefaultPort = 24800;
@@ -84,7 +86,8 @@ enum EDirectionMask {
 enum EDataTransfer {
     kDataStart = 1,
     kDataChunk = 2,
-    kDataEnd = 3
+    kDataEnd = 3,
+    kDataChunkLZ4 = 4   // kDataChunk compressed as an LZ4 block, since 1.8
 };
 
 // Data received constants
@@ -113,13 +116,13 @@ enum EDataReceived {
 // say hello to client;  primary -> secondary
 // $1 = protocol major version number supported by server.  $2 =
 // protocol minor version number supported by server.
-extern const char*        kMsgHello;
+inline constexpr char kMsgHello[] = "Barrier%2i%2i";
 
 // respond to hello from server;  secondary -> primary
 // $1 = protocol major version number supported by client.  $2 =
 // protocol minor version number supported by client.  $3 = client
 // name.
-extern const char*        kMsgHelloBack;
+inline constexpr char kMsgHelloBack[] = "Barrier%2i%2i%s";
 
 
 //
@@ -127,10 +130,10 @@ extern const char*        kMsgHelloBack;
 //
 
 // no operation;  secondary -> primary
-extern const char*        kMsgCNoop;
+inline constexpr char kMsgCNoop[] = "CNOP";
 
 // close connection;  primary -> secondary
-extern const char*        kMsgCClose;
+inline constexpr char kMsgCClose[] = "CBYE";
 
 // enter screen:  primary -> secondary
 // entering screen at screen position $1 = x, $2 = y.  x,y are
@@ -140,7 +143,7 @@ extern const char*        kMsgCClose;
 // mask.  this will have bits set for each toggle modifier key
 // that is activated on entry to the screen.  the secondary screen
 // should adjust its toggle modifiers to reflect that state.
-extern const char*        kMsgCEnter;
+inline constexpr char kMsgCEnter[] = "CINN%2i%2i%4i%2i";
 
 // leave screen:  primary -> secondary
 // leaving screen.  the secondary screen should send clipboard
@@ -149,28 +152,28 @@ extern const char*        kMsgCEnter;
 // not received a kMsgCClipboard for with a greater sequence
 // number) and that were grabbed or have changed since the
 // last leave.
-extern const char*        kMsgCLeave;
+inline constexpr char kMsgCLeave[] = "COUT";
 
 // grab clipboard:  primary <-> secondary
 // sent by screen when some other app on that screen grabs a
 // clipboard.  $1 = the clipboard identifier, $2 = sequence number.
 // secondary screens must use the sequence number passed in the
 // most recent kMsgCEnter.  the primary always sends 0.
-extern const char*        kMsgCClipboard;
+inline constexpr char kMsgCClipboard[] = "CCLP%1i%4i";
 
 // screensaver change:  primary -> secondary
 // screensaver on primary has started ($1 == 1) or closed ($1 == 0)
-extern const char*        kMsgCScreenSaver;
+inline constexpr char kMsgCScreenSaver[] = "CSEC%1i";
 
 // reset options:  primary -> secondary
 // client should reset all of its options to their defaults.
-extern const char*        kMsgCResetOptions;
+inline constexpr char kMsgCResetOptions[] = "CROP";
 
 // resolution change acknowledgment:  primary -> secondary
 // sent by primary in response to a secondary screen's kMsgDInfo.
 // this is sent for every kMsgDInfo, whether or not the primary
 // had sent a kMsgQInfo.
-extern const char*        kMsgCInfoAck;
+inline constexpr char kMsgCInfoAck[] = "CIAK";
 
 // keep connection alive:  primary <-> secondary
 // sent by the server periodically to verify that connections are still
@@ -180,7 +183,7 @@ extern const char*        kMsgCInfoAck;
 // client doesn't receive these (or any message) periodically then it
 // should disconnect from the server.  the appropriate interval is
 // defined by an option.
-extern const char*        kMsgCKeepAlive;
+inline constexpr char kMsgCKeepAlive[] = "CALV";
 
 //
 // data codes
@@ -197,57 +200,74 @@ extern const char*        kMsgCKeepAlive;
 // the press.  this can happen with combining (dead) keys or if
 // the keyboard layouts are not identical and the user releases
 // a modifier key before releasing the modified key.
-extern const char*        kMsgDKeyDown;
+inline constexpr char kMsgDKeyDown[] = "DKDN%2i%2i%2i";
 
 // key pressed 1.0:  same as above but without KeyButton
-extern const char*        kMsgDKeyDown1_0;
+inline constexpr char kMsgDKeyDown1_0[] = "DKDN%2i%2i";
 
 // key auto-repeat:  primary -> secondary
 // $1 = KeyID, $2 = KeyModifierMask, $3 = number of repeats, $4 = KeyButton
-extern const char*        kMsgDKeyRepeat;
+inline constexpr char kMsgDKeyRepeat[] = "DKRP%2i%2i%2i%2i";
 
 // key auto-repeat 1.0:  same as above but without KeyButton
-extern const char*        kMsgDKeyRepeat1_0;
+inline constexpr char kMsgDKeyRepeat1_0[] = "DKRP%2i%2i%2i";
 
 // key released:  primary -> secondary
 // $1 = KeyID, $2 = KeyModifierMask, $3 = KeyButton
-extern const char*        kMsgDKeyUp;
+inline constexpr char kMsgDKeyUp[] = "DKUP%2i%2i%2i";
 
 // key released 1.0:  same as above but without KeyButton
-extern const char*        kMsgDKeyUp1_0;
+inline constexpr char kMsgDKeyUp1_0[] = "DKUP%2i%2i";
 
 // mouse button pressed:  primary -> secondary
 // $1 = ButtonID
-extern const char*        kMsgDMouseDown;
+inline constexpr char kMsgDMouseDown[] = "DMDN%1i";
 
 // mouse button released:  primary -> secondary
 // $1 = ButtonID
-extern const char*        kMsgDMouseUp;
+inline constexpr char kMsgDMouseUp[] = "DMUP%1i";
 
 // mouse moved:  primary -> secondary
 // $1 = x, $2 = y.  x,y are absolute screen coordinates.
-extern const char*        kMsgDMouseMove;
+inline constexpr char kMsgDMouseMove[] = "DMMV%2i%2i";
 
 // relative mouse move:  primary -> secondary
 // $1 = dx, $2 = dy.  dx,dy are motion deltas.
-extern const char*        kMsgDMouseRelMove;
+inline constexpr char kMsgDMouseRelMove[] = "DMRM%2i%2i";
 
 // mouse scroll:  primary -> secondary
 // $1 = xDelta, $2 = yDelta.  the delta should be +120 for one tick forward
 // (away from the user) or right and -120 for one tick backward (toward
 // the user) or left.
-extern const char*        kMsgDMouseWheel;
+inline constexpr char kMsgDMouseWheel[] = "DMWM%2i%2i";
 
 // mouse vertical scroll:  primary -> secondary
 // like as kMsgDMouseWheel except only sends $1 = yDelta.
-extern const char*        kMsgDMouseWheel1_0;
+inline constexpr char kMsgDMouseWheel1_0[] = "DMWM%2i";
 
 // clipboard data:  primary <-> secondary
 // $2 = sequence number, $3 = mark $4 = clipboard data.  the sequence number
 // is 0 when sent by the primary.  secondary screens should use the
 // sequence number from the most recent kMsgCEnter.  $1 = clipboard
-// identifier.
-extern const char*        kMsgDClipboard;
+// identifier.  since 1.8 a data chunk may be sent with mark
+// kDataChunkLZ4 instead of kDataChunk, holding the chunk compressed as
+// an LZ4 block.
+inline constexpr char kMsgDClipboard[] = "DCLP%1i%4i%1i%s";
+
+// same message as kMsgDClipboard with the data passed as a size and a
+// pointer, so clipboard chunks are written without copying them first.
+inline constexpr char kMsgDClipboardSlice[] = "DCLP%1i%4i%1i%S";
+
+// clipboard formats:  primary -> secondary
+// replaces kMsgDClipboard for the primary's clipboards since 1.7.
+// $1 = clipboard identifier, $2 = sequence number of the
+// advertisement, $3 = six integers for each available format:  the
+// format, the size of its data and its digest as four 32 bit words,
+// most significant first.  the data itself is only sent in response
+// to a kMsgQClipboardFormat, as a kMsgDClipboard holding just the
+// requested format and the sequence number of the advertisement it
+// belongs to.  replies may arrive after a newer advertisement.
+inline constexpr char kMsgDClipboardFormats[] = "DCLF%1i%4i%4I";
 
 // client data:  secondary -> primary
 // $1 = coordinate of leftmost pixel on secondary screen,
@@ -263,25 +283,26 @@ extern const char*        kMsgDClipboard;
 // should ignore any kMsgDMouseMove messages until it receives a
 // kMsgCInfoAck in order to prevent attempts to move the mouse off
 // the new screen area.
-extern const char*        kMsgDInfo;
+inline constexpr char kMsgDInfo[] = "DINF%2i%2i%2i%2i%2i%2i%2i";
 
 // set options:  primary -> secondary
 // client should set the given option/value pairs.  $1 = option/value
 // pairs.
-extern const char*        kMsgDSetOptions;
+inline constexpr char kMsgDSetOptions[] = "DSOP%4I";
 
 // file data:  primary <-> secondary
 // transfer file data. A mark is used in the first byte.
 // 0 means the content followed is the file size.
 // 1 means the content followed is the chunk data.
 // 2 means the file transfer is finished.
-extern const char*        kMsgDFileTransfer;
+// since 1.8 chunk data may be sent compressed, see kMsgDClipboard.
+inline constexpr char kMsgDFileTransfer[] = "DFTR%1i%s";
 
 // drag information:  primary <-> secondary
 // transfer drag information. The first 2 bytes are used for storing
 // the number of dragging objects. Then the following string consists
 // of each object's directory.
-extern const char*        kMsgDDragInfo;
+inline constexpr char kMsgDDragInfo[] = "DDRG%2i%s";
 
 //
 // query codes
@@ -289,7 +310,13 @@ extern const char*        kMsgDDragInfo;
 
 // query screen info:  primary -> secondary
 // client should reply with a kMsgDInfo.
-extern const char*        kMsgQInfo;
+inline constexpr char kMsgQInfo[] = "QINF";
+
+// query clipboard format:  secondary -> primary
+// asks for the data of format $2 of clipboard $1 as last advertised
+// by a kMsgDClipboardFormats.  the primary replies with a
+// kMsgDClipboard for its latest advertisement.  since 1.7.
+inline constexpr char kMsgQClipboardFormat[] = "QCLF%1i%1i";
 
 
 //
@@ -298,19 +325,19 @@ extern const char*        kMsgQInfo;
 
 // incompatible versions:  primary -> secondary
 // $1 = major version of primary, $2 = minor version of primary.
-extern const char*        kMsgEIncompatible;
+inline constexpr char kMsgEIncompatible[] = "EICV%2i%2i";
 
 // name provided when connecting is already in use:  primary -> secondary
-extern const char*        kMsgEBusy;
+inline constexpr char kMsgEBusy[] = "EBSY";
 
 // unknown client:  primary -> secondary
 // name provided when connecting is not in primary's screen
 // configuration map.
-extern const char*        kMsgEUnknown;
+inline constexpr char kMsgEUnknown[] = "EUNK";
 
 // protocol violation:  primary -> secondary
 // primary should disconnect after sending this message.
-extern const char*        kMsgEBad;
+inline constexpr char kMsgEBad[] = "EBAD";
 
 
 //
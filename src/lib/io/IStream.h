@@ -113,6 +113,15 @@ public:
     */
     virtual std::uint32_t getSize() const = 0;
 
+    //! Get bytes waiting to be sent
+    /*!
+    Returns the number of bytes written to the stream that haven't
+    been sent yet.  Writers can use this to avoid queueing more than
+    the stream can send.  Some streams don't buffer output and will
+    always return zero.
+    */
+    virtual std::uint32_t getOutputSize() const = 0;
+
     //@}
 };
 
@@ -23,12 +23,15 @@
 //
 
 #include <cassert>
+#include <cstring>
 
-const std::uint32_t StreamBuffer::kChunkSize = 4096;
+const std::uint32_t StreamBuffer::kMinCapacity = 4096;
+const std::uint32_t StreamBuffer::kMaxIdleCapacity = 64 * 1024;
 
 StreamBuffer::StreamBuffer() :
-    m_size(0),
-    m_headUsed(0)
+    m_capacity(0),
+    m_begin(0),
+    m_end(0)
 {
     // do nothing
 }
@@ -40,105 +43,97 @@ StreamBuffer::~StreamBuffer()
 
 const void* StreamBuffer::peek(std::uint32_t n)
 {
-    assert(n <= m_size);
+    assert(n <= getSize());
 
     // if requesting no data then return nullptr so we don't try to access
-    // an empty list.
+    // empty storage.
     if (n == 0) {
         return nullptr;
     }
 
-    // reserve space in first chunk
-    auto head = m_chunks.begin();
-    head->reserve(n + m_headUsed);
-
-    // consolidate chunks into the first chunk until it has n bytes
-    auto scan = head;
-    ++scan;
-    while (head->size() - m_headUsed < n && scan != m_chunks.end()) {
-        head->insert(head->end(), scan->begin(), scan->end());
-        scan = m_chunks.erase(scan);
-    }
-
-    return static_cast<const void*>(&(head->begin()[m_headUsed]));
+    return m_data.get() + m_begin;
 }
 
 void StreamBuffer::pop(std::uint32_t n)
 {
-    // discard all chunks if n is greater than or equal to m_size
-    if (n >= m_size) {
-        m_size     = 0;
-        m_headUsed = 0;
-        m_chunks.clear();
+    // discard everything if n is greater than or equal to the size
+    if (n >= getSize()) {
+        m_begin = 0;
+        m_end   = 0;
+
+        // don't hold on to the storage for a large transfer
+        if (m_capacity > kMaxIdleCapacity) {
+            m_data.reset();
+            m_capacity = 0;
+        }
         return;
     }
 
-    // update size
-    m_size -= n;
-
-    // discard chunks until more than n bytes would've been discarded
-    auto scan = m_chunks.begin();
-    assert(scan != m_chunks.end());
-    while (scan->size() - m_headUsed <= n) {
-        n -= static_cast<std::uint32_t>(scan->size()) - m_headUsed;
-        m_headUsed = 0;
-        scan       = m_chunks.erase(scan);
-        assert(scan != m_chunks.end());
-    }
-
-    // remove left over bytes from the head chunk
-    if (n > 0) {
-        m_headUsed += n;
-    }
+    m_begin += n;
 }
 
 void StreamBuffer::write(const void* vdata, std::uint32_t n)
 {
     assert(vdata != nullptr);
 
-    // ignore if no data, otherwise update size
+    // ignore if no data
     if (n == 0) {
         return;
     }
-    m_size += n;
 
-    // cast data to bytes
-    const std::uint8_t* data = static_cast<const std::uint8_t*>(vdata);
+    std::memcpy(reserve(n), vdata, n);
+    commit(n);
+}
 
-    // point to last chunk if it has space, otherwise append an empty chunk
-    auto scan = m_chunks.end();
-    if (scan != m_chunks.begin()) {
-        --scan;
-        if (scan->size() >= kChunkSize) {
-            ++scan;
-        }
-    }
-    if (scan == m_chunks.end()) {
-        scan = m_chunks.insert(scan, Chunk());
+std::uint8_t* StreamBuffer::reserve(std::uint32_t n)
+{
+    if (m_capacity - m_end < n) {
+        makeSpace(n);
     }
+    return m_data.get() + m_end;
+}
 
-    // append data in chunks
-    while (n > 0) {
-        // choose number of bytes for next chunk
-        assert(scan->size() <= kChunkSize);
-        std::uint32_t count = kChunkSize - static_cast<std::uint32_t>(scan->size());
-        if (count > n)
-            count = n;
-
-        // transfer data
-        scan->insert(scan->end(), data, data + count);
-        n    -= count;
-        data += count;
-
-        // append another empty chunk if we're not done yet
-        if (n > 0) {
-            ++scan;
-            scan = m_chunks.insert(scan, Chunk());
-        }
-    }
+void StreamBuffer::commit(std::uint32_t n)
+{
+    assert(n <= m_capacity - m_end);
+    m_end += n;
+}
+
+const std::uint8_t* StreamBuffer::peek_span() const
+{
+    return (m_begin == m_end) ? nullptr : m_data.get() + m_begin;
 }
 
 std::uint32_t StreamBuffer::getSize() const
 {
-    return m_size;
+    return m_end - m_begin;
+}
+
+void StreamBuffer::makeSpace(std::uint32_t n)
+{
+    std::uint32_t size = getSize();
+
+    // move the data to the front if that frees enough space and the
+    // storage stays at most half full.  otherwise double the storage
+    // until it's at most half full.  either way each byte is moved
+    // O(1) times on average.
+    if (m_data != nullptr && size + n <= m_capacity / 2) {
+        std::memmove(m_data.get(), m_data.get() + m_begin, size);
+    }
+    else {
+        std::uint32_t capacity = (m_capacity == 0) ? kMinCapacity : m_capacity;
+        while (capacity / 2 < size + n) {
+            capacity *= 2;
+        }
+
+        std::unique_ptr<std::uint8_t[]> data(new std::uint8_t[capacity]);
+        if (size > 0) {
+            std::memcpy(data.get(), m_data.get() + m_begin, size);
+        }
+        m_data     = std::move(data);
+        m_capacity = capacity;
+    }
+
+    m_begin = 0;
+    m_end   = size;
 }
@@ -19,12 +19,14 @@
 #pragma once
 
 #include "base/EventTypes.h"
-#include <list>
-#include <vector>
+#include <memory>
 
 //! FIFO of bytes
 /*!
-This class maintains a FIFO (first-in, last-out) buffer of bytes.
+This class maintains a FIFO (first-in, first-out) buffer of bytes.  The
+buffered bytes are always stored contiguously so they can be read, and
+written to a socket, in place.  Space can also be reserved at the end of
+the buffer so a socket can read straight into it.
 */
 class StreamBuffer {
 public:
@@ -38,7 +40,8 @@ public:
     /*!
     Return a pointer to memory with the next \c n bytes in the buffer
     (which must be <= getSize()).  The caller must not modify the returned
-    memory nor delete it.
+    memory nor delete it.  The pointer is valid until the buffer is next
+    modified.
     */
     const void* peek(std::uint32_t n);
 
@@ -55,10 +58,34 @@ public:
     */
     void write(const void* data, std::uint32_t n);
 
+    //! Reserve space at the end of the buffer
+    /*!
+    Returns a pointer to at least \c n writable bytes just past the end of
+    the buffered data.  Bytes written there become part of the buffer
+    once they're passed to \c commit().  This invalidates pointers
+    returned by earlier calls to \c peek() and \c peek_span().
+    */
+    std::uint8_t* reserve(std::uint32_t n);
+
+    //! Append reserved data
+    /*!
+    Appends the first \c n bytes of the space returned by the last call
+    to \c reserve(), which must have been for at least \c n bytes.
+    */
+    void commit(std::uint32_t n);
+
     //@}
     //! @name accessors
     //@{
 
+    //! Read all data without removing from buffer
+    /*!
+    Returns a pointer to all getSize() bytes in the buffer, or nullptr if
+    the buffer is empty.  The pointer is valid until the buffer is next
+    modified.
+    */
+    const std::uint8_t* peek_span() const;
+
     //! Get size of buffer
     /*!
     Returns the number of bytes in the buffer.
@@ -68,12 +95,18 @@ public:
     //@}
 
 private:
-    static const std::uint32_t kChunkSize;
+    // make room for at least n bytes after m_end, moving the buffered
+    // data to the front of the storage or into larger storage
+    void makeSpace(std::uint32_t n);
 
-    typedef std::vector<std::uint8_t> Chunk;
-    typedef std::list<Chunk> ChunkList;
+private:
+    static const std::uint32_t kMinCapacity;
+    static const std::uint32_t kMaxIdleCapacity;
 
-    ChunkList m_chunks;
-    std::uint32_t m_size;
-    std::uint32_t m_headUsed;
+    // buffered bytes are [m_begin, m_end) in m_data.  the capacity is
+    // always a power of two.
+    std::unique_ptr<std::uint8_t[]> m_data;
+    std::uint32_t m_capacity;
+    std::uint32_t m_begin;
+    std::uint32_t m_end;
 };
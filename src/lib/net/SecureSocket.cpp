@@ -24,7 +24,6 @@
 #include "base/Log.h"
 #include "base/String.h"
 #include "base/finally.h"
-#include "base/Time.h"
 #include "common/DataDirectories.h"
 #include "io/filesystem.h"
 #include "net/FingerprintDatabase.h"
@@ -42,7 +41,7 @@ namespace inputleap {
 #define MAX_ERROR_SIZE 65535
 
 static const std::size_t MAX_INPUT_BUFFER_SIZE = 1024 * 1024;
-static const float s_retryDelay = 0.01f;
+static const double s_handshakeTimeout = 30.0;
 
 enum {
     kMsgSize = 128
@@ -75,6 +74,7 @@ SecureSocket::SecureSocket(IEventQueue* events, SocketMultiplexer* socketMultipl
 SecureSocket::~SecureSocket()
 {
     isFatal(true);
+    stop_handshake_timer();
     // take socket from multiplexer ASAP otherwise the race condition
     // could cause events to get called on a dead object. TCPSocket
     // will do this, too, but the double-call is harmless
@@ -129,29 +129,39 @@ std::unique_ptr<ISocketMultiplexerJob> SecureSocket::newJob()
 void
 SecureSocket::secureConnect()
 {
+    // the client speaks first
+    ssl_want_read_ = false;
+    ssl_want_write_ = true;
+    start_handshake_timer();
     setJob(std::make_unique<TSocketMultiplexerMethodJob>([this](auto j, auto r, auto w, auto e)
                                                          { return serviceConnect(j, r, w, e); },
-                                                         getSocket(), isReadable(), isWritable()));
+                                                         getSocket(), ssl_want_read_,
+                                                         ssl_want_write_));
 }
 
 void
 SecureSocket::secureAccept()
 {
+    ssl_want_read_ = true;
+    ssl_want_write_ = false;
+    start_handshake_timer();
     setJob(std::make_unique<TSocketMultiplexerMethodJob>([this](auto j, auto r, auto w, auto e)
                                                          { return serviceAccept(j, r, w, e); },
-                                                         getSocket(), isReadable(), isWritable()));
+                                                         getSocket(), ssl_want_read_,
+                                                         ssl_want_write_));
 }
 
 TCPSocket::EJobResult
 SecureSocket::doRead()
 {
-    std::uint8_t buffer[4096];
-    memset(buffer, 0, sizeof(buffer));
+    const int kReadSize = 4096;
+    bool wasEmpty = (m_inputBuffer.getSize() == 0);
     int bytesRead = 0;
     int status = 0;
 
     if (isSecureReady()) {
-        status = secureRead(buffer, sizeof(buffer), bytesRead);
+        // decrypt straight into the input buffer
+        status = secureRead(m_inputBuffer.reserve(kReadSize), kReadSize, bytesRead);
         if (status < 0) {
             return kBreak;
         }
@@ -164,17 +174,15 @@ SecureSocket::doRead()
     }
 
     if (bytesRead > 0) {
-        bool wasEmpty = (m_inputBuffer.getSize() == 0);
-
         // slurp up as much as possible
         do {
-            m_inputBuffer.write(buffer, bytesRead);
+            m_inputBuffer.commit(bytesRead);
 
             if (m_inputBuffer.getSize() > MAX_INPUT_BUFFER_SIZE) {
                 break;
             }
 
-            status = secureRead(buffer, sizeof(buffer), bytesRead);
+            status = secureRead(m_inputBuffer.reserve(kReadSize), kReadSize, bytesRead);
             if (status < 0) {
                 return kBreak;
             }
@@ -184,6 +192,11 @@ SecureSocket::doRead()
         if (wasEmpty) {
             sendEvent(EventType::STREAM_INPUT_READY);
         }
+
+        // stop reading until the buffer is drained if it's full
+        if (m_inputBuffer.getSize() > MAX_INPUT_BUFFER_SIZE) {
+            return kNew;
+        }
     }
     else {
         // remote write end of stream hungup.  our input side
@@ -213,23 +226,20 @@ SecureSocket::doWrite()
         return kRetry;
 
     if (do_write_retry_) {
+        // a retried write must pass the same data again.  it's still at
+        // the front of the output buffer, though it may have moved in
+        // memory (see SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER).
         bufferSize = do_write_retry_size_;
     } else {
         bufferSize = m_outputBuffer.getSize();
-        if (bufferSize > do_write_retry_buffer_size_) {
-            do_write_retry_buffer_.reset(new char[bufferSize]);
-            do_write_retry_buffer_size_ = bufferSize;
-        }
-        if (bufferSize > 0) {
-            std::memcpy(do_write_retry_buffer_.get(), m_outputBuffer.peek(bufferSize), bufferSize);
-        }
     }
 
     if (bufferSize == 0) {
         return kRetry;
     }
+    assert(bufferSize <= m_outputBuffer.getSize());
 
-    status = secureWrite(do_write_retry_buffer_.get(), bufferSize, bytesWrote);
+    status = secureWrite(m_outputBuffer.peek_span(), bufferSize, bytesWrote);
     if (status > 0) {
         do_write_retry_ = false;
     } else if (status < 0) {
@@ -389,13 +399,18 @@ SecureSocket::initContext(bool server)
     SSL_METHOD* m = const_cast<SSL_METHOD*>(method);
     m_ssl->m_context = SSL_CTX_new(m);
 
-    // drop SSLv3 support
-    SSL_CTX_set_options(m_ssl->m_context, SSL_OP_NO_SSLv3);
-
     if (m_ssl->m_context == nullptr) {
         showError("");
+        return;
     }
 
+    // drop SSLv3 support
+    SSL_CTX_set_options(m_ssl->m_context, SSL_OP_NO_SSLv3);
+
+    // retried writes are passed straight from the output buffer, which
+    // may move the data when more is appended
+    SSL_CTX_set_mode(m_ssl->m_context, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+
     if (security_level_ == ConnectionSecurityLevel::ENCRYPTED_AUTHENTICATED) {
         // We want to ask for peer certificate, but not verify it. If we don't ask for peer
         // certificate, e.g. client won't send it.
@@ -434,11 +449,10 @@ SecureSocket::secureAccept(int socket)
     checkResult(r, secure_accept_retry_);
 
     if (isFatal()) {
-        // tell user and sleep so the socket isn't hammered.
+        // the job stops servicing the socket so it isn't hammered
         LOG_ERR("failed to accept secure socket");
         LOG_INFO("client connection may not be secure");
         m_secureReady = false;
-        inputleap::this_thread_sleep(1);
         secure_accept_retry_ = 0;
         return -1; // Failed, error out
     }
@@ -471,7 +485,6 @@ SecureSocket::secureAccept(int socket)
     if (secure_accept_retry_ > 0) {
         LOG_DEBUG2("retry accepting secure socket");
         m_secureReady = false;
-        inputleap::this_thread_sleep(s_retryDelay);
         return 0;
     }
 
@@ -512,7 +525,6 @@ SecureSocket::secureConnect(int socket)
     if (secure_connect_retry_ > 0) {
         LOG_DEBUG2("retry connect secure socket");
         m_secureReady = false;
-        inputleap::this_thread_sleep(s_retryDelay);
         return 0;
     }
 
@@ -558,6 +570,8 @@ SecureSocket::checkResult(int status, int& retry)
         break;
 
     case SSL_ERROR_WANT_READ:
+        ssl_want_read_ = true;
+        ssl_want_write_ = false;
         retry++;
         LOG_DEBUG2("want to read, error=%d, attempt=%d", errorCode, retry);
         break;
@@ -567,6 +581,8 @@ SecureSocket::checkResult(int status, int& retry)
         // select action actually triggers on a write. This isn't necessary for
         // m_readable because the socket logic is always readable
         m_writable = true;
+        ssl_want_read_ = false;
+        ssl_want_write_ = true;
         retry++;
         LOG_DEBUG2("want to write, error=%d, attempt=%d", errorCode, retry);
         break;
@@ -718,6 +734,11 @@ MultiplexerJobStatus SecureSocket::serviceConnect(ISocketMultiplexerJob* job,
 
     std::lock_guard<std::mutex> lock(tcp_mutex_);
 
+    // the handshake timed out
+    if (isFatal()) {
+        return {false, {}};
+    }
+
     int status = 0;
 #ifdef SYSAPI_WIN32
     status = secureConnect(static_cast<int>(getSocket()->m_socket));
@@ -732,16 +753,19 @@ MultiplexerJobStatus SecureSocket::serviceConnect(ISocketMultiplexerJob* job,
 
     // If status > 0, success
     if (status > 0) {
+        // the timeout must not end the established connection
+        stop_handshake_timer();
         sendEvent(EventType::DATA_SOCKET_SECURE_CONNECTED);
         return newJobOrStopServicing();
     }
 
-    // Retry case
+    // Retry case.  wait for the socket to be ready in the direction
+    // openssl asked for instead of spinning on a writable socket.
     return {
         true,
         std::make_unique<TSocketMultiplexerMethodJob>([this](auto j, auto r, auto w, auto e)
                                                       { return serviceConnect(j, r, w, e); },
-                                                      getSocket(), isReadable(), isWritable())
+                                                      getSocket(), ssl_want_read_, ssl_want_write_)
     };
 }
 
@@ -755,6 +779,11 @@ MultiplexerJobStatus SecureSocket::serviceAccept(ISocketMultiplexerJob* job,
 
     std::lock_guard<std::mutex> lock(tcp_mutex_);
 
+    // the handshake timed out
+    if (isFatal()) {
+        return {false, {}};
+    }
+
     int status = 0;
 #ifdef SYSAPI_WIN32
     status = secureAccept(static_cast<int>(getSocket()->m_socket));
@@ -768,16 +797,18 @@ MultiplexerJobStatus SecureSocket::serviceAccept(ISocketMultiplexerJob* job,
 
     // If status > 0, success
     if (status > 0) {
+        stop_handshake_timer();
         sendEvent(EventType::CLIENT_LISTENER_ACCEPTED);
         return newJobOrStopServicing();
     }
 
-    // Retry case
+    // Retry case.  wait for the socket to be ready in the direction
+    // openssl asked for instead of spinning on a writable socket.
     return {
         true,
         std::make_unique<TSocketMultiplexerMethodJob>([this](auto j, auto r, auto w, auto e)
                                                       { return serviceAccept(j, r, w, e); },
-                                                      getSocket(), isReadable(), isWritable())
+                                                      getSocket(), ssl_want_read_, ssl_want_write_)
     };
 }
 
@@ -859,6 +890,42 @@ SecureSocket::showSecureConnectInfo()
     return;
 }
 
+void SecureSocket::start_handshake_timer()
+{
+    stop_handshake_timer();
+    std::lock_guard<std::mutex> lock(handshake_timer_mutex_);
+    m_events->add_handler(EventType::TIMER, get_event_target(),
+                          [this](const auto& e){ handle_handshake_timeout(); });
+    handshake_timer_ = m_events->newOneShotTimer(s_handshakeTimeout, get_event_target());
+}
+
+void SecureSocket::stop_handshake_timer()
+{
+    std::lock_guard<std::mutex> lock(handshake_timer_mutex_);
+    if (handshake_timer_ != nullptr) {
+        m_events->deleteTimer(handshake_timer_);
+        m_events->remove_handler(EventType::TIMER, get_event_target());
+        handshake_timer_ = nullptr;
+    }
+}
+
+void SecureSocket::handle_handshake_timeout()
+{
+    stop_handshake_timer();
+
+    {
+        std::lock_guard<std::mutex> lock(tcp_mutex_);
+        if (m_secureReady || isFatal()) {
+            return;
+        }
+        LOG_ERR("secure socket handshake timed out");
+        isFatal(true);
+    }
+
+    removeJob();
+    disconnect();
+}
+
 void SecureSocket::handle_tcp_connected(const Event& event)
 {
     (void) event;
@@ -84,6 +84,12 @@ private:
 
     void handle_tcp_connected(const Event& event);
 
+    // the handshake timer is started from the event queue thread and
+    // stopped from either thread
+    void start_handshake_timer();
+    void stop_handshake_timer();
+    void handle_handshake_timeout();
+
     void freeSSLResources();
 
 private:
@@ -97,17 +103,21 @@ private:
     bool m_fatal;
     ConnectionSecurityLevel security_level_ = ConnectionSecurityLevel::ENCRYPTED;
 
+    // the socket readiness the last SSL call is waiting for
+    bool ssl_want_read_ = false;
+    bool ssl_want_write_ = false;
+
+    std::mutex handshake_timer_mutex_;
+    EventQueueTimer* handshake_timer_ = nullptr;
+
     int secure_accept_retry_ = 0; // used only in secureAccept()
     int secure_connect_retry_ = 0; // used only in secureConnect()
     int secure_read_retry_ = 0; // used only in secureRead()
     int secure_write_retry_ = 0; // used only in secureWrite()
 
     // The following are used only from doWrite()
-    // FIXME: using std::vector would simplify logic significantly.
     bool do_write_retry_ = false;
     std::uint32_t do_write_retry_size_ = 0;
-    std::unique_ptr<char[]> do_write_retry_buffer_;
-    std::size_t do_write_retry_buffer_size_ = 0;
 };
 
 } // namespace inputleap
@@ -23,6 +23,7 @@
 #include "arch/Arch.h"
 #include "arch/XArch.h"
 #include "base/Log.h"
+#include <algorithm>
 #include <vector>
 
 namespace inputleap {
@@ -45,18 +46,49 @@ public:
 };
 
 
-SocketMultiplexer::SocketMultiplexer() :
+SocketMultiplexer::SocketMultiplexer(std::size_t threads) :
     m_thread(nullptr),
     m_update(false),
     m_jobListLocker(nullptr),
-    m_jobListLockLocker(nullptr)
+    m_jobListLockLocker(nullptr),
+    m_poller(nullptr)
 {
+    if (threads > 1) {
+        LOG_DEBUG("starting %zu socket multiplexer threads", threads);
+        for (std::size_t i = 0; i < threads; ++i) {
+            m_reactors.push_back(std::make_unique<SocketMultiplexer>());
+            m_reactors.back()->m_parent = this;
+            m_reactors.back()->m_reactorIndex = i;
+        }
+        m_reactorLoads.resize(threads, 0);
+        return;
+    }
+
+    try {
+        m_poller = ARCH->newPoller();
+    }
+    catch (XArchNetwork& e) {
+        LOG_WARN("cannot create socket poller, falling back to polling: %s", e.what());
+    }
+
     // start thread
-    m_thread = new Thread([this](){ service_thread(); });
+    if (m_poller != nullptr) {
+        m_thread = new Thread([this](){ service_poller_thread(); });
+    }
+    else {
+        m_thread = new Thread([this](){ service_thread(); });
+    }
 }
 
 SocketMultiplexer::~SocketMultiplexer()
 {
+    if (m_thread == nullptr) {
+        // the reactors stop their own threads.  stop them before the
+        // affinity goes away since they report retired jobs to it.
+        m_reactors.clear();
+        return;
+    }
+
     m_thread->cancel();
     m_thread->unblockPollSocket();
     {
@@ -68,6 +100,10 @@ SocketMultiplexer::~SocketMultiplexer()
     delete m_thread;
     delete m_jobListLocker;
     delete m_jobListLockLocker;
+
+    if (m_poller != nullptr) {
+        ARCH->closePoller(m_poller);
+    }
 }
 
 void SocketMultiplexer::addSocket(ISocket* socket, std::unique_ptr<ISocketMultiplexerJob>&& job)
@@ -75,15 +111,56 @@ void SocketMultiplexer::addSocket(ISocket* socket, std::unique_ptr<ISocketMultip
     assert(socket != nullptr);
     assert(job != nullptr);
 
+    if (!m_reactors.empty()) {
+        // the reactor may be busy running jobs so don't hold the lock
+        // while waiting for it
+        std::unique_lock<std::mutex> lock(m_reactorMutex);
+        ReactorAffinity* affinity = beginReactorUpdate(lock, socket, true);
+        SocketMultiplexer* reactor = m_reactors[affinity->m_reactor].get();
+        lock.unlock();
+
+        reactor->addSocket(socket, std::move(job));
+
+        // the job may already have stopped servicing and been retired
+        lock.lock();
+        auto i = m_reactorAffinity.find(socket);
+        if (i->second.m_retired) {
+            --m_reactorLoads[i->second.m_reactor];
+            m_reactorAffinity.erase(i);
+        }
+        else {
+            i->second.m_busy = false;
+        }
+        m_reactorUpdated.notify_all();
+        return;
+    }
+
     // prevent other threads from locking the job list
     lockJobListLock();
 
-    // break thread out of poll
-    m_thread->unblockPollSocket();
+    // break thread out of poll.  not necessary with a poller since the
+    // service thread doesn't hold the job list lock while waiting.
+    if (m_poller == nullptr) {
+        m_thread->unblockPollSocket();
+    }
 
     // lock the job list
     lockJobList();
 
+    if (m_poller != nullptr) {
+        PollerJobMap::iterator i = m_pollerJobs.find(socket);
+        if (i == m_pollerJobs.end()) {
+            std::unique_ptr<PollerJob> entry(new PollerJob{socket, nullptr, 0, {}});
+            i = m_pollerJobs.insert(std::make_pair(socket, std::move(entry))).first;
+        }
+        setPollerJob(i, std::move(job));
+        if (m_parent != nullptr) {
+            m_parent->onReactorJobInstalled(socket);
+        }
+        unlockJobList();
+        return;
+    }
+
     // insert/replace job
     SocketJobMap::iterator i = m_socketJobMap.find(socket);
     if (i == m_socketJobMap.end()) {
@@ -98,6 +175,9 @@ void SocketMultiplexer::addSocket(ISocket* socket, std::unique_ptr<ISocketMultip
         *(i->second) = std::move(job);
         m_update = true;
     }
+    if (m_parent != nullptr) {
+        m_parent->onReactorJobInstalled(socket);
+    }
 
     // unlock the job list
     unlockJobList();
@@ -108,15 +188,45 @@ SocketMultiplexer::removeSocket(ISocket* socket)
 {
     assert(socket != nullptr);
 
+    if (!m_reactors.empty()) {
+        std::unique_lock<std::mutex> lock(m_reactorMutex);
+        ReactorAffinity* affinity = beginReactorUpdate(lock, socket, false);
+        if (affinity == nullptr) {
+            return;
+        }
+        SocketMultiplexer* reactor = m_reactors[affinity->m_reactor].get();
+        lock.unlock();
+
+        reactor->removeSocket(socket);
+
+        lock.lock();
+        auto i = m_reactorAffinity.find(socket);
+        --m_reactorLoads[i->second.m_reactor];
+        m_reactorAffinity.erase(i);
+        m_reactorUpdated.notify_all();
+        return;
+    }
+
     // prevent other threads from locking the job list
     lockJobListLock();
 
     // break thread out of poll
-    m_thread->unblockPollSocket();
+    if (m_poller == nullptr) {
+        m_thread->unblockPollSocket();
+    }
 
     // lock the job list
     lockJobList();
 
+    if (m_poller != nullptr) {
+        PollerJobMap::iterator i = m_pollerJobs.find(socket);
+        if (i != m_pollerJobs.end()) {
+            setPollerJob(i, nullptr);
+        }
+        unlockJobList();
+        return;
+    }
+
     // remove job.  rather than removing it from the map we put nullptr
     // in the list instead so the order of jobs in the list continues
     // to match the order of jobs in pfds in service_thread().
@@ -132,6 +242,63 @@ SocketMultiplexer::removeSocket(ISocket* socket)
     unlockJobList();
 }
 
+SocketMultiplexer::ReactorAffinity*
+SocketMultiplexer::beginReactorUpdate(std::unique_lock<std::mutex>& lock, ISocket* socket,
+                                      bool add)
+{
+    for (;;) {
+        auto i = m_reactorAffinity.find(socket);
+        if (i == m_reactorAffinity.end()) {
+            if (!add) {
+                return nullptr;
+            }
+
+            // pin the socket to the reactor with the fewest sockets
+            std::size_t index = 0;
+            for (std::size_t j = 1; j < m_reactorLoads.size(); ++j) {
+                if (m_reactorLoads[j] < m_reactorLoads[index]) {
+                    index = j;
+                }
+            }
+            ++m_reactorLoads[index];
+            ReactorAffinity affinity{index, true, false};
+            return &m_reactorAffinity.insert(std::make_pair(socket, affinity)).first->second;
+        }
+        if (!i->second.m_busy) {
+            i->second.m_busy = true;
+            i->second.m_retired = false;
+            return &i->second;
+        }
+        m_reactorUpdated.wait(lock);
+    }
+}
+
+void SocketMultiplexer::onReactorJobInstalled(ISocket* socket)
+{
+    std::lock_guard<std::mutex> lock(m_reactorMutex);
+    auto i = m_reactorAffinity.find(socket);
+    if (i != m_reactorAffinity.end()) {
+        i->second.m_retired = false;
+    }
+}
+
+void SocketMultiplexer::onReactorJobRetired(std::size_t reactor, ISocket* socket)
+{
+    std::lock_guard<std::mutex> lock(m_reactorMutex);
+    auto i = m_reactorAffinity.find(socket);
+    if (i == m_reactorAffinity.end() || i->second.m_reactor != reactor) {
+        // already removed, maybe added again to another reactor since
+        return;
+    }
+    if (i->second.m_busy) {
+        // leave it to the add or remove in progress
+        i->second.m_retired = true;
+        return;
+    }
+    --m_reactorLoads[reactor];
+    m_reactorAffinity.erase(i);
+}
+
 void SocketMultiplexer::service_thread()
 {
     std::vector<IArchNetwork::PollEntry> pfds;
@@ -231,6 +398,9 @@ void SocketMultiplexer::service_thread()
         for (SocketJobMap::iterator i = m_socketJobMap.begin();
                             i != m_socketJobMap.end();) {
             if (*(i->second) == nullptr) {
+                if (m_parent != nullptr) {
+                    m_parent->onReactorJobRetired(m_reactorIndex, i->first);
+                }
                 m_socketJobs.erase(i->second);
                 m_socketJobMap.erase(i++);
                 m_update = true;
@@ -245,6 +415,153 @@ void SocketMultiplexer::service_thread()
     }
 }
 
+void SocketMultiplexer::service_poller_thread()
+{
+    const int kMaxEvents = 64;
+    IArchNetwork::PollerEvent events[kMaxEvents];
+
+    // service the connections
+    for (;;) {
+        Thread::testCancel();
+
+        // wait for some sockets to become ready.  the job list isn't
+        // locked here so jobs may change or go away while we wait.
+        int n;
+        try {
+            n = ARCH->waitPoller(m_poller, events, kMaxEvents, -1);
+        }
+        catch (XArchNetwork& e) {
+            LOG_WARN("error in socket multiplexer: %s", e.what());
+            n = 0;
+        }
+
+        // lock the job list
+        lockJobListLock();
+        lockJobList();
+
+        // run the jobs that couldn't be put in the poller first
+        std::vector<PollerJob*> failed;
+        failed.swap(m_failedPollerJobs);
+        for (PollerJob* entry : failed) {
+            if (entry->m_job == nullptr) {
+                continue;
+            }
+            MultiplexerJobStatus status = entry->m_job->run(false, false, true);
+            if (!status.continue_servicing) {
+                ISocket* owner = entry->m_owner;
+                setPollerJob(m_pollerJobs.find(owner), nullptr);
+                if (m_parent != nullptr) {
+                    m_parent->onReactorJobRetired(m_reactorIndex, owner);
+                }
+            } else if (status.new_job) {
+                setPollerJob(m_pollerJobs.find(entry->m_owner), std::move(status.new_job));
+            }
+        }
+
+        for (int i = 0; i < n; ++i) {
+            // skip jobs removed since the wait.  the entry itself stays
+            // valid until the retired entries are deleted below.
+            PollerJob* entry = static_cast<PollerJob*>(events[i].m_data);
+            if (entry->m_job == nullptr) {
+                continue;
+            }
+
+            // get poll state
+            unsigned short revents = events[i].m_revents;
+            bool read  = ((revents & IArchNetwork::kPOLLIN) != 0);
+            bool write = ((revents & IArchNetwork::kPOLLOUT) != 0);
+            bool error = ((revents & (IArchNetwork::kPOLLERR |
+                                      IArchNetwork::kPOLLNVAL)) != 0);
+
+            // run job
+            MultiplexerJobStatus status = entry->m_job->run(read, write, error);
+
+            if (!status.continue_servicing) {
+                ISocket* owner = entry->m_owner;
+                setPollerJob(m_pollerJobs.find(owner), nullptr);
+                if (m_parent != nullptr) {
+                    m_parent->onReactorJobRetired(m_reactorIndex, owner);
+                }
+            } else if (status.new_job) {
+                setPollerJob(m_pollerJobs.find(entry->m_owner), std::move(status.new_job));
+            }
+        }
+
+        // any entry retired so far has been removed from the poller
+        // before this batch was handled so no later wait can return it
+        m_retiredPollerJobs.clear();
+
+        // unlock the job list
+        unlockJobList();
+    }
+}
+
+void SocketMultiplexer::setPollerJob(PollerJobMap::iterator i,
+                                     std::unique_ptr<ISocketMultiplexerJob>&& job)
+{
+    assert(i != m_pollerJobs.end());
+
+    PollerJob* entry = i->second.get();
+
+    if (job == nullptr) {
+        // remove the socket before its job (and its reference to the
+        // socket) goes away
+        if (entry->m_socket != nullptr) {
+            try {
+                ARCH->removePollerSocket(m_poller, entry->m_socket);
+            }
+            catch (XArchNetwork& e) {
+                LOG_WARN("error removing socket from multiplexer: %s", e.what());
+            }
+        }
+        entry->m_job.reset();
+        entry->m_socket = nullptr;
+        m_failedPollerJobs.erase(std::remove(m_failedPollerJobs.begin(),
+                                             m_failedPollerJobs.end(), entry),
+                                 m_failedPollerJobs.end());
+        m_retiredPollerJobs.push_back(std::move(i->second));
+        m_pollerJobs.erase(i);
+        return;
+    }
+
+    ArchSocket socket = job->getSocket();
+    unsigned short events = 0;
+    if (job->isReadable()) {
+        events |= IArchNetwork::kPOLLIN;
+    }
+    if (job->isWritable()) {
+        events |= IArchNetwork::kPOLLOUT;
+    }
+
+    entry->m_job = std::move(job);
+
+    // only touch the poller if something changed.  m_socket and m_events
+    // always describe what's actually in the poller.
+    if (entry->m_socket == socket && entry->m_events == events) {
+        return;
+    }
+    try {
+        if (entry->m_socket != nullptr && entry->m_socket != socket) {
+            ARCH->removePollerSocket(m_poller, entry->m_socket);
+            entry->m_socket = nullptr;
+            entry->m_events = 0;
+        }
+        ARCH->setPollerSocket(m_poller, socket, events, entry);
+        entry->m_socket = socket;
+        entry->m_events = events;
+    }
+    catch (XArchNetwork& e) {
+        // the poller won't report the socket so tell the job about the
+        // error instead of leaving it waiting forever
+        LOG_WARN("error updating socket in multiplexer: %s", e.what());
+        if (std::find(m_failedPollerJobs.begin(), m_failedPollerJobs.end(),
+                      entry) == m_failedPollerJobs.end()) {
+            m_failedPollerJobs.push_back(entry);
+        }
+        m_thread->unblockPollSocket();
+    }
+}
+
 SocketMultiplexer::JobCursor
 SocketMultiplexer::newCursor()
 {
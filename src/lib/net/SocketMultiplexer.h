@@ -21,10 +21,16 @@
 #include "Fwd.h"
 #include "arch/IArchNetwork.h"
 #include <condition_variable>
+#include <cstddef>
 #include <list>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <vector>
+
+#ifdef INPUTLEAP_TEST_ENV
+#include <gtest/gtest_prod.h>
+#endif
 
 namespace inputleap {
 
@@ -33,10 +39,24 @@ class Thread;
 //! Socket multiplexer
 /*!
 A socket multiplexer services multiple sockets simultaneously.
+
+If the platform provides a poller (see \c IArchNetwork::newPoller())
+then sockets are kept in it persistently, adding, replacing and
+removing jobs update only the affected socket and the service thread
+is handed just the sockets that are ready.  Otherwise every wakeup
+polls the whole job list.
+
+A multiplexer may run several service threads, each with its own job
+list.  A socket is pinned to the thread with the fewest sockets when
+it's first added and stays there until it's removed, so the jobs for a
+socket still run one at a time on a single thread while jobs for
+different sockets may run concurrently.  A socket whose job stops
+servicing itself is unpinned as if it had been removed.
 */
 class SocketMultiplexer {
 public:
-    SocketMultiplexer();
+    //! Create a multiplexer with \p threads service threads
+    explicit SocketMultiplexer(std::size_t threads = 1);
     ~SocketMultiplexer();
 
     //! @name manipulators
@@ -69,6 +89,29 @@ private:
     // false.  only the service thread sets m_polling.
     void service_thread();
 
+    // service sockets using m_poller.  jobs are only run and modified
+    // with the job list locked but, unlike service_thread(), the job
+    // list is not locked while waiting so other threads don't have to
+    // unblock the service thread to change jobs.
+    void service_poller_thread();
+
+    // a job in m_poller.  the entry is passed as the poller data for
+    // its socket so it's kept alive (in m_retiredPollerJobs) until the
+    // service thread can no longer receive events for it.
+    struct PollerJob {
+        ISocket* m_owner;
+        ArchSocket m_socket;
+        unsigned short m_events;
+        std::unique_ptr<ISocketMultiplexerJob> m_job;
+    };
+    typedef std::map<ISocket*, std::unique_ptr<PollerJob>> PollerJobMap;
+
+    // set the job for a poller entry, updating m_poller as necessary.
+    // a nullptr job removes the entry.  must be called with the job
+    // list locked.
+    void setPollerJob(PollerJobMap::iterator,
+                      std::unique_ptr<ISocketMultiplexerJob>&& job);
+
     // create, iterate, and destroy a cursor.  a cursor is used to
     // safely iterate through the job list while other threads modify
     // the list.  it works by inserting a dummy item in the list and
@@ -95,6 +138,26 @@ private:
     // unlock the job list and the lock out on locking.
     void unlockJobList();
 
+    // called by a reactor, with its job list locked, after it installed
+    // a job for a socket or retired one whose job stopped servicing.
+    // job list locks are never taken with m_reactorMutex held so these
+    // may lock it.
+    void onReactorJobInstalled(ISocket*);
+    void onReactorJobRetired(std::size_t reactor, ISocket*);
+
+    // waits for any add or remove in progress for a socket to finish
+    // then marks one in progress and returns the socket's affinity.  if
+    // the socket isn't pinned then it's pinned to the least loaded
+    // reactor when adding, otherwise nullptr is returned.  must be
+    // called with m_reactorMutex locked.
+    struct ReactorAffinity;
+    ReactorAffinity* beginReactorUpdate(std::unique_lock<std::mutex>&, ISocket*, bool add);
+
+#ifdef INPUTLEAP_TEST_ENV
+    FRIEND_TEST(SocketMultiplexerTests, jobStoppingItself_releasesItsReactor);
+    FRIEND_TEST(SocketMultiplexerTests, concurrentAddAndRemove_leaveNoStaleAffinity);
+#endif
+
 private:
     std::mutex mutex_;
     Thread* m_thread;
@@ -113,6 +176,41 @@ private:
 
     SocketJobs m_socketJobs;
     SocketJobMap m_socketJobMap;
+
+    ArchPoller m_poller;
+    PollerJobMap m_pollerJobs;
+    std::vector<std::unique_ptr<PollerJob>> m_retiredPollerJobs;
+
+    // entries that couldn't be updated in m_poller.  the service thread
+    // runs their jobs with an error.
+    std::vector<PollerJob*> m_failedPollerJobs;
+
+    // the reactor a socket is pinned to.  m_busy is set while an add or
+    // remove for the socket is calling the reactor so those run one at a
+    // time per socket.  m_retired is set when the reactor retires the
+    // socket's job meanwhile and cleared when it installs one, so the
+    // add can tell whether the socket is still on the reactor when done.
+    struct ReactorAffinity {
+        std::size_t m_reactor;
+        bool m_busy;
+        bool m_retired;
+    };
+
+    // single threaded multiplexers that do the actual work when more
+    // than one service thread was requested.  empty otherwise.
+    // m_reactorMutex only guards the affinity and loads;  the reactor is
+    // called after releasing it so a reactor busy running jobs doesn't
+    // hold up adding and removing sockets on the others.
+    std::mutex m_reactorMutex;
+    std::condition_variable m_reactorUpdated;
+    std::vector<std::unique_ptr<SocketMultiplexer>> m_reactors;
+    std::vector<std::size_t> m_reactorLoads;
+    std::map<ISocket*, ReactorAffinity> m_reactorAffinity;
+
+    // the multiplexer a reactor works for and its index there.  null
+    // unless this is a reactor.
+    SocketMultiplexer* m_parent = nullptr;
+    std::size_t m_reactorIndex = 0;
 };
 
 } // namespace inputleap
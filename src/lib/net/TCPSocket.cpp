@@ -35,6 +35,9 @@ namespace inputleap {
 
 static const std::size_t MAX_INPUT_BUFFER_SIZE = 1024 * 1024;
 
+// most unsent data the system may queue for a socket
+static const int kUnsentLimit = 32 * 1024;
+
 TCPSocket::TCPSocket(IEventQueue* events, SocketMultiplexer* socketMultiplexer, IArchNetwork::EAddressFamily family) :
     IDataSocket(events),
     m_events(events),
@@ -129,29 +132,40 @@ const EventTarget* TCPSocket::get_event_target() const
 
 std::uint32_t TCPSocket::read(void* buffer, std::uint32_t n)
 {
-    // copy data directly from our input buffer
-    std::lock_guard<std::mutex> lock(tcp_mutex_);
-    std::uint32_t size = m_inputBuffer.getSize();
-    if (n > size) {
-        n = size;
-    }
-    if (buffer != nullptr && n != 0) {
-        memcpy(buffer, m_inputBuffer.peek(n), n);
-    }
-    m_inputBuffer.pop(n);
+    bool useNewJob = false;
+    {
+        // copy data directly from our input buffer
+        std::lock_guard<std::mutex> lock(tcp_mutex_);
+        std::uint32_t size = m_inputBuffer.getSize();
+        if (n > size) {
+            n = size;
+        }
+        if (buffer != nullptr && n != 0) {
+            memcpy(buffer, m_inputBuffer.peek(n), n);
+        }
+        m_inputBuffer.pop(n);
 
-    // if no more data and we cannot read or write then send disconnected
-    if (n > 0 && m_inputBuffer.getSize() == 0 && !m_readable && !m_writable) {
-        sendEvent(EventType::SOCKET_DISCONNECTED);
-        m_connected = false;
+        // resume reading once a full input buffer has been drained
+        useNewJob = m_readable && size > MAX_INPUT_BUFFER_SIZE &&
+                    m_inputBuffer.getSize() <= MAX_INPUT_BUFFER_SIZE;
+
+        // if no more data and we cannot read or write then send disconnected
+        if (n > 0 && m_inputBuffer.getSize() == 0 && !m_readable && !m_writable) {
+            sendEvent(EventType::SOCKET_DISCONNECTED);
+            m_connected = false;
+        }
     }
 
+    if (useNewJob) {
+        setJob(newJob());
+    }
     return n;
 }
 
 void TCPSocket::write(const void* buffer, std::uint32_t n)
 {
-    bool wasEmpty;
+    bool useNewJob = false;
+    bool stopServicing = false;
     {
         std::lock_guard<std::mutex> lock(tcp_mutex_);
 
@@ -167,15 +181,33 @@ void TCPSocket::write(const void* buffer, std::uint32_t n)
         }
 
         // copy data to the output buffer
-        wasEmpty = (m_outputBuffer.getSize() == 0);
+        bool wasEmpty = (m_outputBuffer.getSize() == 0);
         m_outputBuffer.write(buffer, n);
 
         // there's data to write
         is_flushed_ = false;
+
+        if (!wasEmpty) {
+            // the current job is already waiting to write
+            return;
+        }
+
+        if (m_connected) {
+            // nothing is queued ahead of this data so try to send it
+            // right away.  usually the whole message fits in the kernel
+            // buffer and the multiplexer job doesn't have to change.
+            stopServicing = (tryWrite() == kBreak);
+        }
+
+        // wait for the socket to become writable if we couldn't send
+        // everything, or pick up any state change from a write error
+        useNewJob = (m_outputBuffer.getSize() > 0 || !m_connected || !m_writable);
     }
 
-    // make sure we're waiting to write
-    if (wasEmpty) {
+    if (stopServicing) {
+        removeJob();
+    }
+    else if (useNewJob) {
         setJob(newJob());
     }
 }
@@ -262,6 +294,12 @@ std::uint32_t TCPSocket::getSize() const
     return m_inputBuffer.getSize();
 }
 
+std::uint32_t TCPSocket::getOutputSize() const
+{
+    std::lock_guard<std::mutex> lock(tcp_mutex_);
+    return m_outputBuffer.getSize();
+}
+
 void
 TCPSocket::connect(const NetworkAddress& addr)
 {
@@ -304,6 +342,10 @@ TCPSocket::init()
         // that should be sent without (much) delay.  for example, the
         // mouse motion messages are much less useful if they're delayed.
         ARCH->setNoDelayOnSocket(m_socket, true);
+
+        // likewise keep the system from queueing a long backlog of bulk
+        // data that a mouse motion message would have to wait behind.
+        ARCH->setUnsentLimitOnSocket(m_socket, kUnsentLimit);
     }
     catch (XArchNetwork& e) {
         try {
@@ -320,30 +362,33 @@ TCPSocket::init()
 TCPSocket::EJobResult
 TCPSocket::doRead()
 {
-    std::uint8_t buffer[4096];
-    memset(buffer, 0, sizeof(buffer));
-    size_t bytesRead = 0;
+    const std::uint32_t kReadSize = 4096;
+    bool wasEmpty = (m_inputBuffer.getSize() == 0);
 
-    bytesRead = ARCH->readSocket(m_socket, buffer, sizeof(buffer));
+    // read straight into the input buffer
+    size_t bytesRead = ARCH->readSocket(m_socket, m_inputBuffer.reserve(kReadSize), kReadSize);
 
     if (bytesRead > 0) {
-        bool wasEmpty = (m_inputBuffer.getSize() == 0);
-
         // slurp up as much as possible
         do {
-            m_inputBuffer.write(buffer, static_cast<std::uint32_t>(bytesRead));
+            m_inputBuffer.commit(static_cast<std::uint32_t>(bytesRead));
 
             if (m_inputBuffer.getSize() > MAX_INPUT_BUFFER_SIZE) {
                 break;
             }
 
-            bytesRead = ARCH->readSocket(m_socket, buffer, sizeof(buffer));
+            bytesRead = ARCH->readSocket(m_socket, m_inputBuffer.reserve(kReadSize), kReadSize);
         } while (bytesRead > 0);
 
         // send input ready if input buffer was empty
         if (wasEmpty) {
             sendEvent(EventType::STREAM_INPUT_READY);
         }
+
+        // stop reading until the buffer is drained if it's full
+        if (m_inputBuffer.getSize() > MAX_INPUT_BUFFER_SIZE) {
+            return kNew;
+        }
     }
     else {
         // remote write end of stream hungup.  our input side
@@ -368,8 +413,9 @@ TCPSocket::doWrite()
     std::uint32_t bufferSize = 0;
     int bytesWrote = 0;
 
+    // the buffered data is contiguous so it's sent in place
     bufferSize = m_outputBuffer.getSize();
-    const void* buffer = m_outputBuffer.peek(bufferSize);
+    const void* buffer = m_outputBuffer.peek_span();
     bytesWrote = static_cast<std::uint32_t>(ARCH->writeSocket(m_socket, buffer, bufferSize));
 
     if (bytesWrote > 0) {
@@ -380,6 +426,38 @@ TCPSocket::doWrite()
     return kRetry;
 }
 
+TCPSocket::EJobResult TCPSocket::tryWrite()
+{
+    // note -- must have tcp_mutex_ locked on entry
+
+    try {
+        return doWrite();
+    }
+    catch (XArchNetworkShutdown&) {
+        // remote read end of stream hungup.  our output side
+        // has therefore shutdown.
+        onOutputShutdown();
+        sendEvent(EventType::STREAM_OUTPUT_SHUTDOWN);
+        if (!m_readable && m_inputBuffer.getSize() == 0) {
+            sendEvent(EventType::SOCKET_DISCONNECTED);
+            m_connected = false;
+        }
+    }
+    catch (XArchNetworkDisconnected&) {
+        // stream hungup
+        onDisconnected();
+        sendEvent(EventType::SOCKET_DISCONNECTED);
+    }
+    catch (XArchNetwork& e) {
+        // other write error
+        LOG_WARN("error writing socket: %s", e.what());
+        onDisconnected();
+        sendEvent(EventType::STREAM_OUTPUT_ERROR);
+        sendEvent(EventType::SOCKET_DISCONNECTED);
+    }
+    return kNew;
+}
+
 void TCPSocket::removeJob()
 {
     // multiplexer will delete the old job
@@ -422,14 +500,17 @@ std::unique_ptr<ISocketMultiplexerJob> TCPSocket::newJob()
                     m_socket, m_readable, m_writable);
     }
     else {
+        // don't read more while the input buffer is full.  read()
+        // makes a new job once it's been drained.
+        auto readable = m_readable && (m_inputBuffer.getSize() <= MAX_INPUT_BUFFER_SIZE);
         auto writable = m_writable && (m_outputBuffer.getSize() > 0);
-        if (!(m_readable || writable)) {
+        if (!(readable || writable)) {
             return {};
         }
         return std::make_unique<TSocketMultiplexerMethodJob>(
                     [this](auto j, auto r, auto w, auto e)
                     { return serviceConnected(j, r, w, e); },
-                    m_socket, m_readable, writable);
+                    m_socket, readable, writable);
     }
 }
 
@@ -552,34 +633,7 @@ MultiplexerJobStatus TCPSocket::serviceConnected(ISocketMultiplexerJob* job,
     EJobResult writeResult = kRetry;
     EJobResult readResult = kRetry;
     if (write) {
-        try {
-            writeResult = doWrite();
-        }
-        catch (XArchNetworkShutdown&) {
-            // remote read end of stream hungup.  our output side
-            // has therefore shutdown.
-            onOutputShutdown();
-            sendEvent(EventType::STREAM_OUTPUT_SHUTDOWN);
-            if (!m_readable && m_inputBuffer.getSize() == 0) {
-                sendEvent(EventType::SOCKET_DISCONNECTED);
-                m_connected = false;
-            }
-            writeResult = kNew;
-        }
-        catch (XArchNetworkDisconnected&) {
-            // stream hungup
-            onDisconnected();
-            sendEvent(EventType::SOCKET_DISCONNECTED);
-            writeResult = kNew;
-        }
-        catch (XArchNetwork& e) {
-            // other write error
-            LOG_WARN("error writing socket: %s", e.what());
-            onDisconnected();
-            sendEvent(EventType::STREAM_OUTPUT_ERROR);
-            sendEvent(EventType::SOCKET_DISCONNECTED);
-            writeResult = kNew;
-        }
+        writeResult = tryWrite();
     }
 
     if (read && m_readable) {
@@ -56,6 +56,7 @@ public:
     bool isReady() const override;
     bool isFatal() const override;
     std::uint32_t getSize() const override;
+    std::uint32_t getOutputSize() const override;
 
     // IDataSocket overrides
     void connect(const NetworkAddress&) override;
@@ -75,6 +76,10 @@ protected:
     virtual EJobResult doRead();
     virtual EJobResult doWrite();
 
+    // calls doWrite() and handles write errors.  must be called with
+    // tcp_mutex_ locked.
+    EJobResult tryWrite();
+
     void removeJob();
     void setJob(std::unique_ptr<ISocketMultiplexerJob>&& job);
     MultiplexerJobStatus newJobOrStopServicing();
@@ -15,6 +15,9 @@
 #include <X11/XKBlib.h>
 #include <X11/extensions/XInput2.h>
 
+#include <cstdint>
+#include <poll.h>
+
 namespace inputleap {
 
 class IXWindowsImpl {
@@ -25,6 +28,7 @@ public:
     virtual Status XInitThreads() = 0;
     virtual XIOErrorHandler XSetIOErrorHandler(XIOErrorHandler handler) = 0;
     virtual Window do_DefaultRootWindow(Display* display) = 0;
+    virtual unsigned long do_NextRequest(Display* display) = 0;
     virtual int XCloseDisplay(Display* display) = 0;
     virtual int XTestGrabControl(Display* display, Bool impervious) = 0;
     virtual void XDestroyIC(XIC ic) = 0;
@@ -212,6 +216,12 @@ public:
     virtual unsigned char do_XkbKeyGroupInfo(XkbDescPtr m_xkb,
                                              KeyCode keycode) = 0;
     virtual int XNextEvent(Display* display, XEvent* event_return) = 0;
+
+    /// Waits for the X connection or other descriptors, see ppoll(2)
+    virtual int do_ppoll(struct pollfd* fds, nfds_t nfds, const struct timespec* timeout) = 0;
+
+    /// Returns the number of calls so far that waited for a reply from the X server
+    virtual std::uint64_t get_round_trip_count() const = 0;
 };
 
 } // namespace inputleap
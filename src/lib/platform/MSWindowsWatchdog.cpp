@@ -438,6 +438,7 @@ void MSWindowsWatchdog::output_loop()
             m_ipcLogOutputter.write(kINFO, buffer);
             if (m_fileLogOutputter != nullptr) {
                 m_fileLogOutputter->write(kINFO, buffer);
+                m_fileLogOutputter->flush();
             }
         }
     }
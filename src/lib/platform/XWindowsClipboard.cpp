@@ -127,6 +127,7 @@ XWindowsClipboard::lost(Time time)
     if (m_owner) {
         m_owner    = false;
         m_timeLost = time;
+        failPendingReplies();
         clearCache();
     }
 }
@@ -195,6 +196,19 @@ XWindowsClipboard::addSimpleRequest(Window requestor,
         IXWindowsClipboardConverter* converter = getConverter(target);
         if (converter != nullptr) {
             IClipboard::EFormat clipboardFormat = converter->getFormat();
+            if (m_added[clipboardFormat] && m_promised[clipboardFormat]) {
+                // reply when the data arrives
+                LOG_DEBUG1("waiting for promised format %d", clipboardFormat);
+                if (!m_requested[clipboardFormat]) {
+                    m_requested[clipboardFormat] = true;
+                    m_requestedFormats.push_back(clipboardFormat);
+                }
+                Reply* reply = new Reply(requestor, target, time, property, std::string(),
+                                         converter->getAtom(), converter->getDataSize());
+                reply->m_pending = true;
+                insertReply(reply);
+                return true;
+            }
             if (m_added[clipboardFormat]) {
                 try {
                     data   = converter->fromIClipboard(m_data[clipboardFormat]);
@@ -281,6 +295,81 @@ XWindowsClipboard::getSelection() const
     return m_selection;
 }
 
+bool XWindowsClipboard::fulfill(EFormat format, const std::string& data)
+{
+    if (!m_owner || !m_promised[format]) {
+        return false;
+    }
+
+    LOG_DEBUG("fulfill %zd bytes of clipboard %d format: %d", data.size(), m_id, format);
+
+    m_data[format]      = data;
+    m_promised[format]  = false;
+    m_requested[format] = false;
+
+    // convert the data for each request that was waiting for it
+    for (auto& entry : m_replies) {
+        for (Reply* reply : entry.second) {
+            if (!reply->m_pending) {
+                continue;
+            }
+            IXWindowsClipboardConverter* converter = getConverter(reply->m_target);
+            if (converter == nullptr || converter->getFormat() != format) {
+                continue;
+            }
+            reply->m_pending = false;
+            try {
+                reply->m_data = converter->fromIClipboard(data);
+            }
+            catch (...) {
+                // cannot convert -- send failure
+                reply->m_property = None;
+            }
+        }
+    }
+
+    pushReplies();
+    return true;
+}
+
+void XWindowsClipboard::withdraw(EFormat format)
+{
+    if (!m_owner || !m_promised[format]) {
+        return;
+    }
+
+    LOG_DEBUG("withdraw clipboard %d format: %d", m_id, format);
+
+    m_data[format]      = "";
+    m_added[format]     = false;
+    m_promised[format]  = false;
+    m_requested[format] = false;
+
+    // fail each request that was waiting for the data
+    for (auto& entry : m_replies) {
+        for (Reply* reply : entry.second) {
+            if (!reply->m_pending) {
+                continue;
+            }
+            IXWindowsClipboardConverter* converter = getConverter(reply->m_target);
+            if (converter == nullptr || converter->getFormat() != format) {
+                continue;
+            }
+            reply->m_pending  = false;
+            reply->m_property = None;
+        }
+    }
+
+    pushReplies();
+}
+
+std::vector<IClipboard::EFormat> XWindowsClipboard::takeRequestedFormats()
+{
+    std::vector<EFormat> formats;
+    formats.swap(m_requestedFormats);
+    return formats;
+}
+
 bool
 XWindowsClipboard::clear()
 {
@@ -296,7 +385,8 @@ XWindowsClipboard::clear()
     }
 
     // clear all data.  since we own the data now, the cache is up
-    // to date.
+    // to date.  requests for promised data can't be answered anymore.
+    failPendingReplies();
     clearCache();
     m_cached = true;
 
@@ -321,12 +411,27 @@ void XWindowsClipboard::add(EFormat format, const std::string& data)
 
     LOG_DEBUG("add %zd bytes to clipboard %d format: %d", data.size(), m_id, format);
 
-    m_data[format]  = data;
-    m_added[format] = true;
+    m_data[format]     = data;
+    m_added[format]    = true;
+    m_promised[format] = false;
 
     // FIXME -- set motif clipboard item?
 }
 
+bool XWindowsClipboard::promise(EFormat format)
+{
+    assert(m_open);
+    assert(m_owner);
+
+    LOG_DEBUG("promise clipboard %d format: %d", m_id, format);
+
+    m_data[format]      = "";
+    m_added[format]     = true;
+    m_promised[format]  = true;
+    m_requested[format] = false;
+    return true;
+}
+
 bool
 XWindowsClipboard::open(Time time) const
 {
@@ -405,6 +510,14 @@ std::string XWindowsClipboard::get(EFormat format) const
     return m_data[format];
 }
 
+bool XWindowsClipboard::is_promised(EFormat format) const
+{
+    assert(m_open);
+
+    fillCache();
+    return m_promised[format];
+}
+
 void
 XWindowsClipboard::clearConverters()
 {
@@ -480,9 +593,12 @@ XWindowsClipboard::doClearCache()
     m_checkCache = false;
     m_cached     = false;
     for (std::int32_t index = 0; index < kNumFormats; ++index) {
-        m_data[index]  = "";
-        m_added[index] = false;
+        m_data[index]      = "";
+        m_added[index]     = false;
+        m_promised[index]  = false;
+        m_requested[index] = false;
     }
+    m_requestedFormats.clear();
 }
 
 void
@@ -1041,6 +1157,11 @@ XWindowsClipboard::sendReply(Reply* reply)
         return true;
     }
 
+    // wait until promised data has arrived
+    if (reply->m_pending) {
+        return false;
+    }
+
     // start in failed state if property is None
     bool failed = (reply->m_property == None);
     if (!failed) {
@@ -1205,6 +1326,24 @@ XWindowsClipboard::clearReplies(ReplyList& replies)
     replies.clear();
 }
 
+void
+XWindowsClipboard::failPendingReplies()
+{
+    bool failed = false;
+    for (auto& entry : m_replies) {
+        for (Reply* reply : entry.second) {
+            if (reply->m_pending) {
+                reply->m_pending  = false;
+                reply->m_property = None;
+                failed = true;
+            }
+        }
+    }
+    if (failed) {
+        pushReplies();
+    }
+}
+
 void
 XWindowsClipboard::sendNotify(Window requestor,
                 Atom selection, Atom target, Atom property, Time time)
@@ -1537,6 +1676,7 @@ XWindowsClipboard::Reply::Reply(Window requestor, Atom target, ::Time time) :
     m_property(None),
     m_replied(false),
     m_done(false),
+    m_pending(false),
     m_data(),
     m_type(None),
     m_format(32),
@@ -1553,6 +1693,7 @@ XWindowsClipboard::Reply::Reply(Window requestor, Atom target, ::Time time,
     m_property(property),
     m_replied(false),
     m_done(false),
+    m_pending(false),
     m_data(data),
     m_type(type),
     m_format(format),
@@ -87,14 +87,40 @@ public:
     */
     Atom getSelection() const;
 
+    //! Supply promised data
+    /*!
+    Supplies the data for a format that was promised while we own the
+    selection and answers the requests waiting for it.  Returns false
+    if the format isn't promised.
+    */
+    bool fulfill(EFormat, const std::string& data);
+
+    //! Withdraw a promise
+    /*!
+    Removes a format that was promised while we own the selection and
+    fails the requests waiting for its data.  Does nothing if the
+    format isn't promised.
+    */
+    void withdraw(EFormat);
+
+    //! Get requested promises
+    /*!
+    Returns the promised formats that selection requests started
+    waiting for since the last call.  Each promise is only returned
+    once.
+    */
+    std::vector<EFormat> takeRequestedFormats();
+
     // IClipboard overrides
     bool clear() override;
     void add(EFormat, const std::string& data) override;
+    bool promise(EFormat) override;
     bool open(Time) const override;
     void close() const override;
     Time getTime() const override;
     bool has(EFormat) const override;
     std::string get(EFormat) const override;
+    bool is_promised(EFormat) const override;
 
 private:
     // remove all converters from our list
@@ -239,6 +265,9 @@ private:
         // true iff the reply has sent its last message
         bool m_done;
 
+        // true iff the reply waits for promised data
+        bool m_pending;
+
         // the data to send and its type and format
         std::string m_data;
         Atom m_type;
@@ -273,6 +302,7 @@ private:
     bool sendReply(Reply*);
     void clearReplies();
     void clearReplies(ReplyList&);
+    void failPendingReplies();
     void sendNotify(Window requestor, Atom selection,
                             Atom target, Atom property, Time time);
     bool wasOwnedAtTime(::Time) const;
@@ -305,6 +335,11 @@ private:
     bool m_added[kNumFormats];
     std::string m_data[kNumFormats];
 
+    // formats added without data and whether a request asked for them
+    bool m_promised[kNumFormats];
+    bool m_requested[kNumFormats];
+    std::vector<EFormat> m_requestedFormats;
+
     // conversion request replies
     ReplyMap m_replies;
     ReplyEventMask m_eventMasks;
@@ -21,25 +21,27 @@
 #include "mt/Thread.h"
 #include "base/Event.h"
 #include "base/IEventQueue.h"
+#include "base/Log.h"
 
+#include <cerrno>
 #include <fcntl.h>
 #include <unistd.h>
 #include <poll.h>
+#include <time.h>
 
 namespace inputleap {
 
 XWindowsEventQueueBuffer::XWindowsEventQueueBuffer(IXWindowsImpl* impl,
-        Display* display, Window window, IEventQueue* events) :
+        Display* display, IEventQueue* events) :
     m_display(display),
-    m_window(window),
     m_waiting(false),
-    m_events(events)
+    m_events(events),
+    m_wakeupCount(0),
+    m_wakeupsSinceReport(0)
 {
     m_impl = impl;
     assert(m_display != nullptr);
-    assert(m_window  != None);
 
-    m_userEvent = m_impl->XInternAtom(m_display, "INPUTLEAP_USER_EVENT", False);
     // set up for pipe hack
     int result = pipe2(m_pipefd, O_NONBLOCK);
     assert(result == 0);
@@ -71,62 +73,62 @@ XWindowsEventQueueBuffer::waitForEvent(double dtimeout)
     Thread::testCancel();
 
     // clear out the pipe in preparation for waiting.
-
-    char buf[16];
-    ssize_t read_response = read(m_pipefd[0], buf, 15);
-    if (read_response < 0)
-    {
-        // todo: handle read response
-    }
+    drainPipe();
 
     {
         std::lock_guard<std::mutex> lock(mutex_);
-        // we're now waiting for events
+        // don't wait if a user event was added since the caller checked
+        if (!m_userEvents.empty()) {
+            Thread::testCancel();
+            return;
+        }
+
+        // we're now waiting for events.  user events added from now on
+        // wake us through the pipe.
         m_waiting = true;
 
-        // push out pending events
-        flush();
-    }
-    // calling flush may have queued up a new event.
-    if (!XWindowsEventQueueBuffer::isEmpty()) {
-        Thread::testCancel();
-        return;
+        // push out pending requests
+        m_impl->XFlush(m_display);
     }
 
-    // use poll() to wait for a message from the X server or for timeout.
-    // this is a good deal more efficient than polling and sleeping.
-    struct pollfd pfds[2];
-    pfds[0].fd     = ConnectionNumber(m_display);
-    pfds[0].events = POLLIN;
-    pfds[1].fd     = m_pipefd[0];
-    pfds[1].events = POLLIN;
-    int timeout    = (dtimeout < 0.0) ? -1 :
-                        static_cast<int>(1000.0 * dtimeout);
-    int remaining  =  timeout;
-    int retval     =  0;
-    // It's possible that the X server has queued events locally
-    // in xlib's event buffer and not pushed on to the fd. Hence we
-    // can't simply monitor the fd as we may never be woken up.
-    // ie addEvent calls flush, XFlush may not send via the fd hence
-    // there is an event waiting to be sent but we must exit the poll
-    // before it can.
-    // Instead we poll for a brief period of time (so if events
-    // queued locally in the xlib buffer can be processed)
-    // and continue doing this until timeout is reached.
-    // The human eye can notice 60hz (ansi) which is 16ms, however
-    // we want to give the cpu a chance s owe up this to 25ms
-#define TIMEOUT_DELAY 25
-
-    while (((dtimeout < 0.0) || (remaining > 0)) && getPendingCountLocked() == 0 && retval == 0) {
-        retval = poll(pfds, 2, TIMEOUT_DELAY); //16ms = 60hz, but we make it > to play nicely with the cpu
-        if (pfds[1].revents & POLLIN) {
-            read_response = read(m_pipefd[0], buf, 15);
-            if (read_response < 0)
-            {
-                // todo: handle read response
+    // Xlib may already have read events from the connection into its own
+    // queue.  those don't make the connection readable so look for them
+    // before blocking.  nothing else reads from the display while we're
+    // blocked because user events don't go through the X server.
+    if (getPendingCountLocked() == 0) {
+        struct pollfd pfds[2];
+        pfds[0].fd     = ConnectionNumber(m_display);
+        pfds[0].events = POLLIN;
+        pfds[1].fd     = m_pipefd[0];
+        pfds[1].events = POLLIN;
+
+        // block until the X server sends something, a user event is added
+        // or the timeout expires.  ppoll() takes the timeout with nanosecond
+        // resolution so timers don't fire up to a millisecond early or late.
+        Stopwatch timer;
+        for (;;) {
+            struct timespec timeout;
+            struct timespec* ptimeout = nullptr;
+            if (dtimeout >= 0.0) {
+                double remaining = dtimeout - timer.getTime();
+                if (remaining < 0.0) {
+                    remaining = 0.0;
+                }
+                timeout.tv_sec  = static_cast<time_t>(remaining);
+                timeout.tv_nsec = static_cast<long>(1.0e+9 * (remaining - timeout.tv_sec));
+                ptimeout = &timeout;
+            }
+
+            if (m_impl->do_ppoll(pfds, 2, ptimeout) >= 0 || errno != EINTR) {
+                break;
             }
+            Thread::testCancel();
         }
-        remaining-=TIMEOUT_DELAY;
+
+        if (pfds[1].revents & POLLIN) {
+            drainPipe();
+        }
+        countWakeup();
     }
 
     {
@@ -142,49 +144,29 @@ IEventQueueBuffer::Type XWindowsEventQueueBuffer::getEvent(Event& event, std::ui
 {
     std::lock_guard<std::mutex> lock(mutex_);
 
-    // push out pending events
-    flush();
+    // user events don't need the X connection
+    if (!m_userEvents.empty()) {
+        dataID = m_userEvents.front();
+        m_userEvents.pop_front();
+        return kUser;
+    }
 
     // get next event
     m_impl->XNextEvent(m_display, &m_event);
 
-    // process event
-    if (m_event.xany.type == ClientMessage &&
-        m_event.xclient.message_type == m_userEvent) {
-        dataID = static_cast<std::uint32_t>(m_event.xclient.data.l[0]);
-        return kUser;
-    }
-    else {
-        event = Event(EventType::SYSTEM, m_events->getSystemTarget(),
-                      create_event_data<XEvent*>(&m_event));
-        return kSystem;
-    }
+    event = Event(EventType::SYSTEM, m_events->getSystemTarget(),
+                  create_event_data<XEvent*>(&m_event));
+    return kSystem;
 }
 
 bool XWindowsEventQueueBuffer::addEvent(std::uint32_t dataID)
 {
-    // prepare a message
-    XEvent xevent;
-    xevent.xclient.type         = ClientMessage;
-    xevent.xclient.window       = m_window;
-    xevent.xclient.message_type = m_userEvent;
-    xevent.xclient.format       = 32;
-    xevent.xclient.data.l[0]    = static_cast<long>(dataID);
-
-    // save the message
     std::lock_guard<std::mutex> lock(mutex_);
-    m_postedEvents.push_back(xevent);
+    m_userEvents.push_back(dataID);
 
-    // if we're currently waiting for an event then send saved events to
-    // the X server now.  if we're not waiting then some other thread
-    // might be using the display connection so we can't safely use it
-    // too.
+    // if a thread is waiting for an event then wake it.  it's blocked
+    // on the X connection so this is the only way to reach it.
     if (m_waiting) {
-        flush();
-        // Send a character through the round-trip pipe to wake a thread
-        // that is waiting for a ConnectionNumber() socket to be readable.
-        // The flush call can read incoming data from the socket and put
-        // it in Xlib's input buffer.  That sneaks it past the other thread.
         ssize_t write_response = write(m_pipefd[1], "!", 1);
         if (write_response < 0)
         {
@@ -195,24 +177,41 @@ bool XWindowsEventQueueBuffer::addEvent(std::uint32_t dataID)
     return true;
 }
 
+std::uint64_t XWindowsEventQueueBuffer::get_wakeup_count() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return m_wakeupCount;
+}
+
 bool
 XWindowsEventQueueBuffer::isEmpty() const
 {
     std::lock_guard<std::mutex> lock(mutex_);
-    return (m_impl->XPending(m_display) == 0 );
+    return m_userEvents.empty() && m_impl->XPending(m_display) == 0;
 }
 
-void
-XWindowsEventQueueBuffer::flush()
+void XWindowsEventQueueBuffer::drainPipe()
 {
-    // note -- mutex_ must be locked on entry
+    char buf[16];
+    while (read(m_pipefd[0], buf, sizeof(buf)) > 0) {
+        // discard
+    }
+}
 
-    // flush the posted event list to the X server
-    for (size_t i = 0; i < m_postedEvents.size(); ++i) {
-        m_impl->XSendEvent(m_display, m_window, False, 0, &m_postedEvents[i]);
+void XWindowsEventQueueBuffer::countWakeup()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++m_wakeupCount;
+    ++m_wakeupsSinceReport;
+
+    // report the wakeup rate so idle behaviour can be checked
+    const double elapsed = m_wakeupReportTimer.getTime();
+    if (elapsed >= 10.0) {
+        LOG_DEBUG1("event queue woke %.1f times per second",
+                   m_wakeupsSinceReport / elapsed);
+        m_wakeupsSinceReport = 0;
+        m_wakeupReportTimer.reset();
     }
-    m_impl->XFlush(m_display);
-    m_postedEvents.clear();
 }
 
 } // namespace inputleap
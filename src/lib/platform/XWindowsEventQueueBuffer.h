@@ -22,19 +22,19 @@
 
 #include "base/Fwd.h"
 #include "base/IEventQueueBuffer.h"
+#include "base/Stopwatch.h"
 #include "XWindowsImpl.h"
 
 #include <X11/Xlib.h>
+#include <deque>
 #include <mutex>
-#include <vector>
 
 namespace inputleap {
 
 //! Event queue buffer for X11
 class XWindowsEventQueueBuffer : public IEventQueueBuffer {
 public:
-    XWindowsEventQueueBuffer(IXWindowsImpl* impl, Display*, Window,
-                             IEventQueue* events);
+    XWindowsEventQueueBuffer(IXWindowsImpl* impl, Display*, IEventQueue* events);
     ~XWindowsEventQueueBuffer() override;
 
     // IEventQueueBuffer overrides
@@ -44,24 +44,35 @@ public:
     bool addEvent(std::uint32_t dataID) override;
     bool isEmpty() const override;
 
-private:
-    void flush();
+    //! Get number of wakeups
+    /*!
+    Returns how many times waitForEvent() has returned from blocking on
+    the X connection.
+    */
+    std::uint64_t get_wakeup_count() const;
 
+private:
     int getPendingCountLocked();
+    void drainPipe();
+    void countWakeup();
 
 private:
-    typedef std::vector<XEvent> EventList;
     IXWindowsImpl* m_impl;
 
     mutable std::mutex  mutex_;
     Display* m_display;
-    Window m_window;
-    Atom m_userEvent;
     XEvent m_event;
-    EventList m_postedEvents;
+
+    // user events are kept locally and never go through the X server.
+    // the pipe only wakes up a thread blocked in waitForEvent().
+    std::deque<std::uint32_t> m_userEvents;
     bool m_waiting;
     int m_pipefd[2];
     IEventQueue* m_events;
+
+    std::uint64_t m_wakeupCount;
+    std::uint32_t m_wakeupsSinceReport;
+    Stopwatch m_wakeupReportTimer;
 };
 
 } // namespace inputleap
@@ -18,6 +18,11 @@ Window XWindowsImpl::do_DefaultRootWindow(Display* display)
     return DefaultRootWindow(display);
 }
 
+unsigned long XWindowsImpl::do_NextRequest(Display* display)
+{
+    return NextRequest(display);
+}
+
 int XWindowsImpl::XCloseDisplay(Display* display)
 {
     return ::XCloseDisplay(display);
@@ -46,6 +51,7 @@ int XWindowsImpl::XDestroyWindow(Display* display, Window w)
 int XWindowsImpl::XGetKeyboardControl(Display* display,
                                       XKeyboardState* value_return)
 {
+    ++round_trips_;
     return ::XGetKeyboardControl(display, value_return);
 }
 
@@ -78,17 +84,20 @@ int XWindowsImpl::XSetInputFocus(Display* display, Window focus,
 Bool XWindowsImpl::DPMSQueryExtension(Display* display, int* event_base,
                                       int* error_base)
 {
+    ++round_trips_;
     return ::DPMSQueryExtension(display, event_base, error_base);
 }
 
 Bool XWindowsImpl::DPMSCapable(Display* display)
 {
+    ++round_trips_;
     return ::DPMSCapable(display);
 }
 
 Status XWindowsImpl::DPMSInfo(Display* display, CARD16* power_level,
                               BOOL* state)
 {
+    ++round_trips_;
     return ::DPMSInfo(display, power_level, state);
 }
 
@@ -100,6 +109,7 @@ Status XWindowsImpl::DPMSForceLevel(Display* display, CARD16 level)
 int XWindowsImpl::XGetInputFocus(Display* display, Window* focus_return,
                                  int* revert_to_return)
 {
+    ++round_trips_;
     return ::XGetInputFocus(display, focus_return, revert_to_return);
 }
 
@@ -115,6 +125,7 @@ Bool XWindowsImpl::XQueryPointer(Display* display, Window w,
                                  int* win_x_return,  int* win_y_return,
                                  unsigned int* mask_return)
 {
+    ++round_trips_;
     return ::XQueryPointer(display, w, root_return, child_return, root_x_return,
                            root_y_return, win_x_return, win_y_return,
                            mask_return);
@@ -133,6 +144,7 @@ Bool XWindowsImpl::XCheckMaskEvent(Display* display, long event_mask,
 
 XModifierKeymap* XWindowsImpl::XGetModifierMapping(Display* display)
 {
+    ++round_trips_;
     return ::XGetModifierMapping(display);
 }
 
@@ -203,6 +215,7 @@ Bool XWindowsImpl::XQueryExtension(Display* display, const char* name,
                                    int* first_event_return,
                                    int* first_error_return)
 {
+    ++round_trips_;
     return ::XQueryExtension(display, name, major_opcode_return,
                              first_event_return, first_error_return);
 }
@@ -216,6 +229,7 @@ Bool XWindowsImpl::XkbQueryExtension(Display* display, int* opcodeReturn,
                                      int* eventBaseReturn, int* errorBaseReturn,
                                      int* majorRtrn, int* minorRtrn)
 {
+    ++round_trips_;
     return ::XkbQueryExtension(display, opcodeReturn, eventBaseReturn,
                                errorBaseReturn, majorRtrn, minorRtrn);
 }
@@ -240,6 +254,7 @@ Bool XWindowsImpl::XkbSelectEventDetails(Display* display,
 Bool XWindowsImpl::XRRQueryExtension(Display* display, int* event_base_return,
                                      int* error_base_return)
 {
+    ++round_trips_;
     (void) display;
     (void) event_base_return;
     (void) error_base_return;
@@ -255,16 +270,19 @@ void XWindowsImpl::XRRSelectInput(Display *display, Window window, int mask)
 Bool XWindowsImpl::XineramaQueryExtension(Display* display, int* event_base,
                                           int* error_base)
 {
+    ++round_trips_;
     return ::XineramaQueryExtension(display, event_base, error_base);
 }
 
 Bool XWindowsImpl::XineramaIsActive(Display* display)
 {
+    ++round_trips_;
     return ::XineramaIsActive(display);
 }
 
 void* XWindowsImpl::XineramaQueryScreens(Display* display, int* number)
 {
+    ++round_trips_;
     return ::XineramaQueryScreens(display, number);
 }
 
@@ -305,6 +323,7 @@ char* XWindowsImpl::XGetICValues(XIC ic, const char* type, unsigned long* mask)
 Status XWindowsImpl::XGetWindowAttributes(Display* display, Window w,
                                           XWindowAttributes* attrs)
 {
+    ++round_trips_;
     return ::XGetWindowAttributes(display, w, attrs);
 }
 
@@ -360,6 +379,7 @@ Status XWindowsImpl::XQueryBestCursor(Display* display, Drawable d,
                                       unsigned int* width_return,
                                       unsigned int* height_return)
 {
+    ++round_trips_;
     return ::XQueryBestCursor(display, d, width, height, width_return,
                               height_return);
 }
@@ -390,6 +410,7 @@ Status XWindowsImpl::XQueryTree(Display* display, Window w, Window* root_return,
                                 Window* parent_return, Window** children_return,
                                 unsigned int* nchildren_return)
 {
+    ++round_trips_;
     return ::XQueryTree(display, w, root_return, parent_return, children_return,
                         nchildren_return);
 }
@@ -418,12 +439,14 @@ Status XWindowsImpl::XSendEvent(Display* display, Window w, Bool propagate,
 
 int XWindowsImpl::XSync(Display* display, Bool discard)
 {
+    ++round_trips_;
     return ::XSync(display, discard);
 }
 
 int XWindowsImpl::XGetPointerMapping(Display* display,
                                      unsigned char* map_return, int nmap)
 {
+    ++round_trips_;
     return ::XGetPointerMapping(display, map_return, nmap);
 }
 
@@ -431,6 +454,7 @@ int XWindowsImpl::XGrabKeyboard(Display* display, Window grab_window,
                                 Bool owner_events, int pointer_mode,
                                 int keyboard_mode, Time time)
 {
+    ++round_trips_;
     return ::XGrabKeyboard(display, grab_window, owner_events, pointer_mode,
                            keyboard_mode, time);
 }
@@ -440,6 +464,7 @@ int XWindowsImpl::XGrabPointer(Display* display, Window grab_window,
                                int  pointer_mode, int keyboard_mode,
                                Window confine_to, Cursor cursor, Time time)
 {
+    ++round_trips_;
     return ::XGrabPointer(display, grab_window, owner_events, event_mask,
                           pointer_mode, keyboard_mode, confine_to, cursor,
                           time);
@@ -479,6 +504,7 @@ int XWindowsImpl::XISelectEvents(Display* display, Window w, XIEventMask* masks,
 Atom XWindowsImpl::XInternAtom(Display* display, _Xconst char* atom_name,
                                Bool only_if_exists)
 {
+    ++round_trips_;
     return ::XInternAtom(display, atom_name, only_if_exists);
 }
 
@@ -487,6 +513,7 @@ int XWindowsImpl::XGetScreenSaver(Display* display, int* timeout_return,
                                   int* prefer_blanking_return,
                                   int* allow_exposures_return)
 {
+    ++round_trips_;
     return ::XGetScreenSaver(display, timeout_return, interval_return,
                              prefer_blanking_return, allow_exposures_return);
 }
@@ -526,17 +553,20 @@ int XWindowsImpl::XSetSelectionOwner(Display* display, Atom selection, Window w,
 
 Window XWindowsImpl::XGetSelectionOwner(Display* display, Atom selection)
 {
+    ++round_trips_;
      return ::XGetSelectionOwner(display, selection);
 }
 
 Atom* XWindowsImpl::XListProperties(Display* display, Window w,
                                     int* num_prop_return)
 {
+    ++round_trips_;
     return ::XListProperties(display, w, num_prop_return);
 }
 
 char* XWindowsImpl::XGetAtomName(Display* display, Atom atom)
 {
+    ++round_trips_;
     return ::XGetAtomName(display, atom);
 }
 
@@ -549,23 +579,27 @@ void XWindowsImpl::XkbFreeKeyboard(XkbDescPtr xkb, unsigned int which,
 XkbDescPtr XWindowsImpl::XkbGetMap(Display* display, unsigned int which,
                                    unsigned int deviceSpec)
 {
+    ++round_trips_;
     return ::XkbGetMap(display, which, deviceSpec);
 }
 
 Status XWindowsImpl::XkbGetState(Display* display, unsigned int deviceSet,
                                  XkbStatePtr rtrnState)
 {
+    ++round_trips_;
     return ::XkbGetState(display, deviceSet, rtrnState);
 }
 
 int XWindowsImpl::XQueryKeymap(Display* display, char keys_return[32])
 {
+    ++round_trips_;
     return ::XQueryKeymap(display, keys_return);
 }
 
 Status XWindowsImpl::XkbGetUpdatedMap(Display* display, unsigned int which,
                                       XkbDescPtr desc)
 {
+    ++round_trips_;
     return ::XkbGetUpdatedMap(display, which, desc);
 }
 
@@ -587,6 +621,7 @@ KeySym* XWindowsImpl::XGetKeyboardMapping(Display* display,
                                           int keycode_count,
                                           int* keysyms_per_keycode_return)
 {
+    ++round_trips_;
     return ::XGetKeyboardMapping(display, first_keycode, keycode_count,
                                  keysyms_per_keycode_return);
 }
@@ -631,4 +666,14 @@ int XWindowsImpl::XNextEvent(Display* display, XEvent* event_return)
     return ::XNextEvent(display, event_return);
 }
 
+int XWindowsImpl::do_ppoll(struct pollfd* fds, nfds_t nfds, const struct timespec* timeout)
+{
+    return ::ppoll(fds, nfds, timeout, nullptr);
+}
+
+std::uint64_t XWindowsImpl::get_round_trip_count() const
+{
+    return round_trips_.load(std::memory_order_relaxed);
+}
+
 } // namespace inputleap
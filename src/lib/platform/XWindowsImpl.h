@@ -5,6 +5,8 @@
 
 #include "IXWindowsImpl.h"
 
+#include <atomic>
+
 namespace inputleap {
 
 class XWindowsImpl : public IXWindowsImpl {
@@ -13,6 +15,7 @@ public:
     Status XInitThreads() override;
     XIOErrorHandler XSetIOErrorHandler(XIOErrorHandler handler) override;
     Window do_DefaultRootWindow(Display* display) override;
+    unsigned long do_NextRequest(Display* display) override;
     int XCloseDisplay(Display* display) override;
     int XTestGrabControl(Display* display, Bool impervious) override;
     void XDestroyIC(XIC ic) override;
@@ -146,6 +149,12 @@ public:
                                     int eGroup) override;
     unsigned char do_XkbKeyGroupInfo(XkbDescPtr m_xkb, KeyCode keycode) override;
     int XNextEvent(Display* display, XEvent* event_return) override;
+    int do_ppoll(struct pollfd* fds, nfds_t nfds, const struct timespec* timeout) override;
+
+    std::uint64_t get_round_trip_count() const override;
+
+private:
+    std::atomic<std::uint64_t> round_trips_{0};
 };
 
 } // namespace inputleap
@@ -72,7 +72,7 @@ XWindowsKeyState::init(Display* display, bool useXKB)
     (void) display;
     (void) useXKB;
 
-    XGetKeyboardControl(m_display, &m_keyboardState);
+    m_impl->XGetKeyboardControl(m_display, &m_keyboardState);
     if (useXKB) {
         m_xkb = m_impl->XkbGetMap(m_display,
                                   XkbKeyActionsMask | XkbKeyBehaviorsMask |
@@ -216,7 +216,7 @@ XWindowsKeyState::getKeyMap(inputleap::KeyMap& keyMap)
     // get autorepeat info.  we must use the global_auto_repeat told to
     // us because it may have modified by InputLeap.
     int oldGlobalAutoRepeat = m_keyboardState.global_auto_repeat;
-    XGetKeyboardControl(m_display, &m_keyboardState);
+    m_impl->XGetKeyboardControl(m_display, &m_keyboardState);
     m_keyboardState.global_auto_repeat = oldGlobalAutoRepeat;
 
     if (m_xkb != nullptr) {
@@ -285,7 +285,11 @@ XWindowsKeyState::fakeKey(const Keystroke& keystroke)
         default:
             break;
     }
-    XFlush(m_display);
+}
+
+void XWindowsKeyState::flushFakeEvents()
+{
+    m_impl->XFlush(m_display);
 }
 
 void
@@ -109,6 +109,7 @@ protected:
     // KeyState overrides
     void getKeyMap(inputleap::KeyMap& keyMap) override;
     void fakeKey(const Keystroke& keystroke) override;
+    void flushFakeEvents() override;
 
 private:
     void init(Display* display, bool useXKB);
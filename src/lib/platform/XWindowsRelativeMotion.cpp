@@ -0,0 +1,86 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "platform/XWindowsRelativeMotion.h"
+#include "base/Log.h"
+
+namespace inputleap {
+
+XWindowsRelativeMotion::XWindowsRelativeMotion(IXWindowsImpl* impl, Display* display,
+                                               Window root) :
+    m_impl(impl),
+    m_display(display),
+    m_root(root),
+    m_xCenter(0), m_yCenter(0),
+    m_xLimit(0), m_yLimit(0),
+    m_x(0), m_y(0),
+    m_warping(false),
+    m_warpSerial(0),
+    m_warpCount(0),
+    m_motionCount(0)
+{
+}
+
+void XWindowsRelativeMotion::setArea(std::int32_t x, std::int32_t y,
+                                     std::int32_t w, std::int32_t h)
+{
+    m_xCenter = x + (w >> 1);
+    m_yCenter = y + (h >> 1);
+    m_xLimit  = w >> 2;
+    m_yLimit  = h >> 2;
+}
+
+void XWindowsRelativeMotion::reset(std::int32_t x, std::int32_t y)
+{
+    m_x       = x;
+    m_y       = y;
+    m_warping = false;
+}
+
+void XWindowsRelativeMotion::onMotion(const XMotionEvent& event,
+                                      std::int32_t& dx, std::int32_t& dy)
+{
+    ++m_motionCount;
+
+    // events the X server sent after moving the pointer are relative to
+    // where it moved the pointer to.  serial numbers wrap around.
+    if (m_warping && static_cast<long>(event.serial - m_warpSerial) >= 0) {
+        m_warping = false;
+        m_x       = m_xCenter;
+        m_y       = m_yCenter;
+    }
+
+    dx  = event.x_root - m_x;
+    dy  = event.y_root - m_y;
+    m_x = event.x_root;
+    m_y = event.y_root;
+
+    // move the pointer back to the center before it reaches an edge,
+    // where motion would be lost
+    if (!m_warping &&
+            (event.x_root - m_xCenter < -m_xLimit || event.x_root - m_xCenter > m_xLimit ||
+             event.y_root - m_yCenter < -m_yLimit || event.y_root - m_yCenter > m_yLimit)) {
+        m_warping    = true;
+        m_warpSerial = m_impl->do_NextRequest(m_display);
+        m_impl->XWarpPointer(m_display, None, m_root, 0, 0, 0, 0, m_xCenter, m_yCenter);
+        m_impl->XFlush(m_display);
+        ++m_warpCount;
+        LOG_DEBUG2("warping to %d,%d", m_xCenter, m_yCenter);
+    }
+}
+
+} // namespace inputleap
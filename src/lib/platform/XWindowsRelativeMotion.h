@@ -0,0 +1,103 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "config.h"
+
+#include "IXWindowsImpl.h"
+
+#include <X11/Xlib.h>
+#include <cstdint>
+
+namespace inputleap {
+
+//! Pointer motion of the primary screen while on a secondary screen
+/*!
+While the cursor is on a secondary screen the primary screen's pointer
+is grabbed and only its motion matters.  This turns the grab's motion
+events into deltas and keeps the pointer away from the edges of the
+screen by warping it back to the center.
+
+Warps are asynchronous.  The serial number of the warp request tells
+which events were generated before the X server moved the pointer and
+which after, so no round trip or marker event is needed to find the
+first event at the new position.  Only one warp is in flight at a time.
+*/
+class XWindowsRelativeMotion {
+public:
+    XWindowsRelativeMotion(IXWindowsImpl* impl, Display* display, Window root);
+
+    //! @name manipulators
+    //@{
+
+    //! Set the screen area
+    /*!
+    Sets the area the pointer is kept in.  The pointer is warped back
+    to the center when it's more than a quarter of the area away.
+    */
+    void setArea(std::int32_t x, std::int32_t y, std::int32_t w, std::int32_t h);
+
+    //! Restart at a position
+    /*!
+    Forgets any warp in flight and makes \p x,y the position the next
+    motion is relative to.  Used after a synchronous warp.
+    */
+    void reset(std::int32_t x, std::int32_t y);
+
+    //! Handle a motion event
+    /*!
+    Sets \p dx,dy to the pointer motion since the previous event and
+    starts a warp back to the center if the pointer is too far from it.
+    */
+    void onMotion(const XMotionEvent& event, std::int32_t& dx, std::int32_t& dy);
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Get the number of warps
+    std::uint64_t getWarpCount() const { return m_warpCount; }
+
+    //! Get the number of motion events
+    std::uint64_t getMotionCount() const { return m_motionCount; }
+
+    //@}
+
+private:
+    IXWindowsImpl* m_impl;
+    Display* m_display;
+    Window m_root;
+
+    std::int32_t m_xCenter;
+    std::int32_t m_yCenter;
+    std::int32_t m_xLimit;
+    std::int32_t m_yLimit;
+
+    // the position the next motion is relative to
+    std::int32_t m_x;
+    std::int32_t m_y;
+
+    // serial number of the warp in flight
+    bool m_warping;
+    unsigned long m_warpSerial;
+
+    std::uint64_t m_warpCount;
+    std::uint64_t m_motionCount;
+};
+
+} // namespace inputleap
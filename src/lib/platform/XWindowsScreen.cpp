@@ -22,6 +22,7 @@
 #include "platform/XWindowsClipboard.h"
 #include "platform/XWindowsEventQueueBuffer.h"
 #include "platform/XWindowsKeyState.h"
+#include "platform/XWindowsRelativeMotion.h"
 #include "platform/XWindowsScreenSaver.h"
 #include "platform/XWindowsUtil.h"
 #include "inputleap/Clipboard.h"
@@ -79,6 +80,7 @@ XWindowsScreen::XWindowsScreen(
     m_w(0), m_h(0),
     m_xCenter(0), m_yCenter(0),
     m_xCursor(0), m_yCursor(0),
+    m_relativeMotion(nullptr),
     m_keyState(nullptr),
     m_lastFocus(None),
     m_lastFocusRevert(RevertToNone),
@@ -111,6 +113,7 @@ XWindowsScreen::XWindowsScreen(
 	try {
 		m_display     = openDisplay(displayName);
         m_root        = m_impl->do_DefaultRootWindow(m_display);
+        m_relativeMotion = new XWindowsRelativeMotion(m_impl, m_display, m_root);
 		saveShape();
 		m_window      = openWindow();
         m_screensaver = new XWindowsScreenSaver(m_impl, m_display,
@@ -159,7 +162,7 @@ XWindowsScreen::XWindowsScreen(
 
 	// install the platform event queue
     m_events->set_buffer(std::make_unique<XWindowsEventQueueBuffer>(m_impl, m_display,
-                                                                    m_window, m_events));
+                                                                    m_events));
 }
 
 XWindowsScreen::~XWindowsScreen()
@@ -173,6 +176,7 @@ XWindowsScreen::~XWindowsScreen()
 		delete m_clipboard[id];
 	}
     delete m_keyState;
+    delete m_relativeMotion;
 	delete m_screensaver;
     m_keyState = nullptr;
     m_screensaver = nullptr;
@@ -238,6 +242,13 @@ XWindowsScreen::enter()
 {
 	screensaver(false);
 
+	if (m_isPrimary) {
+		LOG_DEBUG("%llu motion events and %llu warps off screen, %llu round trips",
+				  static_cast<unsigned long long>(m_relativeMotion->getMotionCount()),
+				  static_cast<unsigned long long>(m_relativeMotion->getWarpCount()),
+				  static_cast<unsigned long long>(m_impl->get_round_trip_count()));
+	}
+
 	// release input context focus
     if (m_ic != nullptr) {
         m_impl->XUnsetICFocus(m_ic);
@@ -378,6 +389,22 @@ XWindowsScreen::setClipboard(ClipboardID id, const IClipboard* clipboard)
 	}
 }
 
+bool XWindowsScreen::setClipboardFormat(ClipboardID id, IClipboard::EFormat format,
+                                        const std::string& data)
+{
+    if (m_clipboard[id] == nullptr) {
+        return false;
+    }
+    return m_clipboard[id]->fulfill(format, data);
+}
+
+void XWindowsScreen::withdrawClipboardFormat(ClipboardID id, IClipboard::EFormat format)
+{
+    if (m_clipboard[id] != nullptr) {
+        m_clipboard[id]->withdraw(format);
+    }
+}
+
 void
 XWindowsScreen::checkClipboards()
 {
@@ -515,6 +542,7 @@ void XWindowsScreen::warpCursor(std::int32_t x, std::int32_t y)
 	// save position as last position
 	m_xCursor = x;
 	m_yCursor = y;
+	m_relativeMotion->reset(x, y);
 }
 
 std::uint32_t XWindowsScreen::registerHotKey(KeyID key, KeyModifierMask mask)
@@ -783,14 +811,16 @@ XWindowsScreen::fakeMouseButton(ButtonID button, bool press)
 {
 	const unsigned int xButton = mapButtonToX(button);
 	if (xButton > 0 && xButton < 11) {
+        m_keyState->beginFakeBatch();
         m_impl->XTestFakeButtonEvent(m_display, xButton,
 							press ? True : False, CurrentTime);
-        m_impl->XFlush(m_display);
+        m_keyState->endFakeBatch();
 	}
 }
 
 void XWindowsScreen::fakeMouseMove(std::int32_t x, std::int32_t y)
 {
+    m_keyState->beginFakeBatch();
 	if (m_xinerama && m_xtestIsXineramaUnaware) {
         m_impl->XWarpPointer(m_display, None, m_root, 0, 0, 0, 0, x, y);
 	}
@@ -798,11 +828,12 @@ void XWindowsScreen::fakeMouseMove(std::int32_t x, std::int32_t y)
 		XTestFakeMotionEvent(m_display, DefaultScreen(m_display),
 							x, y, CurrentTime);
 	}
-    m_impl->XFlush(m_display);
+    m_keyState->endFakeBatch();
 }
 
 void XWindowsScreen::fakeMouseRelativeMove(std::int32_t dx, std::int32_t dy) const
 {
+    m_keyState->beginFakeBatch();
 	// FIXME -- ignore xinerama for now
 	if (false && m_xinerama && m_xtestIsXineramaUnaware) {
 //		m_impl->XWarpPointer(m_display, None, m_root, 0, 0, 0, 0, x, y);
@@ -810,7 +841,7 @@ void XWindowsScreen::fakeMouseRelativeMove(std::int32_t dx, std::int32_t dy) con
 	else {
         m_impl->XTestFakeRelativeMotionEvent(m_display, dx, dy, CurrentTime);
 	}
-    m_impl->XFlush(m_display);
+    m_keyState->endFakeBatch();
 }
 
 void XWindowsScreen::fakeMouseWheel(std::int32_t xDelta, std::int32_t yDelta) const
@@ -848,12 +879,12 @@ void XWindowsScreen::fakeMouseWheel(std::int32_t xDelta, std::int32_t yDelta) co
     numEvents = std::abs(numEvents);
 
 	// send as many clicks as necessary
+    m_keyState->beginFakeBatch();
     for (; numEvents > 0; numEvents--) {
         m_impl->XTestFakeButtonEvent(m_display, xButton, True, CurrentTime);
         m_impl->XTestFakeButtonEvent(m_display, xButton, False, CurrentTime);
 	}
-
-    m_impl->XFlush(m_display);
+    m_keyState->endFakeBatch();
 }
 
 Display*
@@ -926,6 +957,7 @@ XWindowsScreen::saveShape()
 	// get center of default screen
 	m_xCenter = m_x + (m_w >> 1);
 	m_yCenter = m_y + (m_h >> 1);
+	m_relativeMotion->setArea(m_x, m_y, m_w, m_h);
 
 	// check if xinerama is enabled and there is more than one screen.
 	// get center of first Xinerama screen.  Xinerama appears to have
@@ -954,6 +986,8 @@ XWindowsScreen::saveShape()
 				m_xinerama = true;
 				m_xCenter  = screens[0].x_org + (screens[0].width  >> 1);
 				m_yCenter  = screens[0].y_org + (screens[0].height >> 1);
+				m_relativeMotion->setArea(screens[0].x_org, screens[0].y_org,
+										  screens[0].width, screens[0].height);
 			}
 			XFree(screens);
 		}
@@ -1199,6 +1233,13 @@ XWindowsScreen::handle_system_event(const Event& event)
 				cookie->type == GenericEvent &&
 				cookie->extension == xi_opcode) {
 			if (cookie->evtype == XI_RawMotion) {
+				if (!m_isOnScreen) {
+					// the grab reports the motion with the pointer's
+					// position, which saves a round trip per event
+                    m_impl->XFreeEventData(m_display, cookie);
+					return;
+				}
+
 				// Get current pointer's position
 				XMotionEvent xmotion;
 				xmotion.type = MotionNotify;
@@ -1280,6 +1321,15 @@ XWindowsScreen::handle_system_event(const Event& event)
 								xevent->xselectionrequest.target,
 								xevent->xselectionrequest.time,
 								xevent->xselectionrequest.property);
+
+				// ask for promised data the request is waiting for
+				for (auto format : m_clipboard[id]->takeRequestedFormats()) {
+					ClipboardFormatInfo info;
+					info.m_id = id;
+					info.m_format = format;
+					sendEvent(EventType::CLIPBOARD_FORMAT_REQUESTED,
+							  create_event_data<ClipboardFormatInfo>(info));
+				}
 				return;
 			}
 		}
@@ -1565,8 +1615,9 @@ XWindowsScreen::onMouseMove(const XMotionEvent& xmotion)
                   create_event_data<MotionInfo>(MotionInfo{m_xCursor, m_yCursor}));
 	}
 	else {
-		// motion on secondary screen.  warp mouse back to
-		// center.
+		// motion on secondary screen.  the mouse is warped
+		// back to center when it gets far from it, without
+		// waiting for the X server.  see XWindowsRelativeMotion.
 		//
 		// my lombard (powerbook g3) running linux and
 		// using the adbmouse driver has two problems:
@@ -1574,16 +1625,9 @@ XWindowsScreen::onMouseMove(const XMotionEvent& xmotion)
 		// pixels and, second, it seems to discard some
 		// physical input after a warp.  the former isn't a
 		// big deal (we're just limited to every other
-		// pixel) but the latter is a PITA.  to work around
-		// it we only warp when the mouse has moved more
-		// than s_size pixels from the center.
-		static const std::int32_t s_size = 32;
-		if (xmotion.x_root - m_xCenter < -s_size ||
-			xmotion.x_root - m_xCenter >  s_size ||
-			xmotion.y_root - m_yCenter < -s_size ||
-			xmotion.y_root - m_yCenter >  s_size) {
-			warpCursorNoFlush(m_xCenter, m_yCenter);
-		}
+		// pixel) but the latter is a PITA.  warping rarely
+		// works around it.
+		m_relativeMotion->onMotion(xmotion, x, y);
 
 		// send event if mouse moved.  do this after warping
 		// back to center in case the motion takes us onto
@@ -33,6 +33,7 @@ namespace inputleap {
 
 class XWindowsClipboard;
 class XWindowsKeyState;
+class XWindowsRelativeMotion;
 class XWindowsScreenSaver;
 
 //! Implementation of IPlatformScreen for X11
@@ -78,6 +79,8 @@ public:
     bool canLeave() override;
     void leave() override;
     bool setClipboard(ClipboardID, const IClipboard*) override;
+    bool setClipboardFormat(ClipboardID, IClipboard::EFormat, const std::string&) override;
+    void withdrawClipboardFormat(ClipboardID, IClipboard::EFormat) override;
     void checkClipboards() override;
     void openScreensaver(bool notify) override;
     void closeScreensaver() override;
@@ -205,6 +208,9 @@ private:
     // last mouse position
     std::int32_t m_xCursor, m_yCursor;
 
+    // mouse motion while on a secondary screen
+    XWindowsRelativeMotion* m_relativeMotion;
+
     // keyboard stuff
     XWindowsKeyState* m_keyState;
 
@@ -37,59 +37,59 @@ const EventTarget* ClientConnectionByStream::get_event_target()
 
 void ClientConnectionByStream::send_query_info_1_6()
 {
-    ProtocolUtil::writef(stream_.get(), kMsgQInfo);
+    ProtocolUtil::write_message<kMsgQInfo>(stream_.get());
 }
 
 void ClientConnectionByStream::send_enter_1_6(std::int32_t x_abs, std::int32_t y_abs,
                                               std::uint32_t seq_num, KeyModifierMask mask)
 {
-    ProtocolUtil::writef(stream_.get(), kMsgCEnter, x_abs, y_abs, seq_num, mask);
+    ProtocolUtil::write_message<kMsgCEnter>(stream_.get(), x_abs, y_abs, seq_num, mask);
 }
 
 void ClientConnectionByStream::send_leave_1_6()
 {
-    ProtocolUtil::writef(stream_.get(), kMsgCLeave);
+    ProtocolUtil::write_message<kMsgCLeave>(stream_.get());
 }
 
 void ClientConnectionByStream::send_key_down_1_6(KeyID key, KeyModifierMask mask, KeyButton button)
 {
-    ProtocolUtil::writef(stream_.get(), kMsgDKeyDown, key, mask, button);
+    ProtocolUtil::write_message<kMsgDKeyDown>(stream_.get(), key, mask, button);
 }
 
 void ClientConnectionByStream::send_key_up_1_6(KeyID key, KeyModifierMask mask, KeyButton button)
 {
-    ProtocolUtil::writef(stream_.get(), kMsgDKeyUp, key, mask, button);
+    ProtocolUtil::write_message<kMsgDKeyUp>(stream_.get(), key, mask, button);
 }
 
 void ClientConnectionByStream::send_key_repeat_1_6(KeyID key, KeyModifierMask mask,
                                                    std::int32_t count, KeyButton button)
 {
-    ProtocolUtil::writef(stream_.get(), kMsgDKeyRepeat, key, mask, count, button);
+    ProtocolUtil::write_message<kMsgDKeyRepeat>(stream_.get(), key, mask, count, button);
 }
 
 void ClientConnectionByStream::send_mouse_down_1_6(ButtonID button)
 {
-    ProtocolUtil::writef(stream_.get(), kMsgDMouseDown, button);
+    ProtocolUtil::write_message<kMsgDMouseDown>(stream_.get(), button);
 }
 
 void ClientConnectionByStream::send_mouse_up_1_6(ButtonID button)
 {
-    ProtocolUtil::writef(stream_.get(), kMsgDMouseUp, button);
+    ProtocolUtil::write_message<kMsgDMouseUp>(stream_.get(), button);
 }
 
 void ClientConnectionByStream::send_mouse_move_1_6(std::int32_t x_abs, std::int32_t y_abs)
 {
-    ProtocolUtil::writef(stream_.get(), kMsgDMouseMove, x_abs, y_abs);
+    ProtocolUtil::write_message<kMsgDMouseMove>(stream_.get(), x_abs, y_abs);
 }
 
 void ClientConnectionByStream::send_mouse_relative_move_1_6(std::int32_t x_rel, std::int32_t y_rel)
 {
-    ProtocolUtil::writef(stream_.get(), kMsgDMouseRelMove, x_rel, y_rel);
+    ProtocolUtil::write_message<kMsgDMouseRelMove>(stream_.get(), x_rel, y_rel);
 }
 
 void ClientConnectionByStream::send_mouse_wheel_1_6(std::int32_t x_delta, std::int32_t y_delta)
 {
-    ProtocolUtil::writef(stream_.get(), kMsgDMouseWheel, x_delta, y_delta);
+    ProtocolUtil::write_message<kMsgDMouseWheel>(stream_.get(), x_delta, y_delta);
 }
 
 void ClientConnectionByStream::send_drag_info_1_6(std::uint32_t file_count, const std::string& data)
@@ -99,12 +99,12 @@ void ClientConnectionByStream::send_drag_info_1_6(std::uint32_t file_count, cons
 
 void ClientConnectionByStream::send_screensaver_1_6(bool on)
 {
-    ProtocolUtil::writef(stream_.get(), kMsgCScreenSaver, on ? 1 : 0);
+    ProtocolUtil::write_message<kMsgCScreenSaver>(stream_.get(), on ? 1 : 0);
 }
 
 void ClientConnectionByStream::send_reset_options_1_6()
 {
-    ProtocolUtil::writef(stream_.get(), kMsgCResetOptions);
+    ProtocolUtil::write_message<kMsgCResetOptions>(stream_.get());
 }
 
 void ClientConnectionByStream::send_set_options_1_6(const OptionsList& options)
@@ -114,12 +114,12 @@ void ClientConnectionByStream::send_set_options_1_6(const OptionsList& options)
 
 void ClientConnectionByStream::send_info_ack_1_6()
 {
-    ProtocolUtil::writef(stream_.get(), kMsgCInfoAck);
+    ProtocolUtil::write_message<kMsgCInfoAck>(stream_.get());
 }
 
 void ClientConnectionByStream::send_keep_alive_1_6()
 {
-    ProtocolUtil::writef(stream_.get(), kMsgCKeepAlive);
+    ProtocolUtil::write_message<kMsgCKeepAlive>(stream_.get());
 }
 
 void ClientConnectionByStream::send_close_1_6(const char* msg)
@@ -129,8 +129,9 @@ void ClientConnectionByStream::send_close_1_6(const char* msg)
 
 void ClientConnectionByStream::send_clipboard_chunk_1_6(const ClipboardChunk& chunk)
 {
-    ProtocolUtil::writef(stream_.get(), kMsgDClipboard, chunk.id_, chunk.sequence_, chunk.mark_,
-                         &chunk.data_);
+    ProtocolUtil::writef(stream_.get(), kMsgDClipboardSlice, chunk.id_, chunk.sequence_,
+                         chunk.mark_, static_cast<std::uint32_t>(chunk.size_),
+                         reinterpret_cast<const std::uint8_t*>(chunk.bytes()));
 }
 
 void ClientConnectionByStream::send_file_chunk_1_6(const FileChunk& chunk)
@@ -140,7 +141,13 @@ void ClientConnectionByStream::send_file_chunk_1_6(const FileChunk& chunk)
 
 void ClientConnectionByStream::send_grab_clipboard(ClipboardID id)
 {
-    ProtocolUtil::writef(stream_.get(), kMsgCClipboard, id, 0);
+    ProtocolUtil::write_message<kMsgCClipboard>(stream_.get(), id, 0);
+}
+
+void ClientConnectionByStream::send_clipboard_formats_1_7(
+        ClipboardID id, std::uint32_t sequence, const std::vector<std::uint32_t>& formats)
+{
+    ProtocolUtil::writef(stream_.get(), kMsgDClipboardFormats, id, sequence, &formats);
 }
 
 void ClientConnectionByStream::flush()
@@ -58,6 +58,9 @@ public:
     void send_file_chunk_1_6(const FileChunk& chunk) override;
     void send_grab_clipboard(ClipboardID id) override;
 
+    void send_clipboard_formats_1_7(ClipboardID id, std::uint32_t sequence,
+                                    const std::vector<std::uint32_t>& formats) override;
+
     void flush() override;
     void close() override;
 
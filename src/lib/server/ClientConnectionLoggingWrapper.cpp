@@ -164,11 +164,16 @@ void ClientConnectionLoggingWrapper::send_clipboard_chunk_1_6(const ClipboardChu
     LOG_DEBUG1("sending clipboard chunk");
     switch (chunk.mark_) {
     case kDataStart:
-        LOG_DEBUG2("sending clipboard chunk start: size=%s", chunk.data_.c_str());
+        LOG_DEBUG2("sending clipboard chunk start: size=%s",
+                   std::string(chunk.bytes(), chunk.size_).c_str());
         break;
 
     case kDataChunk:
-        LOG_DEBUG2("sending clipboard chunk data: size=%zi", chunk.data_.size());
+        LOG_DEBUG2("sending clipboard chunk data: size=%zi", chunk.size_);
+        break;
+
+    case kDataChunkLZ4:
+        LOG_DEBUG2("sending compressed clipboard chunk data: size=%zi", chunk.size_);
         break;
 
     case kDataEnd:
@@ -191,6 +196,10 @@ void ClientConnectionLoggingWrapper::send_file_chunk_1_6(const FileChunk& chunk)
         LOG_DEBUG2("sending file chunk: size=%zi", chunk.data_.size());
         break;
 
+    case kDataChunkLZ4:
+        LOG_DEBUG2("sending compressed file chunk: size=%zi", chunk.data_.size());
+        break;
+
     case kDataEnd:
         LOG_DEBUG2("sending file finished");
         break;
@@ -206,6 +215,14 @@ void ClientConnectionLoggingWrapper::send_grab_clipboard(ClipboardID id)
     conn_->send_grab_clipboard(id);
 }
 
+void ClientConnectionLoggingWrapper::send_clipboard_formats_1_7(
+        ClipboardID id, std::uint32_t sequence, const std::vector<std::uint32_t>& formats)
+{
+    LOG_DEBUG("send clipboard %d formats to \"%s\" seq=%d size=%zd", id, name_.c_str(),
+              sequence, formats.size());
+    conn_->send_clipboard_formats_1_7(id, sequence, formats);
+}
+
 void ClientConnectionLoggingWrapper::flush()
 {
     conn_->flush();
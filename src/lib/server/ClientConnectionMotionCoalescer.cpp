@@ -0,0 +1,346 @@
+/*  InputLeap -- mouse and keyboard sharing utility
+    Copyright (C) InputLeap contributors
+
+    This package is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    found in the file LICENSE that should have accompanied this file.
+
+    This package is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ClientConnectionMotionCoalescer.h"
+#include "base/EventQueueTimer.h"
+#include "base/IEventQueue.h"
+#include "base/Log.h"
+#include "base/Time.h"
+#include "io/IStream.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace inputleap {
+
+namespace {
+
+// motion messages carry 16 bit coordinates
+bool fits_in_message(std::int32_t value)
+{
+    return value >= std::numeric_limits<std::int16_t>::min() &&
+           value <= std::numeric_limits<std::int16_t>::max();
+}
+
+} // namespace
+
+ClientConnectionMotionCoalescer::ClientConnectionMotionCoalescer(
+        const std::string& name, std::unique_ptr<IClientConnection> conn,
+        IEventQueue* events) :
+    name_{name},
+    conn_{std::move(conn)},
+    events_{events},
+    interval_{kDefaultIntervalUs / 1.0e6},
+    last_sent_time_{-std::numeric_limits<double>::infinity()}
+{}
+
+ClientConnectionMotionCoalescer::~ClientConnectionMotionCoalescer()
+{
+    delete_timer();
+}
+
+void ClientConnectionMotionCoalescer::set_interval(std::uint32_t interval_us)
+{
+    flush_motion();
+    interval_ = std::min(interval_us, kMaxIntervalUs) / 1.0e6;
+}
+
+const EventTarget* ClientConnectionMotionCoalescer::get_event_target()
+{
+    return conn_->get_event_target();
+}
+
+IStream* ClientConnectionMotionCoalescer::get_stream()
+{
+    return conn_->get_stream();
+}
+
+void ClientConnectionMotionCoalescer::send_query_info_1_6()
+{
+    flush_motion();
+    conn_->send_query_info_1_6();
+}
+
+void ClientConnectionMotionCoalescer::send_enter_1_6(std::int32_t x_abs, std::int32_t y_abs,
+                                                     std::uint32_t seq_num, KeyModifierMask mask)
+{
+    flush_motion();
+    conn_->send_enter_1_6(x_abs, y_abs, seq_num, mask);
+}
+
+void ClientConnectionMotionCoalescer::send_leave_1_6()
+{
+    flush_motion();
+    conn_->send_leave_1_6();
+}
+
+void ClientConnectionMotionCoalescer::send_key_down_1_6(KeyID key, KeyModifierMask mask,
+                                                        KeyButton button)
+{
+    flush_motion();
+    conn_->send_key_down_1_6(key, mask, button);
+}
+
+void ClientConnectionMotionCoalescer::send_key_up_1_6(KeyID key, KeyModifierMask mask,
+                                                      KeyButton button)
+{
+    flush_motion();
+    conn_->send_key_up_1_6(key, mask, button);
+}
+
+void ClientConnectionMotionCoalescer::send_key_repeat_1_6(KeyID key, KeyModifierMask mask,
+                                                          std::int32_t count, KeyButton button)
+{
+    flush_motion();
+    conn_->send_key_repeat_1_6(key, mask, count, button);
+}
+
+void ClientConnectionMotionCoalescer::send_mouse_down_1_6(ButtonID button)
+{
+    flush_motion();
+    conn_->send_mouse_down_1_6(button);
+}
+
+void ClientConnectionMotionCoalescer::send_mouse_up_1_6(ButtonID button)
+{
+    flush_motion();
+    conn_->send_mouse_up_1_6(button);
+}
+
+void ClientConnectionMotionCoalescer::send_mouse_move_1_6(std::int32_t x_abs, std::int32_t y_abs)
+{
+    if (interval_ <= 0.0) {
+        ++sent_moves_;
+        conn_->send_mouse_move_1_6(x_abs, y_abs);
+        return;
+    }
+
+    // only the last position matters
+    if (pending_ == Motion::ABSOLUTE) {
+        ++merged_moves_;
+        pending_x_ = x_abs;
+        pending_y_ = y_abs;
+        return;
+    }
+    flush_motion();
+
+    double now = current_time_seconds();
+    if (can_send_now(now)) {
+        ++sent_moves_;
+        last_sent_time_ = now;
+        conn_->send_mouse_move_1_6(x_abs, y_abs);
+    }
+    else {
+        hold(Motion::ABSOLUTE, x_abs, y_abs, now);
+    }
+}
+
+void ClientConnectionMotionCoalescer::send_mouse_relative_move_1_6(std::int32_t x_rel,
+                                                                   std::int32_t y_rel)
+{
+    if (interval_ <= 0.0) {
+        ++sent_moves_;
+        conn_->send_mouse_relative_move_1_6(x_rel, y_rel);
+        return;
+    }
+
+    // the deltas add up unless the sum no longer fits in one message
+    if (pending_ == Motion::RELATIVE &&
+            fits_in_message(pending_x_ + x_rel) && fits_in_message(pending_y_ + y_rel)) {
+        ++merged_moves_;
+        pending_x_ += x_rel;
+        pending_y_ += y_rel;
+        return;
+    }
+    flush_motion();
+
+    double now = current_time_seconds();
+    if (can_send_now(now)) {
+        ++sent_moves_;
+        last_sent_time_ = now;
+        conn_->send_mouse_relative_move_1_6(x_rel, y_rel);
+    }
+    else {
+        hold(Motion::RELATIVE, x_rel, y_rel, now);
+    }
+}
+
+void ClientConnectionMotionCoalescer::send_mouse_wheel_1_6(std::int32_t x_delta,
+                                                           std::int32_t y_delta)
+{
+    flush_motion();
+    conn_->send_mouse_wheel_1_6(x_delta, y_delta);
+}
+
+void ClientConnectionMotionCoalescer::send_drag_info_1_6(std::uint32_t file_count,
+                                                         const std::string& data)
+{
+    flush_motion();
+    conn_->send_drag_info_1_6(file_count, data);
+}
+
+void ClientConnectionMotionCoalescer::send_screensaver_1_6(bool on)
+{
+    flush_motion();
+    conn_->send_screensaver_1_6(on);
+}
+
+void ClientConnectionMotionCoalescer::send_reset_options_1_6()
+{
+    set_interval(kDefaultIntervalUs);
+    conn_->send_reset_options_1_6();
+}
+
+void ClientConnectionMotionCoalescer::send_set_options_1_6(const OptionsList& options)
+{
+    flush_motion();
+    for (std::size_t i = 0; i + 1 < options.size(); i += 2) {
+        if (options[i] == kOptionMouseMoveInterval) {
+            set_interval(options[i + 1]);
+        }
+    }
+    conn_->send_set_options_1_6(options);
+}
+
+void ClientConnectionMotionCoalescer::send_info_ack_1_6()
+{
+    flush_motion();
+    conn_->send_info_ack_1_6();
+}
+
+void ClientConnectionMotionCoalescer::send_keep_alive_1_6()
+{
+    flush_motion();
+    conn_->send_keep_alive_1_6();
+}
+
+void ClientConnectionMotionCoalescer::send_close_1_6(const char* msg)
+{
+    flush_motion();
+    conn_->send_close_1_6(msg);
+}
+
+void ClientConnectionMotionCoalescer::send_clipboard_chunk_1_6(const ClipboardChunk& chunk)
+{
+    flush_motion();
+    conn_->send_clipboard_chunk_1_6(chunk);
+}
+
+void ClientConnectionMotionCoalescer::send_file_chunk_1_6(const FileChunk& chunk)
+{
+    flush_motion();
+    conn_->send_file_chunk_1_6(chunk);
+}
+
+void ClientConnectionMotionCoalescer::send_grab_clipboard(ClipboardID id)
+{
+    flush_motion();
+    conn_->send_grab_clipboard(id);
+}
+
+void ClientConnectionMotionCoalescer::send_clipboard_formats_1_7(
+        ClipboardID id, std::uint32_t sequence, const std::vector<std::uint32_t>& formats)
+{
+    flush_motion();
+    conn_->send_clipboard_formats_1_7(id, sequence, formats);
+}
+
+void ClientConnectionMotionCoalescer::flush()
+{
+    flush_motion();
+    conn_->flush();
+}
+
+void ClientConnectionMotionCoalescer::close()
+{
+    // the client is going away, a late move is of no use to it
+    pending_ = Motion::NONE;
+    log_stats();
+    conn_->close();
+}
+
+bool ClientConnectionMotionCoalescer::can_send_now(double now) const
+{
+    // a move written behind unsent data arrives no sooner than one sent
+    // once the data has gone, so wait and send only the latest
+    if (now - last_sent_time_ < interval_) {
+        return false;
+    }
+    IStream* stream = conn_->get_stream();
+    return stream == nullptr || stream->getOutputSize() == 0;
+}
+
+void ClientConnectionMotionCoalescer::hold(Motion motion, std::int32_t x, std::int32_t y,
+                                           double now)
+{
+    pending_ = motion;
+    pending_x_ = x;
+    pending_y_ = y;
+
+    // send when the interval is up or, if that's already the case and
+    // the connection is busy, one interval from now
+    double delay = last_sent_time_ + interval_ - now;
+    if (delay <= 0.0) {
+        delay = interval_;
+    }
+    start_timer(delay);
+}
+
+void ClientConnectionMotionCoalescer::flush_motion()
+{
+    if (pending_ == Motion::NONE) {
+        return;
+    }
+
+    Motion motion = pending_;
+    pending_ = Motion::NONE;
+    ++sent_moves_;
+    last_sent_time_ = current_time_seconds();
+    if (motion == Motion::ABSOLUTE) {
+        conn_->send_mouse_move_1_6(pending_x_, pending_y_);
+    }
+    else {
+        conn_->send_mouse_relative_move_1_6(pending_x_, pending_y_);
+    }
+}
+
+void ClientConnectionMotionCoalescer::start_timer(double delay)
+{
+    if (timer_ != nullptr) {
+        events_->restartTimer(timer_, delay);
+        return;
+    }
+    timer_ = events_->newOneShotTimer(delay, nullptr);
+    events_->add_handler(EventType::TIMER, timer_, [this](const auto& e){ flush_motion(); });
+}
+
+void ClientConnectionMotionCoalescer::delete_timer()
+{
+    if (timer_ != nullptr) {
+        events_->remove_handler(EventType::TIMER, timer_);
+        events_->deleteTimer(timer_);
+        timer_ = nullptr;
+    }
+}
+
+void ClientConnectionMotionCoalescer::log_stats() const
+{
+    LOG_DEBUG("mouse motion to \"%s\": %llu moves sent, %llu merged", name_.c_str(),
+              static_cast<unsigned long long>(sent_moves_),
+              static_cast<unsigned long long>(merged_moves_));
+}
+
+} // namespace inputleap
@@ -0,0 +1,135 @@
+/*  InputLeap -- mouse and keyboard sharing utility
+    Copyright (C) InputLeap contributors
+
+    This package is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    found in the file LICENSE that should have accompanied this file.
+
+    This package is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "IClientConnection.h"
+#include <cstdint>
+#include <memory>
+
+namespace inputleap {
+
+class IStream;
+
+/// Wraps a IClientConnection and merges mouse motion sent faster than the client needs it.
+///
+/// A mouse move is sent at once if the previous one went out at least the motion interval
+/// earlier and nothing is waiting to be written to the client.  Otherwise it is held back and
+/// later moves are merged into it: absolute moves keep the last position and relative moves
+/// are summed.  The held move is sent when the interval has passed, or before any other
+/// message so that buttons, keys and the wheel always act at the latest position.
+///
+/// The interval is set by the kOptionMouseMoveInterval option in microseconds.  Zero, the
+/// default, sends every move unchanged.
+class ClientConnectionMotionCoalescer : public IClientConnection {
+public:
+    /// The motion interval used until the options set another.  Merging is off by default.
+    static constexpr std::uint32_t kDefaultIntervalUs = 0;
+
+    /// The longest motion interval accepted, one second
+    static constexpr std::uint32_t kMaxIntervalUs = 1000000;
+
+    ClientConnectionMotionCoalescer(const std::string& name,
+                                    std::unique_ptr<IClientConnection> conn,
+                                    IEventQueue* events);
+    ~ClientConnectionMotionCoalescer() override;
+
+    /// Returns the number of motion messages written to the client
+    std::uint64_t get_sent_moves() const { return sent_moves_; }
+
+    /// Returns the number of mouse moves merged into another instead of being sent
+    std::uint64_t get_merged_moves() const { return merged_moves_; }
+
+    /// Sets the motion interval in microseconds, at most kMaxIntervalUs
+    void set_interval(std::uint32_t interval_us);
+
+    IStream* get_stream() override;
+
+    const EventTarget* get_event_target() override;
+
+    void send_query_info_1_6() override;
+    void send_enter_1_6(std::int32_t x_abs, std::int32_t y_abs, std::uint32_t seq_num,
+                        KeyModifierMask mask) override;
+    void send_leave_1_6() override;
+    void send_key_down_1_6(KeyID key, KeyModifierMask mask, KeyButton button) override;
+    void send_key_up_1_6(KeyID key, KeyModifierMask mask, KeyButton button) override;
+    void send_key_repeat_1_6(KeyID key, KeyModifierMask mask, std::int32_t count,
+                             KeyButton button) override;
+    void send_mouse_down_1_6(ButtonID button) override;
+    void send_mouse_up_1_6(ButtonID button) override;
+    void send_mouse_move_1_6(std::int32_t x_abs, std::int32_t y_abs) override;
+    void send_mouse_relative_move_1_6(std::int32_t x_rel, std::int32_t y_rel) override;
+    void send_mouse_wheel_1_6(std::int32_t x_delta, std::int32_t y_delta) override;
+    void send_drag_info_1_6(std::uint32_t file_count, const std::string& data) override;
+    void send_screensaver_1_6(bool on) override;
+    void send_reset_options_1_6() override;
+    void send_set_options_1_6(const OptionsList& options) override;
+    void send_info_ack_1_6() override;
+    void send_keep_alive_1_6() override;
+    void send_close_1_6(const char* msg) override;
+
+    void send_clipboard_chunk_1_6(const ClipboardChunk& chunk) override;
+    void send_file_chunk_1_6(const FileChunk& chunk) override;
+    void send_grab_clipboard(ClipboardID id) override;
+
+    void send_clipboard_formats_1_7(ClipboardID id, std::uint32_t sequence,
+                                    const std::vector<std::uint32_t>& formats) override;
+
+    void flush() override;
+    void close() override;
+
+private:
+    enum class Motion {
+        NONE,
+        ABSOLUTE,
+        RELATIVE
+    };
+
+    // returns true if a move may be sent without waiting
+    bool can_send_now(double now) const;
+
+    // holds a move back until the interval has passed
+    void hold(Motion motion, std::int32_t x, std::int32_t y, double now);
+
+    // sends the held move, if any
+    void flush_motion();
+
+    // the timer is created on first use and restarted for each held
+    // move rather than recreated, so its handler is added only once.  a
+    // timer that fires after the held move was sent does nothing.
+    void start_timer(double delay);
+    void delete_timer();
+
+    void log_stats() const;
+
+    std::string name_;
+    std::unique_ptr<IClientConnection> conn_;
+    IEventQueue* events_;
+
+    double interval_;
+    double last_sent_time_;
+
+    Motion pending_ = Motion::NONE;
+    std::int32_t pending_x_ = 0;
+    std::int32_t pending_y_ = 0;
+
+    EventQueueTimer* timer_ = nullptr;
+
+    std::uint64_t sent_moves_ = 0;
+    std::uint64_t merged_moves_ = 0;
+};
+
+} // namespace inputleap
@@ -23,7 +23,6 @@
 #include "inputleap/ClipboardChunk.h"
 #include "inputleap/Exceptions.h"
 #include "inputleap/FileChunk.h"
-#include "inputleap/StreamChunker.h"
 #include "server/Server.h"
 #include "io/IStream.h"
 #include "base/Log.h"
@@ -58,8 +57,8 @@ ClientProxy1_6::ClientProxy1_6(const std::string& name,
                           [this](const auto& e){ handle_write_error(); });
     m_events->add_handler(EventType::FILE_KEEPALIVE, this,
                           [this](const auto& e){ keepAlive(); });
-    m_events->add_handler(EventType::CLIPBOARD_SENDING, this,
-                          [this](const auto& e){ handle_clipboard_sending_event(e); });
+    m_events->add_handler(EventType::STREAM_OUTPUT_FLUSHED, get_conn().get_event_target(),
+                          [this](const auto& e){ send_bulk_data(); });
     m_events->add_handler(EventType::TIMER, this,
                           [this](const auto& e){ handle_flatline(); });
 
@@ -83,6 +82,8 @@ IStream* ClientProxy1_6::getStream() const
 void ClientProxy1_6::disconnect()
 {
     remove_handlers();
+    clipboard_stream_.clear();
+    file_stream_.clear();
     get_conn().close();
     m_events->add_event(EventType::CLIENT_PROXY_DISCONNECTED, get_event_target());
 }
@@ -95,8 +96,8 @@ void ClientProxy1_6::remove_handlers()
     m_events->remove_handler(EventType::STREAM_INPUT_SHUTDOWN, get_conn().get_event_target());
     m_events->remove_handler(EventType::STREAM_OUTPUT_SHUTDOWN, get_conn().get_event_target());
     m_events->remove_handler(EventType::STREAM_INPUT_FORMAT_ERROR, get_conn().get_event_target());
+    m_events->remove_handler(EventType::STREAM_OUTPUT_FLUSHED, get_conn().get_event_target());
     m_events->remove_handler(EventType::FILE_KEEPALIVE, this);
-    m_events->remove_handler(EventType::CLIPBOARD_SENDING, this);
     m_events->remove_handler(EventType::TIMER, this);
 
     // remove timer
@@ -265,9 +266,23 @@ void ClientProxy1_6::handle_flatline()
     disconnect();
 }
 
-void ClientProxy1_6::handle_clipboard_sending_event(const Event& event)
-{
-    get_conn().send_clipboard_chunk_1_6(event.get_data_as<ClipboardChunk>());
+void ClientProxy1_6::send_bulk_data()
+{
+    // called when bulk data is queued and whenever the stream drains.
+    // other messages are written right away so they only ever wait
+    // behind a window's worth of bulk data.  clipboards go first since
+    // they're usually small and about to be pasted.
+    bool sent = clipboard_stream_.pump([this](const ClipboardChunk& chunk)
+    {
+        get_conn().send_clipboard_chunk_1_6(chunk);
+    }, getStream()->getOutputSize());
+    sent |= file_stream_.pump([this](const FileChunk& chunk)
+    {
+        get_conn().send_file_chunk_1_6(chunk);
+    }, getStream()->getOutputSize());
+    if (sent) {
+        keepAlive();
+    }
 }
 
 bool ClientProxy1_6::getClipboard(ClipboardID id, IClipboard* clipboard) const
@@ -313,12 +328,11 @@ void ClientProxy1_6::setClipboard(ClipboardID id, const IClipboard* clipboard)
         m_clipboard[id].m_dirty = false;
         Clipboard::copy(&m_clipboard[id].m_clipboard, clipboard);
 
-        std::string data = m_clipboard[id].m_clipboard.marshall();
-
-        size_t size = data.size();
+        auto data = std::make_shared<const std::string>(m_clipboard[id].m_clipboard.marshall());
         LOG_DEBUG("sending clipboard %d to \"%s\"", id, getName().c_str());
 
-        StreamChunker::sendClipboard(data, size, id, 0, m_events, this);
+        clipboard_stream_.push(id, 0, std::move(data));
+        send_bulk_data();
     }
 }
 
@@ -384,7 +398,8 @@ void ClientProxy1_6::sendDragInfo(std::uint32_t fileCount, const char* info, siz
 
 void ClientProxy1_6::file_chunk_sending(const FileChunk& chunk)
 {
-    get_conn().send_file_chunk_1_6(chunk);
+    file_stream_.push(chunk);
+    send_bulk_data();
 }
 
 void ClientProxy1_6::screensaver(bool on)
@@ -423,7 +438,7 @@ bool ClientProxy1_6::recvInfo()
 {
     // parse the message
     std::int16_t x, y, w, h, dummy1, mx, my;
-    if (!ProtocolUtil::readf(getStream(), kMsgDInfo + 4,
+    if (!ProtocolUtil::read_message_body<kMsgDInfo>(getStream(),
                             &x, &y, &w, &h, &dummy1, &mx, &my)) {
         return false;
     }
@@ -466,8 +481,9 @@ bool ClientProxy1_6::recvClipboard()
     } else if (r == kFinish) {
         LOG_DEBUG("received client \"%s\" clipboard %d seqnum=%d, size=%zd",
                 getName().c_str(), id, seq, dataCached.size());
-        // save clipboard
+        // save clipboard and release the buffer
         m_clipboard[id].m_clipboard.unmarshall(dataCached, 0);
+        std::string().swap(dataCached);
         m_clipboard[id].m_sequenceNumber = seq;
 
         // notify
@@ -486,7 +502,7 @@ bool ClientProxy1_6::recvGrabClipboard()
     // parse message
     ClipboardID id;
     std::uint32_t seqNum;
-    if (!ProtocolUtil::readf(getStream(), kMsgCClipboard + 4, &id, &seqNum)) {
+    if (!ProtocolUtil::read_message_body<kMsgCClipboard>(getStream(), &id, &seqNum)) {
         return false;
     }
     LOG_DEBUG("received client \"%s\" grabbed clipboard %d seqnum=%d", getName().c_str(), id, seqNum);
@@ -514,8 +530,7 @@ void ClientProxy1_6::keepAlive()
 void ClientProxy1_6::fileChunkReceived()
 {
     Server* server = getServer();
-    int result = FileChunk::assemble(getStream(), server->getReceivedFileData(),
-                                     server->getExpectedFileSize());
+    int result = FileChunk::assemble(getStream(), server->getReceivedFile());
 
     if (result == kFinish) {
         m_events->add_event(EventType::FILE_RECEIVE_COMPLETED, server);
@@ -21,6 +21,8 @@
 #include "server/ClientProxy.h"
 #include "base/Fwd.h"
 #include "inputleap/Clipboard.h"
+#include "inputleap/ClipboardStream.h"
+#include "inputleap/FileTransferStream.h"
 #include "inputleap/protocol_types.h"
 
 namespace inputleap {
@@ -80,6 +82,7 @@ protected:
 
     void fileChunkReceived();
     void dragInfoReceived();
+    void send_bulk_data();
 
 private:
     void disconnect();
@@ -89,7 +92,6 @@ private:
     void handle_disconnect();
     void handle_write_error();
     void handle_flatline();
-    void handle_clipboard_sending_event(const Event& event);
 
     bool recvInfo();
     bool recvGrabClipboard();
@@ -106,6 +108,8 @@ protected:
     };
 
     ClientClipboard m_clipboard[kClipboardEnd];
+    ClipboardStream clipboard_stream_;
+    FileTransferStream file_stream_;
 
 protected:
     typedef bool (ClientProxy1_6::*MessageParser)(const std::uint8_t*);
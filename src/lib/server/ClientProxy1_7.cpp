@@ -0,0 +1,122 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "server/ClientProxy1_7.h"
+#include "server/IClientConnection.h"
+
+#include "inputleap/ChunkCompressor.h"
+#include "inputleap/ProtocolUtil.h"
+#include "base/Log.h"
+
+#include <cstring>
+#include <vector>
+
+namespace inputleap {
+
+ClientProxy1_7::ClientProxy1_7(const std::string& name,
+                               std::unique_ptr<IClientConnection> backend,
+                               Server* server, IEventQueue* events) :
+    ClientProxy1_6(name, std::move(backend), server, events)
+{
+}
+
+ClientProxy1_7::~ClientProxy1_7() = default;
+
+void ClientProxy1_7::setClipboard(ClipboardID id, const IClipboard* clipboard)
+{
+    // ignore if this clipboard is already clean
+    if (!m_clipboard[id].m_dirty) {
+        return;
+    }
+
+    // this clipboard is now clean.  keep it to answer queries.
+    m_clipboard[id].m_dirty = false;
+    const Clipboard& saved = m_clipboard[id].m_clipboard;
+    Clipboard::copy(&m_clipboard[id].m_clipboard, clipboard);
+
+    std::vector<std::uint32_t> formats;
+    if (saved.open(0)) {
+        for (std::int32_t index = 0; index < IClipboard::kNumFormats; ++index) {
+            auto format = static_cast<IClipboard::EFormat>(index);
+            if (!saved.has(format)) {
+                continue;
+            }
+            Clipboard::Digest digest = saved.digest(format);
+            formats.push_back(static_cast<std::uint32_t>(format));
+            formats.push_back(static_cast<std::uint32_t>(saved.size(format)));
+            formats.push_back(static_cast<std::uint32_t>(digest[0] >> 32));
+            formats.push_back(static_cast<std::uint32_t>(digest[0]));
+            formats.push_back(static_cast<std::uint32_t>(digest[1] >> 32));
+            formats.push_back(static_cast<std::uint32_t>(digest[1]));
+        }
+        saved.close();
+    }
+
+    LOG_DEBUG("sending clipboard %d formats to \"%s\"", id, getName().c_str());
+    get_conn().send_clipboard_formats_1_7(id, ++advertised_[id], formats);
+}
+
+bool ClientProxy1_7::parseMessage(const std::uint8_t* code)
+{
+    if (memcmp(code, kMsgQClipboardFormat, 4) == 0) {
+        return recvQueryClipboardFormat();
+    }
+    return ClientProxy1_6::parseMessage(code);
+}
+
+bool ClientProxy1_7::recvQueryClipboardFormat()
+{
+    // parse message
+    ClipboardID id;
+    std::uint8_t format;
+    if (!ProtocolUtil::read_message_body<kMsgQClipboardFormat>(getStream(), &id, &format)) {
+        return false;
+    }
+    LOG_DEBUG("received client \"%s\" query for clipboard %d format %d",
+              getName().c_str(), id, format);
+
+    // validate
+    if (id >= kClipboardEnd) {
+        return false;
+    }
+
+    // reply with just the requested format.  the advertisement is
+    // written straight away while replies wait for the stream to drain,
+    // so the client uses the sequence number to drop stale replies.
+    Clipboard reply;
+    bool compressible = true;
+    const Clipboard& saved = m_clipboard[id].m_clipboard;
+    if (format < IClipboard::kNumFormats && reply.open(0)) {
+        if (saved.open(0)) {
+            auto eFormat = static_cast<IClipboard::EFormat>(format);
+            if (saved.has(eFormat)) {
+                reply.add(eFormat, saved.get(eFormat));
+            }
+            compressible = ChunkCompressor::is_compressible(eFormat);
+            saved.close();
+        }
+        reply.close();
+    }
+
+    // each reply holds a different format so none replaces another
+    auto data = std::make_shared<const std::string>(reply.marshall());
+    clipboard_stream_.push(id, advertised_[id], std::move(data), false, compressible);
+    send_bulk_data();
+    return true;
+}
+
+} // namespace inputleap
@@ -19,9 +19,12 @@
 #include "server/ClientProxyUnknown.h"
 #include "ClientConnectionByStream.h"
 #include "ClientConnectionLoggingWrapper.h"
+#include "ClientConnectionMotionCoalescer.h"
 #include "base/ELevel.h"
 #include "server/Server.h"
 #include "server/ClientProxy1_6.h"
+#include "server/ClientProxy1_7.h"
+#include "server/ClientProxy1_8.h"
 #include "inputleap/protocol_types.h"
 #include "inputleap/ProtocolUtil.h"
 #include "inputleap/Exceptions.h"
@@ -179,12 +182,21 @@ void ClientProxyUnknown::handle_data()
                 conn = std::make_unique<ClientConnectionLoggingWrapper>(name, std::move(conn));
             }
 
+            conn = std::make_unique<ClientConnectionMotionCoalescer>(name, std::move(conn),
+                                                                     m_events);
+
             // create client proxy for highest version supported by the client
             if (major == 1) {
                 switch (minor) {
                 case 6:
                     m_proxy = new ClientProxy1_6(name, std::move(conn), m_server, m_events);
                     break;
+                case 7:
+                    m_proxy = new ClientProxy1_7(name, std::move(conn), m_server, m_events);
+                    break;
+                case 8:
+                    m_proxy = new ClientProxy1_8(name, std::move(conn), m_server, m_events);
+                    break;
                 default:
                     break;
                 }
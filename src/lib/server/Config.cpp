@@ -19,6 +19,7 @@
 #include "server/Config.h"
 
 #include "server/Server.h"
+#include "server/ClientConnectionMotionCoalescer.h"
 #include "inputleap/KeyMap.h"
 #include "inputleap/key_types.h"
 #include "net/XSocket.h"
@@ -726,6 +727,14 @@ Config::readSectionOptions(ConfigReadContext& s)
 		else if (name == "clipboardSharingSize") {
 			addOption("", kOptionClipboardSharingSize, s.parseInt(value));
 		}
+		else if (name == "mouseMoveInterval") {
+			OptionValue interval = s.parseInt(value);
+			if (interval < 0 ||
+				interval > static_cast<OptionValue>(ClientConnectionMotionCoalescer::kMaxIntervalUs)) {
+				throw XConfigRead(s, "integer argument \"%{1}\" out of range", value);
+			}
+			addOption("", kOptionMouseMoveInterval, interval);
+		}
 
 		else {
 			handled = false;
@@ -1353,6 +1362,9 @@ Config::getOptionName(OptionID id)
 	if (id == kOptionClipboardSharingSize) {
 		return "clipboardSharingSize";
 	}
+	if (id == kOptionMouseMoveInterval) {
+		return "mouseMoveInterval";
+	}
 	return nullptr;
 }
 
@@ -1405,7 +1417,8 @@ std::string Config::getOptionValue(OptionID id, OptionValue value)
 	if (id == kOptionHeartbeat ||
 		id == kOptionScreenSwitchCornerSize ||
 		id == kOptionScreenSwitchDelay ||
-		id == kOptionScreenSwitchTwoTap) {
+		id == kOptionScreenSwitchTwoTap ||
+		id == kOptionMouseMoveInterval) {
 		return inputleap::string::sprintf("%d", value);
 	}
 	if (id == kOptionMouseScrollDelta) {
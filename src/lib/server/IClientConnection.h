@@ -23,6 +23,7 @@
 #include "inputleap/mouse_types.h"
 #include "inputleap/option_types.h"
 #include <string>
+#include <vector>
 
 namespace inputleap {
 
@@ -62,6 +63,9 @@ public:
     virtual void send_file_chunk_1_6(const FileChunk& chunk) = 0;
     virtual void send_grab_clipboard(ClipboardID id) = 0;
 
+    virtual void send_clipboard_formats_1_7(ClipboardID id, std::uint32_t sequence,
+                                            const std::vector<std::uint32_t>& formats) = 0;
+
     virtual void flush() = 0;
     virtual void close() = 0;
 };
@@ -28,6 +28,11 @@
 
 namespace inputleap {
 
+// modifiers that cannot be combined with a mouse button
+static const KeyModifierMask s_buttonIgnoreMask =
+    KeyModifierAltGr | KeyModifierCapsLock |
+    KeyModifierNumLock | KeyModifierScrollLock;
+
 // -----------------------------------------------------------------------------
 // Input Filter Condition Classes
 // -----------------------------------------------------------------------------
@@ -84,6 +89,12 @@ InputFilter::KeystrokeCondition::getMask() const
     return m_mask;
 }
 
+std::uint32_t
+InputFilter::KeystrokeCondition::getID() const
+{
+    return m_id;
+}
+
 InputFilter::Condition*
 InputFilter::KeystrokeCondition::clone() const
 {
@@ -181,10 +192,6 @@ std::string InputFilter::MouseButtonCondition::format() const
 InputFilter::EFilterStatus
 InputFilter::MouseButtonCondition::match(const Event& event)
 {
-    static const KeyModifierMask s_ignoreMask =
-        KeyModifierAltGr | KeyModifierCapsLock |
-        KeyModifierNumLock | KeyModifierScrollLock;
-
     EFilterStatus status;
 
     // check for hotkey events
@@ -201,7 +208,7 @@ InputFilter::MouseButtonCondition::match(const Event& event)
     // check if it's the right button and modifiers.  ignore modifiers
     // that cannot be combined with a mouse button.
     const auto& minfo = event.get_data_as<IPlatformScreen::ButtonInfo>();
-    if (minfo.m_button != m_button || (minfo.m_mask & ~s_ignoreMask) != m_mask) {
+    if (minfo.m_button != m_button || (minfo.m_mask & ~s_buttonIgnoreMask) != m_mask) {
         return kNoMatch;
     }
 
@@ -813,6 +820,7 @@ InputFilter::InputFilter(const InputFilter& x) :
     m_primaryClient(nullptr),
     m_events(x.m_events)
 {
+    rebuild_index();
     setPrimaryClient(x.m_primaryClient);
 }
 
@@ -829,6 +837,7 @@ InputFilter::operator=(const InputFilter& x)
         setPrimaryClient(nullptr);
 
         m_ruleList = x.m_ruleList;
+        rebuild_index();
 
         setPrimaryClient(oldClient);
     }
@@ -842,6 +851,7 @@ InputFilter::addFilterRule(const Rule& rule)
     if (m_primaryClient != nullptr) {
         m_ruleList.back().enable(m_primaryClient);
     }
+    index_rule(m_ruleList.size() - 1);
 }
 
 void InputFilter::add_rules(const std::vector<Rule>& rules)
@@ -898,24 +908,88 @@ InputFilter::setPrimaryClient(PrimaryClient* client)
             rule->enable(m_primaryClient);
         }
     }
+
+    // hot key ids change with the primary client
+    rebuild_index();
 }
 
 void InputFilter::handle_event(const Event& event)
 {
-    // copy event and adjust target
-    Event myEvent(event.getType(), this, nullptr, event.getFlags() | Event::kDeliverImmediately);
-    myEvent.clone_data_from(event);
+    // adjust target.  the event is handled before this handler returns
+    // so it can share the data of the original.
+    Event myEvent = event.retargeted(this);
+
+    // offer the event to the rules that can match it until one does
+    switch (myEvent.getType()) {
+    case EventType::PRIMARY_SCREEN_HOTKEY_DOWN:
+    case EventType::PRIMARY_SCREEN_HOTKEY_UP: {
+        const auto& kinfo = myEvent.get_data_as<IPlatformScreen::HotKeyInfo>();
+        auto i = m_hotKeyRules.find(kinfo.m_id);
+        if (i != m_hotKeyRules.end() && m_ruleList[i->second].handle_event(m_events, myEvent)) {
+            return;
+        }
+        break;
+    }
 
-    // let each rule try to match the event until one does
-    for (auto rule = m_ruleList.begin(); rule != m_ruleList.end(); ++rule) {
-        if (rule->handle_event(m_events, myEvent)) {
-            // handled
+    case EventType::PRIMARY_SCREEN_BUTTON_DOWN:
+    case EventType::PRIMARY_SCREEN_BUTTON_UP: {
+        const auto& minfo = myEvent.get_data_as<IPlatformScreen::ButtonInfo>();
+        auto i = m_buttonRules.find(button_index_key(minfo.m_button,
+                                                     minfo.m_mask & ~s_buttonIgnoreMask));
+        if (i != m_buttonRules.end() && m_ruleList[i->second].handle_event(m_events, myEvent)) {
             return;
         }
+        break;
+    }
+
+    default:
+        for (std::size_t rule : m_otherRules) {
+            if (m_ruleList[rule].handle_event(m_events, myEvent)) {
+                return;
+            }
+        }
+        break;
     }
 
     // not handled so pass through
-    m_events->add_event(std::move(myEvent));
+    m_events->dispatchEvent(myEvent);
+}
+
+void InputFilter::rebuild_index()
+{
+    m_hotKeyRules.clear();
+    m_buttonRules.clear();
+    m_otherRules.clear();
+    for (std::size_t rule = 0; rule != m_ruleList.size(); ++rule) {
+        index_rule(rule);
+    }
+}
+
+void InputFilter::index_rule(std::size_t rule)
+{
+    const Condition* condition = m_ruleList[rule].getCondition();
+    if (condition == nullptr) {
+        // never matches
+        return;
+    }
+
+    if (auto keystroke = dynamic_cast<const KeystrokeCondition*>(condition)) {
+        // only hot keys registered with the primary client can match
+        if (keystroke->getID() != 0) {
+            m_hotKeyRules.emplace(keystroke->getID(), rule);
+        }
+    }
+    else if (auto button = dynamic_cast<const MouseButtonCondition*>(condition)) {
+        m_buttonRules.emplace(button_index_key(button->getButton(), button->getMask()), rule);
+    }
+    else {
+        m_otherRules.push_back(rule);
+    }
+}
+
+std::uint64_t InputFilter::button_index_key(ButtonID button, KeyModifierMask mask)
+{
+    return (static_cast<std::uint64_t>(mask) << 32) | button;
 }
 
 
@@ -27,6 +27,7 @@
 
 #include <map>
 #include <set>
+#include <unordered_map>
 
 namespace inputleap {
 
@@ -67,6 +68,9 @@ public:
         KeyID getKey() const;
         KeyModifierMask getMask() const;
 
+        // the id of the hot key while enabled, zero otherwise
+        std::uint32_t getID() const;
+
         // Condition overrides
         Condition* clone() const override;
         std::string format() const override;
@@ -336,8 +340,24 @@ private:
     // event handling
     void handle_event(const Event&);
 
+    // rules are indexed by the events their condition can match so
+    // an event is only offered to the rule that can match it.  the
+    // first rule wins if several have the same key.
+    void rebuild_index();
+    void index_rule(std::size_t rule);
+    static std::uint64_t button_index_key(ButtonID button, KeyModifierMask mask);
+
 private:
     RuleList m_ruleList;
+
+    // hot key id to rule index
+    std::unordered_map<std::uint32_t, std::size_t> m_hotKeyRules;
+
+    // mouse button and modifiers to rule index
+    std::unordered_map<std::uint64_t, std::size_t> m_buttonRules;
+
+    // indices of rules with other conditions, in order
+    std::vector<std::size_t> m_otherRules;
     PrimaryClient* m_primaryClient;
     IEventQueue* m_events;
 };
@@ -0,0 +1,168 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "server/ScreenTopology.h"
+
+#include "server/Config.h"
+#include "base/Log.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace inputleap {
+
+void ScreenTopology::rebuild(const Config& config,
+                             const std::map<std::string, BaseClientProxy*>& clients)
+{
+    m_screens.clear();
+    m_names.clear();
+    m_clients.clear();
+
+    for (auto i = config.begin(); i != config.end(); ++i) {
+        m_names[*i] = m_screens.size();
+        m_screens.emplace_back();
+        m_screens.back().m_name = *i;
+    }
+
+    for (auto& screen : m_screens) {
+        for (auto i = config.beginNeighbor(screen.m_name);
+                i != config.endNeighbor(screen.m_name); ++i) {
+            const Config::CellEdge& src = i->first;
+            const Config::CellEdge& dst = i->second;
+            std::size_t side = src.getSide() - kFirstDirection;
+            screen.m_hasLinks[side] = true;
+
+            // a link to a screen that doesn't exist leads nowhere, as
+            // with Config::getNeighbor()
+            auto dstIndex = m_names.find(config.getCanonicalName(dst.getName()));
+            if (dstIndex == m_names.end()) {
+                continue;
+            }
+
+            // the config keeps links sorted by side and start, so
+            // each side's links end up sorted by start
+            Link link;
+            link.m_start = src.getInterval().first;
+            link.m_end = src.getInterval().second;
+            link.m_screen = dstIndex->second;
+            link.m_screenStart = dst.getInterval().first;
+            link.m_screenEnd = dst.getInterval().second;
+            screen.m_links[side].push_back(link);
+        }
+    }
+
+    for (const auto& client : clients) {
+        auto index = m_names.find(client.first);
+        if (index != m_names.end()) {
+            Screen& screen = m_screens[index->second];
+            screen.m_connected = true;
+            screen.m_client = client.second;
+            m_clients[client.second] = index->second;
+        }
+    }
+}
+
+std::size_t ScreenTopology::find(const std::string& name) const
+{
+    auto index = m_names.find(name);
+    return index == m_names.end() ? kNoScreen : index->second;
+}
+
+std::size_t ScreenTopology::find(const BaseClientProxy* client) const
+{
+    auto index = m_clients.find(client);
+    return index == m_clients.end() ? kNoScreen : index->second;
+}
+
+const std::string& ScreenTopology::getName(std::size_t screen) const
+{
+    assert(screen < m_screens.size());
+    return m_screens[screen].m_name;
+}
+
+BaseClientProxy* ScreenTopology::getClient(std::size_t screen) const
+{
+    assert(screen < m_screens.size());
+    return m_screens[screen].m_client;
+}
+
+std::size_t ScreenTopology::getNeighbor(std::size_t screen, EDirection side, float position,
+                                        float& positionOut) const
+{
+    // a path through unconnected screens visits each screen at most
+    // once before reaching a connected one.  going around more often
+    // means it's a loop of unconnected screens.
+    for (std::size_t steps = 0; steps < m_screens.size(); ++steps) {
+        const Link* link = findLink(screen, side, position);
+        if (link == nullptr) {
+            return kNoScreen;
+        }
+
+        // same arithmetic as Config::CellEdge::transform() and
+        // inverseTransform()
+        float t = (position - link->m_start) / (link->m_end - link->m_start);
+        position = t * (link->m_screenEnd - link->m_screenStart) + link->m_screenStart;
+
+        if (m_screens[link->m_screen].m_connected) {
+            positionOut = position;
+            return link->m_screen;
+        }
+
+        LOG_DEBUG2("ignored \"%s\" on %s of \"%s\"", m_screens[link->m_screen].m_name.c_str(),
+                   Config::dirName(side), m_screens[screen].m_name.c_str());
+        screen = link->m_screen;
+    }
+    return kNoScreen;
+}
+
+bool ScreenTopology::hasNeighbor(std::size_t screen, EDirection side) const
+{
+    assert(side >= kFirstDirection && side <= kLastDirection);
+    if (screen >= m_screens.size()) {
+        return false;
+    }
+    return m_screens[screen].m_hasLinks[side - kFirstDirection];
+}
+
+bool ScreenTopology::hasNeighbor(std::size_t screen, EDirection side, float position) const
+{
+    return findLink(screen, side, position) != nullptr;
+}
+
+const ScreenTopology::Link* ScreenTopology::findLink(std::size_t screen, EDirection side,
+                                                     float position) const
+{
+    assert(side >= kFirstDirection && side <= kLastDirection);
+    if (screen >= m_screens.size()) {
+        return nullptr;
+    }
+
+    // the last link starting at or before the position
+    const std::vector<Link>& links = m_screens[screen].m_links[side - kFirstDirection];
+    auto i = std::upper_bound(links.begin(), links.end(), position,
+                              [](float x, const Link& link) { return x < link.m_start; });
+    if (i == links.begin()) {
+        return nullptr;
+    }
+    --i;
+    if (position >= i->m_start && position < i->m_end) {
+        return &*i;
+    }
+    return nullptr;
+}
+
+} // namespace inputleap
@@ -0,0 +1,125 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "inputleap/protocol_types.h"
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace inputleap {
+
+class BaseClientProxy;
+class Config;
+
+//! Index of the links between screens
+/*!
+A copy of the links of a Config that can be searched without comparing
+screen names.  Screens are numbered and each side of a screen holds its
+links sorted by position, each naming the destination by number.  The
+index also knows which screens are connected, so it must be rebuilt
+when the configuration changes or a client connects or disconnects.
+*/
+class ScreenTopology {
+public:
+    //! Number returned for no screen
+    static constexpr std::size_t kNoScreen = static_cast<std::size_t>(-1);
+
+    //! @name manipulators
+    //@{
+
+    //! Index a configuration
+    /*!
+    Replaces the index with the links of \p config.  \p clients are the
+    connected screens by canonical name.
+    */
+    void rebuild(const Config& config, const std::map<std::string, BaseClientProxy*>& clients);
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Get the number of a screen by canonical name
+    std::size_t find(const std::string& name) const;
+
+    //! Get the number of a connected screen
+    std::size_t find(const BaseClientProxy* client) const;
+
+    //! Get the canonical name of a screen
+    const std::string& getName(std::size_t screen) const;
+
+    //! Get the client of a screen, nullptr if it's not connected
+    BaseClientProxy* getClient(std::size_t screen) const;
+
+    //! Find the closest connected neighbor
+    /*!
+    Returns the connected screen at \p position (in [0,1) along the
+    side) on side \p side of \p screen, skipping over screens that
+    aren't connected, and sets \p positionOut to the position on that
+    screen.  Returns kNoScreen if there is none.  This gives the same
+    result as repeating Config::getNeighbor() until it names a connected
+    screen.
+    */
+    std::size_t getNeighbor(std::size_t screen, EDirection side, float position,
+                            float& positionOut) const;
+
+    //! Check for any neighbor on a side
+    /*!
+    Returns true if \p side of \p screen links to any screen, connected
+    or not.  The same as Config::hasNeighbor().
+    */
+    bool hasNeighbor(std::size_t screen, EDirection side) const;
+
+    //! Check for a neighbor at a position
+    /*!
+    Returns true if \p side of \p screen links to a screen, connected or
+    not, at \p position.
+    */
+    bool hasNeighbor(std::size_t screen, EDirection side, float position) const;
+
+    //@}
+
+private:
+    struct Link {
+        float m_start;
+        float m_end;
+        std::size_t m_screen;
+        float m_screenStart;
+        float m_screenEnd;
+    };
+
+    struct Screen {
+        std::string m_name;
+        BaseClientProxy* m_client = nullptr;
+        bool m_connected = false;
+        bool m_hasLinks[kNumDirections] = {};
+        std::vector<Link> m_links[kNumDirections];
+    };
+
+    const Link* findLink(std::size_t screen, EDirection side, float position) const;
+
+private:
+    std::vector<Screen> m_screens;
+    std::map<std::string, std::size_t> m_names;
+    std::unordered_map<const BaseClientProxy*, std::size_t> m_clients;
+};
+
+} // namespace inputleap
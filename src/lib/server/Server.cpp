@@ -114,7 +114,7 @@ Server::Server(
 			clipboard.m_clipboard.clear();
 			clipboard.m_clipboard.close();
 		}
-		clipboard.m_clipboardData   = clipboard.m_clipboard.marshall();
+		clipboard.m_clipboardDigest = clipboard.m_clipboard.digest();
 	}
 
     // install event handlers
@@ -239,6 +239,7 @@ Server::setConfig(const Config& config)
 
 	// cut over
 	processOptions();
+	updateTopology();
 
 	// add ScrollLock as a hotkey to lock to the screen.  this was a
 	// built-in feature in earlier releases and is now supported via
@@ -460,7 +461,7 @@ void Server::switchScreen(BaseClientProxy* dst, std::int32_t x, std::int32_t y,
 			// send the clipboard data to new active screen
 			for (ClipboardID id = 0; id < kClipboardEnd; ++id) {
 				// Hackity hackity hack
-				if (m_clipboards[id].m_clipboard.marshall().size() > m_maximumClipboardSize) {
+				if (m_clipboards[id].m_clipboard.marshalled_size() > m_maximumClipboardSize) {
 					continue;
 				}
 				m_active->setClipboard(id, &m_clipboards[id].m_clipboard);
@@ -538,12 +539,18 @@ void Server::mapToPixel(BaseClientProxy* client, EDirection dir, float f, std::i
 	}
 }
 
+void
+Server::updateTopology()
+{
+	m_topology.rebuild(*m_config, m_clients);
+}
+
 bool
 Server::hasAnyNeighbor(BaseClientProxy* client, EDirection dir) const
 {
 	assert(client != nullptr);
 
-	return m_config->hasNeighbor(getName(client), dir);
+	return m_topology.hasNeighbor(m_topology.find(client), dir);
 }
 
 BaseClientProxy* Server::getNeighbor(BaseClientProxy* src, EDirection dir, std::int32_t& x,
@@ -553,44 +560,31 @@ BaseClientProxy* Server::getNeighbor(BaseClientProxy* src, EDirection dir, std::
 
 	assert(src != nullptr);
 
-	// get source screen name
-    std::string srcName = getName(src);
-	assert(!srcName.empty());
-	LOG_DEBUG2("find neighbor on %s of \"%s\"", Config::dirName(dir), srcName.c_str());
+	std::size_t srcScreen = m_topology.find(src);
+	if (srcScreen == ScreenTopology::kNoScreen) {
+		return nullptr;
+	}
+	LOG_DEBUG2("find neighbor on %s of \"%s\"", Config::dirName(dir),
+	           m_topology.getName(srcScreen).c_str());
 
 	// convert position to fraction
 	float t = mapToFraction(src, dir, x, y);
 
-	// search for the closest neighbor that exists in direction dir
-	float tTmp;
-	for (;;) {
-        std::string dstName(m_config->getNeighbor(srcName, dir, t, &tTmp));
-
-		// if nothing in that direction then return nullptr. if the
-		// destination is the source then we can make no more
-		// progress in this direction.  since we haven't found a
-		// connected neighbor we return nullptr.
-		if (dstName.empty()) {
-			LOG_DEBUG2("no neighbor on %s of \"%s\"", Config::dirName(dir), srcName.c_str());
-			return nullptr;
-		}
-
-		// look up neighbor cell.  if the screen is connected and
-		// ready then we can stop.
-        auto index = m_clients.find(dstName);
-		if (index != m_clients.end()) {
-			LOG_DEBUG2("\"%s\" is on %s of \"%s\" at %f", dstName.c_str(), Config::dirName(dir), srcName.c_str(), t);
-			mapToPixel(index->second, dir, tTmp, x, y);
-			return index->second;
-		}
-
-		// skip over unconnected screen
-		LOG_DEBUG2("ignored \"%s\" on %s of \"%s\"", dstName.c_str(), Config::dirName(dir), srcName.c_str());
-		srcName = dstName;
-
-		// use position on skipped screen
-		t = tTmp;
+	// find the closest neighbor that exists in direction dir, skipping
+	// over unconnected screens
+	float tDst;
+	std::size_t dstScreen = m_topology.getNeighbor(srcScreen, dir, t, tDst);
+	if (dstScreen == ScreenTopology::kNoScreen) {
+		LOG_DEBUG2("no neighbor on %s of \"%s\"", Config::dirName(dir),
+		           m_topology.getName(srcScreen).c_str());
+		return nullptr;
 	}
+
+	BaseClientProxy* dst = m_topology.getClient(dstScreen);
+	LOG_DEBUG2("\"%s\" is on %s of \"%s\" at %f", m_topology.getName(dstScreen).c_str(),
+	           Config::dirName(dir), m_topology.getName(srcScreen).c_str(), t);
+	mapToPixel(dst, dir, tDst, x, y);
+	return dst;
 }
 
 BaseClientProxy* Server::mapToNeighbor(BaseClientProxy* src, EDirection srcSide, std::int32_t& x,
@@ -709,7 +703,7 @@ void Server::avoidJumpZone(BaseClientProxy* dst, EDirection dir, std::int32_t& x
 		return;
 	}
 
-    const std::string dstName(getName(dst));
+	std::size_t dstScreen = m_topology.find(dst);
 	std::int32_t dx, dy, dw, dh;
 	dst->getShape(dx, dy, dw, dh);
 	float t = mapToFraction(dst, dir, x, y);
@@ -720,25 +714,25 @@ void Server::avoidJumpZone(BaseClientProxy* dst, EDirection dir, std::int32_t& x
 	// don't need to move inwards because that side can't provoke a jump.
 	switch (dir) {
 	case kLeft:
-		if (!m_config->getNeighbor(dstName, kRight, t, nullptr).empty() &&
+		if (m_topology.hasNeighbor(dstScreen, kRight, t) &&
 			x > dx + dw - 1 - z)
 			x = dx + dw - 1 - z;
 		break;
 
 	case kRight:
-		if (!m_config->getNeighbor(dstName, kLeft, t, nullptr).empty() &&
+		if (m_topology.hasNeighbor(dstScreen, kLeft, t) &&
 			x < dx + z)
 			x = dx + z;
 		break;
 
 	case kTop:
-		if (!m_config->getNeighbor(dstName, kBottom, t, nullptr).empty() &&
+		if (m_topology.hasNeighbor(dstScreen, kBottom, t) &&
 			y > dy + dh - 1 - z)
 			y = dy + dh - 1 - z;
 		break;
 
 	case kBottom:
-		if (!m_config->getNeighbor(dstName, kTop, t, nullptr).empty() &&
+		if (m_topology.hasNeighbor(dstScreen, kTop, t) &&
 			y < dy + z)
 			y = dy + z;
 		break;
@@ -1202,7 +1196,7 @@ void Server::handle_clipboard_grabbed(const Event& event, BaseClientProxy* grabb
 		clipboard.m_clipboard.clear();
 		clipboard.m_clipboard.close();
 	}
-	clipboard.m_clipboardData = clipboard.m_clipboard.marshall();
+	clipboard.m_clipboardDigest = clipboard.m_clipboard.digest();
 
 	// tell all other screens to take ownership of clipboard.  tell the
 	// grabber that it's clipboard isn't dirty.
@@ -1471,20 +1465,20 @@ void Server::onClipboardChanged(BaseClientProxy* sender, ClipboardID id, std::ui
 	}
 
 	// ignore if data hasn't changed
-    std::string data = clipboard.m_clipboard.marshall();
-	if (data.size() > m_maximumClipboardSize) {
+	if (clipboard.m_clipboard.marshalled_size() > m_maximumClipboardSize) {
 		LOG_NOTE("not updating clipboard because it's over the size limit (%zi KB) configured by the server",
 			m_maximumClipboardSize);
 		return;
 	}
-	if (data == clipboard.m_clipboardData) {
+	Clipboard::Digest digest = clipboard.m_clipboard.digest();
+	if (digest == clipboard.m_clipboardDigest) {
 		LOG_DEBUG("ignored screen \"%s\" update of clipboard %d (unchanged)", clipboard.m_clipboardOwner.c_str(), id);
 		return;
 	}
 
 	// got new data
 	LOG_INFO("screen \"%s\" updated clipboard %d", clipboard.m_clipboardOwner.c_str(), id);
-	clipboard.m_clipboardData = data;
+	clipboard.m_clipboardDigest = digest;
 
 	// tell all clients except the sender that the clipboard is dirty
     for (auto index = m_clients.begin(); index != m_clients.end(); ++index) {
@@ -2010,11 +2004,17 @@ void
 Server::onFileReceiveCompleted()
 {
 	if (isReceivedFileSizeValid()) {
-        m_writeToDropDirThread = new Thread([this]() { write_to_drop_dir_thread(); });
+        // the file now belongs to the thread;  another transfer may start
+        // while it waits for the drop
+        fs::path received = m_receivedFile.release();
+        m_writeToDropDirThread = new Thread([this, received]()
+        {
+            write_to_drop_dir_thread(received);
+        });
 	}
 }
 
-void Server::write_to_drop_dir_thread()
+void Server::write_to_drop_dir_thread(const fs::path& received)
 {
 	LOG_DEBUG("starting write to drop dir thread");
 
@@ -2022,8 +2022,7 @@ void Server::write_to_drop_dir_thread()
 		inputleap::this_thread_sleep(.1f);
 	}
 
-	DropHelper::writeToDir(m_screen->getDropTarget(), m_fakeDragFileList,
-					m_receivedFileData);
+	DropHelper::writeToDir(m_screen->getDropTarget(), m_fakeDragFileList, received);
 }
 
 bool
@@ -2045,6 +2044,7 @@ Server::addClient(BaseClientProxy* client)
 	// add to list
 	m_clientSet.insert(client);
 	m_clients.insert(std::make_pair(name, client));
+	updateTopology();
 
 	// initialize client data
 	std::int32_t x, y;
@@ -2074,6 +2074,7 @@ Server::removeClient(BaseClientProxy* client)
 	// remove from list
 	m_clients.erase(getName(client));
 	m_clientSet.erase(i);
+	updateTopology();
 
 	return true;
 }
@@ -2217,7 +2218,7 @@ Server::forceLeaveClient(BaseClientProxy* client)
 
 Server::ClipboardInfo::ClipboardInfo() :
 	m_clipboard(),
-	m_clipboardData(),
+	m_clipboardDigest(),
 	m_clipboardOwner(),
 	m_clipboardSeqNum(0)
 {
@@ -2227,7 +2228,7 @@ Server::ClipboardInfo::ClipboardInfo() :
 bool
 Server::isReceivedFileSizeValid()
 {
-	return m_expectedFileSize == m_receivedFileData.size();
+	return m_receivedFile.is_complete();
 }
 
 void
@@ -2262,6 +2263,10 @@ void Server::dragInfoReceived(std::uint32_t fileNum, std::string content)
 
 	DragInformation::parseDragInfo(m_fakeDragFileList, fileNum, content);
 
+	// the file follows the drag information.  write it where it will be
+	// dropped.
+	m_receivedFile.set_directory(fs::u8path(m_screen->getDropTarget()));
+
 	m_screen->startDraggingFiles(m_fakeDragFileList);
 }
 
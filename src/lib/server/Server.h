@@ -19,6 +19,7 @@
 #pragma once
 
 #include "server/Config.h"
+#include "server/ScreenTopology.h"
 #include "inputleap/clipboard_types.h"
 #include "inputleap/Clipboard.h"
 #include "inputleap/key_types.h"
@@ -26,6 +27,7 @@
 #include "inputleap/Fwd.h"
 #include "inputleap/INode.h"
 #include "inputleap/DragInformation.h"
+#include "inputleap/IncomingFile.h"
 #include "inputleap/ServerArgs.h"
 #include "base/Fwd.h"
 #include "base/Event.h"
@@ -176,11 +178,8 @@ public:
     //! Return true if received file size is valid
     bool isReceivedFileSizeValid();
 
-    //! Return expected file data size
-    size_t& getExpectedFileSize() { return m_expectedFileSize; }
-
-    //! Return received file data
-    std::string& getReceivedFileData() { return m_receivedFileData; }
+    //! Return the file being received
+    IncomingFile& getReceivedFile() { return m_receivedFile; }
 
     //! Return fake drag file list
     DragFileList getFakeDragFileList() { return m_fakeDragFileList; }
@@ -220,6 +219,10 @@ private:
     // on the direction.
     void mapToPixel(BaseClientProxy*, EDirection, float f, std::int32_t& x, std::int32_t& y) const;
 
+    // rebuild m_topology after a change to the configuration or the
+    // connected clients
+    void updateTopology();
+
     // returns true if the client has a neighbor anywhere along the edge
     // indicated by the direction.
     bool hasAnyNeighbor(BaseClientProxy*, EDirection) const;
@@ -362,7 +365,7 @@ private:
     void send_file_thread(const char* filename);
 
     // thread function for writing file to drop directory
-    void write_to_drop_dir_thread();
+    void write_to_drop_dir_thread(const fs::path& received);
 
     // thread function for sending drag information
     void send_drag_info_thread(BaseClientProxy* newScreen);
@@ -380,7 +383,7 @@ private:
 
     public:
         Clipboard m_clipboard;
-        std::string m_clipboardData;
+        Clipboard::Digest m_clipboardDigest;
         std::string m_clipboardOwner;
         std::uint32_t m_clipboardSeqNum;
     };
@@ -418,6 +421,9 @@ private:
     // current configuration
     Config* m_config;
 
+    // links between screens (from m_config and m_clients)
+    ScreenTopology m_topology;
+
     // input filter (from m_config);
     InputFilter input_filter_;
 
@@ -467,8 +473,7 @@ private:
     IEventQueue* m_events;
 
     // file transfer
-    size_t m_expectedFileSize;
-    std::string m_receivedFileData;
+    IncomingFile m_receivedFile;
     DragFileList m_dragFileList;
     DragFileList m_fakeDragFileList;
     Thread* m_sendFileThread;
@@ -0,0 +1,152 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "inputleap/ClipboardChunk.h"
+#include "inputleap/ClipboardStream.h"
+#include "inputleap/PacketStreamFilter.h"
+#include "inputleap/ProtocolUtil.h"
+#include "inputleap/protocol_types.h"
+#include "net/NetworkAddress.h"
+#include "net/SocketMultiplexer.h"
+#include "net/TCPListenSocket.h"
+#include "net/TCPSocket.h"
+#include "base/Log.h"
+#include "test/global/TestEventQueue.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+#if SYSAPI_UNIX
+#include <unistd.h>
+#endif
+
+namespace inputleap {
+
+#define TEST_PORT 24806
+#define TEST_HOST "127.0.0.1"
+
+namespace {
+
+// current resident set size in bytes, or 0 if unknown
+std::size_t residentSize()
+{
+#if defined(__linux__)
+    std::FILE* file = std::fopen("/proc/self/statm", "r");
+    if (file == nullptr) {
+        return 0;
+    }
+    unsigned long size = 0;
+    unsigned long resident = 0;
+    int n = std::fscanf(file, "%lu %lu", &size, &resident);
+    std::fclose(file);
+    return n == 2 ? resident * static_cast<std::size_t>(sysconf(_SC_PAGESIZE)) : 0;
+#else
+    return 0;
+#endif
+}
+
+} // namespace
+
+// sends a 100 MB clipboard over loopback and reports the peak memory
+// growth.  the sender and the receiver each hold one copy of it, so
+// anything beyond two copies is buffering in the transfer itself.
+TEST(ClipboardTransferTests, DISABLED_benchmark_largeClipboard_peakMemory)
+{
+    const std::size_t kSize = 100 * 1024 * 1024;
+
+    if (residentSize() == 0) {
+        GTEST_SKIP() << "resident set size is not available";
+    }
+
+    TestEventQueue events;
+    SocketMultiplexer multiplexer;
+
+    NetworkAddress address(TEST_HOST, TEST_PORT);
+    address.resolve();
+    TCPListenSocket listener(&events, &multiplexer, IArchNetwork::kINET);
+    listener.bind(address);
+
+    auto client = std::make_unique<TCPSocket>(&events, &multiplexer, IArchNetwork::kINET);
+    client->connect(address);
+    PacketStreamFilter sender(&events, std::move(client));
+
+    std::unique_ptr<PacketStreamFilter> receiver;
+    std::string received;
+    std::size_t baseline = residentSize();
+    std::size_t peak = baseline;
+    bool finished = false;
+
+    auto receive = [&]() {
+        while (receiver->isReady()) {
+            std::uint8_t code[4];
+            receiver->read(code, 4);
+            ClipboardID id;
+            std::uint32_t sequence;
+            int result = ClipboardChunk::assemble(receiver.get(), received, id, sequence);
+            ASSERT_NE(kError, result);
+            if (result == kFinish) {
+                peak = std::max(peak, residentSize());
+                finished = true;
+                events.raiseQuitEvent();
+                return;
+            }
+        }
+    };
+
+    events.add_handler(EventType::LISTEN_SOCKET_CONNECTING, &listener, [&](const auto&) {
+        receiver = std::make_unique<PacketStreamFilter>(&events, listener.accept());
+        events.add_handler(EventType::STREAM_INPUT_READY, receiver->get_event_target(),
+                           [&](const auto&) { receive(); });
+    });
+
+    ClipboardStream stream;
+    auto pump = [&]() {
+        stream.pump([&](const ClipboardChunk& chunk) {
+            ProtocolUtil::writef(&sender, kMsgDClipboardSlice, chunk.id_, chunk.sequence_,
+                                 chunk.mark_, static_cast<std::uint32_t>(chunk.size_),
+                                 reinterpret_cast<const std::uint8_t*>(chunk.bytes()));
+        }, sender.getOutputSize());
+        peak = std::max(peak, residentSize());
+    };
+    events.add_handler(EventType::STREAM_OUTPUT_FLUSHED, sender.get_event_target(),
+                       [&](const auto&) { pump(); });
+
+    stream.push(kClipboardClipboard, 0, std::make_shared<const std::string>(kSize, 'x'));
+    pump();
+
+    events.initQuitTimeout(60);
+    events.loop();
+    events.cleanupQuitTimeout();
+
+    events.remove_handler(EventType::LISTEN_SOCKET_CONNECTING, &listener);
+    events.remove_handler(EventType::STREAM_OUTPUT_FLUSHED, sender.get_event_target());
+    if (receiver) {
+        events.remove_handler(EventType::STREAM_INPUT_READY, receiver->get_event_target());
+    }
+
+    ASSERT_TRUE(finished);
+    EXPECT_EQ(kSize, received.size());
+
+    double growth = static_cast<double>(peak - baseline) / kSize;
+    LOG_PRINT("100 MB clipboard: peak memory growth %.2fx the clipboard size", growth);
+    EXPECT_LT(growth, 2.25);
+}
+
+} // namespace inputleap
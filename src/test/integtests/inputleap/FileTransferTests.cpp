@@ -0,0 +1,359 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "inputleap/FileChunk.h"
+#include "inputleap/FileTransferStream.h"
+#include "inputleap/IncomingFile.h"
+#include "inputleap/PacketStreamFilter.h"
+#include "inputleap/ProtocolUtil.h"
+#include "inputleap/StreamChunker.h"
+#include "inputleap/protocol_types.h"
+#include "net/NetworkAddress.h"
+#include "net/SocketMultiplexer.h"
+#include "net/TCPListenSocket.h"
+#include "net/TCPSocket.h"
+#include "mt/Thread.h"
+#include "arch/Arch.h"
+#include "base/EventQueueTimer.h"
+#include "base/Log.h"
+#include "test/global/TestEventQueue.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if SYSAPI_UNIX
+#include <unistd.h>
+#endif
+
+namespace inputleap {
+
+#define TEST_PORT 24807
+#define TEST_HOST "127.0.0.1"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+    std::vector<double> latencies;
+    double seconds = 0;
+    std::size_t received = 0;
+    bool finished = false;
+
+    double percentile(double p) const
+    {
+        if (latencies.empty()) {
+            return 0;
+        }
+        std::size_t index = static_cast<std::size_t>(p * (latencies.size() - 1));
+        return latencies[index];
+    }
+};
+
+// current resident set size in bytes, or 0 if unknown
+std::size_t residentSize()
+{
+#if defined(__linux__)
+    std::FILE* file = std::fopen("/proc/self/statm", "r");
+    if (file == nullptr) {
+        return 0;
+    }
+    unsigned long size = 0;
+    unsigned long resident = 0;
+    int n = std::fscanf(file, "%lu %lu", &size, &resident);
+    std::fclose(file);
+    return n == 2 ? resident * static_cast<std::size_t>(sysconf(_SC_PAGESIZE)) : 0;
+#else
+    return 0;
+#endif
+}
+
+std::uint32_t read_u32(const std::uint8_t* p)
+{
+    return (std::uint32_t(p[0]) << 24) | (std::uint32_t(p[1]) << 16) |
+           (std::uint32_t(p[2]) << 8) | std::uint32_t(p[3]);
+}
+
+// sends a file of the given size over loopback while moving the mouse
+// every couple of milliseconds, and measures how long each mouse move
+// takes to arrive.  the receiving end reads packets on its own thread,
+// throttled to the given rate to stand in for a link slower than the
+// sender.  if paced is false all file chunks are written to the
+// connection at once, as they were before file transfers had their own
+// lane.
+Result transfer_file(std::size_t size, double bytesPerSecond, bool paced, int port)
+{
+    const std::size_t kChunkSize = 32 * 1024;
+
+    TestEventQueue events;
+    SocketMultiplexer multiplexer;
+
+    NetworkAddress address(TEST_HOST, port);
+    address.resolve();
+    ArchSocket listener = ARCH->newSocket(IArchNetwork::kINET, IArchNetwork::kSTREAM);
+    ARCH->setReuseAddrOnSocket(listener, true);
+    ARCH->bindSocket(listener, address.getAddress());
+    ARCH->listenOnSocket(listener);
+
+    auto client = std::make_unique<TCPSocket>(&events, &multiplexer, IArchNetwork::kINET);
+    client->connect(address);
+    PacketStreamFilter sender(&events, std::move(client));
+
+    Result result;
+    std::mutex mutex;
+    std::deque<Clock::time_point> moves;
+
+    Thread receiver([&]() {
+        ArchSocket socket = nullptr;
+        while (socket == nullptr) {
+            IArchNetwork::PollEntry pe{listener, IArchNetwork::kPOLLIN, 0};
+            ARCH->pollSocket(&pe, 1, 1.0);
+            socket = ARCH->acceptSocket(listener, nullptr);
+        }
+
+        // keep reading after the file until the mouse moves sent during
+        // the transfer have arrived
+        auto waiting = [&]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return !result.finished || !moves.empty();
+        };
+
+        std::vector<std::uint8_t> buffer;
+        std::size_t start = 0;
+        std::size_t total = 0;
+        auto begin = Clock::now();
+        while (waiting()) {
+            IArchNetwork::PollEntry pe{socket, IArchNetwork::kPOLLIN, 0};
+            ARCH->pollSocket(&pe, 1, 1.0);
+            std::uint8_t data[64 * 1024];
+            std::size_t n = ARCH->readSocket(socket, data, sizeof(data));
+            buffer.insert(buffer.end(), data, data + n);
+
+            total += n;
+            std::this_thread::sleep_until(begin + std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double>(total / bytesPerSecond)));
+
+            // each packet is a 4 byte size followed by the message
+            while (buffer.size() - start >= 8 &&
+                   buffer.size() - start >= 4 + read_u32(&buffer[start])) {
+                const std::uint8_t* message = &buffer[start + 4];
+                start += 4 + read_u32(&buffer[start]);
+                std::lock_guard<std::mutex> lock(mutex);
+                if (std::memcmp(message, kMsgDMouseMove, 4) == 0) {
+                    std::chrono::duration<double, std::milli> latency =
+                            Clock::now() - moves.front();
+                    result.latencies.push_back(latency.count());
+                    moves.pop_front();
+                }
+                else if (message[4] == kDataChunk) {
+                    result.received += read_u32(message + 5);
+                }
+                else if (message[4] == kDataEnd) {
+                    result.finished = true;
+                    events.raiseQuitEvent();
+                }
+            }
+            buffer.erase(buffer.begin(), buffer.begin() + start);
+            start = 0;
+        }
+        ARCH->closeSocket(socket);
+    });
+
+    FileTransferStream stream;
+    auto write = [&](const FileChunk& chunk) {
+        ProtocolUtil::writef(&sender, kMsgDFileTransfer, chunk.mark_, &chunk.data_);
+    };
+    events.add_handler(EventType::STREAM_OUTPUT_FLUSHED, sender.get_event_target(),
+                       [&](const auto&) { stream.pump(write, sender.getOutputSize()); });
+
+    EventQueueTimer* timer = events.newTimer(0.002, nullptr);
+    events.add_handler(EventType::TIMER, timer, [&](const auto&) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (result.finished) {
+            return;
+        }
+        moves.push_back(Clock::now());
+        ProtocolUtil::write_message<kMsgDMouseMove>(&sender, 100, 100);
+    });
+
+    std::string data(kChunkSize, 'x');
+    auto start = Clock::now();
+    stream.push(FileChunk::start(size));
+    for (std::size_t sent = 0; sent < size; sent += kChunkSize) {
+        stream.push(FileChunk::data(reinterpret_cast<std::uint8_t*>(&data[0]),
+                                    std::min(kChunkSize, size - sent)));
+    }
+    stream.push(FileChunk::end());
+    if (paced) {
+        stream.pump(write, sender.getOutputSize());
+    }
+    else {
+        while (!stream.empty()) {
+            stream.pump(write);
+        }
+    }
+
+    events.initQuitTimeout(120);
+    events.loop();
+    events.cleanupQuitTimeout();
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    result.seconds = elapsed.count();
+
+    receiver.wait();
+    ARCH->closeSocket(listener);
+    events.remove_handler(EventType::TIMER, timer);
+    events.deleteTimer(timer);
+    events.remove_handler(EventType::STREAM_OUTPUT_FLUSHED, sender.get_event_target());
+
+    std::sort(result.latencies.begin(), result.latencies.end());
+    return result;
+}
+
+} // namespace
+
+// mouse moves sent during a 200 MB file transfer over loopback, read at
+// 256 MB/s, should not wait behind the file data.
+TEST(FileTransferTests, DISABLED_benchmark_largeFile_mouseMoveLatency)
+{
+    const std::size_t kSize = 200 * 1024 * 1024;
+    const double kRate = 256.0 * 1024 * 1024;
+
+    Result unpaced = transfer_file(kSize, kRate, false, TEST_PORT);
+    Result paced = transfer_file(kSize, kRate, true, TEST_PORT + 1);
+    ASSERT_TRUE(unpaced.finished);
+    ASSERT_TRUE(paced.finished);
+    EXPECT_EQ(kSize, unpaced.received);
+    EXPECT_EQ(kSize, paced.received);
+
+    for (const auto* result : { &unpaced, &paced }) {
+        LOG_PRINT("200 MB file %s: %.2f s, %zu mouse moves, latency p50 %.2f ms "
+                  "p99 %.2f ms max %.2f ms",
+                  result == &paced ? "paced" : "unpaced", result->seconds,
+                  result->latencies.size(), result->percentile(0.5),
+                  result->percentile(0.99), result->percentile(1.0));
+    }
+}
+
+// sends a 64 MB file over loopback the way a dragged file is sent:  read
+// on its own thread, queued as events and written as the connection
+// drains, and received into a temporary file.  neither end should hold
+// more than a few windows' worth of the file in memory.
+TEST(FileTransferTests, largeFile_peakMemoryStaysBounded)
+{
+    const std::size_t kSize = 64 * 1024 * 1024;
+    const char* kFilename = "FileTransferTests.large";
+
+    if (residentSize() == 0) {
+        GTEST_SKIP() << "resident set size is not available";
+    }
+
+    // a sparse file is quick to create and to read
+    std::error_code error;
+    { std::ofstream create(kFilename, std::ios::binary); }
+    fs::resize_file(kFilename, kSize, error);
+    ASSERT_FALSE(error) << error.message();
+
+    TestEventQueue events;
+    SocketMultiplexer multiplexer;
+
+    NetworkAddress address(TEST_HOST, TEST_PORT + 2);
+    address.resolve();
+    TCPListenSocket listener(&events, &multiplexer, IArchNetwork::kINET);
+    listener.bind(address);
+
+    auto client = std::make_unique<TCPSocket>(&events, &multiplexer, IArchNetwork::kINET);
+    client->connect(address);
+    PacketStreamFilter sender(&events, std::move(client));
+
+    std::unique_ptr<PacketStreamFilter> receiver;
+    IncomingFile received;
+    std::size_t baseline = residentSize();
+    std::size_t peak = baseline;
+    bool finished = false;
+
+    auto receive = [&]() {
+        while (receiver->isReady()) {
+            std::uint8_t code[4];
+            receiver->read(code, 4);
+            int result = FileChunk::assemble(receiver.get(), received);
+            ASSERT_NE(kError, result);
+            if (result == kFinish) {
+                finished = true;
+                events.raiseQuitEvent();
+                return;
+            }
+        }
+    };
+
+    events.add_handler(EventType::LISTEN_SOCKET_CONNECTING, &listener, [&](const auto&) {
+        receiver = std::make_unique<PacketStreamFilter>(&events, listener.accept());
+        events.add_handler(EventType::STREAM_INPUT_READY, receiver->get_event_target(),
+                           [&](const auto&) { receive(); });
+    });
+
+    FileTransferStream stream;
+    auto pump = [&]() {
+        stream.pump([&](const FileChunk& chunk) {
+            ProtocolUtil::writef(&sender, kMsgDFileTransfer, chunk.mark_, &chunk.data_);
+        }, sender.getOutputSize());
+        peak = std::max(peak, residentSize());
+    };
+    events.add_handler(EventType::STREAM_OUTPUT_FLUSHED, sender.get_event_target(),
+                       [&](const auto&) { pump(); });
+
+    EventTarget target;
+    events.add_handler(EventType::FILE_CHUNK_SENDING, &target, [&](const auto& e) {
+        stream.push(e.template get_data_as<FileChunk>());
+        pump();
+    });
+
+    Thread reader([&]() { StreamChunker::sendFile(kFilename, &events, &target); });
+
+    events.initQuitTimeout(60);
+    events.loop();
+    events.cleanupQuitTimeout();
+
+    reader.wait();
+    events.remove_handler(EventType::FILE_CHUNK_SENDING, &target);
+    events.remove_handler(EventType::LISTEN_SOCKET_CONNECTING, &listener);
+    events.remove_handler(EventType::STREAM_OUTPUT_FLUSHED, sender.get_event_target());
+    if (receiver) {
+        events.remove_handler(EventType::STREAM_INPUT_READY, receiver->get_event_target());
+    }
+    fs::remove(kFilename, error);
+
+    ASSERT_TRUE(finished);
+    EXPECT_TRUE(received.is_complete());
+    EXPECT_EQ(kSize, received.received());
+
+    // the sender reads at most 1 MB ahead and the connection holds a
+    // window of data, so a fraction of the file is in memory at a time
+    double growth = static_cast<double>(peak - baseline) / (1024 * 1024);
+    EXPECT_LT(growth, 16);
+}
+
+} // namespace inputleap
@@ -0,0 +1,221 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "net/SecureSocket.h"
+#include "net/SecureUtils.h"
+#include "net/SocketMultiplexer.h"
+#include "net/TSocketMultiplexerMethodJob.h"
+#include "arch/Arch.h"
+#include "base/EventQueue.h"
+#include "io/filesystem.h"
+#include "mt/Thread.h"
+
+#if SYSAPI_WIN32
+#include "arch/win32/ArchNetworkWinsock.h"
+#elif SYSAPI_UNIX
+#include "arch/unix/ArchNetworkBSD.h"
+#endif
+
+#include <gtest/gtest.h>
+#include <openssl/ssl.h>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace inputleap {
+
+#define TEST_PORT 24805
+#define TEST_HOST "127.0.0.1"
+
+namespace {
+
+// a socket that only serves as the key for a job in the multiplexer
+class KeySocket : public ISocket {
+public:
+    void bind(const NetworkAddress&) override { }
+    void close() override { }
+    const EventTarget* get_event_target() const override { return nullptr; }
+};
+
+class SecureSocketTests : public ::testing::Test {
+public:
+    SecureSocketTests()
+    {
+        m_certPath = fs::temp_directory_path() / "SecureSocketTests.pem";
+        generate_pem_self_signed_cert(m_certPath.u8string());
+
+        m_addr = ARCH->nameToAddr(TEST_HOST);
+        ARCH->setAddrPort(m_addr, TEST_PORT);
+        m_listener = ARCH->newSocket(IArchNetwork::kINET, IArchNetwork::kSTREAM);
+        ARCH->setReuseAddrOnSocket(m_listener, true);
+        ARCH->bindSocket(m_listener, m_addr);
+        ARCH->listenOnSocket(m_listener);
+    }
+
+    ~SecureSocketTests() override
+    {
+        for (auto socket : m_sockets) {
+            ARCH->closeSocket(socket);
+        }
+        ARCH->closeSocket(m_listener);
+        ARCH->closeAddr(m_addr);
+        fs::remove(m_certPath);
+    }
+
+    // connects a new client socket and returns it along with the
+    // accepted server side socket
+    std::pair<ArchSocket, ArchSocket> connect()
+    {
+        ArchSocket client = ARCH->newSocket(IArchNetwork::kINET, IArchNetwork::kSTREAM);
+        ARCH->connectSocket(client, m_addr);
+        m_sockets.push_back(client);
+
+        ArchSocket server = nullptr;
+        while (server == nullptr) {
+            IArchNetwork::PollEntry pe{m_listener, IArchNetwork::kPOLLIN, 0};
+            ARCH->pollSocket(&pe, 1, 1.0);
+            server = ARCH->acceptSocket(m_listener, nullptr);
+        }
+        return std::make_pair(client, server);
+    }
+
+    void waitForReceived(size_t count)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        ASSERT_TRUE(m_cv.wait_for(lock, std::chrono::seconds(5),
+                                  [this, count]() { return m_received >= count; }));
+    }
+
+    fs::path m_certPath;
+    ArchNetAddress m_addr;
+    ArchSocket m_listener;
+    std::vector<ArchSocket> m_sockets;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    size_t m_received = 0;
+};
+
+} // namespace
+
+TEST_F(SecureSocketTests, secureAccept_handshakeCompletes)
+{
+    EventQueue events;
+    SocketMultiplexer multiplexer;
+
+    auto pair = connect();
+    auto secure = std::make_unique<SecureSocket>(&events, &multiplexer, pair.second,
+                                                 ConnectionSecurityLevel::ENCRYPTED);
+    secure->initSsl(true);
+    ASSERT_TRUE(secure->load_certificates(m_certPath));
+    secure->secureAccept();
+
+    // handshake from a plain openssl client on the non-blocking socket
+    bool connected = false;
+    // an inputleap thread since ARCH->pollSocket() needs one
+    Thread client([&connected, socket = pair.first]() {
+        SSL_CTX* context = SSL_CTX_new(TLS_client_method());
+        SSL* ssl = SSL_new(context);
+#if SYSAPI_WIN32
+        SSL_set_fd(ssl, static_cast<int>(socket->m_socket));
+#elif SYSAPI_UNIX
+        SSL_set_fd(ssl, socket->m_fd);
+#endif
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (std::chrono::steady_clock::now() < deadline) {
+            int r = SSL_connect(ssl);
+            if (r == 1) {
+                connected = true;
+                break;
+            }
+            int error = SSL_get_error(ssl, r);
+            if (error != SSL_ERROR_WANT_READ && error != SSL_ERROR_WANT_WRITE) {
+                break;
+            }
+            IArchNetwork::PollEntry pe{socket, error == SSL_ERROR_WANT_READ ?
+                                       IArchNetwork::kPOLLIN : IArchNetwork::kPOLLOUT, 0};
+            ARCH->pollSocket(&pe, 1, 0.1);
+        }
+        SSL_free(ssl);
+        SSL_CTX_free(context);
+    });
+    client.wait();
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!secure->isSecureReady() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    EXPECT_TRUE(connected);
+    EXPECT_TRUE(secure->isSecureReady());
+    secure.reset();
+}
+
+TEST_F(SecureSocketTests, stalledHandshake_otherSocketsKeepFlowing)
+{
+    const int kMessages = 200;
+
+    EventQueue events;
+    SocketMultiplexer multiplexer;
+
+    // a client that sends part of a tls record header and then stalls
+    auto stalled = connect();
+    auto secure = std::make_unique<SecureSocket>(&events, &multiplexer, stalled.second,
+                                                 ConnectionSecurityLevel::ENCRYPTED);
+    secure->initSsl(true);
+    ASSERT_TRUE(secure->load_certificates(m_certPath));
+    secure->secureAccept();
+    ARCH->writeSocket(stalled.first, "\x16\x03\x01", 3);
+
+    // a plain socket serviced by the same multiplexer
+    KeySocket key;
+    auto plain = connect();
+    m_sockets.push_back(plain.second);
+    multiplexer.addSocket(&key, std::make_unique<TSocketMultiplexerMethodJob>(
+        [this, server = plain.second](ISocketMultiplexerJob*, bool read, bool, bool error)
+        -> MultiplexerJobStatus
+    {
+        if (error) {
+            return {false, {}};
+        }
+        if (read) {
+            char buffer[64];
+            size_t n = ARCH->readSocket(server, buffer, sizeof(buffer));
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_received += n;
+            m_cv.notify_all();
+        }
+        return {true, {}};
+    }, plain.second, true, false));
+
+    // every message is delivered while the handshake is still pending,
+    // i.e. neither finished nor failed
+    for (int i = 0; i < kMessages; ++i) {
+        ARCH->writeSocket(plain.first, "x", 1);
+        waitForReceived(i + 1);
+    }
+    EXPECT_FALSE(secure->isSecureReady());
+    EXPECT_FALSE(secure->isFatal());
+
+    multiplexer.removeSocket(&key);
+    secure.reset();
+}
+
+} // namespace inputleap
@@ -0,0 +1,434 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define INPUTLEAP_TEST_ENV
+
+#include "net/SocketMultiplexer.h"
+#include "net/ISocket.h"
+#include "net/TSocketMultiplexerMethodJob.h"
+#include "arch/Arch.h"
+#include "base/Log.h"
+#include "mt/Thread.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace inputleap {
+
+#define TEST_PORT 24804
+#define TEST_HOST "127.0.0.1"
+
+namespace {
+
+// a socket that only serves as the key for a job in the multiplexer
+class KeySocket : public ISocket {
+public:
+    void bind(const NetworkAddress&) override { }
+    void close() override { }
+    const EventTarget* get_event_target() const override { return nullptr; }
+};
+
+class SocketMultiplexerTests : public ::testing::Test {
+public:
+    SocketMultiplexerTests()
+    {
+        m_addr = ARCH->nameToAddr(TEST_HOST);
+        ARCH->setAddrPort(m_addr, TEST_PORT);
+        m_listener = ARCH->newSocket(IArchNetwork::kINET, IArchNetwork::kSTREAM);
+        ARCH->setReuseAddrOnSocket(m_listener, true);
+        ARCH->bindSocket(m_listener, m_addr);
+        ARCH->listenOnSocket(m_listener);
+    }
+
+    ~SocketMultiplexerTests() override
+    {
+        for (auto& pair : m_pairs) {
+            ARCH->closeSocket(pair.first);
+            ARCH->closeSocket(pair.second);
+        }
+        ARCH->closeSocket(m_listener);
+        ARCH->closeAddr(m_addr);
+    }
+
+    // returns a connected (client, server) pair of sockets
+    std::pair<ArchSocket, ArchSocket> newSocketPair()
+    {
+        ArchSocket client = ARCH->newSocket(IArchNetwork::kINET, IArchNetwork::kSTREAM);
+        ARCH->connectSocket(client, m_addr);
+
+        ArchSocket server = nullptr;
+        while (server == nullptr) {
+            IArchNetwork::PollEntry pe{m_listener, IArchNetwork::kPOLLIN, 0};
+            ARCH->pollSocket(&pe, 1, 1.0);
+            server = ARCH->acceptSocket(m_listener, nullptr);
+        }
+
+        m_pairs.push_back(std::make_pair(client, server));
+        return m_pairs.back();
+    }
+
+    // adds a job for the server side of a new socket pair that counts
+    // the bytes it reads
+    ArchSocket addReadJob(SocketMultiplexer& multiplexer, KeySocket* key)
+    {
+        auto pair = newSocketPair();
+        multiplexer.addSocket(key, std::make_unique<TSocketMultiplexerMethodJob>(
+            [this, server = pair.second](ISocketMultiplexerJob*, bool read, bool, bool error)
+            -> MultiplexerJobStatus
+        {
+            if (error) {
+                return {false, {}};
+            }
+            if (read) {
+                char buffer[64];
+                size_t n = ARCH->readSocket(server, buffer, sizeof(buffer));
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_received += n;
+                m_cv.notify_all();
+            }
+            return {true, {}};
+        }, pair.second, true, false));
+        return pair.first;
+    }
+
+    void waitForReceived(size_t count)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        ASSERT_TRUE(m_cv.wait_for(lock, std::chrono::seconds(5),
+                                  [this, count]() { return m_received >= count; }));
+    }
+
+    ArchNetAddress m_addr;
+    ArchSocket m_listener;
+    std::vector<std::pair<ArchSocket, ArchSocket>> m_pairs;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    size_t m_received = 0;
+};
+
+} // namespace
+
+TEST_F(SocketMultiplexerTests, readyJobRunsAmongIdleSockets)
+{
+    SocketMultiplexer multiplexer;
+    std::vector<KeySocket> keys(33);
+    std::vector<ArchSocket> clients;
+    for (auto& key : keys) {
+        clients.push_back(addReadJob(multiplexer, &key));
+    }
+
+    // each write wakes only the job for its own socket
+    for (size_t i = 0; i < clients.size(); ++i) {
+        ARCH->writeSocket(clients[i], "x", 1);
+        waitForReceived(i + 1);
+    }
+
+    // jobs removed while idle are never run again
+    for (size_t i = 0; i < keys.size(); i += 2) {
+        multiplexer.removeSocket(&keys[i]);
+    }
+    for (size_t i = 1; i < clients.size(); i += 2) {
+        ARCH->writeSocket(clients[i], "x", 1);
+    }
+    waitForReceived(clients.size() + clients.size() / 2);
+
+    for (auto& key : keys) {
+        multiplexer.removeSocket(&key);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    EXPECT_EQ(clients.size() + clients.size() / 2, m_received);
+}
+
+TEST_F(SocketMultiplexerTests, hungUpSocketWithReadsPaused_runsJobWithErrorOnce)
+{
+    SocketMultiplexer multiplexer;
+    KeySocket key;
+    auto pair = newSocketPair();
+
+    std::atomic<int> runs(0);
+    multiplexer.addSocket(&key, std::make_unique<TSocketMultiplexerMethodJob>(
+        [this, &runs](ISocketMultiplexerJob*, bool, bool, bool error) -> MultiplexerJobStatus
+    {
+        ++runs;
+        if (error) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_received = 1;
+            m_cv.notify_all();
+            return {false, {}};
+        }
+        return {true, {}};
+    }, pair.second, false, false));
+
+    // shut down both directions so the socket is hung up
+    ARCH->closeSocketForWrite(pair.second);
+    ARCH->closeSocketForWrite(pair.first);
+    waitForReceived(1);
+
+    // the job is gone so nothing wakes the service thread again
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(1, runs.load());
+
+    multiplexer.removeSocket(&key);
+}
+
+TEST_F(SocketMultiplexerTests, busyReactor_doesNotBlockAddingSocketsToOthers)
+{
+    SocketMultiplexer multiplexer(2);
+    KeySocket busyKey, key;
+    auto pair = newSocketPair();
+
+    // a job that keeps its reactor busy until released
+    bool started = false, released = false, timedOut = false;
+    multiplexer.addSocket(&busyKey, std::make_unique<TSocketMultiplexerMethodJob>(
+        [&](ISocketMultiplexerJob*, bool, bool, bool) -> MultiplexerJobStatus
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        started = true;
+        m_cv.notify_all();
+        timedOut = !m_cv.wait_for(lock, std::chrono::seconds(2), [&]() { return released; });
+        return {false, {}};
+    }, pair.second, false, true));
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [&]() { return started; });
+    }
+
+    // replacing the busy job waits for its reactor
+    Thread replacer([&]() {
+        multiplexer.addSocket(&busyKey, std::make_unique<TSocketMultiplexerMethodJob>(
+            [](ISocketMultiplexerJob*, bool, bool, bool) -> MultiplexerJobStatus {
+                return {false, {}};
+            }, pair.second, false, false));
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // but a socket on the other reactor is added and serviced meanwhile
+    ArchSocket client = addReadJob(multiplexer, &key);
+    ARCH->writeSocket(client, "x", 1);
+    waitForReceived(1);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        EXPECT_FALSE(timedOut);
+        released = true;
+        m_cv.notify_all();
+    }
+    replacer.wait();
+
+    multiplexer.removeSocket(&key);
+    multiplexer.removeSocket(&busyKey);
+}
+
+TEST_F(SocketMultiplexerTests, jobStoppingItself_releasesItsReactor)
+{
+    SocketMultiplexer multiplexer(2);
+    KeySocket key;
+    auto pair = newSocketPair();
+
+    multiplexer.addSocket(&key, std::make_unique<TSocketMultiplexerMethodJob>(
+        [](ISocketMultiplexerJob*, bool, bool, bool) -> MultiplexerJobStatus {
+            return {false, {}};
+        }, pair.second, false, true));
+
+    // the reactor drops the socket right after running the job
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(multiplexer.m_reactorMutex);
+            if (multiplexer.m_reactorAffinity.empty()) {
+                break;
+            }
+        }
+        ASSERT_LT(std::chrono::steady_clock::now(), deadline);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    std::lock_guard<std::mutex> lock(multiplexer.m_reactorMutex);
+    EXPECT_EQ(std::vector<std::size_t>(2, 0), multiplexer.m_reactorLoads);
+}
+
+TEST_F(SocketMultiplexerTests, concurrentAddAndRemove_leaveNoStaleAffinity)
+{
+    const int kIterations = 500;
+    SocketMultiplexer multiplexer(2);
+    KeySocket key;
+    auto pair = newSocketPair();
+
+    // every other job stops servicing as soon as it runs
+    Thread adder([&]() {
+        for (int i = 0; i < kIterations; ++i) {
+            bool keep = (i % 2 == 0);
+            multiplexer.addSocket(&key, std::make_unique<TSocketMultiplexerMethodJob>(
+                [keep](ISocketMultiplexerJob*, bool, bool, bool) -> MultiplexerJobStatus {
+                    return {keep, {}};
+                }, pair.second, false, true));
+        }
+    });
+    Thread remover([&]() {
+        for (int i = 0; i < kIterations; ++i) {
+            multiplexer.removeSocket(&key);
+            std::this_thread::yield();
+        }
+    });
+    adder.wait();
+    remover.wait();
+    multiplexer.removeSocket(&key);
+
+    std::lock_guard<std::mutex> lock(multiplexer.m_reactorMutex);
+    EXPECT_TRUE(multiplexer.m_reactorAffinity.empty());
+    EXPECT_EQ(std::vector<std::size_t>(2, 0), multiplexer.m_reactorLoads);
+}
+
+// reports the cost of a wakeup as the number of idle sockets grows.
+// with a poller this should stay flat.
+TEST_F(SocketMultiplexerTests, DISABLED_benchmark_wakeupCostWithIdleSockets)
+{
+    const int kIterations = 2000;
+
+    for (size_t idle : { 8, 64, 256 }) {
+        SocketMultiplexer multiplexer;
+        std::vector<KeySocket> keys(idle + 1);
+        for (size_t i = 0; i < idle; ++i) {
+            addReadJob(multiplexer, &keys[i]);
+        }
+        ArchSocket active = addReadJob(multiplexer, &keys[idle]);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_received = 0;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kIterations; ++i) {
+            ARCH->writeSocket(active, "x", 1);
+            waitForReceived(i + 1);
+        }
+        std::chrono::duration<double, std::micro> elapsed =
+                std::chrono::steady_clock::now() - start;
+
+        LOG_PRINT("%d idle sockets: %.2f us per wakeup",
+                  static_cast<int>(idle), elapsed.count() / kIterations);
+
+        for (auto& key : keys) {
+            multiplexer.removeSocket(&key);
+        }
+    }
+}
+
+// reports the p99 latency of small messages to several clients while
+// another client receives a 50 MB transfer.  each chunk of the transfer
+// is scrambled before it's written to stand in for encryption.
+TEST_F(SocketMultiplexerTests, DISABLED_benchmark_smallMessageLatencyDuringBulkTransfer)
+{
+    const size_t kBulkSize = 50 * 1024 * 1024;
+    const size_t kChunkSize = 64 * 1024;
+    const size_t kClients = 4;
+    const int kMessages = 400;
+
+    for (size_t threads : { 1, 4 }) {
+        SocketMultiplexer multiplexer(threads);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_received = 0;
+        }
+
+        // the bulk transfer, drained by a client thread
+        KeySocket bulkKey;
+        auto bulk = newSocketPair();
+        std::atomic<bool> bulkDone(false);
+        Thread drain([&bulkDone, client = bulk.first]() {
+            std::vector<char> buffer(kChunkSize);
+            size_t total = 0;
+            while (total < kBulkSize) {
+                IArchNetwork::PollEntry pe{client, IArchNetwork::kPOLLIN, 0};
+                ARCH->pollSocket(&pe, 1, 0.1);
+                total += ARCH->readSocket(client, buffer.data(), buffer.size());
+            }
+            bulkDone = true;
+        });
+
+        std::vector<char> chunk(kChunkSize);
+        size_t sent = 0;
+        size_t offset = kChunkSize;
+        std::uint64_t state = 1;
+        multiplexer.addSocket(&bulkKey, std::make_unique<TSocketMultiplexerMethodJob>(
+            [&, server = bulk.second](ISocketMultiplexerJob*, bool, bool write, bool error)
+            -> MultiplexerJobStatus
+        {
+            if (error || sent == kBulkSize) {
+                return {false, {}};
+            }
+            if (write) {
+                if (offset == chunk.size()) {
+                    for (auto& c : chunk) {
+                        state = state * 6364136223846793005ull + static_cast<unsigned char>(c);
+                        c = static_cast<char>(state >> 56);
+                    }
+                    offset = 0;
+                }
+                size_t n = std::min(chunk.size() - offset, kBulkSize - sent);
+                n = ARCH->writeSocket(server, chunk.data() + offset, n);
+                offset += n;
+                sent += n;
+            }
+            return {true, {}};
+        }, bulk.second, false, true));
+
+        // small messages to the other clients
+        std::vector<KeySocket> keys(kClients);
+        std::vector<ArchSocket> clients;
+        for (auto& key : keys) {
+            clients.push_back(addReadJob(multiplexer, &key));
+        }
+
+        std::vector<double> latencies;
+        for (int i = 0; i < kMessages && !bulkDone; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            ARCH->writeSocket(clients[i % kClients], "x", 1);
+            waitForReceived(i + 1);
+            std::chrono::duration<double, std::micro> elapsed =
+                    std::chrono::steady_clock::now() - start;
+            latencies.push_back(elapsed.count());
+        }
+
+        drain.wait();
+        multiplexer.removeSocket(&bulkKey);
+        for (auto& key : keys) {
+            multiplexer.removeSocket(&key);
+        }
+
+        ASSERT_FALSE(latencies.empty());
+        std::sort(latencies.begin(), latencies.end());
+        LOG_PRINT("%d threads: p99 %.1f us over %d small messages during bulk transfer",
+                  static_cast<int>(threads), latencies[latencies.size() * 99 / 100],
+                  static_cast<int>(latencies.size()));
+    }
+}
+
+} // namespace inputleap
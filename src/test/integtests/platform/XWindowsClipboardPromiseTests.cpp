@@ -0,0 +1,156 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// gtest must come before the X headers which define None
+#include <gtest/gtest.h>
+
+#include "platform/XWindowsClipboard.h"
+#include "platform/XWindowsImpl.h"
+#include "platform/XWindowsUtil.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace inputleap {
+
+namespace {
+
+// a clipboard owning PRIMARY with a promised text format, and a window
+// asking for the text
+class XWindowsClipboardPromiseTests : public ::testing::Test {
+public:
+    void SetUp() override
+    {
+        display_ = XOpenDisplay(nullptr);
+        if (display_ == nullptr) {
+            GTEST_SKIP() << "unable to open display, skipping test";
+        }
+
+        Window root = DefaultRootWindow(display_);
+        owner_ = XCreateSimpleWindow(display_, root, 0, 0, 1, 1, 0, 0, 0);
+        requestor_ = XCreateSimpleWindow(display_, root, 0, 0, 1, 1, 0, 0, 0);
+        XSelectInput(display_, owner_, PropertyChangeMask);
+        target_ = XInternAtom(display_, "UTF8_STRING", False);
+        property_ = XInternAtom(display_, "INPUTLEAP_TEST", False);
+
+        clipboard_ = std::make_unique<XWindowsClipboard>(&impl_, display_, owner_,
+                                                         kClipboardSelection);
+        promise();
+    }
+
+    void TearDown() override
+    {
+        if (display_ == nullptr) {
+            return;
+        }
+        clipboard_.reset();
+        XDestroyWindow(display_, requestor_);
+        XDestroyWindow(display_, owner_);
+        XCloseDisplay(display_);
+    }
+
+    // takes ownership and promises text
+    void promise()
+    {
+        ASSERT_TRUE(clipboard_->open(XWindowsUtil::getCurrentTime(display_, owner_)));
+        ASSERT_TRUE(clipboard_->clear());
+        ASSERT_TRUE(clipboard_->promise(IClipboard::kText));
+        clipboard_->close();
+    }
+
+    void request()
+    {
+        clipboard_->addRequest(owner_, requestor_, target_, CurrentTime, property_);
+        XSync(display_, False);
+    }
+
+    // returns true if the requestor was notified, with the notified
+    // property in property
+    bool notified(Atom& property)
+    {
+        XSync(display_, False);
+        XEvent event;
+        if (!XCheckTypedWindowEvent(display_, requestor_, SelectionNotify, &event)) {
+            return false;
+        }
+        property = event.xselection.property;
+        return true;
+    }
+
+    std::string requestor_property()
+    {
+        std::string data;
+        XWindowsUtil::getWindowProperty(display_, requestor_, property_, &data,
+                                        nullptr, nullptr, False);
+        return data;
+    }
+
+    XWindowsImpl impl_;
+    Display* display_ = nullptr;
+    Window owner_ = None;
+    Window requestor_ = None;
+    Atom target_ = None;
+    Atom property_ = None;
+    std::unique_ptr<XWindowsClipboard> clipboard_;
+};
+
+} // namespace
+
+TEST_F(XWindowsClipboardPromiseTests, request_promisedFormat_waitsForData)
+{
+    request();
+
+    Atom property;
+    EXPECT_FALSE(notified(property));
+    EXPECT_EQ(std::vector<IClipboard::EFormat>{ IClipboard::kText },
+              clipboard_->takeRequestedFormats());
+    EXPECT_TRUE(clipboard_->takeRequestedFormats().empty());
+
+    EXPECT_TRUE(clipboard_->fulfill(IClipboard::kText, "hello"));
+    ASSERT_TRUE(notified(property));
+    EXPECT_EQ(property_, property);
+    EXPECT_EQ("hello", requestor_property());
+}
+
+TEST_F(XWindowsClipboardPromiseTests, withdraw_pendingRequest_fails)
+{
+    request();
+    clipboard_->withdraw(IClipboard::kText);
+
+    Atom property;
+    ASSERT_TRUE(notified(property));
+    EXPECT_EQ(static_cast<Atom>(None), property);
+
+    // the format is gone
+    EXPECT_FALSE(clipboard_->fulfill(IClipboard::kText, "hello"));
+    clipboard_->open(CurrentTime);
+    EXPECT_FALSE(clipboard_->has(IClipboard::kText));
+    clipboard_->close();
+}
+
+TEST_F(XWindowsClipboardPromiseTests, clear_pendingRequest_fails)
+{
+    request();
+    promise();
+
+    Atom property;
+    ASSERT_TRUE(notified(property));
+    EXPECT_EQ(static_cast<Atom>(None), property);
+}
+
+} // namespace inputleap
@@ -0,0 +1,44 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#define INPUTLEAP_TEST_ENV
+
+#include "client/Client.h"
+
+#include <gmock/gmock.h>
+
+namespace inputleap {
+
+class MockClient : public Client
+{
+public:
+    MOCK_METHOD0(handshakeComplete, void());
+    MOCK_METHOD0(beginFakeBatch, void());
+    MOCK_METHOD0(endFakeBatch, void());
+    MOCK_METHOD1(setOptions, void(const OptionsList&));
+    MOCK_METHOD1(screensaver, void(bool));
+    MOCK_METHOD2(mouseMove, void(std::int32_t, std::int32_t));
+    MOCK_METHOD1(mouseDown, void(ButtonID));
+    MOCK_METHOD3(keyDown, void(KeyID, KeyModifierMask, KeyButton));
+    MOCK_METHOD2(setClipboard, void(ClipboardID, const IClipboard*));
+    MOCK_METHOD3(setClipboardFormat, bool(ClipboardID, IClipboard::EFormat, const std::string&));
+    MOCK_METHOD2(withdrawClipboardFormat, void(ClipboardID, IClipboard::EFormat));
+};
+
+} // namespace inputleap
@@ -40,6 +40,7 @@ public:
     MOCK_METHOD1(add_event, void(Event&&));
     MOCK_METHOD2(remove_handler, void(EventType, const EventTarget*));
     MOCK_METHOD1(dispatchEvent, bool(const Event&));
+    MOCK_METHOD2(restartTimer, void(EventQueueTimer*, double));
     MOCK_METHOD1(deleteTimer, void(EventQueueTimer*));
     MOCK_METHOD0(getSystemTarget, const EventTarget*());
     MOCK_CONST_METHOD0(waitForReady, void());
@@ -0,0 +1,79 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "io/IStream.h"
+#include "base/EventTarget.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace inputleap {
+
+// a stream kept in memory.  reads consume input_ and writes are appended
+// to output_.  the stream is its own event target so tests can raise
+// stream events for it.
+class MemoryStream : public IStream, public EventTarget {
+public:
+    void close() override { }
+    std::uint32_t read(void* buffer, std::uint32_t n) override
+    {
+        n = std::min(n, getSize());
+        std::memcpy(buffer, input_.data() + pos_, n);
+        pos_ += n;
+        return n;
+    }
+    void write(const void* buffer, std::uint32_t n) override
+    {
+        const std::uint8_t* bytes = static_cast<const std::uint8_t*>(buffer);
+        output_.insert(output_.end(), bytes, bytes + n);
+        ++writes_;
+    }
+    void flush() override { }
+    void shutdownInput() override { }
+    void shutdownOutput() override { }
+    const EventTarget* get_event_target() const override { return this; }
+    bool isReady() const override { return pos_ < input_.size(); }
+    std::uint32_t getSize() const override
+    {
+        return static_cast<std::uint32_t>(input_.size() - pos_);
+    }
+    std::uint32_t getOutputSize() const override { return output_size_; }
+
+    // makes everything written so far readable from the start
+    void replay()
+    {
+        input_ = output_;
+        pos_ = 0;
+    }
+
+    // skips input, e.g. the code of a message
+    void skip(std::size_t n) { pos_ += n; }
+
+    std::vector<std::uint8_t> input_;
+    std::size_t pos_ = 0;
+    std::vector<std::uint8_t> output_;
+    int writes_ = 0;
+
+    // what getOutputSize() reports as still waiting to be sent
+    std::uint32_t output_size_ = 0;
+};
+
+} // namespace inputleap
@@ -39,4 +39,5 @@ public:
     MOCK_CONST_METHOD0(get_event_target, void*());
     MOCK_CONST_METHOD0(isReady, bool());
     MOCK_CONST_METHOD0(getSize, std::uint32_t());
+    MOCK_CONST_METHOD0(getOutputSize, std::uint32_t());
 };
@@ -0,0 +1,258 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// gmock must come before the X headers which define None
+#include <gmock/gmock.h>
+
+#include "platform/IXWindowsImpl.h"
+
+class MockXWindowsImpl : public inputleap::IXWindowsImpl
+{
+public:
+    MOCK_METHOD(Status, XInitThreads, (), (override));
+    MOCK_METHOD(XIOErrorHandler, XSetIOErrorHandler, (XIOErrorHandler handler), (override));
+    MOCK_METHOD(Window, do_DefaultRootWindow, (Display* display), (override));
+    MOCK_METHOD(unsigned long, do_NextRequest, (Display* display), (override));
+    MOCK_METHOD(int, XCloseDisplay, (Display* display), (override));
+    MOCK_METHOD(int, XTestGrabControl, (Display* display, Bool impervious), (override));
+    MOCK_METHOD(void, XDestroyIC, (XIC ic), (override));
+    MOCK_METHOD(Status, XCloseIM, (XIM im), (override));
+    MOCK_METHOD(int, XDestroyWindow, (Display* display, Window w), (override));
+    MOCK_METHOD(int, XGetKeyboardControl,
+                (Display* display, XKeyboardState* value_return),
+                (override));
+    MOCK_METHOD(int, XMoveWindow, (Display* display, Window w, int x, int y), (override));
+    MOCK_METHOD(int, XMapRaised, (Display* display, Window w), (override));
+    MOCK_METHOD(void, XUnsetICFocus, (XIC ic), (override));
+    MOCK_METHOD(int, XUnmapWindow, (Display* display, Window w), (override));
+    MOCK_METHOD(int, XSetInputFocus,
+                (Display* display, Window focus, int revert_to, Time time),
+                (override));
+    MOCK_METHOD(Bool, DPMSQueryExtension,
+                (Display* display, int* event_base, int* error_base),
+                (override));
+    MOCK_METHOD(Bool, DPMSCapable, (Display* display), (override));
+    MOCK_METHOD(Status, DPMSInfo, (Display* display, CARD16* power_level, BOOL* state), (override));
+    MOCK_METHOD(Status, DPMSForceLevel, (Display* display, CARD16 level), (override));
+    MOCK_METHOD(int, XGetInputFocus,
+                (Display* display, Window* focus_return, int* revert_to_return),
+                (override));
+    MOCK_METHOD(void, XSetICFocus, (XIC ic), (override));
+    MOCK_METHOD(Bool, XQueryPointer,
+                (Display* display, Window w, Window* root_return, Window* child_return,
+                 int* root_x_return, int* root_y_return, int* win_x_return, int* win_y_return,
+                 unsigned int* mask_return),
+                (override));
+    MOCK_METHOD(void, XLockDisplay, (Display* display), (override));
+    MOCK_METHOD(Bool, XCheckMaskEvent,
+                (Display* display, long event_mask, XEvent* event_return),
+                (override));
+    MOCK_METHOD(XModifierKeymap*, XGetModifierMapping, (Display* display), (override));
+    MOCK_METHOD(int, XGrabKey,
+                (Display* display, int keycode, unsigned int modifiers, Window grab_window,
+                 int owner_events, int pointer_made, int keyboard_mode),
+                (override));
+    MOCK_METHOD(int, XFreeModifiermap, (XModifierKeymap* modmap), (override));
+    MOCK_METHOD(int, XUngrabKey,
+                (Display* display, int keycode, unsigned int modifiers, Window grab_window),
+                (override));
+    MOCK_METHOD(int, XTestFakeButtonEvent,
+                (Display* display, unsigned int button, int is_press, unsigned long delay),
+                (override));
+    MOCK_METHOD(int, XFlush, (Display* display), (override));
+    MOCK_METHOD(int, XWarpPointer,
+                (Display* display, Window src_w, Window dest_w, int src_x, int src_y,
+                 unsigned int src_width, unsigned int src_height, int dest_x, int dest_y),
+                (override));
+    MOCK_METHOD(int, XTestFakeRelativeMotionEvent,
+                (Display* display, int x, int y, unsigned long delay),
+                (override));
+    MOCK_METHOD(KeyCode, XKeysymToKeycode, (Display* display, KeySym keysym), (override));
+    MOCK_METHOD(int, XTestFakeKeyEvent,
+                (Display* display, unsigned int keycode, int is_press, unsigned long delay),
+                (override));
+    MOCK_METHOD(Display*, XOpenDisplay, (_Xconst char* display_name), (override));
+    MOCK_METHOD(Bool, XQueryExtension,
+                (Display* display, const char* name, int* major_opcode_return,
+                 int* first_event_return, int* first_error_return),
+                (override));
+    MOCK_METHOD(Bool, XkbLibraryVersion, (int* libMajorRtrn, int* libMinorRtrn), (override));
+    MOCK_METHOD(Bool, XkbQueryExtension,
+                (Display* display, int* opcodeReturn, int* eventBaseReturn, int* errorBaseReturn,
+                 int* majorRtrn, int* minorRtrn),
+                (override));
+    MOCK_METHOD(Bool, XkbSelectEvents,
+                (Display* display, unsigned int deviceID, unsigned int affect, unsigned int values),
+                (override));
+    MOCK_METHOD(Bool, XkbSelectEventDetails,
+                (Display* display, unsigned int deviceID, unsigned int eventType,
+                 unsigned long affect, unsigned long details),
+                (override));
+    MOCK_METHOD(Bool, XRRQueryExtension,
+                (Display* display, int* event_base_return, int* error_base_return),
+                (override));
+    MOCK_METHOD(void, XRRSelectInput, (Display *display, Window window, int mask), (override));
+    MOCK_METHOD(Bool, XineramaQueryExtension,
+                (Display* display, int* event_base, int* error_base),
+                (override));
+    MOCK_METHOD(Bool, XineramaIsActive, (Display* display), (override));
+    MOCK_METHOD(void*, XineramaQueryScreens, (Display* display, int* number), (override));
+    MOCK_METHOD(Window, XCreateWindow,
+                (Display* display, Window parent, int x, int y, unsigned int width,
+                 unsigned int height, unsigned int border_width, int depth, unsigned int klass,
+                 Visual* visual, unsigned long valuemask, XSetWindowAttributes* attributes),
+                (override));
+    MOCK_METHOD(XIM, XOpenIM,
+                (Display* display, _XrmHashBucketRec* rdb, char* res_name, char* res_class),
+                (override));
+    MOCK_METHOD(char*, XGetIMValues, (XIM im, const char* type, void* ptr), (override));
+    MOCK_METHOD(XIC, XCreateIC,
+                (XIM im, const char* type1, unsigned long data1, const char* type2,
+                 unsigned long data2),
+                (override));
+    MOCK_METHOD(char*, XGetICValues, (XIC ic, const char* type, unsigned long* mask), (override));
+    MOCK_METHOD(Status, XGetWindowAttributes,
+                (Display* display, Window w, XWindowAttributes* attrs),
+                (override));
+    MOCK_METHOD(int, XSelectInput, (Display* display, Window w, long event_mask), (override));
+    MOCK_METHOD(Bool, XCheckIfEvent,
+                (Display* display, XEvent* event, Bool (*predicate)(Display *, XEvent *, XPointer),
+                 XPointer arg),
+                (override));
+    MOCK_METHOD(Bool, XFilterEvent, (XEvent* event, Window window), (override));
+    MOCK_METHOD(Bool, XGetEventData, (Display* display, XGenericEventCookie* cookie), (override));
+    MOCK_METHOD(void, XFreeEventData, (Display* display, XGenericEventCookie* cookie), (override));
+    MOCK_METHOD(int, XDeleteProperty, (Display* display, Window w, Atom property), (override));
+    MOCK_METHOD(int, XResizeWindow,
+                (Display* display, Window w, unsigned int width, unsigned int height),
+                (override));
+    MOCK_METHOD(int, XMaskEvent,
+                (Display* display, long event_mask, XEvent* event_return),
+                (override));
+    MOCK_METHOD(Status, XQueryBestCursor,
+                (Display* display, Drawable d, unsigned int width, unsigned int height,
+                 unsigned int* width_return, unsigned int* height_return),
+                (override));
+    MOCK_METHOD(Pixmap, XCreateBitmapFromData,
+                (Display* display, Drawable d, const char* data, unsigned int width,
+                 unsigned int height),
+                (override));
+    MOCK_METHOD(Cursor, XCreatePixmapCursor,
+                (Display* display, Pixmap source, Pixmap mask, XColor* foreground_color,
+                 XColor* background_color, unsigned int x, unsigned int y),
+                (override));
+    MOCK_METHOD(int, XFreePixmap, (Display* display, Pixmap pixmap), (override));
+    MOCK_METHOD(Status, XQueryTree,
+                (Display* display, Window w, Window* root_return, Window* parent_return,
+                 Window** children_return, unsigned int* nchildren_return),
+                (override));
+    MOCK_METHOD(int, XmbLookupString,
+                (XIC ic, XKeyPressedEvent* event, char* buffer_return, int bytes_buffer,
+                 KeySym* keysym_return, int* status_return),
+                (override));
+    MOCK_METHOD(int, XLookupString,
+                (XKeyEvent* event_struct, char* buffer_return, int bytes_buffer,
+                 KeySym* keysym_return, XComposeStatus* status_in_out),
+                (override));
+    MOCK_METHOD(Status, XSendEvent,
+                (Display* display, Window w, Bool propagate, long event_mask, XEvent* event_send),
+                (override));
+    MOCK_METHOD(int, XSync, (Display* display, Bool discard), (override));
+    MOCK_METHOD(int, XGetPointerMapping,
+                (Display* display, unsigned char* map_return, int nmap),
+                (override));
+    MOCK_METHOD(int, XGrabKeyboard,
+                (Display* display, Window grab_window, Bool owner_events, int pointer_mode,
+                 int keyboard_mode, Time time),
+                (override));
+    MOCK_METHOD(int, XGrabPointer,
+                (Display* display, Window grab_window, Bool owner_events, unsigned int event_mask,
+                 int pointer_mode, int keyboard_mode, Window confine_to, Cursor cursor, Time time),
+                (override));
+    MOCK_METHOD(int, XUngrabKeyboard, (Display* display, Time time), (override));
+    MOCK_METHOD(int, XPending, (Display* display), (override));
+    MOCK_METHOD(int, XPeekEvent, (Display* display, XEvent* event_return), (override));
+    MOCK_METHOD(Status, XkbRefreshKeyboardMapping, (XkbMapNotifyEvent* event), (override));
+    MOCK_METHOD(int, XRefreshKeyboardMapping, (XMappingEvent* event_map), (override));
+    MOCK_METHOD(int, XISelectEvents,
+                (Display* display, Window w, XIEventMask* masks, int num_masks),
+                (override));
+    MOCK_METHOD(Atom, XInternAtom,
+                (Display* display, _Xconst char* atom_name, Bool only_if_exists),
+                (override));
+    MOCK_METHOD(int, XGetScreenSaver,
+                (Display* display, int* timeout_return, int* interval_return,
+                 int* prefer_blanking_return, int* allow_exposures_return),
+                (override));
+    MOCK_METHOD(int, XSetScreenSaver,
+                (Display* display, int timeout, int interval, int prefer_blanking,
+                 int allow_exposures),
+                (override));
+    MOCK_METHOD(int, XForceScreenSaver, (Display* display, int mode), (override));
+    MOCK_METHOD(int, XFree, (void* data), (override));
+    MOCK_METHOD(Status, DPMSEnable, (Display* display), (override));
+    MOCK_METHOD(Status, DPMSDisable, (Display* display), (override));
+    MOCK_METHOD(int, XSetSelectionOwner,
+                (Display* display, Atom selection, Window w, Time time),
+                (override));
+    MOCK_METHOD(Window, XGetSelectionOwner, (Display* display, Atom selection), (override));
+    MOCK_METHOD(Atom*, XListProperties,
+                (Display* display, Window w, int* num_prop_return),
+                (override));
+    MOCK_METHOD(char*, XGetAtomName, (Display* display, Atom atom), (override));
+    MOCK_METHOD(void, XkbFreeKeyboard,
+                (XkbDescPtr xkb, unsigned int which, Bool freeDesc),
+                (override));
+    MOCK_METHOD(XkbDescPtr, XkbGetMap,
+                (Display* display, unsigned int which, unsigned int deviceSpec),
+                (override));
+    MOCK_METHOD(Status, XkbGetState,
+                (Display* display, unsigned int deviceSet, XkbStatePtr rtrnState),
+                (override));
+    MOCK_METHOD(int, XQueryKeymap, (Display* display, char keys_return[32]), (override));
+    MOCK_METHOD(Status, XkbGetUpdatedMap,
+                (Display* display, unsigned int which, XkbDescPtr desc),
+                (override));
+    MOCK_METHOD(Bool, XkbLockGroup,
+                (Display* display, unsigned int deviceSpec, unsigned int group),
+                (override));
+    MOCK_METHOD(int, XDisplayKeycodes,
+                (Display* display, int* min_keycodes_return, int* max_keycodes_return),
+                (override));
+    MOCK_METHOD(KeySym*, XGetKeyboardMapping,
+                (Display* display, unsigned int first_keycode, int keycode_count,
+                 int* keysyms_per_keycode_return),
+                (override));
+    MOCK_METHOD(int, do_XkbKeyNumGroups, (XkbDescPtr m_xkb, KeyCode desc), (override));
+    MOCK_METHOD(XkbKeyTypePtr, do_XkbKeyKeyType,
+                (XkbDescPtr m_xkb, KeyCode keycode, int eGroup),
+                (override));
+    MOCK_METHOD(KeySym, do_XkbKeySymEntry,
+                (XkbDescPtr m_xkb, KeyCode keycode, int level, int eGroup),
+                (override));
+    MOCK_METHOD(Bool, do_XkbKeyHasActions, (XkbDescPtr m_xkb, KeyCode keycode), (override));
+    MOCK_METHOD(XkbAction*, do_XkbKeyActionEntry,
+                (XkbDescPtr m_xkb, KeyCode keycode, int level, int eGroup),
+                (override));
+    MOCK_METHOD(unsigned char, do_XkbKeyGroupInfo, (XkbDescPtr m_xkb, KeyCode keycode), (override));
+    MOCK_METHOD(int, XNextEvent, (Display* display, XEvent* event_return), (override));
+    MOCK_METHOD(int, do_ppoll, (struct pollfd* fds, nfds_t nfds, const struct timespec* timeout),
+                (override));
+    MOCK_METHOD(std::uint64_t, get_round_trip_count, (), (const, override));
+};
@@ -0,0 +1,514 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/EventQueue.h"
+#include "base/EventQueueTimer.h"
+#include "base/Log.h"
+#include "base/Time.h"
+#include "mt/Thread.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace inputleap;
+
+namespace {
+
+// runs the queue's loop on its own thread until a quit event arrives.
+// the loop needs a Thread since it is a cancellation point.
+class EventLoopThread {
+public:
+    explicit EventLoopThread(EventQueue& queue) :
+        m_queue(queue),
+        m_thread([&queue]() { queue.loop(); })
+    {
+        m_queue.waitForReady();
+    }
+
+    ~EventLoopThread() { join(); }
+
+    void join()
+    {
+        if (!m_joined) {
+            m_joined = true;
+            m_queue.add_event(EventType::QUIT);
+            m_thread.wait();
+        }
+    }
+
+private:
+    EventQueue& m_queue;
+    Thread m_thread;
+    bool m_joined = false;
+};
+
+// waits for the next timer event and returns its timer, or nullptr if
+// none arrives within the timeout
+EventQueueTimer* waitForTimer(EventQueue& queue, double timeout,
+                              std::uint32_t* count = nullptr)
+{
+    Event event;
+    if (!queue.getEvent(event, timeout)) {
+        return nullptr;
+    }
+    EXPECT_EQ(EventType::TIMER, event.getType());
+    auto* data = event.get_data_as<IEventQueue::TimerEvent*>();
+    if (count != nullptr) {
+        *count = data->m_count;
+    }
+    EventQueueTimer* timer = data->m_timer;
+    Event::deleteData(event);
+    return timer;
+}
+
+} // namespace
+
+TEST(EventQueueTests, add_event_multipleProducers_deliveredOnceInProducerOrder)
+{
+    const int kProducers = 4;
+    const int kEvents = 20000;
+
+    EventQueue queue;
+    std::vector<EventTarget> targets(kProducers);
+    std::vector<int> next(kProducers, 0);
+    int misordered = 0;
+    for (int p = 0; p < kProducers; ++p) {
+        queue.add_handler(EventType::STREAM_INPUT_READY, &targets[p],
+                          [&next, &misordered, p](const Event& event)
+        {
+            if (event.get_data_as<int>() != next[p]++) {
+                ++misordered;
+            }
+        });
+    }
+
+    {
+        EventLoopThread loop(queue);
+        std::vector<std::thread> producers;
+        for (int p = 0; p < kProducers; ++p) {
+            producers.emplace_back([&queue, &targets, p]() {
+                for (int i = 0; i < kEvents; ++i) {
+                    queue.add_event(Event(EventType::STREAM_INPUT_READY, &targets[p],
+                                          create_event_data<int>(i)));
+                }
+            });
+        }
+        for (auto& producer : producers) {
+            producer.join();
+        }
+    }
+
+    for (int p = 0; p < kProducers; ++p) {
+        EXPECT_EQ(kEvents, next[p]);
+        queue.remove_handlers(&targets[p]);
+    }
+    EXPECT_EQ(0, misordered);
+}
+
+TEST(EventQueueTests, add_event_manyPendingEvents_deliveredInOrder)
+{
+    // more events than fit in the buffer's ring are queued before the
+    // consumer gets to run
+    const int kEvents = 100000;
+
+    EventQueue queue;
+    EventTarget target;
+    int next = 0;
+    int misordered = 0;
+    queue.add_handler(EventType::STREAM_INPUT_READY, &target,
+                      [&next, &misordered](const Event& event)
+    {
+        if (event.get_data_as<int>() != next++) {
+            ++misordered;
+        }
+    });
+
+    auto loop = std::make_unique<EventLoopThread>(queue);
+    for (int i = 0; i < kEvents; ++i) {
+        queue.add_event(Event(EventType::STREAM_INPUT_READY, &target, create_event_data<int>(i)));
+    }
+    loop.reset();
+
+    EXPECT_EQ(kEvents, next);
+    EXPECT_EQ(0, misordered);
+    queue.remove_handlers(&target);
+}
+
+TEST(EventQueueTests, DISABLED_benchmark_multipleProducers)
+{
+    const int kEvents = 200000;
+
+    for (int producerCount : { 1, 4 }) {
+        EventQueue queue;
+        EventTarget target;
+        const int expected = kEvents / producerCount * producerCount;
+        int received = 0;
+        std::chrono::steady_clock::time_point end;
+        queue.add_handler(EventType::STREAM_INPUT_READY, &target,
+                          [&received, &end, expected](const Event&)
+        {
+            // joining the loop thread is slow so stop the clock here
+            if (++received == expected) {
+                end = std::chrono::steady_clock::now();
+            }
+        });
+
+        auto start = std::chrono::steady_clock::now();
+        {
+            EventLoopThread loop(queue);
+            std::vector<std::thread> producers;
+            for (int p = 0; p < producerCount; ++p) {
+                producers.emplace_back([&queue, &target, producerCount]() {
+                    for (int i = 0; i < kEvents / producerCount; ++i) {
+                        queue.add_event(Event(EventType::STREAM_INPUT_READY, &target));
+                    }
+                });
+            }
+            for (auto& producer : producers) {
+                producer.join();
+            }
+        }
+        std::chrono::duration<double> elapsed = end - start;
+
+        EXPECT_EQ(expected, received);
+        LOG_PRINT("%d producer(s): %.0f events per second", producerCount,
+                  received / elapsed.count());
+        queue.remove_handlers(&target);
+    }
+}
+
+TEST(EventQueueTests, dispatchEvent_noHandlerForType_usesCatchAllHandler)
+{
+    EventQueue queue;
+    EventTarget target;
+    int typed = 0;
+    int any = 0;
+    queue.add_handler(EventType::STREAM_INPUT_READY, &target, [&typed](const Event&) { ++typed; });
+    queue.add_handler(EventType::UNKNOWN, &target, [&any](const Event&) { ++any; });
+
+    EXPECT_TRUE(queue.dispatchEvent(Event(EventType::STREAM_INPUT_READY, &target)));
+    EXPECT_TRUE(queue.dispatchEvent(Event(EventType::STREAM_OUTPUT_FLUSHED, &target)));
+    EXPECT_EQ(1, typed);
+    EXPECT_EQ(1, any);
+
+    queue.remove_handler(EventType::UNKNOWN, &target);
+    EXPECT_FALSE(queue.dispatchEvent(Event(EventType::STREAM_OUTPUT_FLUSHED, &target)));
+
+    queue.remove_handler(EventType::STREAM_INPUT_READY, &target);
+    EXPECT_FALSE(queue.dispatchEvent(Event(EventType::STREAM_INPUT_READY, &target)));
+}
+
+TEST(EventQueueTests, dispatchEvent_handlerRemovesItself_captureStaysValid)
+{
+    EventQueue queue;
+    EventTarget target;
+    auto data = std::make_shared<int>(42);
+    int seen = 0;
+    queue.add_handler(EventType::STREAM_INPUT_READY, &target,
+                      [&queue, &target, &seen, data](const Event&)
+    {
+        queue.remove_handlers(&target);
+        seen = *data;
+    });
+
+    EXPECT_TRUE(queue.dispatchEvent(Event(EventType::STREAM_INPUT_READY, &target)));
+    EXPECT_EQ(42, seen);
+    EXPECT_FALSE(queue.dispatchEvent(Event(EventType::STREAM_INPUT_READY, &target)));
+
+    // the handler's copy of data has been released
+    EXPECT_EQ(1, data.use_count());
+}
+
+TEST(EventQueueTests, dispatchEvent_manyTargets_runsMatchingHandlerOnly)
+{
+    const int kTargets = 50;
+    const EventType types[] = {
+        EventType::STREAM_INPUT_READY,
+        EventType::STREAM_OUTPUT_ERROR,
+        EventType::SOCKET_DISCONNECTED,
+    };
+
+    EventQueue queue;
+    std::vector<EventTarget> targets(kTargets);
+    std::vector<int> received(kTargets * 3, 0);
+    for (int i = 0; i < kTargets; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            queue.add_handler(types[j], &targets[i], [&received, i, j](const Event&) {
+                ++received[i * 3 + j];
+            });
+        }
+    }
+
+    for (int i = 0; i < kTargets * 3; ++i) {
+        EXPECT_TRUE(queue.dispatchEvent(Event(types[i % 3], &targets[i / 3])));
+    }
+    EXPECT_EQ(std::vector<int>(kTargets * 3, 1), received);
+
+    for (auto& target : targets) {
+        queue.remove_handlers(&target);
+    }
+}
+
+TEST(EventQueueTests, dispatchEvent_handlersChangingOnOtherThread_findsUnchangedHandler)
+{
+    const int kChanges = 2000;
+    EventQueue queue;
+    EventTarget target;
+    std::atomic<int> received(0);
+    queue.add_handler(EventType::STREAM_INPUT_READY, &target,
+                      [&received](const Event&) { ++received; });
+
+    // adding targets grows the hash and replacing handlers retires the
+    // old ones while the dispatching thread may still be looking at them
+    std::atomic<bool> done(false);
+    std::thread dispatcher([&]() {
+        while (!done) {
+            EXPECT_TRUE(queue.dispatchEvent(Event(EventType::STREAM_INPUT_READY, &target)));
+        }
+    });
+    while (received == 0) {
+        std::this_thread::yield();
+    }
+    std::vector<EventTarget> others(kChanges / 10);
+    for (int i = 0; i < kChanges; ++i) {
+        EventTarget* other = &others[i % others.size()];
+        queue.add_handler(EventType::STREAM_INPUT_READY, other, [](const Event&) { });
+        if (i % 3 == 0) {
+            queue.remove_handlers(other);
+        }
+    }
+    done = true;
+    dispatcher.join();
+
+    for (auto& other : others) {
+        queue.remove_handlers(&other);
+    }
+    queue.remove_handlers(&target);
+}
+
+TEST(EventQueueTests, DISABLED_benchmark_dispatchManyTargets)
+{
+    // a server has a few handlers on each of many client and socket targets
+    const int kTargets = 500;
+    const int kEvents = 1000000;
+    const EventType types[] = {
+        EventType::STREAM_INPUT_READY,
+        EventType::STREAM_OUTPUT_ERROR,
+        EventType::SOCKET_DISCONNECTED,
+    };
+
+    EventQueue queue;
+    std::vector<EventTarget> targets(kTargets);
+    int received = 0;
+    for (auto& target : targets) {
+        for (auto type : types) {
+            queue.add_handler(type, &target, [&received](const Event&) { ++received; });
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kEvents; ++i) {
+        queue.dispatchEvent(Event(types[i % 3], &targets[i % kTargets]));
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_EQ(kEvents, received);
+    LOG_PRINT("%d targets: %.0f dispatches per second", kTargets, kEvents / elapsed.count());
+    for (auto& target : targets) {
+        queue.remove_handlers(&target);
+    }
+}
+
+TEST(EventQueueTests, newOneShotTimer_firesOnceInDeadlineOrder)
+{
+    EventQueue queue;
+    EventQueueTimer* late = queue.newOneShotTimer(0.03, nullptr);
+    EventQueueTimer* early = queue.newOneShotTimer(0.01, nullptr);
+
+    double start = current_time_seconds();
+    EXPECT_EQ(early, waitForTimer(queue, 1.0));
+    EXPECT_GE(current_time_seconds() - start, 0.01);
+    EXPECT_EQ(late, waitForTimer(queue, 1.0));
+    EXPECT_GE(current_time_seconds() - start, 0.03);
+    EXPECT_EQ(nullptr, waitForTimer(queue, 0.02));
+
+    queue.deleteTimer(early);
+    queue.deleteTimer(late);
+}
+
+TEST(EventQueueTests, restartTimer_pendingOrExpired_firesAgainLater)
+{
+    EventQueue queue;
+    EventQueueTimer* restarted = queue.newOneShotTimer(0.01, nullptr);
+    EventQueueTimer* other = queue.newOneShotTimer(0.03, nullptr);
+
+    // moved behind the other timer
+    queue.restartTimer(restarted, 0.05);
+    EXPECT_EQ(other, waitForTimer(queue, 1.0));
+    EXPECT_EQ(restarted, waitForTimer(queue, 1.0));
+
+    // queued again after it expired
+    queue.restartTimer(restarted, 0.01);
+    EXPECT_EQ(restarted, waitForTimer(queue, 1.0));
+    EXPECT_EQ(nullptr, waitForTimer(queue, 0.02));
+
+    queue.deleteTimer(restarted);
+    queue.deleteTimer(other);
+}
+
+TEST(EventQueueTests, deleteTimer_pendingTimers_neverFire)
+{
+    EventQueue queue;
+
+    // deadlines out of creation order, each one different.  every
+    // other timer is deleted.
+    std::vector<std::pair<int, EventQueueTimer*>> kept;
+    for (int i = 0; i < 100; ++i) {
+        int step = (i * 37) % 100;
+        EventQueueTimer* timer = queue.newOneShotTimer(0.001 + 0.0001 * step, nullptr);
+        if (i % 2 == 0) {
+            queue.deleteTimer(timer);
+        }
+        else {
+            kept.emplace_back(step, timer);
+        }
+    }
+    std::sort(kept.begin(), kept.end());
+
+    std::vector<EventQueueTimer*> expected;
+    for (const auto& timer : kept) {
+        expected.push_back(timer.second);
+    }
+    std::vector<EventQueueTimer*> fired;
+    while (EventQueueTimer* timer = waitForTimer(queue, 0.1)) {
+        fired.push_back(timer);
+    }
+    EXPECT_EQ(expected, fired);
+
+    for (auto* timer : fired) {
+        queue.deleteTimer(timer);
+    }
+}
+
+TEST(EventQueueTests, newTimer_queueBusy_countsMissedPeriods)
+{
+    EventQueue queue;
+    EventQueueTimer* timer = queue.newTimer(0.01, nullptr);
+
+    this_thread_sleep(0.035);
+    std::uint32_t count = 0;
+    EXPECT_EQ(timer, waitForTimer(queue, 1.0, &count));
+    EXPECT_GE(count, 3u);
+
+    // the next period starts from the deadline, not from when the
+    // event was taken
+    count = 0;
+    EXPECT_EQ(timer, waitForTimer(queue, 1.0, &count));
+    EXPECT_EQ(1u, count);
+
+    queue.deleteTimer(timer);
+}
+
+TEST(EventQueueTests, newOneShotTimer_amongIdleTimers_firesInOrderNotEarly)
+{
+    EventQueue queue;
+    std::vector<EventQueueTimer*> idle;
+    for (int i = 0; i < 1000; ++i) {
+        idle.push_back(queue.newTimer(1000.0 + i, nullptr));
+    }
+
+    std::vector<double> deadlines;
+    std::vector<EventQueueTimer*> due;
+    for (int i = 0; i < 5; ++i) {
+        double duration = 0.002 * (i + 1);
+        deadlines.push_back(current_time_seconds() + duration);
+        due.push_back(queue.newOneShotTimer(duration, nullptr));
+    }
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(due[i], waitForTimer(queue, 1.0));
+        EXPECT_GE(current_time_seconds(), deadlines[i]);
+        queue.deleteTimer(due[i]);
+    }
+    EXPECT_EQ(nullptr, waitForTimer(queue, 0.0));
+
+    for (auto* timer : idle) {
+        queue.deleteTimer(timer);
+    }
+}
+
+TEST(EventQueueTests, DISABLED_benchmark_manyTimers)
+{
+    for (int timerCount : { 10, 10000 }) {
+        EventQueue queue;
+
+        // the kind of timers clients and servers keep: long periods that
+        // rarely fire, some of them replaced all the time
+        std::vector<EventQueueTimer*> idle;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < timerCount; ++i) {
+            idle.push_back(queue.newTimer(1000.0 + i, nullptr));
+        }
+        for (int i = 0; i < timerCount; i += 2) {
+            queue.deleteTimer(idle[i]);
+            idle[i] = queue.newOneShotTimer(1000.0 + i, nullptr);
+        }
+        std::chrono::duration<double, std::micro> churn = std::chrono::steady_clock::now() - start;
+
+        // an iteration of the loop that finds no event or timer due
+        const int kPolls = 100000;
+        Event event;
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kPolls; ++i) {
+            queue.getEvent(event, 0.0);
+        }
+        std::chrono::duration<double, std::nano> poll = std::chrono::steady_clock::now() - start;
+
+        // timers due soon among the idle ones
+        const int kDue = 50;
+        std::vector<double> deadlines;
+        std::vector<EventQueueTimer*> due;
+        for (int i = 0; i < kDue; ++i) {
+            double duration = 0.002 * (i + 1);
+            deadlines.push_back(current_time_seconds() + duration);
+            due.push_back(queue.newOneShotTimer(duration, nullptr));
+        }
+        double maxLate = 0.0;
+        double totalLate = 0.0;
+        for (int i = 0; i < kDue; ++i) {
+            EXPECT_EQ(due[i], waitForTimer(queue, 1.0));
+            double late = current_time_seconds() - deadlines[i];
+            EXPECT_GE(late, 0.0);
+            maxLate = std::max(maxLate, late);
+            totalLate += late;
+            queue.deleteTimer(due[i]);
+        }
+
+        LOG_PRINT("%d timers: %.0f ns per idle loop iteration, %.2f us per timer created "
+                  "and deleted, fired %.0f us late on average and %.0f us at most",
+                  timerCount, poll.count() / kPolls, churn.count() / (timerCount * 1.5),
+                  1e6 * totalLate / kDue, 1e6 * maxLate);
+
+        for (auto* timer : idle) {
+            queue.deleteTimer(timer);
+        }
+    }
+}
@@ -0,0 +1,104 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/LogFormat.h"
+
+#include <gtest/gtest.h>
+#include <cstdarg>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace inputleap {
+
+namespace {
+
+// formats through captureLogArgs() and formatLogArgs(), or returns
+// "<not captured>"
+std::string deferred(std::size_t capacity, const char* format, ...)
+{
+    std::vector<char> args(capacity);
+    va_list list;
+    va_start(list, format);
+    bool captured = captureLogArgs(format, list, args.data(), args.size());
+    va_end(list);
+    if (!captured) {
+        return "<not captured>";
+    }
+
+    char out[256];
+    formatLogArgs(format, args.data(), out, sizeof(out));
+    return out;
+}
+
+template <typename... Args>
+std::string immediate(const char* format, Args... args)
+{
+    char out[256];
+    std::snprintf(out, sizeof(out), format, args...);
+    return out;
+}
+
+} // namespace
+
+TEST(LogFormatTests, formatLogArgs_integers_matchPrintf)
+{
+    EXPECT_EQ(immediate("%d %i %+d %u", -5, 7, 3, 4000000000u),
+              deferred(256, "%d %i %+d %u", -5, 7, 3, 4000000000u));
+    EXPECT_EQ(immediate("%04x %08x %03x %X", 0xab, 0xdeadbeef, 1, 255),
+              deferred(256, "%04x %08x %03x %X", 0xab, 0xdeadbeef, 1, 255));
+    EXPECT_EQ(immediate("%ld %08lx %zd %zu %zi", -1L, 0x1234L, static_cast<std::ptrdiff_t>(-9),
+                        static_cast<std::size_t>(9), static_cast<std::ptrdiff_t>(10)),
+              deferred(256, "%ld %08lx %zd %zu %zi", -1L, 0x1234L, static_cast<std::ptrdiff_t>(-9),
+                       static_cast<std::size_t>(9), static_cast<std::ptrdiff_t>(10)));
+    EXPECT_EQ(immediate("%hhu %hd", 300, 70000), deferred(256, "%hhu %hd", 300, 70000));
+}
+
+TEST(LogFormatTests, formatLogArgs_otherConversions_matchPrintf)
+{
+    int value = 0;
+    EXPECT_EQ(immediate("%c%c %p 100%%", 'o', 'k', static_cast<void*>(&value)),
+              deferred(256, "%c%c %p 100%%", 'o', 'k', static_cast<void*>(&value)));
+    EXPECT_EQ(immediate("%f %.2f %+.2f %0.2f %.0f", 1.5, 2.25, 3.5, 0.125, 9.9),
+              deferred(256, "%f %.2f %+.2f %0.2f %.0f", 1.5, 2.25, 3.5, 0.125, 9.9));
+    EXPECT_EQ(immediate("%*d|%-*d|%.*f", 5, 1, 4, 2, 3, 1.0),
+              deferred(256, "%*d|%-*d|%.*f", 5, 1, 4, 2, 3, 1.0));
+}
+
+TEST(LogFormatTests, formatLogArgs_strings_copiedWithPrecision)
+{
+    char unterminated[4] = { 'a', 'b', 'c', 'd' };
+    EXPECT_EQ("[abc] [hello] [(null)]",
+              deferred(256, "[%.3s] [%s] [%s]", unterminated, "hello",
+                       static_cast<const char*>(nullptr)));
+    EXPECT_EQ("[ab]", deferred(256, "[%.*s]", 2, "abc"));
+}
+
+TEST(LogFormatTests, captureLogArgs_tooLarge_returnsFalse)
+{
+    EXPECT_EQ("<not captured>", deferred(8, "%s", "longer than eight"));
+    EXPECT_EQ("<not captured>", deferred(8, "%d %d", 1, 2));
+    EXPECT_EQ("1", deferred(8, "%d", 1));
+}
+
+TEST(LogFormatTests, captureLogArgs_unsupported_returnsFalse)
+{
+    EXPECT_EQ("<not captured>", deferred(256, "%Lf", 1.0L));
+    EXPECT_EQ("<not captured>", deferred(256, "%ls", L"wide"));
+}
+
+} // namespace inputleap
@@ -0,0 +1,267 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/Log.h"
+#include "base/log_outputters.h"
+#include "io/filesystem.h"
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace inputleap {
+
+namespace {
+
+class CaptureLogOutputter : public ILogOutputter {
+public:
+    void open(const char*) override { }
+    void close() override { }
+    void show(bool) override { }
+    bool write(ELevel level, const char* message) override
+    {
+        m_messages.push_back(message);
+        return true;
+    }
+    void flush() override { ++m_flushes; }
+
+    std::vector<std::string> m_messages;
+    int m_flushes = 0;
+};
+
+// routes the log to one outputter for the lifetime of the object
+class LogCapture {
+public:
+    explicit LogCapture(ILogOutputter* outputter) :
+        m_outputter(outputter)
+    {
+        CLOG->insert(&m_stop);
+        CLOG->insert(m_outputter);
+    }
+
+    ~LogCapture()
+    {
+        CLOG->setAsync(false);
+        CLOG->setFilter(kDEBUG4);
+        CLOG->remove(m_outputter);
+        CLOG->remove(&m_stop);
+    }
+
+private:
+    StopLogOutputter m_stop;
+    ILogOutputter* m_outputter;
+};
+
+bool contains(const std::string& message, const char* text)
+{
+    return message.find(text) != std::string::npos;
+}
+
+struct Cost {
+    double messagesPerSecond;
+    double callNs;
+};
+
+// logs from several threads and measures how long the calls take and
+// how long until everything is written
+Cost measure(bool async, int threads, int perThread)
+{
+    CLOG->setAsync(async);
+
+    std::vector<double> callNs(threads);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([t, perThread, &callNs]() {
+            auto begin = std::chrono::steady_clock::now();
+            for (int i = 0; i < perThread; ++i) {
+                LOG_DEBUG1("thread %d message %d: moved the cursor to %d,%d", t, i, i, -i);
+            }
+            callNs[t] = std::chrono::duration<double, std::nano>(
+                        std::chrono::steady_clock::now() - begin).count() / perThread;
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    CLOG->setAsync(false);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    Cost cost;
+    cost.messagesPerSecond = threads * perThread / elapsed.count();
+    cost.callNs = 0;
+    for (double ns : callNs) {
+        cost.callNs += ns / threads;
+    }
+    return cost;
+}
+
+// measures the cost of a call when the writer keeps up:  messages are
+// logged in bursts that fit the buffer, waiting for the writer in between
+double measureBurst(bool async, int bursts, int perBurst)
+{
+    CLOG->setAsync(async);
+
+    std::chrono::duration<double, std::nano> calls(0);
+    for (int burst = 0; burst < bursts; ++burst) {
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < perBurst; ++i) {
+            LOG_DEBUG1("burst %d message %d: moved the cursor to %d,%d", burst, i, i, -i);
+        }
+        calls += std::chrono::steady_clock::now() - begin;
+        CLOG->flush();
+    }
+    CLOG->setAsync(false);
+    return calls.count() / (bursts * perBurst);
+}
+
+} // namespace
+
+TEST(LogTests, async_writesMessagesInOrder)
+{
+    CaptureLogOutputter capture;
+    {
+        LogCapture scope(&capture);
+        CLOG->setAsync(true);
+
+        std::thread other([]() {
+            for (int i = 0; i < 500; ++i) {
+                LOG_DEBUG("other %d", i);
+            }
+        });
+        for (int i = 0; i < 500; ++i) {
+            LOG_DEBUG("main %d", i);
+        }
+        other.join();
+    }
+
+    int main = 0;
+    int other = 0;
+    for (const auto& message : capture.m_messages) {
+        if (contains(message, "DEBUG: main ")) {
+            EXPECT_TRUE(contains(message, ("main " + std::to_string(main++)).c_str()));
+        }
+        else if (contains(message, "DEBUG: other ")) {
+            EXPECT_TRUE(contains(message, ("other " + std::to_string(other++)).c_str()));
+        }
+    }
+    EXPECT_EQ(500, main);
+    EXPECT_EQ(500, other);
+    EXPECT_LT(capture.m_flushes, 1000);
+}
+
+TEST(LogTests, async_errorWrittenAfterBufferedMessages)
+{
+    CaptureLogOutputter capture;
+    LogCapture scope(&capture);
+    CLOG->setAsync(true);
+
+    LOG_DEBUG("first");
+    LOG_ERR("second");
+
+    // the error is written before LOG_ERR returns
+    std::vector<std::string> written;
+    for (const auto& message : capture.m_messages) {
+        if (contains(message, ": first") || contains(message, ": second")) {
+            written.push_back(message);
+        }
+    }
+    ASSERT_EQ(2u, written.size());
+    EXPECT_TRUE(contains(written[0], "DEBUG: first"));
+    EXPECT_TRUE(contains(written[1], "ERROR: second"));
+}
+
+TEST(LogTests, print_filtered_skipsArguments)
+{
+    CaptureLogOutputter capture;
+    LogCapture scope(&capture);
+    CLOG->setFilter(kINFO);
+
+    int evaluated = 0;
+    auto argument = [&evaluated]() { return ++evaluated; };
+    LOG_DEBUG("%d", argument());
+    LOG_INFO("%d", argument());
+
+    EXPECT_EQ(1, evaluated);
+    EXPECT_EQ(1u, capture.m_messages.size());
+}
+
+TEST(LogTests, fileOutputter_rotatesWhenFull)
+{
+    const char* kFilename = "LogTests.log";
+    std::remove(kFilename);
+    std::remove("LogTests.log.1");
+
+    {
+        FileLogOutputter file(kFilename);
+        std::string line(1000, 'x');
+        for (int i = 0; i < 1100; ++i) {
+            file.write(kINFO, line.c_str());
+        }
+        file.flush();
+    }
+
+    EXPECT_TRUE(fs::exists("LogTests.log.1"));
+    EXPECT_GT(fs::file_size("LogTests.log.1"), 1024u * 1024);
+    EXPECT_LT(fs::file_size(kFilename), 1024u * 1024);
+    std::remove(kFilename);
+    std::remove("LogTests.log.1");
+}
+
+TEST(LogTests, DISABLED_benchmark_syncAndAsyncFileLogging)
+{
+    const int kThreads = 4;
+    const int kPerThread = 20000;
+    const char* kFilename = "LogTests.benchmark.log";
+
+    Cost sync;
+    Cost async;
+    double syncBurstNs;
+    double asyncBurstNs;
+    double disabledNs;
+    {
+        FileLogOutputter file(kFilename);
+        LogCapture scope(&file);
+        sync = measure(false, kThreads, kPerThread);
+        async = measure(true, kThreads, kPerThread);
+        syncBurstNs = measureBurst(false, 200, 32);
+        asyncBurstNs = measureBurst(true, 200, 32);
+
+        CLOG->setFilter(kINFO);
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < kPerThread; ++i) {
+            LOG_DEBUG1("filtered message %d", i);
+        }
+        disabledNs = std::chrono::duration<double, std::nano>(
+                    std::chrono::steady_clock::now() - begin).count() / kPerThread;
+    }
+    std::remove(kFilename);
+    std::remove("LogTests.benchmark.log.1");
+
+    LOG_PRINT("file logging from %d threads: sync %.0f msg/s %.0f ns per call, "
+              "async %.0f msg/s %.0f ns per call, filtered %.1f ns per call",
+              kThreads, sync.messagesPerSecond, sync.callNs,
+              async.messagesPerSecond, async.callNs, disabledNs);
+    LOG_PRINT("file logging in bursts: sync %.0f ns per call, async %.0f ns per call",
+              syncBurstNs, asyncBurstNs);
+}
+
+} // namespace inputleap
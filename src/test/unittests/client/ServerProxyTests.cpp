@@ -0,0 +1,292 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test/mock/client/MockClient.h"
+#include "test/global/TestEventQueue.h"
+#include "test/mock/io/MemoryStream.h"
+#include "client/ServerProxy.h"
+#include "inputleap/Clipboard.h"
+#include "inputleap/ClipboardChunk.h"
+#include "inputleap/ProtocolUtil.h"
+#include "inputleap/protocol_types.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using ::testing::_;
+using ::testing::InSequence;
+using ::testing::Invoke;
+using ::testing::NiceMock;
+using ::testing::Return;
+using ::testing::Throw;
+
+namespace inputleap {
+
+namespace {
+
+class ServerProxyTests : public ::testing::Test {
+public:
+    ServerProxyTests() : proxy_(&client_, &stream_, &events_)
+    {
+        // finish the handshake
+        std::vector<std::uint32_t> options;
+        send(kMsgDSetOptions, &options);
+        proxy_.handleDataForTest();
+        stream_.output_.clear();
+    }
+
+    // queues a message from the server
+    template<class... Args>
+    void send(const char* format, Args... args)
+    {
+        MemoryStream server;
+        ProtocolUtil::writef(&server, format, args...);
+        stream_.input_.insert(stream_.input_.end(), server.output_.begin(),
+                              server.output_.end());
+    }
+
+    // advertises text as the server's clipboard.  size overrides the
+    // announced size.
+    void advertise(std::uint32_t sequence, const std::string& text,
+                   std::uint32_t size = kTextSize)
+    {
+        Clipboard clipboard;
+        clipboard.open(0);
+        clipboard.add(IClipboard::kText, text);
+        Clipboard::Digest digest = clipboard.digest(IClipboard::kText);
+        clipboard.close();
+
+        std::vector<std::uint32_t> formats = {
+            IClipboard::kText,
+            size == kTextSize ? static_cast<std::uint32_t>(text.size()) : size,
+            static_cast<std::uint32_t>(digest[0] >> 32),
+            static_cast<std::uint32_t>(digest[0]),
+            static_cast<std::uint32_t>(digest[1] >> 32),
+            static_cast<std::uint32_t>(digest[1])
+        };
+        send(kMsgDClipboardFormats, kClipboardClipboard, sequence, &formats);
+    }
+
+    // replies with text to a query for the given advertisement
+    void reply(std::uint32_t sequence, const std::string& text)
+    {
+        Clipboard clipboard;
+        clipboard.open(0);
+        clipboard.add(IClipboard::kText, text);
+        clipboard.close();
+        auto data = std::make_shared<const std::string>(clipboard.marshall());
+
+        for (const auto& chunk : {
+                ClipboardChunk::start(kClipboardClipboard, sequence, data->size()),
+                ClipboardChunk::data(kClipboardClipboard, sequence, data, 0, data->size()),
+                ClipboardChunk::end(kClipboardClipboard, sequence) }) {
+            send(kMsgDClipboardSlice, chunk.id_, chunk.sequence_, chunk.mark_,
+                 static_cast<std::uint32_t>(chunk.size_),
+                 reinterpret_cast<const std::uint8_t*>(chunk.bytes()));
+        }
+    }
+
+    // number of times the text was asked for
+    std::size_t queries()
+    {
+        MemoryStream query;
+        ProtocolUtil::write_message<kMsgQClipboardFormat>(
+                &query, kClipboardClipboard, static_cast<std::uint8_t>(IClipboard::kText));
+
+        std::size_t count = 0;
+        auto i = stream_.output_.begin();
+        while ((i = std::search(i, stream_.output_.end(), query.output_.begin(),
+                                query.output_.end())) != stream_.output_.end()) {
+            ++count;
+            ++i;
+        }
+        return count;
+    }
+
+    static const std::uint32_t kTextSize = 0xffffffff;
+
+    TestEventQueue events_;
+    NiceMock<MockClient> client_;
+    MemoryStream stream_;
+    ServerProxy proxy_;
+};
+
+} // namespace
+
+TEST_F(ServerProxyTests, handleData_inputMessages_synthesizedInOneBatch)
+{
+    send(kMsgDKeyDown, 0x61, 0, 38);
+    send(kMsgDMouseDown, 1);
+    send(kMsgDMouseMove, 10, 20);
+
+    InSequence seq;
+    EXPECT_CALL(client_, beginFakeBatch()).Times(1);
+    EXPECT_CALL(client_, keyDown(0x61, _, 38)).Times(1);
+    EXPECT_CALL(client_, mouseDown(1)).Times(1);
+    EXPECT_CALL(client_, mouseMove(10, 20)).Times(1);
+    EXPECT_CALL(client_, endFakeBatch()).Times(1);
+
+    proxy_.handleDataForTest();
+}
+
+TEST_F(ServerProxyTests, handleData_otherMessageAfterInput_endsBatchBeforeIt)
+{
+    send(kMsgDMouseMove, 10, 20);
+    send(kMsgDMouseMove, 30, 40);
+    send(kMsgCScreenSaver, 1);
+    send(kMsgDMouseDown, 1);
+
+    // the compressed motion is sent with the batch it belongs to
+    InSequence seq;
+    EXPECT_CALL(client_, beginFakeBatch()).Times(1);
+    EXPECT_CALL(client_, mouseMove(30, 40)).Times(1);
+    EXPECT_CALL(client_, endFakeBatch()).Times(1);
+    EXPECT_CALL(client_, screensaver(true)).Times(1);
+    EXPECT_CALL(client_, beginFakeBatch()).Times(1);
+    EXPECT_CALL(client_, mouseDown(1)).Times(1);
+    EXPECT_CALL(client_, endFakeBatch()).Times(1);
+
+    proxy_.handleDataForTest();
+}
+
+TEST_F(ServerProxyTests, handleData_noInputMessages_noBatch)
+{
+    send(kMsgCScreenSaver, 1);
+
+    EXPECT_CALL(client_, beginFakeBatch()).Times(0);
+    EXPECT_CALL(client_, endFakeBatch()).Times(0);
+
+    proxy_.handleDataForTest();
+}
+
+TEST_F(ServerProxyTests, handleData_exceptionDuringBatch_endsBatch)
+{
+    send(kMsgDMouseDown, 1);
+
+    EXPECT_CALL(client_, beginFakeBatch()).Times(1);
+    EXPECT_CALL(client_, mouseDown(1)).WillOnce(Throw(std::runtime_error("failed")));
+    EXPECT_CALL(client_, endFakeBatch()).Times(1);
+
+    EXPECT_THROW(proxy_.handleDataForTest(), std::runtime_error);
+}
+
+TEST_F(ServerProxyTests, clipboardFormats_screenCannotDefer_fetchesAndSetsClipboardOnce)
+{
+    // a screen that can't keep promises reads all the data right away
+    std::vector<std::string> texts;
+    EXPECT_CALL(client_, setClipboard(kClipboardClipboard, _)).Times(2)
+        .WillRepeatedly(Invoke([&texts](ClipboardID, const IClipboard* clipboard) {
+            clipboard->open(0);
+            texts.push_back(clipboard->get(IClipboard::kText));
+            clipboard->close();
+        }));
+
+    advertise(1, "hello");
+    proxy_.handleDataForTest();
+    EXPECT_EQ(1u, queries());
+
+    reply(1, "hello");
+    proxy_.handleDataForTest();
+    EXPECT_EQ((std::vector<std::string>{ "", "hello" }), texts);
+}
+
+TEST_F(ServerProxyTests, clipboardFormats_replyToOlderAdvertisement_isDropped)
+{
+    EXPECT_CALL(client_, setClipboardFormat(_, _, "old")).Times(0);
+    EXPECT_CALL(client_, setClipboardFormat(kClipboardClipboard, IClipboard::kText, "new"))
+        .WillOnce(Return(true));
+
+    advertise(1, "old");
+    proxy_.handleDataForTest();
+    proxy_.requestClipboardFormat(kClipboardClipboard, IClipboard::kText);
+
+    // the new advertisement overtakes the reply to the old one
+    advertise(2, "new");
+    reply(1, "old");
+    proxy_.handleDataForTest();
+    proxy_.requestClipboardFormat(kClipboardClipboard, IClipboard::kText);
+    EXPECT_EQ(2u, queries());
+
+    reply(2, "new");
+    proxy_.handleDataForTest();
+}
+
+TEST_F(ServerProxyTests, clipboardFormats_dataNotAsAdvertised_withdrawsFormat)
+{
+    EXPECT_CALL(client_, setClipboardFormat(_, _, _)).Times(0);
+    EXPECT_CALL(client_, withdrawClipboardFormat(kClipboardClipboard, IClipboard::kText))
+        .Times(1);
+
+    advertise(1, "hello");
+    proxy_.handleDataForTest();
+    proxy_.requestClipboardFormat(kClipboardClipboard, IClipboard::kText);
+
+    reply(1, "world");
+    proxy_.handleDataForTest();
+
+    // nothing is pending anymore so the format isn't asked for again
+    proxy_.requestClipboardFormat(kClipboardClipboard, IClipboard::kText);
+    EXPECT_EQ(1u, queries());
+}
+
+TEST_F(ServerProxyTests, clipboardFormats_sizeNotAsAdvertised_withdrawsFormat)
+{
+    EXPECT_CALL(client_, setClipboardFormat(_, _, _)).Times(0);
+    EXPECT_CALL(client_, withdrawClipboardFormat(kClipboardClipboard, IClipboard::kText))
+        .Times(1);
+
+    advertise(1, "hello", 1000);
+    proxy_.handleDataForTest();
+    proxy_.requestClipboardFormat(kClipboardClipboard, IClipboard::kText);
+
+    reply(1, "hello");
+    proxy_.handleDataForTest();
+}
+
+TEST_F(ServerProxyTests, requestClipboardFormat_askedTwice_queriesOnce)
+{
+    advertise(1, "hello");
+    proxy_.handleDataForTest();
+
+    proxy_.requestClipboardFormat(kClipboardClipboard, IClipboard::kText);
+    proxy_.requestClipboardFormat(kClipboardClipboard, IClipboard::kText);
+    EXPECT_EQ(1u, queries());
+}
+
+TEST_F(ServerProxyTests, destroy_requestPending_withdrawsPromisedFormats)
+{
+    // another connection over the same stream, dropped while the screen
+    // waits for the text
+    auto proxy = std::make_unique<ServerProxy>(&client_, &stream_, &events_);
+    std::vector<std::uint32_t> options;
+    send(kMsgDSetOptions, &options);
+    advertise(1, "hello");
+    proxy->handleDataForTest();
+    proxy->requestClipboardFormat(kClipboardClipboard, IClipboard::kText);
+    EXPECT_EQ(1u, queries());
+
+    EXPECT_CALL(client_, withdrawClipboardFormat(kClipboardClipboard, IClipboard::kText))
+        .Times(1);
+    proxy.reset();
+}
+
+} // namespace inputleap
@@ -0,0 +1,295 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "inputleap/ChunkCompressor.h"
+#include "inputleap/ClipboardStream.h"
+#include "inputleap/protocol_types.h"
+#include "base/Log.h"
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace inputleap {
+
+namespace {
+
+std::string make_text(std::size_t size)
+{
+    static const char* words[] = {
+        "the", "clipboard", "is", "shared", "between", "screens", "and", "every",
+        "paste", "sends", "text", "over", "a", "network", "connection", "quickly"
+    };
+    std::mt19937 random(1);
+    std::string text;
+    while (text.size() < size) {
+        text += words[random() % 16];
+        text += (random() % 12 == 0) ? "\n" : " ";
+    }
+    text.resize(size);
+    return text;
+}
+
+std::string make_html(std::size_t size)
+{
+    std::mt19937 random(2);
+    std::string html;
+    while (html.size() < size) {
+        html += "<tr><td class=\"cell\">";
+        html += std::to_string(random() % 100000);
+        html += "</td><td style=\"color: #333\">";
+        html += make_text(random() % 40);
+        html += "</td></tr>\n";
+    }
+    html.resize(size);
+    return html;
+}
+
+// a 32bpp screenshot-like bitmap:  flat areas with some gradients
+std::string make_bitmap(std::size_t width, std::size_t height)
+{
+    std::string bitmap(40 + width * height * 4, '\0');
+    for (std::size_t y = 0; y < height; ++y) {
+        for (std::size_t x = 0; x < width; ++x) {
+            char* pixel = &bitmap[40 + (y * width + x) * 4];
+            bool window = x > width / 4 && y > height / 4 && y < height * 3 / 4;
+            pixel[0] = static_cast<char>(window ? 0xf0 : x * 255 / width);
+            pixel[1] = static_cast<char>(window ? 0xf0 : 0x40);
+            pixel[2] = static_cast<char>(window ? 0xf0 : y * 255 / height);
+            pixel[3] = static_cast<char>(0xff);
+        }
+    }
+    return bitmap;
+}
+
+// stands in for PNG data:  a PNG signature followed by noise
+std::string make_png(std::size_t size)
+{
+    std::mt19937 random(3);
+    std::string png(size, '\0');
+    for (auto& c : png) {
+        c = static_cast<char>(random());
+    }
+    png.replace(0, 8, "\x89PNG\r\n\x1a\n", 8);
+    return png;
+}
+
+struct Transfer {
+    std::size_t wire = 0;
+    double compress_ns = 0;
+    double decompress_ns = 0;
+};
+
+Transfer send(const std::string& data, bool compression, bool compressible = true)
+{
+    ClipboardStream stream;
+    stream.set_compression(compression);
+    stream.push(kClipboardClipboard, 0, std::make_shared<const std::string>(data), true,
+                compressible);
+
+    Transfer transfer;
+    std::vector<ClipboardChunk> chunks;
+    auto start = std::chrono::steady_clock::now();
+    while (stream.pump([&chunks](const ClipboardChunk& chunk) { chunks.push_back(chunk); })) {
+    }
+    transfer.compress_ns = std::chrono::duration<double, std::nano>(
+                std::chrono::steady_clock::now() - start).count();
+
+    std::string received;
+    start = std::chrono::steady_clock::now();
+    for (const auto& chunk : chunks) {
+        transfer.wire += chunk.size_;
+        if (chunk.mark_ == kDataChunk) {
+            received.append(chunk.bytes(), chunk.size_);
+        }
+        else if (chunk.mark_ == kDataChunkLZ4) {
+            EXPECT_TRUE(ChunkCompressor::decompress(*chunk.buffer_, received,
+                                                    data.size() - received.size()));
+        }
+    }
+    transfer.decompress_ns = std::chrono::duration<double, std::nano>(
+                std::chrono::steady_clock::now() - start).count();
+
+    EXPECT_EQ(data, received);
+    return transfer;
+}
+
+} // namespace
+
+TEST(ChunkCompressorTests, compress_text_roundTrips)
+{
+    std::string text = make_text(32 * 1024);
+    ChunkCompressor compressor;
+    std::string packed;
+    ASSERT_TRUE(compressor.compress(text.data(), text.size(), packed));
+    EXPECT_LT(packed.size(), text.size() / 2);
+
+    std::string unpacked = "prefix";
+    ASSERT_TRUE(ChunkCompressor::decompress(packed, unpacked, text.size()));
+    EXPECT_EQ("prefix" + text, unpacked);
+}
+
+TEST(ChunkCompressorTests, compress_runs_roundTrips)
+{
+    // long runs make matches that overlap themselves
+    std::string data(1000, 'a');
+    data += std::string(300, 'b') + "tail of the data";
+    ChunkCompressor compressor;
+    std::string packed;
+    ASSERT_TRUE(compressor.compress(data.data(), data.size(), packed));
+
+    std::string unpacked;
+    ASSERT_TRUE(ChunkCompressor::decompress(packed, unpacked, data.size()));
+    EXPECT_EQ(data, unpacked);
+}
+
+TEST(ChunkCompressorTests, compress_noise_backsOff)
+{
+    std::string noise = make_png(32 * 1024).substr(8);
+    ChunkCompressor compressor;
+    std::string packed;
+    EXPECT_FALSE(compressor.compress(noise.data(), noise.size(), packed));
+
+    // skips one chunk, then tries again and skips three
+    EXPECT_FALSE(compressor.compress(noise.data(), noise.size(), packed));
+    EXPECT_FALSE(compressor.compress(noise.data(), noise.size(), packed));
+
+    std::string text = make_text(1024);
+    EXPECT_FALSE(compressor.compress(text.data(), text.size(), packed));
+    compressor.reset();
+    EXPECT_TRUE(compressor.compress(text.data(), text.size(), packed));
+}
+
+TEST(ChunkCompressorTests, compress_compressedFile_skipsTransfer)
+{
+    std::string png = make_png(64);
+    png += make_text(4096);
+    ChunkCompressor compressor;
+    std::string packed;
+    EXPECT_FALSE(compressor.compress(png.data(), png.size(), packed));
+
+    std::string text = make_text(4096);
+    EXPECT_FALSE(compressor.compress(text.data(), text.size(), packed));
+
+    compressor.reset(false);
+    EXPECT_FALSE(compressor.compress(text.data(), text.size(), packed));
+}
+
+TEST(ChunkCompressorTests, decompress_overLimit_returnsFalse)
+{
+    std::string data(4096, 'x');
+    ChunkCompressor compressor;
+    std::string packed;
+    ASSERT_TRUE(compressor.compress(data.data(), data.size(), packed));
+
+    std::string unpacked;
+    EXPECT_FALSE(ChunkCompressor::decompress(packed, unpacked, data.size() - 1));
+}
+
+TEST(ChunkCompressorTests, decompress_corrupt_returnsFalse)
+{
+    std::string text = make_text(4096);
+    ChunkCompressor compressor;
+    std::string packed;
+    ASSERT_TRUE(compressor.compress(text.data(), text.size(), packed));
+
+    std::string unpacked;
+    EXPECT_FALSE(ChunkCompressor::decompress(packed.substr(0, packed.size() / 2), unpacked,
+                                             text.size()));
+    unpacked.clear();
+    EXPECT_FALSE(ChunkCompressor::decompress("", unpacked, text.size()));
+
+    // a match reaching back before the start of the chunk
+    unpacked.clear();
+    EXPECT_FALSE(ChunkCompressor::decompress(std::string("\x10" "a" "\x05\x00", 4), unpacked,
+                                             text.size()));
+}
+
+TEST(ChunkCompressorTests, isCompressible_imageFormats)
+{
+    EXPECT_TRUE(ChunkCompressor::is_compressible(IClipboard::kText));
+    EXPECT_TRUE(ChunkCompressor::is_compressible(IClipboard::kHTML));
+    EXPECT_TRUE(ChunkCompressor::is_compressible(IClipboard::kBitmap));
+    EXPECT_FALSE(ChunkCompressor::is_compressible(IClipboard::kPNG));
+    EXPECT_FALSE(ChunkCompressor::is_compressible(IClipboard::kJpeg));
+    EXPECT_FALSE(ChunkCompressor::is_compressible(IClipboard::kWebp));
+}
+
+TEST(ChunkCompressorTests, pump_compression_sendsCompressedChunks)
+{
+    std::string text = make_text(100 * 1024);
+    Transfer plain = send(text, false);
+    Transfer packed = send(text, true);
+    EXPECT_EQ(text.size() + 6, plain.wire);
+    EXPECT_LT(packed.wire, plain.wire / 2);
+
+    // marked as compressed already so sent as is
+    Transfer hinted = send(text, true, false);
+    EXPECT_EQ(plain.wire, hinted.wire);
+}
+
+TEST(ChunkCompressorTests, pump_compression_neverMuchLarger)
+{
+    const std::string payloads[] = {
+        make_html(32 * 1024),
+        make_bitmap(64, 64),
+        make_png(32 * 1024),
+    };
+    for (const auto& payload : payloads) {
+        Transfer plain = send(payload, false);
+        Transfer packed = send(payload, true);
+        EXPECT_LE(packed.wire, plain.wire + plain.wire / 100);
+    }
+}
+
+TEST(ChunkCompressorTests, DISABLED_benchmark_clipboardCorpus)
+{
+    struct Payload {
+        const char* name;
+        std::string data;
+    };
+    const Payload corpus[] = {
+        { "text", make_text(64 * 1024) },
+        { "html", make_html(256 * 1024) },
+        { "bitmap", make_bitmap(1280, 800) },
+        { "png", make_png(1024 * 1024) },
+    };
+
+    // links throttled to 10 and 100 Mbit/s
+    const double kLinkBytesPerNs[] = { 10e6 / 8 / 1e9, 100e6 / 8 / 1e9 };
+
+    for (const auto& payload : corpus) {
+        Transfer plain = send(payload.data, false);
+        Transfer packed = send(payload.data, true);
+        EXPECT_LE(packed.wire, plain.wire + plain.wire / 100) << payload.name;
+
+        for (double rate : kLinkBytesPerNs) {
+            double plainMs = (plain.compress_ns + plain.wire / rate + plain.decompress_ns) / 1e6;
+            double packedMs = (packed.compress_ns + packed.wire / rate +
+                               packed.decompress_ns) / 1e6;
+            LOG_PRINT("%s %zu bytes at %.0f Mbit/s: raw %zu bytes %.2f ms, "
+                      "compressed %zu bytes %.2f ms",
+                      payload.name, payload.data.size(), rate * 8e3,
+                      plain.wire, plainMs, packed.wire, packedMs);
+        }
+    }
+}
+
+} // namespace inputleap
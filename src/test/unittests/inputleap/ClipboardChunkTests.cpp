@@ -0,0 +1,75 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "inputleap/ClipboardChunk.h"
+#include "inputleap/ProtocolUtil.h"
+#include "inputleap/protocol_types.h"
+#include "test/mock/io/MemoryStream.h"
+
+#include <gtest/gtest.h>
+#include <string>
+
+namespace inputleap {
+
+namespace {
+
+// writes a chunk and assembles it again
+int assemble(const ClipboardChunk& chunk, std::string& data)
+{
+    MemoryStream stream;
+    ProtocolUtil::writef(&stream, kMsgDClipboardSlice, chunk.id_, chunk.sequence_, chunk.mark_,
+                         static_cast<std::uint32_t>(chunk.size_),
+                         reinterpret_cast<const std::uint8_t*>(chunk.bytes()));
+    stream.replay();
+    stream.skip(4);
+
+    ClipboardID id;
+    std::uint32_t sequence;
+    return ClipboardChunk::assemble(&stream, data, id, sequence);
+}
+
+} // namespace
+
+TEST(ClipboardChunkTests, assemble_chunks_givesData)
+{
+    auto buffer = std::make_shared<const std::string>("hello world");
+    std::string data;
+
+    EXPECT_EQ(kStart, assemble(ClipboardChunk::start(kClipboardClipboard, 1, 11), data));
+    EXPECT_EQ(kNotFinish, assemble(ClipboardChunk::data(kClipboardClipboard, 1, buffer, 0, 5),
+                                   data));
+    EXPECT_EQ(kNotFinish, assemble(ClipboardChunk::data(kClipboardClipboard, 1, buffer, 5, 6),
+                                   data));
+    EXPECT_EQ(kFinish, assemble(ClipboardChunk::end(kClipboardClipboard, 1), data));
+    EXPECT_EQ("hello world", data);
+}
+
+TEST(ClipboardChunkTests, assemble_hugeAnnouncedSize_reservesBoundedAmount)
+{
+    const std::size_t kAnnounced = std::size_t(1) << 30;
+    std::string data;
+
+    EXPECT_EQ(kStart, assemble(ClipboardChunk::start(kClipboardClipboard, 1, kAnnounced), data));
+    EXPECT_LE(data.capacity(), ClipboardChunk::kMaxReservedSize);
+
+    // the announced size is still checked at the end
+    auto buffer = std::make_shared<const std::string>("hello");
+    assemble(ClipboardChunk::data(kClipboardClipboard, 1, buffer, 0, 5), data);
+    EXPECT_EQ(kError, assemble(ClipboardChunk::end(kClipboardClipboard, 1), data));
+}
+
+} // namespace inputleap
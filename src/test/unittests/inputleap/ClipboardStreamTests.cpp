@@ -0,0 +1,108 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "inputleap/ClipboardStream.h"
+#include "inputleap/protocol_types.h"
+
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace inputleap {
+
+namespace {
+
+std::vector<ClipboardChunk> pumpAll(ClipboardStream& stream, std::size_t* pumps = nullptr)
+{
+    std::vector<ClipboardChunk> chunks;
+    std::size_t count = 0;
+    while (stream.pump([&chunks](const ClipboardChunk& chunk) { chunks.push_back(chunk); })) {
+        ++count;
+    }
+    if (pumps != nullptr) {
+        *pumps = count;
+    }
+    return chunks;
+}
+
+} // namespace
+
+TEST(ClipboardStreamTests, pump_largeClipboard_slicesOneBuffer)
+{
+    auto data = std::make_shared<const std::string>(100 * 1024, 'x');
+    ClipboardStream stream;
+    stream.push(kClipboardClipboard, 7, data);
+
+    auto chunks = pumpAll(stream);
+
+    ASSERT_EQ(6u, chunks.size());
+    EXPECT_EQ(kDataStart, chunks[0].mark_);
+    EXPECT_EQ("102400", std::string(chunks[0].bytes(), chunks[0].size_));
+    std::string joined;
+    for (std::size_t i = 1; i < 5; ++i) {
+        EXPECT_EQ(kDataChunk, chunks[i].mark_);
+        EXPECT_EQ(7u, chunks[i].sequence_);
+        EXPECT_EQ(data, chunks[i].buffer_);
+        joined.append(chunks[i].bytes(), chunks[i].size_);
+    }
+    EXPECT_EQ(*data, joined);
+    EXPECT_EQ(kDataEnd, chunks[5].mark_);
+    EXPECT_TRUE(stream.empty());
+}
+
+TEST(ClipboardStreamTests, pump_window_limitsDataPerCall)
+{
+    ClipboardStream stream(ClipboardStream::kChunkSize * 2);
+    stream.push(kClipboardClipboard, 0,
+                std::make_shared<const std::string>(ClipboardStream::kChunkSize * 5, 'x'));
+
+    std::size_t pumps = 0;
+    auto chunks = pumpAll(stream, &pumps);
+
+    EXPECT_EQ(7u, chunks.size());
+    EXPECT_EQ(3u, pumps);
+}
+
+TEST(ClipboardStreamTests, push_notStarted_replacedByNewer)
+{
+    ClipboardStream stream;
+    stream.push(kClipboardClipboard, 1, std::make_shared<const std::string>("old"));
+    stream.push(kClipboardSelection, 1, std::make_shared<const std::string>("other"));
+    stream.push(kClipboardClipboard, 2, std::make_shared<const std::string>("new"));
+
+    auto chunks = pumpAll(stream);
+
+    ASSERT_EQ(6u, chunks.size());
+    EXPECT_EQ(kClipboardClipboard, chunks[1].id_);
+    EXPECT_EQ(2u, chunks[1].sequence_);
+    EXPECT_EQ("new", std::string(chunks[1].bytes(), chunks[1].size_));
+    EXPECT_EQ(kClipboardSelection, chunks[4].id_);
+}
+
+TEST(ClipboardStreamTests, push_noReplace_sendsBoth)
+{
+    ClipboardStream stream;
+    stream.push(kClipboardClipboard, 0, std::make_shared<const std::string>("text"), false);
+    stream.push(kClipboardClipboard, 0, std::make_shared<const std::string>("html"), false);
+
+    auto chunks = pumpAll(stream);
+
+    ASSERT_EQ(6u, chunks.size());
+    EXPECT_EQ("text", std::string(chunks[1].bytes(), chunks[1].size_));
+    EXPECT_EQ("html", std::string(chunks[4].bytes(), chunks[4].size_));
+}
+
+} // namespace inputleap
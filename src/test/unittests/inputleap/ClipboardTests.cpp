@@ -398,4 +398,128 @@ TEST(ClipboardTests, copy_withSingleText_clipboardsAreEqual)
     EXPECT_EQ("test string!", actual);
 }
 
+TEST(ClipboardTests, marshalledSize_withTextAndHtml_matchesMarshall)
+{
+    Clipboard clipboard;
+    clipboard.open(0);
+    clipboard.add(IClipboard::kText, "test string!");
+    clipboard.add(IClipboard::kHTML, "other test string!");
+    clipboard.add(IClipboard::kText, "replaced");
+    clipboard.close();
+
+    EXPECT_EQ(clipboard.marshall().size(), clipboard.marshalled_size());
+}
+
+TEST(ClipboardTests, marshalledSize_cleared_matchesMarshall)
+{
+    Clipboard clipboard;
+    clipboard.open(0);
+    clipboard.add(IClipboard::kText, "test string!");
+    clipboard.clear();
+    clipboard.close();
+
+    EXPECT_EQ(clipboard.marshall().size(), clipboard.marshalled_size());
+}
+
+TEST(ClipboardTests, digest_sameContent_digestsAreEqual)
+{
+    Clipboard clipboard1;
+    clipboard1.open(0);
+    clipboard1.add(IClipboard::kText, "test string!");
+    clipboard1.add(IClipboard::kHTML, "other test string!");
+    clipboard1.close();
+
+    Clipboard clipboard2;
+    clipboard2.unmarshall(clipboard1.marshall(), 0);
+
+    EXPECT_EQ(clipboard1.digest(), clipboard2.digest());
+}
+
+TEST(ClipboardTests, digest_changedContent_digestChanges)
+{
+    Clipboard clipboard;
+    clipboard.open(0);
+    clipboard.add(IClipboard::kText, "test string!");
+    Clipboard::Digest before = clipboard.digest();
+
+    clipboard.add(IClipboard::kText, "test string?");
+
+    EXPECT_NE(before, clipboard.digest());
+}
+
+TEST(ClipboardTests, digest_sameDataOtherFormat_digestsDiffer)
+{
+    Clipboard clipboard1;
+    clipboard1.open(0);
+    clipboard1.add(IClipboard::kText, "test string!");
+
+    Clipboard clipboard2;
+    clipboard2.open(0);
+    clipboard2.add(IClipboard::kHTML, "test string!");
+
+    EXPECT_NE(clipboard1.digest(), clipboard2.digest());
+}
+
+TEST(ClipboardTests, formatDigest_sameData_digestsAreEqual)
+{
+    Clipboard clipboard1;
+    clipboard1.open(0);
+    clipboard1.add(IClipboard::kText, "test string!");
+    clipboard1.add(IClipboard::kHTML, "other test string!");
+    clipboard1.close();
+
+    Clipboard clipboard2;
+    clipboard2.open(0);
+    clipboard2.add(IClipboard::kText, "test string!");
+    clipboard2.close();
+
+    EXPECT_EQ(clipboard1.digest(IClipboard::kText), clipboard2.digest(IClipboard::kText));
+    EXPECT_NE(clipboard1.digest(IClipboard::kText), clipboard1.digest(IClipboard::kHTML));
+    EXPECT_EQ(Clipboard::Digest(), clipboard2.digest(IClipboard::kHTML));
+}
+
+TEST(ClipboardTests, promise_get_returnsEmptyAndMarksDemanded)
+{
+    Clipboard clipboard;
+    clipboard.open(0);
+    EXPECT_TRUE(clipboard.promise(IClipboard::kText));
+
+    EXPECT_TRUE(clipboard.has(IClipboard::kText));
+    EXPECT_TRUE(clipboard.is_promised(IClipboard::kText));
+    EXPECT_FALSE(clipboard.is_demanded(IClipboard::kText));
+    EXPECT_EQ("", clipboard.get(IClipboard::kText));
+    EXPECT_TRUE(clipboard.is_demanded(IClipboard::kText));
+}
+
+TEST(ClipboardTests, add_promisedFormat_suppliesData)
+{
+    Clipboard clipboard;
+    clipboard.open(0);
+    clipboard.promise(IClipboard::kText);
+    clipboard.add(IClipboard::kText, "test string!");
+
+    EXPECT_FALSE(clipboard.is_promised(IClipboard::kText));
+    EXPECT_EQ("test string!", clipboard.get(IClipboard::kText));
+    clipboard.close();
+    EXPECT_EQ(clipboard.marshall().size(), clipboard.marshalled_size());
+}
+
+TEST(ClipboardTests, copy_promisedFormat_staysPromised)
+{
+    Clipboard source;
+    source.open(0);
+    source.promise(IClipboard::kText);
+    source.add(IClipboard::kHTML, "other test string!");
+    source.close();
+
+    Clipboard copy;
+    Clipboard::copy(&copy, &source);
+
+    copy.open(0);
+    EXPECT_TRUE(copy.is_promised(IClipboard::kText));
+    EXPECT_EQ("other test string!", copy.get(IClipboard::kHTML));
+    copy.close();
+    EXPECT_FALSE(source.is_demanded(IClipboard::kText));
+}
+
 } // namespace inputleap
@@ -0,0 +1,107 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "inputleap/ChunkCompressor.h"
+#include "inputleap/FileTransferStream.h"
+#include "inputleap/protocol_types.h"
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace inputleap {
+
+TEST(FileTransferStreamTests, pump_window_limitsDataPerCall)
+{
+    std::string data(32 * 1024, 'x');
+    FileTransferStream stream(64 * 1024);
+    stream.push(FileChunk::start(data.size() * 4));
+    for (int i = 0; i < 4; ++i) {
+        stream.push(FileChunk::data(reinterpret_cast<std::uint8_t*>(&data[0]), data.size()));
+    }
+    stream.push(FileChunk::end());
+
+    std::vector<std::uint8_t> marks;
+    auto writer = [&marks](const FileChunk& chunk) { marks.push_back(chunk.mark_); };
+
+    ASSERT_TRUE(stream.pump(writer));
+    EXPECT_EQ(3u, marks.size());
+
+    // nothing fits while the connection still holds a window of data
+    EXPECT_FALSE(stream.pump(writer, 64 * 1024));
+
+    ASSERT_TRUE(stream.pump(writer, 1024));
+    ASSERT_TRUE(stream.pump(writer));
+    EXPECT_TRUE(stream.empty());
+    EXPECT_EQ(6u, marks.size());
+    EXPECT_EQ(kDataEnd, marks.back());
+}
+
+TEST(FileTransferStreamTests, pump_compression_compressesDataChunks)
+{
+    std::string data(32 * 1024, 'x');
+    FileTransferStream stream;
+    stream.set_compression(true);
+    stream.push(FileChunk::start(data.size()));
+    stream.push(FileChunk::data(data));
+    stream.push(FileChunk::end());
+
+    std::vector<FileChunk> chunks;
+    stream.pump([&chunks](const FileChunk& chunk) { chunks.push_back(chunk); });
+
+    ASSERT_EQ(3u, chunks.size());
+    EXPECT_EQ(kDataChunkLZ4, chunks[1].mark_);
+    std::string unpacked;
+    ASSERT_TRUE(ChunkCompressor::decompress(chunks[1].data_, unpacked, data.size()));
+    EXPECT_EQ(data, unpacked);
+}
+
+TEST(FileTransferStreamTests, pump_sentChunk_releasesCredit)
+{
+    auto credit = std::make_shared<int>(0);
+    FileTransferStream stream;
+    FileChunk chunk = FileChunk::data(std::string(1024, 'x'));
+    chunk.credit_ = credit;
+    stream.push(std::move(chunk));
+    stream.push(FileChunk::end());
+    EXPECT_EQ(2, credit.use_count());
+
+    stream.pump([](const FileChunk&) {});
+    EXPECT_EQ(1, credit.use_count());
+}
+
+TEST(FileTransferStreamTests, pump_compressedChunk_recyclesOriginalBuffer)
+{
+    std::string data(32 * 1024, 'x');
+    const char* buffer = data.data();
+    std::string recycled;
+    FileTransferStream stream;
+    stream.set_compression(true);
+    FileChunk chunk = FileChunk::data(std::move(data));
+    chunk.recycle_ = [&recycled](std::string&& b) { recycled = std::move(b); };
+    stream.push(std::move(chunk));
+
+    std::uint8_t mark = 0;
+    stream.pump([&mark](const FileChunk& sent) { mark = sent.mark_; });
+
+    EXPECT_EQ(kDataChunkLZ4, mark);
+    EXPECT_EQ(buffer, recycled.data());
+    EXPECT_EQ(32u * 1024, recycled.size());
+}
+
+} // namespace inputleap
@@ -0,0 +1,106 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "inputleap/IncomingFile.h"
+
+#include <gtest/gtest.h>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+
+namespace inputleap {
+
+TEST(IncomingFileTests, release_finished_returnsFile)
+{
+    IncomingFile file;
+    ASSERT_TRUE(file.start(10));
+    EXPECT_TRUE(file.write("hello", 5));
+    EXPECT_TRUE(file.write("world", 5));
+    EXPECT_EQ(10u, file.received());
+    ASSERT_TRUE(file.finish());
+    EXPECT_TRUE(file.is_complete());
+
+    fs::path path = file.release();
+    ASSERT_FALSE(path.empty());
+    EXPECT_FALSE(file.is_complete());
+
+    std::ifstream stream;
+    open_utf8_path(stream, path, std::ios::in | std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(stream)),
+                         std::istreambuf_iterator<char>());
+    EXPECT_EQ("helloworld", contents);
+    stream.close();
+    fs::remove(path);
+}
+
+TEST(IncomingFileTests, write_pastSize_returnsFalse)
+{
+    IncomingFile file;
+    ASSERT_TRUE(file.start(4));
+    EXPECT_FALSE(file.write("hello", 5));
+    EXPECT_TRUE(file.write("hell", 4));
+    EXPECT_FALSE(file.write("o", 1));
+}
+
+TEST(IncomingFileTests, finish_short_isNotComplete)
+{
+    IncomingFile file;
+    ASSERT_TRUE(file.start(10));
+    EXPECT_TRUE(file.write("hello", 5));
+    EXPECT_FALSE(file.finish());
+    EXPECT_FALSE(file.is_complete());
+    EXPECT_TRUE(file.release().empty());
+}
+
+TEST(IncomingFileTests, start_again_replacesTransfer)
+{
+    IncomingFile file;
+    ASSERT_TRUE(file.start(5));
+    ASSERT_TRUE(file.write("first", 5));
+    ASSERT_TRUE(file.finish());
+    ASSERT_TRUE(file.start(6));
+    ASSERT_TRUE(file.write("second", 6));
+    ASSERT_TRUE(file.finish());
+
+    fs::path path = file.release();
+    EXPECT_EQ(6u, fs::file_size(path));
+    fs::remove(path);
+}
+
+TEST(IncomingFileTests, start_directorySet_createsPrivateFileThere)
+{
+    fs::path dir = fs::temp_directory_path() /
+                   ("inputleap-test-" + std::to_string(std::random_device()()));
+    ASSERT_TRUE(fs::create_directory(dir));
+
+    IncomingFile file;
+    file.set_directory(dir);
+    ASSERT_TRUE(file.start(5));
+    ASSERT_TRUE(file.write("hello", 5));
+    ASSERT_TRUE(file.finish());
+
+    fs::path path = file.release();
+    EXPECT_EQ(dir, path.parent_path());
+#if SYSAPI_UNIX
+    EXPECT_EQ(fs::perms::owner_read | fs::perms::owner_write,
+              fs::status(path).permissions() & fs::perms::all);
+#endif
+    fs::remove_all(dir);
+}
+
+} // namespace inputleap
@@ -18,9 +18,12 @@
 #define INPUTLEAP_TEST_ENV
 
 #include "inputleap/KeyMap.h"
+#include "base/Log.h"
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
+#include <chrono>
+#include <vector>
 
 using ::testing::_;
 using ::testing::NiceMock;
@@ -31,6 +34,129 @@ using ::testing::SaveArg;
 
 namespace inputleap {
 
+namespace {
+
+const KeyButton kShiftButton = 50;
+const KeyButton kAltGrButton = 108;
+const KeyID kKeyEAcute = 0x00e9;
+const KeyID kKeyEuro = 0x20ac;
+
+void addKey(KeyMap& keyMap, KeyID id, KeyButton button, KeyModifierMask required,
+            KeyModifierMask sensitive)
+{
+    KeyMap::KeyItem item;
+    item.m_id        = id;
+    item.m_group     = 0;
+    item.m_button    = button;
+    item.m_required  = required;
+    item.m_sensitive = sensitive;
+    item.m_client    = 0;
+    KeyMap::initModifierKey(item);
+    keyMap.addKeyEntry(item);
+}
+
+// a US-like layout with AltGr symbols and a dead acute, set up the way
+// KeyState::updateKeyMap() does it
+void makeLayout(KeyMap& keyMap)
+{
+    const KeyModifierMask kLevels = KeyModifierShift | KeyModifierAltGr;
+    for (KeyID c = 'a'; c <= 'z'; ++c) {
+        KeyButton button = static_cast<KeyButton>(10 + c - 'a');
+        addKey(keyMap, c, button, 0, kLevels);
+        addKey(keyMap, c - 'a' + 'A', button, KeyModifierShift, kLevels);
+    }
+    for (KeyID c = '0'; c <= '9'; ++c) {
+        addKey(keyMap, c, static_cast<KeyButton>(40 + c - '0'), 0, kLevels);
+    }
+    addKey(keyMap, ',', 51, 0, kLevels);
+    addKey(keyMap, '.', 52, 0, kLevels);
+    addKey(keyMap, ' ', 53, 0, 0);
+    addKey(keyMap, kKeyReturn, 54, 0, 0);
+    addKey(keyMap, '@', 10 + 'q' - 'a', KeyModifierAltGr, kLevels);
+    addKey(keyMap, kKeyEuro, 10 + 'e' - 'a', KeyModifierAltGr, kLevels);
+    addKey(keyMap, kKeyDeadAcute, 55, 0, kLevels);
+    addKey(keyMap, kKeyShift_L, kShiftButton, 0, 0);
+    addKey(keyMap, kKeyAltGr, kAltGrButton, 0, 0);
+    keyMap.finish();
+
+    KeyID acute[] = { kKeyDeadAcute, 'e' };
+    keyMap.addKeyCombinationEntry(kKeyEAcute, 0, acute, 2);
+}
+
+// a mail being typed.  '#' stands for e acute and '$' for the euro sign.
+std::vector<KeyID> makeTypingTrace()
+{
+    const char* text = "Dear Caf# team, your order 4711 costs 12,50$. "
+                       "Write to orders@example.com or call 555 0199.\n";
+    std::vector<KeyID> trace;
+    for (const char* c = text; *c != '\0'; ++c) {
+        switch (*c) {
+        case '#':
+            trace.push_back(kKeyEAcute);
+            break;
+
+        case '$':
+            trace.push_back(kKeyEuro);
+            break;
+
+        case '\n':
+            trace.push_back(kKeyReturn);
+            break;
+
+        default:
+            trace.push_back(static_cast<unsigned char>(*c));
+            break;
+        }
+    }
+    return trace;
+}
+
+// presses keys like the server sends them, pressing and releasing Shift
+// or AltGr around the characters that need them
+class Typist {
+public:
+    // maps pressing \p id through \p map, a mapKey() lookalike
+    template <class MapKey>
+    const KeyMap::KeyItem* press(MapKey map, KeyMap::Keystrokes& keys, KeyID id)
+    {
+        KeyModifierMask mask = 0;
+        KeyButton button = 0;
+        KeyID modifier = kKeyNone;
+        if (id >= 'A' && id <= 'Z') {
+            mask = KeyModifierShift;
+            button = kShiftButton;
+            modifier = kKeyShift_L;
+        }
+        else if (id == '@' || id == kKeyEuro) {
+            mask = KeyModifierAltGr;
+            button = kAltGrButton;
+            modifier = kKeyAltGr;
+        }
+
+        if (modifier != kKeyNone) {
+            map(keys, modifier, m_modifiers, m_state, 0);
+        }
+        const KeyMap::KeyItem* item = map(keys, id, m_modifiers, m_state, mask);
+        if (modifier != kKeyNone) {
+            // KeyState forgets a modifier when it's released
+            auto range = m_modifiers.equal_range(mask);
+            for (auto i = range.first; i != range.second; ++i) {
+                if (i->second.m_button == button) {
+                    m_modifiers.erase(i);
+                    break;
+                }
+            }
+            m_state &= ~mask;
+        }
+        return item;
+    }
+
+    KeyMap::ModifierToKeys m_modifiers;
+    KeyModifierMask m_state = 0;
+};
+
+} // namespace
+
 TEST(KeyMapTests, findBestKey_requiredDown_matchExactFirstItem)
 {
     KeyMap keyMap;
@@ -215,4 +341,125 @@ TEST(KeyMapTests, isCommand_superMask_returnTrue)
     EXPECT_EQ(true, keyMap.isCommand(mask));
 }
 
+TEST(KeyMapTests, mapKey_typingTrace_sameAsUncached)
+{
+    KeyMap keyMap;
+    makeLayout(keyMap);
+
+    auto cached = [&](KeyMap::Keystrokes& keys, KeyID id, KeyMap::ModifierToKeys& modifiers,
+                      KeyModifierMask& state, KeyModifierMask mask) {
+        return keyMap.mapKey(keys, id, 0, modifiers, state, mask, false);
+    };
+    auto uncached = [&](KeyMap::Keystrokes& keys, KeyID id, KeyMap::ModifierToKeys& modifiers,
+                        KeyModifierMask& state, KeyModifierMask mask) {
+        return keyMap.mapKeyUncached(keys, id, 0, modifiers, state, mask, false);
+    };
+
+    // twice through so the second pass uses the plans
+    std::vector<KeyID> trace = makeTypingTrace();
+    Typist typist;
+    Typist expected;
+    for (int pass = 0; pass < 2; ++pass) {
+        for (KeyID id : trace) {
+            KeyMap::Keystrokes keys;
+            KeyMap::Keystrokes expectedKeys;
+            const KeyMap::KeyItem* item = typist.press(cached, keys, id);
+            const KeyMap::KeyItem* expectedItem = expected.press(uncached, expectedKeys, id);
+
+            ASSERT_NE(nullptr, item) << "key " << id;
+            EXPECT_EQ(expectedItem, item);
+            EXPECT_EQ(expected.m_state, typist.m_state);
+            EXPECT_TRUE(expected.m_modifiers == typist.m_modifiers);
+            ASSERT_EQ(expectedKeys.size(), keys.size());
+            for (std::size_t i = 0; i < keys.size(); ++i) {
+                ASSERT_EQ(KeyMap::Keystroke::kButton, keys[i].m_type);
+                EXPECT_EQ(expectedKeys[i].m_data.m_button.m_button,
+                          keys[i].m_data.m_button.m_button);
+                EXPECT_EQ(expectedKeys[i].m_data.m_button.m_press,
+                          keys[i].m_data.m_button.m_press);
+            }
+        }
+    }
+}
+
+TEST(KeyMapTests, mapKey_afterUpdate_usesNewMap)
+{
+    KeyMap keyMap;
+    makeLayout(keyMap);
+
+    KeyMap::Keystrokes keys;
+    KeyMap::ModifierToKeys modifiers;
+    KeyModifierMask state = 0;
+    const KeyMap::KeyItem* item = keyMap.mapKey(keys, 'a', 0, modifiers, state, 0, false);
+    ASSERT_NE(nullptr, item);
+    EXPECT_EQ(10, item->m_button);
+
+    // the layout changed and KeyState::updateKeyMap() swaps in a new map
+    KeyMap newKeyMap;
+    addKey(newKeyMap, 'a', 70, 0, 0);
+    newKeyMap.finish();
+    keyMap.swap(newKeyMap);
+    keyMap.finish();
+
+    keys.clear();
+    item = keyMap.mapKey(keys, 'a', 0, modifiers, state, 0, false);
+    ASSERT_NE(nullptr, item);
+    EXPECT_EQ(70, item->m_button);
+    EXPECT_EQ(nullptr, keyMap.mapKey(keys, 'b', 0, modifiers, state, 0, false));
+}
+
+TEST(KeyMapTests, DISABLED_benchmark_mapKeyTypingTrace)
+{
+    KeyMap keyMap;
+    makeLayout(keyMap);
+    std::vector<KeyID> trace = makeTypingTrace();
+    const int kRounds = 2000;
+
+    auto cached = [&](KeyMap::Keystrokes& keys, KeyID id, KeyMap::ModifierToKeys& modifiers,
+                      KeyModifierMask& state, KeyModifierMask mask) {
+        return keyMap.mapKey(keys, id, 0, modifiers, state, mask, false);
+    };
+    auto uncached = [&](KeyMap::Keystrokes& keys, KeyID id, KeyMap::ModifierToKeys& modifiers,
+                        KeyModifierMask& state, KeyModifierMask mask) {
+        return keyMap.mapKeyUncached(keys, id, 0, modifiers, state, mask, false);
+    };
+
+    // measure the mapping, not the log.  AltGr keys are searched for
+    // as command keys, which logs at INFO.
+    int filter = CLOG->getFilter();
+    CLOG->setFilter(kWARNING);
+
+    std::size_t strokes = 0;
+    KeyMap::Keystrokes keys;
+    keys.reserve(16);
+    Typist typist;
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; ++round) {
+        for (KeyID id : trace) {
+            keys.clear();
+            typist.press(uncached, keys, id);
+            strokes += keys.size();
+        }
+    }
+    std::chrono::duration<double, std::nano> uncachedTime =
+        std::chrono::steady_clock::now() - begin;
+
+    begin = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; ++round) {
+        for (KeyID id : trace) {
+            keys.clear();
+            typist.press(cached, keys, id);
+            strokes += keys.size();
+        }
+    }
+    std::chrono::duration<double, std::nano> cachedTime = std::chrono::steady_clock::now() - begin;
+
+    CLOG->setFilter(filter);
+
+    double presses = static_cast<double>(kRounds) * trace.size();
+    LOG_PRINT("mapping a typed key: %.0f ns, with keystroke plans %.0f ns (%zu)",
+              uncachedTime.count() / presses, cachedTime.count() / presses, strokes % 2);
+}
+
 }
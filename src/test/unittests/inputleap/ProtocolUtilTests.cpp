@@ -0,0 +1,184 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "inputleap/ProtocolUtil.h"
+#include "inputleap/protocol_types.h"
+#include "test/mock/io/MemoryStream.h"
+#include "base/Log.h"
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace inputleap;
+
+namespace {
+
+template<const char* Format, class... Args>
+void expect_same_bytes(Args... args)
+{
+    MemoryStream typed;
+    MemoryStream formatted;
+    ProtocolUtil::write_message<Format>(&typed, args...);
+    ProtocolUtil::writef(&formatted, Format, args...);
+    EXPECT_EQ(formatted.output_, typed.output_) << Format;
+    EXPECT_EQ(1, typed.writes_);
+}
+
+} // namespace
+
+TEST(ProtocolUtilTests, writeMessage_matchesWritef)
+{
+    expect_same_bytes<kMsgCNoop>();
+    expect_same_bytes<kMsgCKeepAlive>();
+    expect_same_bytes<kMsgCEnter>(std::int16_t(-5), std::int16_t(1200), 0x01020304u,
+                                  std::uint16_t(0x8001));
+    expect_same_bytes<kMsgCClipboard>(std::uint8_t(1), 0xdeadbeefu);
+    expect_same_bytes<kMsgCScreenSaver>(1);
+    expect_same_bytes<kMsgDKeyDown>(0xefffu, 0x2003u, 0x41u);
+    expect_same_bytes<kMsgDKeyRepeat>(0x61u, 0u, 3, 0x26u);
+    expect_same_bytes<kMsgDMouseDown>(std::int8_t(-1));
+    expect_same_bytes<kMsgDMouseMove>(-32768, 32767);
+    expect_same_bytes<kMsgDMouseRelMove>(std::int16_t(-3), std::int16_t(7));
+    expect_same_bytes<kMsgDMouseWheel>(0, -120);
+    expect_same_bytes<kMsgDInfo>(0, 0, 1920, 1080, 0, -1, 540);
+    expect_same_bytes<kMsgEIncompatible>(kProtocolMajorVersion, kProtocolMinorVersion);
+    expect_same_bytes<kMsgHello>(kProtocolMajorVersion, kProtocolMinorVersion);
+}
+
+TEST(ProtocolUtilTests, readMessageBody_matchesReadf)
+{
+    MemoryStream stream;
+    ProtocolUtil::writef(&stream, kMsgCEnter, -5, 1200, 0x01020304u, 0x8001u);
+    ProtocolUtil::writef(&stream, kMsgCEnter, -5, 1200, 0x01020304u, 0x8001u);
+
+    std::int16_t x1, y1, x2, y2;
+    std::uint32_t seq1, seq2;
+    std::uint16_t mask1, mask2;
+    stream.replay();
+    stream.skip(4);
+    ASSERT_TRUE(ProtocolUtil::readf(&stream, kMsgCEnter + 4, &x1, &y1, &seq1, &mask1));
+    stream.skip(4);
+    ASSERT_TRUE(ProtocolUtil::read_message_body<kMsgCEnter>(&stream, &x2, &y2, &seq2, &mask2));
+
+    EXPECT_EQ(-5, x2);
+    EXPECT_EQ(1200, y2);
+    EXPECT_EQ(x1, x2);
+    EXPECT_EQ(y1, y2);
+    EXPECT_EQ(seq1, seq2);
+    EXPECT_EQ(mask1, mask2);
+    EXPECT_EQ(0u, stream.getSize());
+}
+
+TEST(ProtocolUtilTests, readMessageBody_signExtendsIntoWiderTypes)
+{
+    MemoryStream stream;
+    ProtocolUtil::write_message<kMsgDMouseMove>(&stream, -2, 40000);
+
+    std::int32_t x;
+    std::uint32_t y;
+    stream.replay();
+    stream.skip(4);
+    ASSERT_TRUE(ProtocolUtil::read_message_body<kMsgDMouseMove>(&stream, &x, &y));
+    EXPECT_EQ(-2, x);
+    EXPECT_EQ(40000u, y);
+}
+
+TEST(ProtocolUtilTests, readMessageBody_truncatedStream_returnsFalse)
+{
+    MemoryStream stream;
+    ProtocolUtil::write_message<kMsgDMouseMove>(&stream, 1, 2);
+    stream.output_.pop_back();
+
+    std::int16_t x, y;
+    stream.replay();
+    stream.skip(4);
+    EXPECT_FALSE(ProtocolUtil::read_message_body<kMsgDMouseMove>(&stream, &x, &y));
+}
+
+TEST(ProtocolUtilTests, fixedFormat_decode_mismatchedLiteral_returnsFalse)
+{
+    using Layout = ProtocolFixedFormat<kMsgHello>;
+    static_assert(Layout::kSize == 11, "Barrier + 2 + 2");
+    static_assert(Layout::kArgs == 2, "major and minor version");
+
+    std::uint8_t buffer[Layout::kSize];
+    Layout::encode(buffer, 1, 6);
+
+    std::uint16_t major, minor;
+    EXPECT_TRUE(Layout::decode(buffer, &major, &minor));
+    EXPECT_EQ(1, major);
+    EXPECT_EQ(6, minor);
+
+    buffer[0] = 'S';
+    EXPECT_FALSE(Layout::decode(buffer, &major, &minor));
+}
+
+TEST(ProtocolUtilTests, writef_largeMessage_roundTrips)
+{
+    MemoryStream stream;
+    std::string data(100000, 'x');
+    ProtocolUtil::writef(&stream, kMsgDFileTransfer, 1, &data);
+    EXPECT_EQ(4u + 1 + 4 + data.size(), stream.output_.size());
+
+    std::uint8_t mark = 0;
+    std::string read;
+    stream.replay();
+    stream.skip(4);
+    ASSERT_TRUE(ProtocolUtil::readf(&stream, kMsgDFileTransfer + 4, &mark, &read));
+    EXPECT_EQ(1, mark);
+    EXPECT_EQ(data, read);
+}
+
+TEST(ProtocolUtilTests, DISABLED_benchmark_mouseMove)
+{
+    const int kIterations = 200000;
+    MemoryStream stream;
+    stream.output_.reserve(kIterations * 8);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        ProtocolUtil::writef(&stream, kMsgDMouseMove, i & 0x7fff, i >> 4);
+    }
+    std::int16_t x, y;
+    std::int32_t sum = 0;
+    stream.replay();
+    while (stream.getSize() > 0) {
+        stream.skip(4);
+        ProtocolUtil::readf(&stream, kMsgDMouseMove + 4, &x, &y);
+        sum += x;
+    }
+    std::chrono::duration<double, std::nano> formatted = std::chrono::steady_clock::now() - start;
+
+    stream.output_.clear();
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        ProtocolUtil::write_message<kMsgDMouseMove>(&stream, i & 0x7fff, i >> 4);
+    }
+    stream.replay();
+    while (stream.getSize() > 0) {
+        stream.skip(4);
+        ProtocolUtil::read_message_body<kMsgDMouseMove>(&stream, &x, &y);
+        sum -= x;
+    }
+    std::chrono::duration<double, std::nano> typed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_EQ(0, sum);
+    LOG_PRINT("mouse move write+read: writef/readf %.1f ns, write_message/read_message_body %.1f ns",
+              formatted.count() / kIterations, typed.count() / kIterations);
+}
@@ -67,4 +67,32 @@ TEST(ServerArgsParsingTests, parseServerArgs_configArg_setConfigFile)
     EXPECT_EQ("mock_configFile", serverArgs.m_configFile);
 }
 
+TEST(ServerArgsParsingTests, parseServerArgs_socketThreadsArg_setSocketThreads)
+{
+    NiceMock<MockArgParser> argParser;
+    ON_CALL(argParser, parseGenericArgs(_, _, _)).WillByDefault(Invoke(server_stubParseGenericArgs));
+    ON_CALL(argParser, checkUnexpectedArgs()).WillByDefault(Invoke(server_stubCheckUnexpectedArgs));
+    ServerArgs serverArgs;
+    const int argc = 3;
+    const char* kSocketThreadsCmd[argc] = { "stub", "--socket-threads", "4" };
+
+    EXPECT_TRUE(argParser.parseServerArgs(serverArgs, argc, kSocketThreadsCmd));
+
+    EXPECT_EQ(4u, serverArgs.socket_threads);
+}
+
+TEST(ServerArgsParsingTests, parseServerArgs_zeroSocketThreads_fails)
+{
+    NiceMock<MockArgParser> argParser;
+    ON_CALL(argParser, parseGenericArgs(_, _, _)).WillByDefault(Invoke(server_stubParseGenericArgs));
+    ON_CALL(argParser, checkUnexpectedArgs()).WillByDefault(Invoke(server_stubCheckUnexpectedArgs));
+    ServerArgs serverArgs;
+    const int argc = 3;
+    const char* kSocketThreadsCmd[argc] = { "stub", "--socket-threads", "0" };
+
+    EXPECT_FALSE(argParser.parseServerArgs(serverArgs, argc, kSocketThreadsCmd));
+
+    EXPECT_EQ(1u, serverArgs.socket_threads);
+}
+
 } // namespace inputleap
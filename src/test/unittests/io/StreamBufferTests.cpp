@@ -0,0 +1,148 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "io/StreamBuffer.h"
+#include "base/Log.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+using namespace inputleap;
+
+namespace {
+
+std::vector<std::uint8_t> make_data(std::size_t size)
+{
+    std::vector<std::uint8_t> data(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<std::uint8_t>(i * 7 + 3);
+    }
+    return data;
+}
+
+} // namespace
+
+TEST(StreamBufferTests, write_peek_pop_fifoOrder)
+{
+    auto data = make_data(10000);
+    StreamBuffer buffer;
+
+    buffer.write(data.data(), 3000);
+    buffer.write(data.data() + 3000, 7000);
+    EXPECT_EQ(10000u, buffer.getSize());
+
+    EXPECT_EQ(0, std::memcmp(buffer.peek(10000), data.data(), 10000));
+    buffer.pop(2500);
+    EXPECT_EQ(7500u, buffer.getSize());
+    EXPECT_EQ(0, std::memcmp(buffer.peek_span(), data.data() + 2500, 7500));
+
+    buffer.pop(7500);
+    EXPECT_EQ(0u, buffer.getSize());
+    EXPECT_EQ(nullptr, buffer.peek_span());
+    EXPECT_EQ(nullptr, buffer.peek(0));
+}
+
+TEST(StreamBufferTests, reserve_commit_appendsInPlace)
+{
+    auto data = make_data(100);
+    StreamBuffer buffer;
+    buffer.write(data.data(), 40);
+
+    std::uint8_t* space = buffer.reserve(4096);
+    std::memcpy(space, data.data() + 40, 60);
+    EXPECT_EQ(40u, buffer.getSize());
+
+    buffer.commit(60);
+    EXPECT_EQ(100u, buffer.getSize());
+    EXPECT_EQ(0, std::memcmp(buffer.peek_span(), data.data(), 100));
+}
+
+TEST(StreamBufferTests, interleavedWritesAndPops_dataStaysContiguous)
+{
+    auto data = make_data(1 << 20);
+    StreamBuffer buffer;
+    std::size_t written = 0;
+    std::size_t read = 0;
+
+    // grow, compact and shrink the storage in turn
+    for (int i = 0; written < data.size(); ++i) {
+        std::size_t n = std::min<std::size_t>(1 + (i * 977) % 20000, data.size() - written);
+        buffer.write(data.data() + written, static_cast<std::uint32_t>(n));
+        written += n;
+
+        std::uint32_t size = buffer.getSize();
+        ASSERT_EQ(written - read, size);
+        ASSERT_EQ(0, std::memcmp(buffer.peek_span(), data.data() + read, size));
+
+        std::uint32_t m = (i % 3 == 0) ? size : size / 2;
+        buffer.pop(m);
+        read += m;
+    }
+}
+
+// the socket pattern for protocol messages: a few messages queue up and
+// are read back one by one, so reads straddle earlier writes
+TEST(StreamBufferTests, DISABLED_benchmark_smallMessages)
+{
+    const int kIterations = 2000000;
+    auto data = make_data(64);
+    std::uint8_t out[64];
+    StreamBuffer buffer;
+    std::uint32_t checksum = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        std::uint32_t size = 16 + (i % 49);
+        buffer.write(data.data(), size);
+        if (buffer.getSize() > 256) {
+            std::uint32_t n = 16 + ((i * 3) % 49);
+            std::memcpy(out, buffer.peek(n), n);
+            buffer.pop(n);
+            checksum += out[0];
+        }
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+    LOG_PRINT("16-64 byte messages: %.1f ns per message (%u)",
+              elapsed.count() / kIterations, checksum);
+}
+
+// the socket pattern for clipboard transfers: 32 KB chunks are queued
+// and the kernel takes part of the buffer at a time
+TEST(StreamBufferTests, DISABLED_benchmark_clipboardChunks)
+{
+    const int kIterations = 20000;
+    const std::uint32_t kChunkSize = 32 * 1024;
+    auto data = make_data(kChunkSize);
+    StreamBuffer buffer;
+    std::uint32_t checksum = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        buffer.write(data.data(), kChunkSize);
+        std::uint32_t n = buffer.getSize();
+        const std::uint8_t* p = static_cast<const std::uint8_t*>(buffer.peek(n));
+        checksum += p[n - 1];
+        buffer.pop(n > 20000 ? n - 20000 : n);
+    }
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+    LOG_PRINT("32 KB chunks: %.2f us per chunk (%u)", elapsed.count() / kIterations, checksum);
+}
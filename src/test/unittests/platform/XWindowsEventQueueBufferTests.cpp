@@ -0,0 +1,166 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "test/mock/platform/MockXWindowsImpl.h"
+#include "test/mock/inputleap/MockEventQueue.h"
+#include "platform/XWindowsEventQueueBuffer.h"
+#include "base/Event.h"
+
+#include <poll.h>
+#include <type_traits>
+#include <unistd.h>
+
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::NiceMock;
+using ::testing::Return;
+
+namespace inputleap {
+
+namespace {
+
+// a display that only provides the connection fd used by waitForEvent().
+// the fd is a pipe nobody writes to, i.e. an idle X connection.
+class XWindowsEventQueueBufferTests : public ::testing::Test {
+public:
+    XWindowsEventQueueBufferTests()
+    {
+        EXPECT_EQ(0, pipe(m_connection));
+        m_displayData.fd = m_connection[0];
+        ON_CALL(m_impl, XPending(_)).WillByDefault(Return(0));
+    }
+
+    ~XWindowsEventQueueBufferTests() override
+    {
+        close(m_connection[0]);
+        close(m_connection[1]);
+    }
+
+    Display* display() { return reinterpret_cast<Display*>(&m_displayData); }
+
+    NiceMock<MockXWindowsImpl> m_impl;
+    NiceMock<MockEventQueue> m_events;
+    int m_connection[2];
+
+private:
+    std::remove_pointer_t<_XPrivDisplay> m_displayData{};
+};
+
+} // namespace
+
+TEST_F(XWindowsEventQueueBufferTests, addEvent_userEvents_neverReachXServer)
+{
+    EXPECT_CALL(m_impl, XSendEvent(_, _, _, _, _)).Times(0);
+    EXPECT_CALL(m_impl, XNextEvent(_, _)).Times(0);
+    EXPECT_CALL(m_impl, XFlush(_)).Times(0);
+
+    XWindowsEventQueueBuffer buffer(&m_impl, display(), &m_events);
+    EXPECT_TRUE(buffer.isEmpty());
+
+    buffer.addEvent(7);
+    buffer.addEvent(3);
+    EXPECT_FALSE(buffer.isEmpty());
+
+    Event event;
+    std::uint32_t dataID = 0;
+    EXPECT_EQ(IEventQueueBuffer::kUser, buffer.getEvent(event, dataID));
+    EXPECT_EQ(7u, dataID);
+    EXPECT_EQ(IEventQueueBuffer::kUser, buffer.getEvent(event, dataID));
+    EXPECT_EQ(3u, dataID);
+    EXPECT_TRUE(buffer.isEmpty());
+}
+
+TEST_F(XWindowsEventQueueBufferTests, getEvent_noUserEvents_readsXEvent)
+{
+    ON_CALL(m_impl, XPending(_)).WillByDefault(Return(1));
+    EXPECT_CALL(m_impl, XNextEvent(display(), _)).Times(1);
+
+    XWindowsEventQueueBuffer buffer(&m_impl, display(), &m_events);
+    EXPECT_FALSE(buffer.isEmpty());
+
+    Event event;
+    std::uint32_t dataID = 0;
+    EXPECT_EQ(IEventQueueBuffer::kSystem, buffer.getEvent(event, dataID));
+    EXPECT_EQ(EventType::SYSTEM, event.getType());
+}
+
+TEST_F(XWindowsEventQueueBufferTests, waitForEvent_idle_pollsOnceWithTimeout)
+{
+    XWindowsEventQueueBuffer buffer(&m_impl, display(), &m_events);
+
+    double timeout = -1.0;
+    EXPECT_CALL(m_impl, do_ppoll(_, 2, _))
+        .WillOnce(Invoke([this, &timeout](pollfd* fds, nfds_t, const timespec* ptimeout) {
+            EXPECT_EQ(m_connection[0], fds[0].fd);
+            EXPECT_EQ(POLLIN, fds[0].events);
+            EXPECT_EQ(POLLIN, fds[1].events);
+            if (ptimeout != nullptr) {
+                timeout = ptimeout->tv_sec + ptimeout->tv_nsec / 1.0e+9;
+            }
+            return 0;
+        }));
+
+    buffer.waitForEvent(0.2);
+
+    EXPECT_GT(timeout, 0.1);
+    EXPECT_LE(timeout, 0.2);
+    EXPECT_EQ(1u, buffer.get_wakeup_count());
+}
+
+TEST_F(XWindowsEventQueueBufferTests, waitForEvent_noTimeout_pollsWithoutTimeout)
+{
+    XWindowsEventQueueBuffer buffer(&m_impl, display(), &m_events);
+
+    EXPECT_CALL(m_impl, do_ppoll(_, 2, nullptr)).WillOnce(Return(0));
+
+    buffer.waitForEvent(-1.0);
+    EXPECT_EQ(1u, buffer.get_wakeup_count());
+}
+
+TEST_F(XWindowsEventQueueBufferTests, waitForEvent_userEventPending_doesNotPoll)
+{
+    XWindowsEventQueueBuffer buffer(&m_impl, display(), &m_events);
+    buffer.addEvent(1);
+
+    EXPECT_CALL(m_impl, do_ppoll(_, _, _)).Times(0);
+
+    buffer.waitForEvent(5.0);
+    EXPECT_EQ(0u, buffer.get_wakeup_count());
+}
+
+TEST_F(XWindowsEventQueueBufferTests, waitForEvent_addEventWhileBlocked_wakesWaiter)
+{
+    XWindowsEventQueueBuffer buffer(&m_impl, display(), &m_events);
+
+    // another thread adds an event while the waiter is blocked.  the
+    // descriptors the waiter polls must then be readable.
+    EXPECT_CALL(m_impl, do_ppoll(_, 2, _))
+        .WillOnce(Invoke([&buffer](pollfd* fds, nfds_t nfds, const timespec*) {
+            buffer.addEvent(1);
+            timespec now{};
+            return ::ppoll(fds, nfds, &now, nullptr);
+        }));
+
+    buffer.waitForEvent(5.0);
+    EXPECT_FALSE(buffer.isEmpty());
+    EXPECT_EQ(1u, buffer.get_wakeup_count());
+}
+
+} // namespace inputleap
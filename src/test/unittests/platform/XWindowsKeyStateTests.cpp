@@ -0,0 +1,116 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "test/mock/platform/MockXWindowsImpl.h"
+#include "test/mock/inputleap/MockEventQueue.h"
+#include "test/mock/inputleap/MockKeyMap.h"
+#include "platform/XWindowsKeyState.h"
+
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::Mock;
+using ::testing::NiceMock;
+using ::testing::Return;
+
+namespace inputleap {
+
+namespace {
+
+const KeyButton kShiftButton = 50;
+const KeyButton kControlButton = 37;
+
+KeyMap::KeyItem s_keyItem;
+
+// maps every key the way a shifted character is typed while control is
+// down:  control up, shift down, the key, shift up, control down
+const KeyMap::KeyItem* mapShiftedKey(KeyMap::Keystrokes& keys, KeyID id, std::int32_t,
+                                     KeyMap::ModifierToKeys&, KeyModifierMask&,
+                                     KeyModifierMask, bool)
+{
+    KeyButton button = static_cast<KeyButton>(id);
+    keys.push_back(KeyMap::Keystroke(kControlButton, false, false, 0));
+    keys.push_back(KeyMap::Keystroke(kShiftButton, true, false, 0));
+    keys.push_back(KeyMap::Keystroke(button, true, false, 0));
+    keys.push_back(KeyMap::Keystroke(kShiftButton, false, false, 0));
+    keys.push_back(KeyMap::Keystroke(kControlButton, true, false, 0));
+    s_keyItem.m_button = button;
+    s_keyItem.m_client = 0;
+    return &s_keyItem;
+}
+
+// the mock never looks at the display
+class XWindowsKeyStateTests : public ::testing::Test {
+public:
+    XWindowsKeyStateTests()
+    {
+        ON_CALL(m_impl, XGetKeyboardControl(_, _))
+            .WillByDefault(Invoke([](Display*, XKeyboardState* state) {
+                *state = XKeyboardState();
+                return 0;
+            }));
+        ON_CALL(m_keyMap, mapKey(_, _, _, _, _, _, _)).WillByDefault(Invoke(mapShiftedKey));
+    }
+
+    NiceMock<MockXWindowsImpl> m_impl;
+    NiceMock<MockEventQueue> m_events;
+    NiceMock<MockKeyMap> m_keyMap;
+};
+
+} // namespace
+
+TEST_F(XWindowsKeyStateTests, fakeKeyDown_modifierChanges_flushesOnce)
+{
+    XWindowsKeyState keyState(&m_impl, nullptr, false, &m_events, m_keyMap);
+
+    EXPECT_CALL(m_impl, XTestFakeKeyEvent(_, _, _, _)).Times(5);
+    EXPECT_CALL(m_impl, XFlush(_)).Times(1);
+    keyState.fakeKeyDown('A', KeyModifierShift, 1);
+    Mock::VerifyAndClearExpectations(&m_impl);
+
+    EXPECT_CALL(m_impl, XTestFakeKeyEvent(_, 'A', False, _)).Times(1);
+    EXPECT_CALL(m_impl, XFlush(_)).Times(1);
+    keyState.fakeKeyUp(1);
+}
+
+TEST_F(XWindowsKeyStateTests, fakeKeyDown_inBatch_flushesWhenBatchEnds)
+{
+    XWindowsKeyState keyState(&m_impl, nullptr, false, &m_events, m_keyMap);
+    const char* text = "Pasted";
+
+    EXPECT_CALL(m_impl, XFlush(_)).Times(0);
+    keyState.beginFakeBatch();
+    KeyButton serverID = 1;
+    for (const char* c = text; *c != '\0'; ++c, ++serverID) {
+        keyState.fakeKeyDown(*c, 0, serverID);
+        keyState.fakeKeyUp(serverID);
+    }
+
+    // nested batches don't flush either
+    keyState.beginFakeBatch();
+    keyState.fakeKeyDown('!', 0, serverID);
+    keyState.fakeKeyUp(serverID);
+    keyState.endFakeBatch();
+    Mock::VerifyAndClearExpectations(&m_impl);
+
+    EXPECT_CALL(m_impl, XFlush(_)).Times(1);
+    keyState.endFakeBatch();
+}
+
+} // namespace inputleap
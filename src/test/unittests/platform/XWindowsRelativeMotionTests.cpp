@@ -0,0 +1,239 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "test/mock/platform/MockXWindowsImpl.h"
+#include "platform/XWindowsRelativeMotion.h"
+#include "base/Log.h"
+
+#include <algorithm>
+#include <deque>
+
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::NiceMock;
+using ::testing::Return;
+
+namespace inputleap {
+
+namespace {
+
+const Window kRoot = 1;
+
+XMotionEvent makeMotion(unsigned long serial, int x, int y)
+{
+    XMotionEvent event{};
+    event.type   = MotionNotify;
+    event.serial = serial;
+    event.x_root = x;
+    event.y_root = y;
+    return event;
+}
+
+// an X server that handles requests and delivers events some time after
+// they were sent.  the pointer stops at the edges of the screen.
+class FakeServer {
+public:
+    FakeServer(NiceMock<MockXWindowsImpl>& impl, int w, int h, int latency) :
+        m_w(w), m_h(h), m_latency(latency), m_x(w / 2), m_y(h / 2)
+    {
+        ON_CALL(impl, do_NextRequest(_)).WillByDefault(Invoke([this](Display*) {
+            return m_nextRequest;
+        }));
+        ON_CALL(impl, XWarpPointer(_, _, _, _, _, _, _, _, _)).WillByDefault(Invoke(
+            [this](Display*, Window, Window, int, int, unsigned int, unsigned int, int x, int y) {
+                m_requests.push_back(Request{m_time + m_latency, m_nextRequest++, x, y});
+                return 0;
+            }));
+    }
+
+    // the user moves the mouse.  returns the events the client has now.
+    std::deque<XMotionEvent> step(int dx, int dy)
+    {
+        ++m_time;
+        while (!m_requests.empty() && m_requests.front().m_time <= m_time) {
+            m_x = m_requests.front().m_x;
+            m_y = m_requests.front().m_y;
+            m_lastRequest = m_requests.front().m_serial;
+            m_requests.pop_front();
+        }
+
+        m_x = std::clamp(m_x + dx, 0, m_w - 1);
+        m_y = std::clamp(m_y + dy, 0, m_h - 1);
+        m_events.push_back(std::make_pair(m_time + m_latency,
+                                          makeMotion(m_lastRequest, m_x, m_y)));
+
+        std::deque<XMotionEvent> delivered;
+        while (!m_events.empty() && m_events.front().first <= m_time) {
+            delivered.push_back(m_events.front().second);
+            m_events.pop_front();
+        }
+        return delivered;
+    }
+
+private:
+    struct Request {
+        int m_time;
+        unsigned long m_serial;
+        int m_x;
+        int m_y;
+    };
+
+    int m_w;
+    int m_h;
+    int m_latency;
+    int m_time = 0;
+    int m_x;
+    int m_y;
+    unsigned long m_nextRequest = 100;
+    unsigned long m_lastRequest = 99;
+    std::deque<Request> m_requests;
+    std::deque<std::pair<int, XMotionEvent>> m_events;
+};
+
+} // namespace
+
+TEST(XWindowsRelativeMotionTests, onMotion_nearCenter_doesNotWarp)
+{
+    NiceMock<MockXWindowsImpl> impl;
+    XWindowsRelativeMotion motion(&impl, nullptr, kRoot);
+    motion.setArea(0, 0, 1920, 1080);
+    motion.reset(960, 540);
+
+    EXPECT_CALL(impl, XWarpPointer(_, _, _, _, _, _, _, _, _)).Times(0);
+    EXPECT_CALL(impl, XSync(_, _)).Times(0);
+    EXPECT_CALL(impl, XQueryPointer(_, _, _, _, _, _, _, _, _)).Times(0);
+
+    std::int32_t dx, dy;
+    motion.onMotion(makeMotion(1, 965, 538), dx, dy);
+    EXPECT_EQ(5, dx);
+    EXPECT_EQ(-2, dy);
+    motion.onMotion(makeMotion(2, 1100, 600), dx, dy);
+    EXPECT_EQ(135, dx);
+    EXPECT_EQ(62, dy);
+    EXPECT_EQ(0u, motion.getWarpCount());
+}
+
+TEST(XWindowsRelativeMotionTests, onMotion_farFromCenter_warpsOnceWithoutWaiting)
+{
+    NiceMock<MockXWindowsImpl> impl;
+    XWindowsRelativeMotion motion(&impl, nullptr, kRoot);
+    motion.setArea(0, 0, 1920, 1080);
+    motion.reset(960, 540);
+
+    EXPECT_CALL(impl, do_NextRequest(_)).WillOnce(Return(10));
+    EXPECT_CALL(impl, XWarpPointer(_, None, kRoot, _, _, _, _, 960, 540)).Times(1);
+    EXPECT_CALL(impl, XSync(_, _)).Times(0);
+
+    std::int32_t dx, dy;
+    motion.onMotion(makeMotion(5, 1500, 540), dx, dy);
+    EXPECT_EQ(540, dx);
+
+    // sent before the warp:  relative to the last event, and no second warp
+    motion.onMotion(makeMotion(9, 1510, 540), dx, dy);
+    EXPECT_EQ(10, dx);
+
+    // sent after the warp:  relative to the center
+    motion.onMotion(makeMotion(10, 955, 545), dx, dy);
+    EXPECT_EQ(-5, dx);
+    EXPECT_EQ(5, dy);
+    EXPECT_EQ(1u, motion.getWarpCount());
+}
+
+TEST(XWindowsRelativeMotionTests, onMotion_serialWrapsAround_warpIsDone)
+{
+    NiceMock<MockXWindowsImpl> impl;
+    XWindowsRelativeMotion motion(&impl, nullptr, kRoot);
+    motion.setArea(0, 0, 1920, 1080);
+    motion.reset(960, 540);
+
+    ON_CALL(impl, do_NextRequest(_)).WillByDefault(Return(~0ul));
+
+    std::int32_t dx, dy;
+    motion.onMotion(makeMotion(~0ul - 1, 100, 540), dx, dy);
+    motion.onMotion(makeMotion(1, 962, 540), dx, dy);
+    EXPECT_EQ(2, dx);
+}
+
+TEST(XWindowsRelativeMotionTests, reset_warpInFlight_forgetsWarp)
+{
+    NiceMock<MockXWindowsImpl> impl;
+    XWindowsRelativeMotion motion(&impl, nullptr, kRoot);
+    motion.setArea(0, 0, 1920, 1080);
+    motion.reset(960, 540);
+
+    ON_CALL(impl, do_NextRequest(_)).WillByDefault(Return(10));
+
+    std::int32_t dx, dy;
+    motion.onMotion(makeMotion(5, 1500, 540), dx, dy);
+    motion.reset(100, 100);
+    motion.onMotion(makeMotion(20, 101, 100), dx, dy);
+    EXPECT_EQ(1, dx);
+}
+
+TEST(XWindowsRelativeMotionTests, onMotion_slowServer_noMotionLostAndNoRoundTrips)
+{
+    CLOG->setFilter(kINFO);
+
+    const int latency = 8;
+    NiceMock<MockXWindowsImpl> impl;
+    FakeServer server(impl, 1920, 1080, latency);
+    XWindowsRelativeMotion motion(&impl, nullptr, kRoot);
+    motion.setArea(0, 0, 1920, 1080);
+    motion.reset(960, 540);
+
+    EXPECT_CALL(impl, XSync(_, _)).Times(0);
+    EXPECT_CALL(impl, XQueryPointer(_, _, _, _, _, _, _, _, _)).Times(0);
+
+    // a fast flick to the right, back down and left, then circles
+    std::int64_t sentX = 0, sentY = 0, gotX = 0, gotY = 0;
+    auto move = [&](int dx, int dy) {
+        sentX += dx;
+        sentY += dy;
+        for (const XMotionEvent& event : server.step(dx, dy)) {
+            std::int32_t x, y;
+            motion.onMotion(event, x, y);
+            gotX += x;
+            gotY += y;
+        }
+    };
+    for (int i = 0; i < 2000; ++i) {
+        move(25, 0);
+    }
+    for (int i = 0; i < 2000; ++i) {
+        move(-17, 13);
+    }
+    const int circle[8][2] = {{20, 0}, {14, 14}, {0, 20}, {-14, 14},
+                              {-20, 0}, {-14, -14}, {0, -20}, {14, -14}};
+    for (int i = 0; i < 4000; ++i) {
+        move(circle[(i / 10) % 8][0], circle[(i / 10) % 8][1]);
+    }
+    for (int i = 0; i < 2 * latency; ++i) {
+        move(0, 0);
+    }
+
+    EXPECT_EQ(sentX, gotX);
+    EXPECT_EQ(sentY, gotY);
+    EXPECT_LT(motion.getWarpCount(), motion.getMotionCount() / 10);
+    LOG_INFO("%llu motion events, %llu warps, no round trips",
+             static_cast<unsigned long long>(motion.getMotionCount()),
+             static_cast<unsigned long long>(motion.getWarpCount()));
+}
+
+} // namespace inputleap
@@ -0,0 +1,393 @@
+/*  InputLeap -- mouse and keyboard sharing utility
+    Copyright (C) InputLeap contributors
+
+    This package is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    found in the file LICENSE that should have accompanied this file.
+
+    This package is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "server/ClientConnectionMotionCoalescer.h"
+#include "test/mock/inputleap/MockEventQueue.h"
+#include "test/mock/io/MemoryStream.h"
+#include "base/EventQueueTimer.h"
+#include "base/Log.h"
+#include "base/Time.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::NiceMock;
+
+namespace inputleap {
+
+namespace {
+
+// records the messages written to the client, oldest first
+class RecordingConnection : public IClientConnection {
+public:
+    RecordingConnection(std::deque<std::string>& sent, MemoryStream& stream) :
+        sent_{sent}, stream_{stream}
+    {}
+
+    const EventTarget* get_event_target() override { return nullptr; }
+    IStream* get_stream() override { return &stream_; }
+
+    void send_query_info_1_6() override { record("query info"); }
+    void send_leave_1_6() override { record("leave"); }
+    void send_enter_1_6(std::int32_t x, std::int32_t y, std::uint32_t, KeyModifierMask) override
+    {
+        record("enter " + std::to_string(x) + "," + std::to_string(y));
+    }
+    void send_key_down_1_6(KeyID key, KeyModifierMask, KeyButton) override
+    {
+        record("key down " + std::to_string(key));
+    }
+    void send_key_up_1_6(KeyID key, KeyModifierMask, KeyButton) override
+    {
+        record("key up " + std::to_string(key));
+    }
+    void send_key_repeat_1_6(KeyID key, KeyModifierMask, std::int32_t, KeyButton) override
+    {
+        record("key repeat " + std::to_string(key));
+    }
+    void send_mouse_down_1_6(ButtonID button) override
+    {
+        record("mouse down " + std::to_string(button));
+    }
+    void send_mouse_up_1_6(ButtonID button) override
+    {
+        record("mouse up " + std::to_string(button));
+    }
+    void send_mouse_move_1_6(std::int32_t x, std::int32_t y) override
+    {
+        record("move " + std::to_string(x) + "," + std::to_string(y));
+    }
+    void send_mouse_relative_move_1_6(std::int32_t x, std::int32_t y) override
+    {
+        record("relative move " + std::to_string(x) + "," + std::to_string(y));
+    }
+    void send_mouse_wheel_1_6(std::int32_t x, std::int32_t y) override
+    {
+        record("wheel " + std::to_string(x) + "," + std::to_string(y));
+    }
+    void send_drag_info_1_6(std::uint32_t, const std::string&) override { record("drag info"); }
+    void send_screensaver_1_6(bool) override { record("screensaver"); }
+    void send_reset_options_1_6() override { record("reset options"); }
+    void send_set_options_1_6(const OptionsList&) override { record("set options"); }
+    void send_info_ack_1_6() override { record("info ack"); }
+    void send_keep_alive_1_6() override { record("keep alive"); }
+    void send_close_1_6(const char*) override { record("close"); }
+    void send_clipboard_chunk_1_6(const ClipboardChunk&) override { record("clipboard"); }
+    void send_file_chunk_1_6(const FileChunk&) override { record("file"); }
+    void send_grab_clipboard(ClipboardID) override { record("grab clipboard"); }
+    void send_clipboard_formats_1_7(ClipboardID, std::uint32_t,
+                                    const std::vector<std::uint32_t>&) override
+    {
+        record("clipboard formats");
+    }
+    void flush() override {}
+    void close() override {}
+
+private:
+    void record(const std::string& message) { sent_.push_back(message); }
+
+    std::deque<std::string>& sent_;
+    MemoryStream& stream_;
+};
+
+// an event queue with one timer that fires only when the test says so
+class ManualTimerEvents {
+public:
+    ManualTimerEvents()
+    {
+        ON_CALL(queue_, newOneShotTimer(_, _)).WillByDefault(Invoke([this](double delay,
+                                                                           const EventTarget*) {
+            ++timers_created_;
+            running_ = true;
+            last_delay_ = delay;
+            return &timer_;
+        }));
+        ON_CALL(queue_, restartTimer(&timer_, _)).WillByDefault(Invoke([this](EventQueueTimer*,
+                                                                              double delay) {
+            running_ = true;
+            last_delay_ = delay;
+        }));
+        ON_CALL(queue_, add_handler(EventType::TIMER, _, _)).WillByDefault(Invoke(
+            [this](EventType, const EventTarget* target, const IEventQueue::EventHandler& h) {
+                handlers_[target] = h;
+            }));
+        ON_CALL(queue_, remove_handler(EventType::TIMER, _)).WillByDefault(Invoke(
+            [this](EventType, const EventTarget* target) { handlers_.erase(target); }));
+    }
+
+    IEventQueue* queue() { return &queue_; }
+
+    bool timer_running() const { return running_; }
+
+    int timers_created() const { return timers_created_; }
+
+    double last_delay() const { return last_delay_; }
+
+    void fire()
+    {
+        auto handler = handlers_.find(&timer_);
+        if (running_ && handler != handlers_.end()) {
+            running_ = false;
+            IEventQueue::EventHandler h = handler->second;
+            h(Event(EventType::TIMER, &timer_));
+        }
+    }
+
+private:
+    NiceMock<MockEventQueue> queue_;
+    EventQueueTimer timer_;
+    std::map<const EventTarget*, IEventQueue::EventHandler> handlers_;
+    bool running_ = false;
+    int timers_created_ = 0;
+    double last_delay_ = 0.0;
+};
+
+struct CoalescerFixture {
+    CoalescerFixture(std::uint32_t interval_us)
+    {
+        coalescer = std::make_unique<ClientConnectionMotionCoalescer>(
+                    "client", std::make_unique<RecordingConnection>(sent, stream),
+                    events.queue());
+        coalescer->send_set_options_1_6({ kOptionMouseMoveInterval, interval_us });
+        sent.clear();
+    }
+
+    std::vector<std::string> take_sent()
+    {
+        std::vector<std::string> result(sent.begin(), sent.end());
+        sent.clear();
+        return result;
+    }
+
+    std::deque<std::string> sent;
+    MemoryStream stream;
+    ManualTimerEvents events;
+    std::unique_ptr<ClientConnectionMotionCoalescer> coalescer;
+};
+
+// long enough that no move goes out early on its own
+const std::uint32_t kLongInterval = 60000000;
+
+typedef std::vector<std::string> Messages;
+
+} // namespace
+
+TEST(ClientConnectionMotionCoalescerTests, mouseMove_fastMoves_sendsLastPositionWhenDue)
+{
+    CoalescerFixture f(kLongInterval);
+
+    f.coalescer->send_mouse_move_1_6(1, 1);
+    f.coalescer->send_mouse_move_1_6(2, 2);
+    f.coalescer->send_mouse_move_1_6(3, 3);
+    EXPECT_EQ(Messages({ "move 1,1" }), f.take_sent());
+    EXPECT_TRUE(f.events.timer_running());
+    EXPECT_LE(f.events.last_delay(), kLongInterval / 1.0e6);
+
+    f.events.fire();
+    EXPECT_EQ(Messages({ "move 3,3" }), f.take_sent());
+    EXPECT_FALSE(f.events.timer_running());
+    EXPECT_EQ(2u, f.coalescer->get_sent_moves());
+    EXPECT_EQ(1u, f.coalescer->get_merged_moves());
+}
+
+TEST(ClientConnectionMotionCoalescerTests, mouseRelativeMove_fastMoves_sendsSum)
+{
+    CoalescerFixture f(kLongInterval);
+
+    f.coalescer->send_mouse_relative_move_1_6(1, 1);
+    f.coalescer->send_mouse_relative_move_1_6(2, 3);
+    f.coalescer->send_mouse_relative_move_1_6(4, -5);
+    f.events.fire();
+    EXPECT_EQ(Messages({ "relative move 1,1", "relative move 6,-2" }), f.take_sent());
+}
+
+TEST(ClientConnectionMotionCoalescerTests, mouseRelativeMove_sumTooLarge_sendsHeldMoveFirst)
+{
+    CoalescerFixture f(kLongInterval);
+
+    f.coalescer->send_mouse_relative_move_1_6(1, 0);
+    f.coalescer->send_mouse_relative_move_1_6(30000, 0);
+    f.coalescer->send_mouse_relative_move_1_6(30000, 0);
+    f.events.fire();
+    EXPECT_EQ(Messages({ "relative move 1,0", "relative move 30000,0",
+                         "relative move 30000,0" }), f.take_sent());
+}
+
+TEST(ClientConnectionMotionCoalescerTests, otherMessages_sendHeldMoveFirst)
+{
+    CoalescerFixture f(kLongInterval);
+
+    f.coalescer->send_mouse_move_1_6(1, 1);
+    f.coalescer->send_mouse_move_1_6(2, 2);
+    f.coalescer->send_mouse_down_1_6(1);
+    f.coalescer->send_mouse_move_1_6(3, 3);
+    f.coalescer->send_mouse_up_1_6(1);
+    f.coalescer->send_mouse_move_1_6(4, 4);
+    f.coalescer->send_key_down_1_6(65, 0, 30);
+    f.coalescer->send_mouse_relative_move_1_6(5, 5);
+    f.coalescer->send_mouse_wheel_1_6(0, 120);
+    f.coalescer->send_mouse_move_1_6(6, 6);
+    f.coalescer->send_leave_1_6();
+
+    EXPECT_EQ(Messages({ "move 1,1", "move 2,2", "mouse down 1", "move 3,3", "mouse up 1",
+                         "move 4,4", "key down 65", "relative move 5,5", "wheel 0,120",
+                         "move 6,6", "leave" }), f.take_sent());
+
+    // nothing is held for the timer to send
+    f.events.fire();
+    EXPECT_TRUE(f.take_sent().empty());
+}
+
+TEST(ClientConnectionMotionCoalescerTests, mouseMove_kindChanges_sendsHeldMoveFirst)
+{
+    CoalescerFixture f(kLongInterval);
+
+    f.coalescer->send_mouse_move_1_6(1, 1);
+    f.coalescer->send_mouse_move_1_6(2, 2);
+    f.coalescer->send_mouse_relative_move_1_6(3, 3);
+    f.events.fire();
+    EXPECT_EQ(Messages({ "move 1,1", "move 2,2", "relative move 3,3" }), f.take_sent());
+}
+
+TEST(ClientConnectionMotionCoalescerTests, mouseMove_zeroInterval_sendsEveryMove)
+{
+    CoalescerFixture f(0);
+
+    f.coalescer->send_mouse_move_1_6(1, 1);
+    f.coalescer->send_mouse_move_1_6(2, 2);
+    f.coalescer->send_mouse_relative_move_1_6(3, 3);
+    EXPECT_EQ(Messages({ "move 1,1", "move 2,2", "relative move 3,3" }), f.take_sent());
+    EXPECT_FALSE(f.events.timer_running());
+    EXPECT_EQ(0u, f.coalescer->get_merged_moves());
+}
+
+TEST(ClientConnectionMotionCoalescerTests, mouseMove_outputBacklog_holdsMove)
+{
+    CoalescerFixture f(1);
+
+    f.coalescer->send_mouse_move_1_6(1, 1);
+    this_thread_sleep(0.002);
+    f.coalescer->send_mouse_move_1_6(2, 2);
+    EXPECT_EQ(Messages({ "move 1,1", "move 2,2" }), f.take_sent());
+
+    f.stream.output_size_ = 100;
+    this_thread_sleep(0.002);
+    f.coalescer->send_mouse_move_1_6(3, 3);
+    EXPECT_TRUE(f.take_sent().empty());
+    EXPECT_TRUE(f.events.timer_running());
+
+    f.events.fire();
+    EXPECT_EQ(Messages({ "move 3,3" }), f.take_sent());
+}
+
+TEST(ClientConnectionMotionCoalescerTests, close_dropsHeldMove)
+{
+    CoalescerFixture f(kLongInterval);
+
+    f.coalescer->send_mouse_move_1_6(1, 1);
+    f.coalescer->send_mouse_move_1_6(2, 2);
+    f.coalescer->close();
+    EXPECT_EQ(Messages({ "move 1,1" }), f.take_sent());
+
+    f.events.fire();
+    EXPECT_TRUE(f.take_sent().empty());
+}
+
+TEST(ClientConnectionMotionCoalescerTests, resetOptions_turnsMergingOff)
+{
+    CoalescerFixture f(kLongInterval);
+
+    f.coalescer->send_reset_options_1_6();
+    f.coalescer->send_mouse_move_1_6(1, 1);
+    f.coalescer->send_mouse_move_1_6(2, 2);
+    EXPECT_EQ(Messages({ "reset options", "move 1,1", "move 2,2" }), f.take_sent());
+    EXPECT_FALSE(f.events.timer_running());
+}
+
+TEST(ClientConnectionMotionCoalescerTests, mouseMove_manyHeldMoves_reusesOneTimer)
+{
+    CoalescerFixture f(kLongInterval);
+
+    for (int i = 0; i < 10; ++i) {
+        f.coalescer->send_mouse_move_1_6(i, i);
+        f.coalescer->send_mouse_move_1_6(i, i + 1);
+        f.coalescer->send_mouse_down_1_6(1);
+    }
+    f.coalescer->send_mouse_move_1_6(10, 10);
+    EXPECT_TRUE(f.events.timer_running());
+    f.events.fire();
+    EXPECT_EQ(1, f.events.timers_created());
+}
+
+// A mouse reporting 8 moves per frame to a client whose link carries 4
+// messages per frame.  Each move's x is the frame it was made in, so the
+// last position to reach the client tells how late it is.
+TEST(ClientConnectionMotionCoalescerTests, latency_slowLink_staysBounded)
+{
+    const int kFrames = 200;
+    const int kMovesPerFrame = 8;
+    const std::size_t kLinkMessagesPerFrame = 4;
+    const std::uint32_t kMessageSize = 12;
+
+    auto run = [&](std::uint32_t interval_us, std::uint64_t& sent_moves) {
+        CoalescerFixture f(interval_us);
+        int max_latency = 0;
+        for (int frame = 0; frame < kFrames; ++frame) {
+            for (int i = 0; i < kMovesPerFrame; ++i) {
+                f.stream.output_size_ = static_cast<std::uint32_t>(f.sent.size()) * kMessageSize;
+                f.coalescer->send_mouse_move_1_6(frame, i);
+            }
+
+            // the event loop runs the timer at most once a frame
+            f.events.fire();
+
+            int delivered = -1;
+            for (std::size_t i = 0; i < kLinkMessagesPerFrame && !f.sent.empty(); ++i) {
+                const std::string& message = f.sent.front();
+                delivered = std::stoi(message.substr(message.find(' ') + 1));
+                f.sent.pop_front();
+            }
+            if (delivered >= 0) {
+                max_latency = std::max(max_latency, frame - delivered);
+            }
+        }
+        sent_moves = f.coalescer->get_sent_moves();
+        return max_latency;
+    };
+
+    std::uint64_t direct_moves = 0;
+    std::uint64_t coalesced_moves = 0;
+    int direct_latency = run(0, direct_moves);
+    int coalesced_latency = run(kLongInterval, coalesced_moves);
+
+    LOG_PRINT("mouse moves over a slow link: %d frames late and %llu messages unmerged, "
+              "%d frames late and %llu messages merged",
+              direct_latency, static_cast<unsigned long long>(direct_moves),
+              coalesced_latency, static_cast<unsigned long long>(coalesced_moves));
+
+    // unmerged moves queue up behind each other without bound
+    EXPECT_GT(direct_latency, kFrames / 4);
+    EXPECT_LE(coalesced_latency, 1);
+    EXPECT_LT(coalesced_moves, direct_moves / kMovesPerFrame * 2);
+}
+
+} // namespace inputleap
@@ -0,0 +1,174 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "server/ClientProxy1_7.h"
+#include "server/ClientConnectionByStream.h"
+#include "inputleap/Clipboard.h"
+#include "inputleap/ClipboardChunk.h"
+#include "inputleap/ProtocolUtil.h"
+#include "inputleap/protocol_types.h"
+#include "test/global/TestEventQueue.h"
+#include "test/mock/io/MemoryStream.h"
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace inputleap {
+
+namespace {
+
+// a message the proxy sent
+struct SentMessage {
+    std::string code;
+    std::uint32_t sequence = 0;
+    std::vector<std::uint32_t> formats;
+    Clipboard clipboard;
+};
+
+class ClientProxy1_7Tests : public ::testing::Test {
+public:
+    ClientProxy1_7Tests() :
+        stream_(new MemoryStream),
+        proxy_("client", std::make_unique<ClientConnectionByStream>(
+                   std::unique_ptr<IStream>(stream_)), nullptr, &events_)
+    {
+        // finish the handshake
+        receive(kMsgDInfo, 0, 0, 1920, 1080, 0, 0, 0);
+        stream_->output_.clear();
+    }
+
+    // delivers a message from the client
+    template<class... Args>
+    void receive(const char* format, Args... args)
+    {
+        MemoryStream client;
+        ProtocolUtil::writef(&client, format, args...);
+        stream_->input_.insert(stream_->input_.end(), client.output_.begin(),
+                               client.output_.end());
+        events_.dispatchEvent(Event(EventType::STREAM_INPUT_READY, stream_));
+    }
+
+    void set_text(const std::string& text)
+    {
+        Clipboard clipboard;
+        clipboard.open(0);
+        clipboard.add(IClipboard::kText, text);
+        clipboard.close();
+        proxy_.setClipboardDirty(kClipboardClipboard, true);
+        proxy_.setClipboard(kClipboardClipboard, &clipboard);
+    }
+
+    // reads back the clipboard advertisements and replies the proxy sent
+    std::vector<SentMessage> sent()
+    {
+        MemoryStream output;
+        output.input_ = stream_->output_;
+
+        std::vector<SentMessage> messages;
+        std::string data;
+        std::uint8_t code[4];
+        while (output.read(code, 4) == 4) {
+            SentMessage message;
+            message.code.assign(reinterpret_cast<char*>(code), 4);
+            ClipboardID id;
+            if (message.code == "CALV") {
+                // sent along with bulk data
+                continue;
+            }
+            else if (message.code == "DCLF") {
+                EXPECT_TRUE(ProtocolUtil::readf(&output, kMsgDClipboardFormats + 4, &id,
+                                                &message.sequence, &message.formats));
+                messages.push_back(message);
+            }
+            else if (message.code == "DCLP") {
+                int result = ClipboardChunk::assemble(&output, data, id, message.sequence);
+                EXPECT_NE(kError, result);
+                if (result == kFinish) {
+                    message.clipboard.unmarshall(data, 0);
+                    messages.push_back(message);
+                }
+            }
+            else {
+                ADD_FAILURE() << "unexpected message " << message.code;
+                break;
+            }
+        }
+        return messages;
+    }
+
+    TestEventQueue events_;
+    MemoryStream* stream_;
+    ClientProxy1_7 proxy_;
+};
+
+std::string text_of(const Clipboard& clipboard)
+{
+    clipboard.open(0);
+    std::string text = clipboard.get(IClipboard::kText);
+    clipboard.close();
+    return text;
+}
+
+} // namespace
+
+TEST_F(ClientProxy1_7Tests, setClipboard_advertisesFormatsOnly)
+{
+    set_text("hello");
+
+    Clipboard clipboard;
+    clipboard.open(0);
+    clipboard.add(IClipboard::kText, "hello");
+    Clipboard::Digest digest = clipboard.digest(IClipboard::kText);
+    clipboard.close();
+
+    auto messages = sent();
+    ASSERT_EQ(1u, messages.size());
+    EXPECT_EQ("DCLF", messages[0].code);
+    EXPECT_EQ((std::vector<std::uint32_t>{
+                  IClipboard::kText, 5,
+                  static_cast<std::uint32_t>(digest[0] >> 32),
+                  static_cast<std::uint32_t>(digest[0]),
+                  static_cast<std::uint32_t>(digest[1] >> 32),
+                  static_cast<std::uint32_t>(digest[1]) }),
+              messages[0].formats);
+}
+
+TEST_F(ClientProxy1_7Tests, queryClipboardFormat_repliesWithAdvertisedSequence)
+{
+    set_text("old");
+    receive(kMsgQClipboardFormat, kClipboardClipboard, IClipboard::kText);
+    set_text("new");
+    receive(kMsgQClipboardFormat, kClipboardClipboard, IClipboard::kText);
+
+    auto messages = sent();
+    ASSERT_EQ(4u, messages.size());
+    EXPECT_EQ("DCLF", messages[0].code);
+    EXPECT_EQ("DCLP", messages[1].code);
+    EXPECT_EQ("DCLF", messages[2].code);
+    EXPECT_EQ("DCLP", messages[3].code);
+
+    // each reply carries the sequence number of its advertisement
+    EXPECT_NE(messages[0].sequence, messages[2].sequence);
+    EXPECT_EQ(messages[0].sequence, messages[1].sequence);
+    EXPECT_EQ("old", text_of(messages[1].clipboard));
+    EXPECT_EQ(messages[2].sequence, messages[3].sequence);
+    EXPECT_EQ("new", text_of(messages[3].clipboard));
+}
+
+} // namespace inputleap
@@ -245,4 +245,45 @@ TEST(ConfigTests, getOptions_nonExistentScreen_returnsNull)
     EXPECT_EQ(nullptr, options);
 }
 
-} // namespace inputleap
\ No newline at end of file
+TEST(ConfigTests, parseMouseMoveInterval_globalOption_parsedAndWritten)
+{
+    Config config;
+    std::stringstream ss;
+    ss << "section: screens\n"
+       << "\ttest:\n"
+       << "end\n"
+       << "section: options\n"
+       << "\tmouseMoveInterval = 2000\n"
+       << "end\n";
+
+    ss >> config;
+
+    const Config::ScreenOptions* options = config.getOptions("");
+    ASSERT_NE(nullptr, options);
+
+    auto it = options->find(kOptionMouseMoveInterval);
+    ASSERT_NE(options->end(), it);
+    EXPECT_EQ(2000, it->second);
+
+    std::stringstream out;
+    out << config;
+    EXPECT_NE(std::string::npos, out.str().find("mouseMoveInterval = 2000"));
+}
+
+TEST(ConfigTests, parseMouseMoveInterval_outOfRange_throws)
+{
+    for (const char* interval : { "-1", "1000001" }) {
+        Config config;
+        std::stringstream ss;
+        ss << "section: screens\n"
+           << "\ttest:\n"
+           << "end\n"
+           << "section: options\n"
+           << "\tmouseMoveInterval = " << interval << "\n"
+           << "end\n";
+
+        EXPECT_THROW(ss >> config, XConfigRead) << interval;
+    }
+}
+
+} // namespace inputleap
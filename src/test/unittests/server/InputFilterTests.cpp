@@ -0,0 +1,271 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test/mock/server/MockPrimaryClient.h"
+#include "test/global/TestEventQueue.h"
+#include "server/InputFilter.h"
+#include "base/Log.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <chrono>
+
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::NiceMock;
+
+namespace inputleap {
+
+namespace {
+
+const int kNumHotKeyRules = 200;
+
+// a primary client that hands out hot key ids in order
+class FakePrimaryClient : public NiceMock<MockPrimaryClient> {
+public:
+    FakePrimaryClient()
+    {
+        ON_CALL(*this, registerHotKey(_, _)).WillByDefault(Invoke([this](KeyID, KeyModifierMask) {
+            return ++m_lastID;
+        }));
+    }
+
+    std::uint32_t m_lastID = 0;
+};
+
+// counts the events the filter sends to the server
+class InputFilterTests : public ::testing::Test {
+public:
+    InputFilterTests() : m_filter(&m_events)
+    {
+        count(EventType::KEY_STATE_KEY_DOWN, m_keyDowns);
+        count(EventType::PRIMARY_SCREEN_BUTTON_DOWN, m_buttonDowns);
+        count(EventType::SERVER_LOCK_CURSOR_TO_SCREEN, m_locks);
+        count(EventType::SERVER_SWITCH_TO_SCREEN, m_switches);
+    }
+
+    ~InputFilterTests() override
+    {
+        m_filter.setPrimaryClient(nullptr);
+        m_events.remove_handlers(&m_filter);
+    }
+
+    void count(EventType type, int& counter)
+    {
+        m_events.add_handler(type, &m_filter, [&counter](const auto&) { ++counter; });
+    }
+
+    // hot key rules for ctrl+a, ctrl+b, ... and a rule for the second
+    // mouse button with shift
+    void addRules()
+    {
+        for (int i = 0; i < kNumHotKeyRules; ++i) {
+            InputFilter::Rule rule(new InputFilter::KeystrokeCondition(0x61 + i,
+                                                                       KeyModifierControl));
+            rule.adoptAction(new InputFilter::LockCursorToScreenAction(), true);
+            m_filter.addFilterRule(rule);
+        }
+        InputFilter::Rule rule(new InputFilter::MouseButtonCondition(kButtonRight,
+                                                                     KeyModifierShift));
+        rule.adoptAction(new InputFilter::SwitchToScreenAction("laptop"), true);
+        m_filter.addFilterRule(rule);
+    }
+
+    template<class T>
+    void send(EventType type, const T& info, const EventTarget* source = nullptr)
+    {
+        if (source == nullptr) {
+            source = m_primary.get_event_target();
+        }
+        Event event(type, source, create_event_data<T>(info));
+        m_events.dispatchEvent(event);
+        Event::deleteData(event);
+    }
+
+    TestEventQueue m_events;
+    FakePrimaryClient m_primary;
+    InputFilter m_filter;
+    int m_keyDowns = 0;
+    int m_buttonDowns = 0;
+    int m_locks = 0;
+    int m_switches = 0;
+};
+
+} // namespace
+
+TEST_F(InputFilterTests, handleEvent_hotKey_performsActionsOfItsRule)
+{
+    addRules();
+    m_filter.setPrimaryClient(&m_primary);
+
+    send(EventType::PRIMARY_SCREEN_HOTKEY_DOWN, IPlatformScreen::HotKeyInfo{kNumHotKeyRules});
+    send(EventType::PRIMARY_SCREEN_HOTKEY_DOWN, IPlatformScreen::HotKeyInfo{kNumHotKeyRules + 1});
+
+    EXPECT_EQ(1, m_locks);
+}
+
+TEST_F(InputFilterTests, handleEvent_hotKeysRegisteredAgain_usesNewIDs)
+{
+    addRules();
+    m_filter.setPrimaryClient(&m_primary);
+    m_filter.setPrimaryClient(nullptr);
+    m_filter.setPrimaryClient(&m_primary);
+
+    send(EventType::PRIMARY_SCREEN_HOTKEY_DOWN, IPlatformScreen::HotKeyInfo{1});
+    EXPECT_EQ(0, m_locks);
+    send(EventType::PRIMARY_SCREEN_HOTKEY_DOWN, IPlatformScreen::HotKeyInfo{kNumHotKeyRules + 1});
+    EXPECT_EQ(1, m_locks);
+}
+
+TEST_F(InputFilterTests, handleEvent_ruleAddedWhileEnabled_matches)
+{
+    m_filter.setPrimaryClient(&m_primary);
+    InputFilter::Rule rule(new InputFilter::KeystrokeCondition(0x61, KeyModifierControl));
+    rule.adoptAction(new InputFilter::LockCursorToScreenAction(), true);
+    m_filter.addFilterRule(rule);
+
+    send(EventType::PRIMARY_SCREEN_HOTKEY_DOWN, IPlatformScreen::HotKeyInfo{1});
+    EXPECT_EQ(1, m_locks);
+}
+
+TEST_F(InputFilterTests, handleEvent_button_matchesIgnoringLockModifiers)
+{
+    addRules();
+    m_filter.setPrimaryClient(&m_primary);
+
+    send(EventType::PRIMARY_SCREEN_BUTTON_DOWN,
+         IPlatformScreen::ButtonInfo{kButtonRight, KeyModifierShift | KeyModifierNumLock});
+    EXPECT_EQ(1, m_switches);
+    EXPECT_EQ(0, m_buttonDowns);
+
+    send(EventType::PRIMARY_SCREEN_BUTTON_DOWN,
+         IPlatformScreen::ButtonInfo{kButtonRight, KeyModifierControl});
+    EXPECT_EQ(1, m_switches);
+    EXPECT_EQ(1, m_buttonDowns);
+}
+
+TEST_F(InputFilterTests, handleEvent_key_passesThroughWithData)
+{
+    addRules();
+    m_filter.setPrimaryClient(&m_primary);
+
+    KeyID key = 0;
+    m_events.remove_handler(EventType::KEY_STATE_KEY_DOWN, &m_filter);
+    m_events.add_handler(EventType::KEY_STATE_KEY_DOWN, &m_filter, [&key](const Event& event) {
+        key = event.get_data_as<IKeyState::KeyInfo>().m_key;
+    });
+
+    send(EventType::KEY_STATE_KEY_DOWN, IKeyState::KeyInfo(0x61, KeyModifierControl, 38, 1));
+    EXPECT_EQ(0x61u, key);
+    EXPECT_EQ(0, m_locks);
+}
+
+TEST_F(InputFilterTests, copy_hasRulesOfOriginal_matches)
+{
+    addRules();
+    InputFilter copy(&m_events);
+    copy = m_filter;
+    m_events.add_handler(EventType::SERVER_SWITCH_TO_SCREEN, &copy,
+                         [this](const auto&) { ++m_switches; });
+    copy.setPrimaryClient(&m_primary);
+
+    send(EventType::PRIMARY_SCREEN_BUTTON_DOWN,
+         IPlatformScreen::ButtonInfo{kButtonRight, KeyModifierShift});
+    EXPECT_EQ(1, m_switches);
+
+    copy.setPrimaryClient(nullptr);
+    m_events.remove_handlers(&copy);
+}
+
+TEST_F(InputFilterTests, DISABLED_benchmark_handleEvent200HotKeyRules)
+{
+    addRules();
+    m_filter.setPrimaryClient(&m_primary);
+    const int kRounds = 20000;
+
+    // the rules of the filter are matched one after the other the way
+    // the filter did it before they were indexed, for events from
+    // another source.  these are enabled after the filter's, so they
+    // have the next ids.
+    EventTarget linearSource;
+    InputFilter::RuleList rules = m_filter.get_rules();
+    for (auto& rule : rules) {
+        rule.enable(&m_primary);
+    }
+    auto linear = [&](const Event& event) {
+        Event myEvent(event.getType(), &m_filter, nullptr,
+                      event.getFlags() | Event::kDeliverImmediately);
+        myEvent.clone_data_from(event);
+        for (auto& rule : rules) {
+            if (rule.handle_event(&m_events, myEvent)) {
+                Event::deleteData(myEvent);
+                return;
+            }
+        }
+        m_events.add_event(std::move(myEvent));
+    };
+    m_events.add_handler(EventType::KEY_STATE_KEY_DOWN, &linearSource, linear);
+    m_events.add_handler(EventType::PRIMARY_SCREEN_HOTKEY_DOWN, &linearSource, linear);
+
+    // measure the matching, not the log
+    int filter = CLOG->getFilter();
+    CLOG->setFilter(kINFO);
+
+    IKeyState::KeyInfo key(0x61, KeyModifierControl, 38, 1);
+    auto begin = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; ++round) {
+        send(EventType::KEY_STATE_KEY_DOWN, key, &linearSource);
+    }
+    std::chrono::duration<double, std::nano> linearKeyTime =
+        std::chrono::steady_clock::now() - begin;
+
+    begin = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; ++round) {
+        send(EventType::KEY_STATE_KEY_DOWN, key);
+    }
+    std::chrono::duration<double, std::nano> keyTime = std::chrono::steady_clock::now() - begin;
+
+    // the last hot key rule
+    IPlatformScreen::HotKeyInfo hotKey(2 * kNumHotKeyRules);
+    begin = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; ++round) {
+        send(EventType::PRIMARY_SCREEN_HOTKEY_DOWN, hotKey, &linearSource);
+    }
+    std::chrono::duration<double, std::nano> linearHotKeyTime =
+        std::chrono::steady_clock::now() - begin;
+
+    hotKey.m_id = kNumHotKeyRules;
+    begin = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; ++round) {
+        send(EventType::PRIMARY_SCREEN_HOTKEY_DOWN, hotKey);
+    }
+    std::chrono::duration<double, std::nano> hotKeyTime =
+        std::chrono::steady_clock::now() - begin;
+
+    CLOG->setFilter(filter);
+
+    EXPECT_EQ(2 * kRounds, m_keyDowns);
+    EXPECT_EQ(2 * kRounds, m_locks);
+    LOG_INFO("%d rules, key: %.0f ns linear, %.0f ns indexed; hot key: %.0f ns linear, "
+             "%.0f ns indexed", static_cast<int>(rules.size()),
+             linearKeyTime.count() / kRounds, keyTime.count() / kRounds,
+             linearHotKeyTime.count() / kRounds, hotKeyTime.count() / kRounds);
+
+    m_events.remove_handlers(&linearSource);
+}
+
+} // namespace inputleap
@@ -0,0 +1,258 @@
+/*
+ * InputLeap -- mouse and keyboard sharing utility
+ * Copyright (C) InputLeap contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "server/ScreenTopology.h"
+#include "server/Config.h"
+#include "base/Log.h"
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace inputleap {
+
+namespace {
+
+typedef std::map<std::string, BaseClientProxy*> Clients;
+
+std::string screenName(int column, int row)
+{
+    return "screen" + std::to_string(column) + "x" + std::to_string(row);
+}
+
+// a grid of screens, each linked to its neighbors.  the top and bottom
+// links of odd columns are offset to exercise the position mapping.
+void makeGrid(Config& config, int columns, int rows)
+{
+    for (int row = 0; row < rows; ++row) {
+        for (int column = 0; column < columns; ++column) {
+            config.addScreen(screenName(column, row));
+        }
+    }
+    for (int row = 0; row < rows; ++row) {
+        for (int column = 0; column < columns; ++column) {
+            std::string name = screenName(column, row);
+            if (column > 0) {
+                config.connect(name, kLeft, 0.0f, 1.0f, screenName(column - 1, row), 0.0f, 1.0f);
+            }
+            if (column + 1 < columns) {
+                config.connect(name, kRight, 0.0f, 1.0f, screenName(column + 1, row), 0.0f, 1.0f);
+            }
+            if (row > 0) {
+                if (column % 2 == 1) {
+                    config.connect(name, kTop, 0.0f, 0.5f, screenName(column, row - 1), 0.25f, 1.0f);
+                    config.connect(name, kTop, 0.5f, 1.0f, screenName(column - 1, row - 1), 0.0f, 0.75f);
+                }
+                else {
+                    config.connect(name, kTop, 0.0f, 1.0f, screenName(column, row - 1), 0.0f, 1.0f);
+                }
+            }
+            if (row + 1 < rows) {
+                config.connect(name, kBottom, 0.1f, 0.9f, screenName(column, row + 1), 0.0f, 1.0f);
+            }
+        }
+    }
+}
+
+// the search the server did before it had an index
+std::string findByConfig(const Config& config, const Clients& clients, std::string name,
+                         EDirection side, float position, float& positionOut)
+{
+    for (;;) {
+        std::string dstName = config.getNeighbor(name, side, position, &positionOut);
+        if (dstName.empty() || clients.count(dstName) != 0) {
+            return dstName;
+        }
+        name = dstName;
+        position = positionOut;
+    }
+}
+
+const EDirection kSides[] = { kLeft, kRight, kTop, kBottom };
+
+} // namespace
+
+TEST(ScreenTopologyTests, getNeighbor_skipsUnconnected)
+{
+    Config config;
+    config.addScreen("a");
+    config.addScreen("b");
+    config.addScreen("c");
+    config.connect("a", kRight, 0.0f, 1.0f, "b", 0.0f, 1.0f);
+    config.connect("b", kRight, 0.0f, 1.0f, "c", 0.0f, 0.5f);
+
+    ScreenTopology topology;
+    topology.rebuild(config, { { "a", nullptr }, { "c", nullptr } });
+
+    float position = -1.0f;
+    std::size_t neighbor = topology.getNeighbor(topology.find("a"), kRight, 0.5f, position);
+    ASSERT_NE(ScreenTopology::kNoScreen, neighbor);
+    EXPECT_EQ("c", topology.getName(neighbor));
+    EXPECT_FLOAT_EQ(0.25f, position);
+
+    EXPECT_EQ(ScreenTopology::kNoScreen,
+              topology.getNeighbor(topology.find("a"), kLeft, 0.5f, position));
+    EXPECT_EQ(ScreenTopology::kNoScreen,
+              topology.getNeighbor(topology.find("c"), kRight, 0.5f, position));
+}
+
+TEST(ScreenTopologyTests, getNeighbor_loopOfUnconnected_returnsNoScreen)
+{
+    Config config;
+    config.addScreen("a");
+    config.addScreen("b");
+    config.addScreen("c");
+    config.connect("a", kRight, 0.0f, 1.0f, "b", 0.0f, 1.0f);
+    config.connect("b", kRight, 0.0f, 1.0f, "c", 0.0f, 1.0f);
+    config.connect("c", kRight, 0.0f, 1.0f, "b", 0.0f, 1.0f);
+
+    ScreenTopology topology;
+    topology.rebuild(config, { { "a", nullptr } });
+
+    float position;
+    EXPECT_EQ(ScreenTopology::kNoScreen,
+              topology.getNeighbor(topology.find("a"), kRight, 0.5f, position));
+}
+
+TEST(ScreenTopologyTests, hasNeighbor_matchesConfig)
+{
+    Config config;
+    config.addScreen("a");
+    config.addScreen("b");
+    config.connect("a", kTop, 0.25f, 0.5f, "b", 0.0f, 1.0f);
+
+    ScreenTopology topology;
+    topology.rebuild(config, { { "a", nullptr } });
+
+    std::size_t a = topology.find("a");
+    EXPECT_TRUE(topology.hasNeighbor(a, kTop));
+    EXPECT_FALSE(topology.hasNeighbor(a, kBottom));
+    EXPECT_TRUE(topology.hasNeighbor(a, kTop, 0.25f));
+    EXPECT_FALSE(topology.hasNeighbor(a, kTop, 0.5f));
+    EXPECT_FALSE(topology.hasNeighbor(a, kTop, 0.1f));
+    EXPECT_FALSE(topology.hasNeighbor(ScreenTopology::kNoScreen, kTop));
+}
+
+TEST(ScreenTopologyTests, getNeighbor_grid_matchesConfig)
+{
+    Config config;
+    makeGrid(config, 10, 5);
+
+    // every third screen is connected
+    Clients clients;
+    int count = 0;
+    for (auto i = config.begin(); i != config.end(); ++i) {
+        if (count++ % 3 == 0) {
+            clients[*i] = nullptr;
+        }
+    }
+
+    ScreenTopology topology;
+    topology.rebuild(config, clients);
+
+    int filter = CLOG->getFilter();
+    CLOG->setFilter(kINFO);
+    for (auto i = config.begin(); i != config.end(); ++i) {
+        for (EDirection side : kSides) {
+            for (float t = 0.005f; t < 1.0f; t += 0.01f) {
+                float expectedPosition = -1.0f;
+                float position = -1.0f;
+                std::string expected = findByConfig(config, clients, *i, side, t, expectedPosition);
+                std::size_t neighbor = topology.getNeighbor(topology.find(*i), side, t, position);
+                if (expected.empty()) {
+                    EXPECT_EQ(ScreenTopology::kNoScreen, neighbor);
+                }
+                else {
+                    ASSERT_NE(ScreenTopology::kNoScreen, neighbor);
+                    EXPECT_EQ(expected, topology.getName(neighbor));
+                    EXPECT_EQ(expectedPosition, position);
+                }
+            }
+        }
+    }
+    CLOG->setFilter(filter);
+}
+
+TEST(ScreenTopologyTests, DISABLED_benchmark_grid50)
+{
+    Config config;
+    makeGrid(config, 10, 5);
+
+    // every other screen is connected so crossings skip screens
+    Clients clients;
+    int count = 0;
+    for (auto i = config.begin(); i != config.end(); ++i) {
+        if (count++ % 2 == 0) {
+            clients[*i] = nullptr;
+        }
+    }
+
+    std::vector<std::string> names;
+    for (auto i = config.begin(); i != config.end(); ++i) {
+        names.push_back(*i);
+    }
+    const int kRounds = 200;
+
+    // measure the search, not the debug log
+    int filter = CLOG->getFilter();
+    CLOG->setFilter(kINFO);
+
+    std::size_t found = 0;
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; ++round) {
+        for (const auto& name : names) {
+            for (EDirection side : kSides) {
+                float position;
+                found += findByConfig(config, clients, name, side, 0.3f, position).size();
+            }
+        }
+    }
+    std::chrono::duration<double, std::nano> configTime = std::chrono::steady_clock::now() - begin;
+
+    begin = std::chrono::steady_clock::now();
+    ScreenTopology topology;
+    topology.rebuild(config, clients);
+    std::chrono::duration<double, std::micro> rebuildTime = std::chrono::steady_clock::now() - begin;
+
+    std::vector<std::size_t> screens;
+    for (const auto& name : names) {
+        screens.push_back(topology.find(name));
+    }
+    begin = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; ++round) {
+        for (std::size_t screen : screens) {
+            for (EDirection side : kSides) {
+                float position;
+                found += topology.getNeighbor(screen, side, 0.3f, position);
+            }
+        }
+    }
+    std::chrono::duration<double, std::nano> topologyTime = std::chrono::steady_clock::now() - begin;
+
+    CLOG->setFilter(filter);
+
+    double lookups = kRounds * names.size() * 4.0;
+    LOG_PRINT("neighbor lookup in a 50 screen grid: config %.0f ns, index %.1f ns, "
+              "rebuilding the index %.0f us (%zu)",
+              configTime.count() / lookups, topologyTime.count() / lookups,
+              rebuildTime.count(), found % 2);
+}
+
+} // namespace inputleap